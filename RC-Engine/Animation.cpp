@@ -5,19 +5,43 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
+
 #include "Animation.h"
 #include "LogManager.h"
 
 extern LogManager * gLogManager;
 
+// Returns the key the time falls after, keys are sorted by time
+template <typename KeyType>
+static uint32_t FindKeyFrame(float time, const KeyType * keys, uint32_t keyCount)
+{
+	for (uint32_t i = 0; i < keyCount - 1; i++)
+	{
+		if (time < keys[i + 1].time)
+			return i;
+	}
+
+	return 0;
+}
+
 Animation::Animation()
 {
-	scene = NULL;
+	header = NULL;
+	nodes = NULL;
+	channels = NULL;
+	positionKeys = NULL;
+	rotationKeys = NULL;
+	scaleKeys = NULL;
 }
 
 Animation::~Animation()
 {
-	scene = NULL;
+	scaleKeys = NULL;
+	rotationKeys = NULL;
+	positionKeys = NULL;
+	channels = NULL;
+	nodes = NULL;
+	header = NULL;
 }
 
 bool Animation::Init(std::string filename, uint32_t numBones, bool loopAnim)
@@ -29,20 +53,65 @@ bool Animation::Init(std::string filename, uint32_t numBones, bool loopAnim)
 	runTime = 0.0f;
 	speed = 0.001f;
 
-	scene = importer.ReadFile(filename, aiProcess_MakeLeftHanded | aiProcess_FlipWindingOrder);
+	if (!clipFile.Init(filename))
+	{
+		gLogManager->AddMessage("ERROR: Animation file not found! (" + filename + ")");
+		return false;
+	}
 
-	if (!scene)
+	header = (const RCAnimHeader*)clipFile.Read(sizeof(RCAnimHeader));
+	if (header == NULL || header->magic != RCA_MAGIC || header->version != RCA_VERSION)
 	{
-		gLogManager->AddMessage("ERROR: Reading animation file! ASSIMP INFO: ");
-		gLogManager->AddMessage(importer.GetErrorString());
+		gLogManager->AddMessage("ERROR: Animation file has an unknown format or version! (" + filename + ")");
 		return false;
 	}
 
-	boneTransforms.resize(numBones);
-	boneTransformsGLM.resize(numBones);
+	if (header->boneCount != numBones)
+	{
+		gLogManager->AddMessage("ERROR: Animation was baked for a different skeleton! (" + filename + ")");
+		return false;
+	}
 
-	globalInverseTransform = scene->mRootNode->mTransformation;
-	globalInverseTransform.Inverse();
+	// Every table is used straight from the file data
+	nodes = (const RCAnimNode*)clipFile.Read(sizeof(RCAnimNode) * header->nodeCount);
+	channels = (const RCAnimChannel*)clipFile.Read(sizeof(RCAnimChannel) * header->channelCount);
+	positionKeys = (const RCAnimVectorKey*)clipFile.Read(sizeof(RCAnimVectorKey) * header->positionKeyCount);
+	rotationKeys = (const RCAnimQuatKey*)clipFile.Read(sizeof(RCAnimQuatKey) * header->rotationKeyCount);
+	scaleKeys = (const RCAnimVectorKey*)clipFile.Read(sizeof(RCAnimVectorKey) * header->scaleKeyCount);
+
+	if (nodes == NULL || channels == NULL || positionKeys == NULL || rotationKeys == NULL || scaleKeys == NULL)
+	{
+		gLogManager->AddMessage("ERROR: Animation file is corrupted! (" + filename + ")");
+		return false;
+	}
+
+	// Validate indices once, so Update doesn't have to
+	for (uint32_t i = 0; i < header->nodeCount; i++)
+	{
+		if (nodes[i].parent >= (int32_t)i || nodes[i].boneIndex >= (int32_t)numBones || nodes[i].channelIndex >= (int32_t)header->channelCount)
+		{
+			gLogManager->AddMessage("ERROR: Animation file is corrupted! (" + filename + ")");
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header->channelCount; i++)
+	{
+		const RCAnimChannel& channel = channels[i];
+		if (channel.positionKeyCount == 0 || channel.rotationKeyCount == 0 || channel.scaleKeyCount == 0 ||
+			channel.firstPositionKey + channel.positionKeyCount > header->positionKeyCount ||
+			channel.firstRotationKey + channel.rotationKeyCount > header->rotationKeyCount ||
+			channel.firstScaleKey + channel.scaleKeyCount > header->scaleKeyCount)
+		{
+			gLogManager->AddMessage("ERROR: Animation file is corrupted! (" + filename + ")");
+			return false;
+		}
+	}
+
+	globalInverseTransform = glm::make_mat4(header->globalInverseTransform);
+
+	nodeTransforms.resize(header->nodeCount);
+	boneTransformsGLM.resize(numBones);
 
 	return true;
 }
@@ -58,29 +127,47 @@ void Animation::ResetAnimation()
 	isFinished = false;
 }
 
-void Animation::Update(float time, std::vector<aiMatrix4x4>& boneOffsets, std::map<std::string, uint32_t>& boneMapping)
+void Animation::Update(float time, std::vector<glm::mat4>& boneOffsets)
 {
 	if(!isFinished)
 		runTime += time * speed;
 
-	float ticksPerSecond = (float)(scene->mAnimations[0]->mTicksPerSecond != 0 ? scene->mAnimations[0]->mTicksPerSecond : 25.0f);
+	float ticksPerSecond = header->ticksPerSecond;
 	float timeInTicks = runTime * ticksPerSecond;
 
-	if (timeInTicks > scene->mAnimations[0]->mDuration && !loop)
+	if (timeInTicks > header->duration && !loop)
 	{
 		isFinished = true;
 		runTime -= time * speed;
 	}
 
-	float animationTime = fmod(timeInTicks, (float)scene->mAnimations[0]->mDuration);
+	float animationTime = fmod(timeInTicks, header->duration);
+
+	// Nodes are stored parents first, so a single pass resolves the whole hierarchy
+	for (uint32_t i = 0; i < header->nodeCount; i++)
+	{
+		const RCAnimNode& node = nodes[i];
+
+		glm::mat4 nodeTransform;
+		if (node.channelIndex >= 0)
+		{
+			const RCAnimChannel& channel = channels[node.channelIndex];
+			nodeTransform = InterpolateTranslation(animationTime, channel) * InterpolateRotation(animationTime, channel) *
+				InterpolateScale(animationTime, channel);
+		}
+		else
+			nodeTransform = glm::make_mat4(node.transform);
 
-	aiMatrix4x4 identity = aiMatrix4x4();
-	ReadNodeHierarchy(animationTime, scene->mRootNode, identity, boneOffsets, boneMapping);
+		if (node.parent >= 0)
+			nodeTransforms[i] = nodeTransforms[node.parent] * nodeTransform;
+		else
+			nodeTransforms[i] = nodeTransform;
 
-	for (uint32_t i = 0; i < boneTransforms.size(); i++)
-		boneTransformsGLM[i] = glm::transpose(glm::make_mat4(&boneTransforms[i].a1));
+		if (node.boneIndex >= 0)
+			boneTransformsGLM[node.boneIndex] = globalInverseTransform * nodeTransforms[i] * boneOffsets[node.boneIndex];
+	}
 
-	if (runTime > scene->mAnimations[0]->mDuration * ticksPerSecond)
+	if (runTime > header->duration * ticksPerSecond)
 		runTime = 0.0f;
 }
 
@@ -94,150 +181,77 @@ bool Animation::IsFinished()
 	return isFinished;
 }
 
-void Animation::ReadNodeHierarchy(float animTime, const aiNode * node, const aiMatrix4x4 & parentTransform,
-	std::vector<aiMatrix4x4>& boneOffsets, std::map<std::string, uint32_t>& boneMapping)
+glm::mat4 Animation::InterpolateTranslation(float time, const RCAnimChannel& channel)
 {
-	std::string nodeName(node->mName.data);
-
-	aiMatrix4x4 nodeTransform(node->mTransformation);
-
-	const aiNodeAnim * nodeAnim = FindNodeAnim(nodeName);
-	if (nodeAnim)
-	{
-		aiMatrix4x4 matScale = InterpolateScale(animTime, nodeAnim);
-		aiMatrix4x4 matRotation = InterpolateRotation(animTime, nodeAnim);
-		aiMatrix4x4 matTranslation = InterpolateTranslation(animTime, nodeAnim);
-
-		nodeTransform = matTranslation * matRotation * matScale;
-	}
+	const RCAnimVectorKey * keys = positionKeys + channel.firstPositionKey;
+	glm::vec3 translation;
 
-	aiMatrix4x4 globalTransform = parentTransform * nodeTransform;
-
-	if (boneMapping.find(nodeName) != boneMapping.end())
-	{
-		uint32_t boneIndex = boneMapping[nodeName];
-		boneTransforms[boneIndex] = globalInverseTransform * globalTransform * boneOffsets[boneIndex];
-	}
-	
-	for (uint32_t i = 0; i < node->mNumChildren; i++)
-		ReadNodeHierarchy(animTime, node->mChildren[i], globalTransform, boneOffsets, boneMapping);
-}
-
-const aiNodeAnim * Animation::FindNodeAnim(std::string nodeName)
-{
-	aiAnimation * anim = scene->mAnimations[0];
-	for (uint32_t i = 0; i < anim->mNumChannels; i++)
-	{
-		const aiNodeAnim* nodeAnim = anim->mChannels[i];
-		if (std::string(nodeAnim->mNodeName.data) == nodeName)
-			return nodeAnim;
-	}
-
-	return NULL;
-}
-
-aiMatrix4x4 Animation::InterpolateTranslation(float time, const aiNodeAnim * nodeAnim)
-{
-	aiVector3D translation;
-
-	if (nodeAnim->mNumPositionKeys == 1)
-		translation = nodeAnim->mPositionKeys[0].mValue;
+	if (channel.positionKeyCount == 1)
+		translation = glm::vec3(keys[0].x, keys[0].y, keys[0].z);
 	else
 	{
-		uint32_t frameIndex = 0;
-		for (uint32_t i = 0; i < nodeAnim->mNumPositionKeys - 1; i++)
-		{
-			if (time < (float)nodeAnim->mPositionKeys[i + 1].mTime)
-			{
-				frameIndex = i;
-				break;
-			}
-		}
+		uint32_t frameIndex = FindKeyFrame(time, keys, channel.positionKeyCount);
 
-		aiVectorKey currentFrame = nodeAnim->mPositionKeys[frameIndex];
-		aiVectorKey nextFrame = nodeAnim->mPositionKeys[(frameIndex + 1) % nodeAnim->mNumPositionKeys];
+		const RCAnimVectorKey& currentFrame = keys[frameIndex];
+		const RCAnimVectorKey& nextFrame = keys[(frameIndex + 1) % channel.positionKeyCount];
 
-		float delta = (time - (float)currentFrame.mTime) / (float)(nextFrame.mTime - currentFrame.mTime);
+		float delta = (time - currentFrame.time) / (nextFrame.time - currentFrame.time);
 
-		const aiVector3D& start = currentFrame.mValue;
-		const aiVector3D& end = nextFrame.mValue;
+		glm::vec3 start(currentFrame.x, currentFrame.y, currentFrame.z);
+		glm::vec3 end(nextFrame.x, nextFrame.y, nextFrame.z);
 
-		translation = (start + delta * (end - start));
+		translation = start + delta * (end - start);
 	}
 
-	aiMatrix4x4 mat;
-	aiMatrix4x4::Translation(translation, mat);
-	return mat;
+	return glm::translate(glm::mat4(), translation);
 }
 
-aiMatrix4x4 Animation::InterpolateRotation(float time, const aiNodeAnim * nodeAnim)
+glm::mat4 Animation::InterpolateRotation(float time, const RCAnimChannel& channel)
 {
-	aiQuaternion rotation;
+	const RCAnimQuatKey * keys = rotationKeys + channel.firstRotationKey;
+	glm::quat rotation;
 
-	if (nodeAnim->mNumRotationKeys == 1)
-	{
-		rotation = nodeAnim->mRotationKeys[0].mValue;
-	}
+	if (channel.rotationKeyCount == 1)
+		rotation = glm::quat(keys[0].w, keys[0].x, keys[0].y, keys[0].z);
 	else
 	{
-		uint32_t frameIndex = 0;
-		for (uint32_t i = 0; i < nodeAnim->mNumRotationKeys - 1; i++)
-		{
-			if (time < (float)nodeAnim->mRotationKeys[i + 1].mTime)
-			{
-				frameIndex = i;
-				break;
-			}
-		}
+		uint32_t frameIndex = FindKeyFrame(time, keys, channel.rotationKeyCount);
 
-		aiQuatKey currentFrame = nodeAnim->mRotationKeys[frameIndex];
-		aiQuatKey nextFrame = nodeAnim->mRotationKeys[(frameIndex + 1) % nodeAnim->mNumRotationKeys];
+		const RCAnimQuatKey& currentFrame = keys[frameIndex];
+		const RCAnimQuatKey& nextFrame = keys[(frameIndex + 1) % channel.rotationKeyCount];
 
-		float delta = (time - (float)currentFrame.mTime) / (float)(nextFrame.mTime - currentFrame.mTime);
+		float delta = (time - currentFrame.time) / (nextFrame.time - currentFrame.time);
 
-		const aiQuaternion& start = currentFrame.mValue;
-		const aiQuaternion& end = nextFrame.mValue;
+		glm::quat start(currentFrame.w, currentFrame.x, currentFrame.y, currentFrame.z);
+		glm::quat end(nextFrame.w, nextFrame.x, nextFrame.y, nextFrame.z);
 
-		aiQuaternion::Interpolate(rotation, start, end, delta);
-		rotation.Normalize();
+		rotation = glm::normalize(glm::slerp(start, end, delta));
 	}
 
-	aiMatrix4x4 mat(rotation.GetMatrix());
-	return mat;
+	return glm::mat4_cast(rotation);
 }
 
-aiMatrix4x4 Animation::InterpolateScale(float time, const aiNodeAnim * nodeAnim)
+glm::mat4 Animation::InterpolateScale(float time, const RCAnimChannel& channel)
 {
-	aiVector3D scale;
+	const RCAnimVectorKey * keys = scaleKeys + channel.firstScaleKey;
+	glm::vec3 scale;
 
-	if (nodeAnim->mNumScalingKeys == 1)
-	{
-		scale = nodeAnim->mScalingKeys[0].mValue;
-	}
+	if (channel.scaleKeyCount == 1)
+		scale = glm::vec3(keys[0].x, keys[0].y, keys[0].z);
 	else
 	{
-		uint32_t frameIndex = 0;
-		for (uint32_t i = 0; i < nodeAnim->mNumScalingKeys - 1; i++)
-		{
-			if (time < (float)nodeAnim->mScalingKeys[i + 1].mTime)
-			{
-				frameIndex = i;
-				break;
-			}
-		}
+		uint32_t frameIndex = FindKeyFrame(time, keys, channel.scaleKeyCount);
 
-		aiVectorKey currentFrame = nodeAnim->mScalingKeys[frameIndex];
-		aiVectorKey nextFrame = nodeAnim->mScalingKeys[(frameIndex + 1) % nodeAnim->mNumScalingKeys];
+		const RCAnimVectorKey& currentFrame = keys[frameIndex];
+		const RCAnimVectorKey& nextFrame = keys[(frameIndex + 1) % channel.scaleKeyCount];
 
-		float delta = (time - (float)currentFrame.mTime) / (float)(nextFrame.mTime - currentFrame.mTime);
+		float delta = (time - currentFrame.time) / (nextFrame.time - currentFrame.time);
 
-		const aiVector3D& start = currentFrame.mValue;
-		const aiVector3D& end = nextFrame.mValue;
+		glm::vec3 start(currentFrame.x, currentFrame.y, currentFrame.z);
+		glm::vec3 end(nextFrame.x, nextFrame.y, nextFrame.z);
 
-		scale = (start + delta * (end - start));
+		scale = start + delta * (end - start);
 	}
 
-	aiMatrix4x4 mat;
-	aiMatrix4x4::Scaling(scale, mat);
-	return mat;
-}
+	return glm::scale(glm::mat4(), scale);
+}
\ No newline at end of file
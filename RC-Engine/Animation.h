@@ -10,24 +10,31 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define MAX_BONES 64
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <string>
 #include <vector>
 #include <map>
 #include <gtc/type_ptr.hpp>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
+#include <gtc/quaternion.hpp>
+
+#include "MappedFile.h"
+#include "AnimationClipFormat.h"
 
 class Animation
 {
 	private:
-		Assimp::Importer importer;
-		const aiScene * scene;
+		MappedFile clipFile;
+		const RCAnimHeader * header;
+		const RCAnimNode * nodes;
+		const RCAnimChannel * channels;
+		const RCAnimVectorKey * positionKeys;
+		const RCAnimQuatKey * rotationKeys;
+		const RCAnimVectorKey * scaleKeys;
+
 		uint32_t numBones;
-		aiMatrix4x4 globalInverseTransform;
-		std::vector<aiMatrix4x4> boneTransforms;
+		glm::mat4 globalInverseTransform;
+		std::vector<glm::mat4> nodeTransforms;
 		std::vector<glm::mat4> boneTransformsGLM;
 
 		float runTime;
@@ -35,12 +42,9 @@ class Animation
 		bool loop;
 		bool isFinished;
 	private:
-		void ReadNodeHierarchy(float animTime, const aiNode* node, const aiMatrix4x4& parentTransform,
-			std::vector<aiMatrix4x4>& boneOffsets, std::map<std::string, uint32_t>& boneMapping);
-		const aiNodeAnim * FindNodeAnim(std::string nodeName);
-		aiMatrix4x4 InterpolateTranslation(float time, const aiNodeAnim* nodeAnim);
-		aiMatrix4x4 InterpolateRotation(float time, const aiNodeAnim* nodeAnim);
-		aiMatrix4x4 InterpolateScale(float time, const aiNodeAnim* nodeAnim);
+		glm::mat4 InterpolateTranslation(float time, const RCAnimChannel& channel);
+		glm::mat4 InterpolateRotation(float time, const RCAnimChannel& channel);
+		glm::mat4 InterpolateScale(float time, const RCAnimChannel& channel);
 	public:
 		Animation();
 		~Animation();
@@ -48,7 +52,7 @@ class Animation
 		bool Init(std::string filename, uint32_t numBones, bool loopAnim);
 		void SetAnimationSpeed(float speed);
 		void ResetAnimation();
-		void Update(float time, std::vector<aiMatrix4x4>& boneOffsets, std::map<std::string, uint32_t>& boneMapping);
+		void Update(float time, std::vector<glm::mat4>& boneOffsets);
 		std::vector<glm::mat4>& GetBoneTransforms();
 		bool IsFinished();
 };
\ No newline at end of file
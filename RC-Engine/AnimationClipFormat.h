@@ -0,0 +1,66 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: AnimationClipFormat.h                                |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+
+// Layout of a baked .rca animation clip:
+//   RCAnimHeader
+//   RCAnimNode table (nodeCount), parents always come before their children
+//   RCAnimChannel table (channelCount)
+//   position keys (positionKeyCount), rotation keys (rotationKeyCount), scale keys (scaleKeyCount)
+//
+// Only nodes that lead to a bone are kept, and bone indices are resolved against the skin the clip was baked for.
+// Matrices are stored column major, so they can be used with glm::make_mat4 directly.
+
+#define RCA_MAGIC 0x31414352
+#define RCA_VERSION 1
+
+struct RCAnimHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	float duration;
+	float ticksPerSecond;
+	uint32_t boneCount;
+	uint32_t nodeCount;
+	uint32_t channelCount;
+	uint32_t positionKeyCount;
+	uint32_t rotationKeyCount;
+	uint32_t scaleKeyCount;
+	float globalInverseTransform[16];
+};
+
+struct RCAnimNode
+{
+	int32_t parent;
+	int32_t boneIndex;
+	int32_t channelIndex;
+	float transform[16];
+};
+
+struct RCAnimChannel
+{
+	uint32_t firstPositionKey;
+	uint32_t positionKeyCount;
+	uint32_t firstRotationKey;
+	uint32_t rotationKeyCount;
+	uint32_t firstScaleKey;
+	uint32_t scaleKeyCount;
+};
+
+struct RCAnimVectorKey
+{
+	float time;
+	float x, y, z;
+};
+
+struct RCAnimQuatKey
+{
+	float time;
+	float x, y, z, w;
+};
\ No newline at end of file
@@ -0,0 +1,228 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: AssetArchive.cpp                                     |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <atomic>
+#include <vector>
+
+#include "AssetArchive.h"
+#include "LogManager.h"
+#include "ParallelFor.h"
+#include "LZ4.h"
+
+extern LogManager * gLogManager;
+
+AssetArchive::AssetArchive()
+{
+	header = NULL;
+	entries = NULL;
+	hashSlots = NULL;
+	names = NULL;
+}
+
+AssetArchive::~AssetArchive()
+{
+	names = NULL;
+	hashSlots = NULL;
+	entries = NULL;
+	header = NULL;
+}
+
+bool AssetArchive::Init(std::string filename)
+{
+	if (!archiveFile.Init(filename, false))
+		return false;
+
+	const unsigned char * data = archiveFile.GetData();
+	size_t size = archiveFile.GetSize();
+
+	if (size < sizeof(RCPakHeader))
+	{
+		gLogManager->AddMessage("ERROR: Asset archive is too small! (" + filename + ")");
+		Unload();
+		return false;
+	}
+
+	const RCPakHeader * archiveHeader = (const RCPakHeader*)data;
+	if (archiveHeader->magic != RCPAK_MAGIC || archiveHeader->version != RCPAK_VERSION)
+	{
+		gLogManager->AddMessage("ERROR: Asset archive has an unknown format or version! (" + filename + ")");
+		Unload();
+		return false;
+	}
+
+	// Make sure every table fits inside the file before using it
+	if (archiveHeader->entryTableOffset + (uint64_t)archiveHeader->entryCount * sizeof(RCPakEntry) > size ||
+		archiveHeader->hashTableOffset + (uint64_t)archiveHeader->hashSlotCount * sizeof(uint32_t) > size ||
+		archiveHeader->nameTableOffset > size || archiveHeader->hashSlotCount == 0 ||
+		(archiveHeader->hashSlotCount & (archiveHeader->hashSlotCount - 1)) != 0)
+	{
+		gLogManager->AddMessage("ERROR: Asset archive is corrupted! (" + filename + ")");
+		Unload();
+		return false;
+	}
+
+	// Every entry is checked once here, lookups and opens trust the tables afterwards
+	const RCPakEntry * archiveEntries = (const RCPakEntry*)(data + archiveHeader->entryTableOffset);
+	uint64_t nameTableSize = size - archiveHeader->nameTableOffset;
+	for (uint32_t i = 0; i < archiveHeader->entryCount; i++)
+	{
+		if (!ValidateEntry(&archiveEntries[i], size, nameTableSize))
+		{
+			gLogManager->AddMessage("ERROR: Asset archive entry " + std::to_string(i) + " is corrupted! (" + filename + ")");
+			Unload();
+			return false;
+		}
+	}
+
+	header = archiveHeader;
+	entries = archiveEntries;
+	hashSlots = (const uint32_t*)(data + header->hashTableOffset);
+	names = (const char*)(data + header->nameTableOffset);
+
+	return true;
+}
+
+void AssetArchive::Unload()
+{
+	archiveFile.Unload();
+
+	names = NULL;
+	hashSlots = NULL;
+	entries = NULL;
+	header = NULL;
+}
+
+bool AssetArchive::ValidateEntry(const RCPakEntry * entry, uint64_t archiveSize, uint64_t nameTableSize)
+{
+	if ((uint64_t)entry->nameOffset + entry->nameLength > nameTableSize)
+		return false;
+
+	if (entry->dataOffset > archiveSize || entry->storedSize > archiveSize - entry->dataOffset)
+		return false;
+
+	if (entry->compression == RCPAK_COMPRESSION_NONE)
+		return entry->originalSize <= entry->storedSize;
+
+	// Unknown compressions are reported when the file is opened
+	if (entry->compression != RCPAK_COMPRESSION_LZ4)
+		return true;
+
+	// The block size table has to fit in the entry before anything reads it
+	uint64_t expectedBlockCount = (entry->originalSize + RCPAK_BLOCK_SIZE - 1) / RCPAK_BLOCK_SIZE;
+	return entry->blockCount == expectedBlockCount && (uint64_t)entry->blockCount * sizeof(uint32_t) <= entry->storedSize;
+}
+
+const RCPakEntry * AssetArchive::FindEntry(std::string path)
+{
+	if (header == NULL)
+		return NULL;
+
+	std::string normalizedPath = RCPakNormalizePath(path);
+	uint64_t hash = RCPakHashPath(normalizedPath);
+
+	uint32_t mask = header->hashSlotCount - 1;
+	for (uint32_t probe = 0; probe < header->hashSlotCount; probe++)
+	{
+		uint32_t slot = hashSlots[(hash + probe) & mask];
+		if (slot == 0 || slot > header->entryCount)
+			return NULL;
+
+		// Compare names as well, so a hash collision can never return the wrong file
+		const RCPakEntry * entry = &entries[slot - 1];
+		if (entry->pathHash == hash && entry->nameLength == normalizedPath.size() &&
+			normalizedPath.compare(0, std::string::npos, names + entry->nameOffset, entry->nameLength) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+bool AssetArchive::DecompressEntry(const RCPakEntry * entry, unsigned char * dst)
+{
+	const unsigned char * entryData = archiveFile.GetData() + entry->dataOffset;
+	const uint32_t * blockSizes = (const uint32_t*)entryData;
+
+	// Block offsets inside the entry, each block has to end inside the entry
+	std::vector<uint64_t> blockOffsets(entry->blockCount);
+	uint64_t offset = (uint64_t)entry->blockCount * sizeof(uint32_t);
+	for (uint32_t i = 0; i < entry->blockCount; i++)
+	{
+		if (blockSizes[i] > entry->storedSize - offset)
+			return false;
+
+		blockOffsets[i] = offset;
+		offset += blockSizes[i];
+	}
+
+	std::atomic<bool> failed(false);
+	auto decodeBlock = [&](unsigned int i)
+	{
+		uint64_t blockStart = (uint64_t)i * RCPAK_BLOCK_SIZE;
+		int blockSize = (int)(entry->originalSize - blockStart < RCPAK_BLOCK_SIZE ? entry->originalSize - blockStart : RCPAK_BLOCK_SIZE);
+
+		if (blockSizes[i] == (uint32_t)blockSize)
+			memcpy(dst + blockStart, entryData + blockOffsets[i], blockSize);
+		else if (LZ4::DecompressBlock(entryData + blockOffsets[i], (int)blockSizes[i], dst + blockStart, blockSize) != blockSize)
+			failed = true;
+	};
+
+	// Blocks are independent. Small entries aren't worth starting threads for, large ones are mostly opened on the
+	// main thread and are spread across all cores.
+	if (entry->blockCount >= RCPAK_PARALLEL_BLOCK_COUNT)
+		ParallelFor(entry->blockCount, decodeBlock);
+	else
+	{
+		for (uint32_t i = 0; i < entry->blockCount; i++)
+			decodeBlock(i);
+	}
+
+	return !failed;
+}
+
+bool AssetArchive::OpenFile(std::string path, MappedFile * file)
+{
+	const RCPakEntry * entry = FindEntry(path);
+	if (entry == NULL)
+		return false;
+
+	// Uncompressed entries are handed out as views into the mapped archive
+	if (entry->compression == RCPAK_COMPRESSION_NONE)
+	{
+		file->InitFromMemory(archiveFile.GetData() + entry->dataOffset, (size_t)entry->originalSize, NULL);
+		return true;
+	}
+
+	if (entry->compression != RCPAK_COMPRESSION_LZ4)
+	{
+		gLogManager->AddMessage("ERROR: Unknown compression in asset archive! (" + path + ")");
+		return false;
+	}
+
+	unsigned char * decompressedData = new unsigned char[(size_t)entry->originalSize];
+	if (!DecompressEntry(entry, decompressedData))
+	{
+		gLogManager->AddMessage("ERROR: Failed to decompress asset archive entry! (" + path + ")");
+		delete[] decompressedData;
+		return false;
+	}
+
+	file->InitFromMemory(decompressedData, (size_t)entry->originalSize, decompressedData);
+	return true;
+}
+
+bool AssetArchive::Contains(std::string path)
+{
+	return FindEntry(path) != NULL;
+}
+
+unsigned int AssetArchive::GetFileCount()
+{
+	if (header == NULL)
+		return 0;
+
+	return header->entryCount;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: AssetArchive.h                                       |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include "MappedFile.h"
+#include "AssetArchiveFormat.h"
+
+// Compressed entries with at least this many blocks are decoded on several threads
+#define RCPAK_PARALLEL_BLOCK_COUNT 4
+
+class AssetArchive
+{
+	private:
+		MappedFile archiveFile;
+		const RCPakHeader * header;
+		const RCPakEntry * entries;
+		const uint32_t * hashSlots;
+		const char * names;
+	private:
+		bool ValidateEntry(const RCPakEntry * entry, uint64_t archiveSize, uint64_t nameTableSize);
+		const RCPakEntry * FindEntry(std::string path);
+		bool DecompressEntry(const RCPakEntry * entry, unsigned char * dst);
+	public:
+		AssetArchive();
+		~AssetArchive();
+
+		bool Init(std::string filename);
+		void Unload();
+		bool OpenFile(std::string path, MappedFile * file);
+		bool Contains(std::string path);
+		unsigned int GetFileCount();
+};
\ No newline at end of file
@@ -0,0 +1,85 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: AssetArchiveFormat.h                                 |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// Layout of a .rcpak file:
+//   RCPakHeader
+//   entry data, every entry starts on a RCPAK_PAGE_SIZE boundary so it can be used straight from a mapped view
+//   RCPakEntry table (entryCount)
+//   hash slot table (hashSlotCount, entry index + 1, 0 marks an empty slot, linear probing)
+//   name table (not null terminated, referenced by nameOffset/nameLength)
+//
+// Compressed entries start with a uint32_t array of stored block sizes followed by the blocks. Every block
+// except the last one decompresses to RCPAK_BLOCK_SIZE bytes, so blocks can be decoded independently.
+// A block whose stored size equals its decompressed size is stored raw.
+
+#define RCPAK_MAGIC 0x4B415052
+#define RCPAK_VERSION 1
+#define RCPAK_PAGE_SIZE 4096
+#define RCPAK_BLOCK_SIZE (256 * 1024)
+
+enum RCPAK_COMPRESSION
+{
+	RCPAK_COMPRESSION_NONE,
+	RCPAK_COMPRESSION_LZ4
+};
+
+struct RCPakHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t hashSlotCount;
+	uint64_t entryTableOffset;
+	uint64_t hashTableOffset;
+	uint64_t nameTableOffset;
+};
+
+struct RCPakEntry
+{
+	uint64_t pathHash;
+	uint64_t dataOffset;
+	uint64_t storedSize;
+	uint64_t originalSize;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t compression;
+	uint32_t blockCount;
+};
+
+// Paths are stored lower case with forward slashes, relative to the executable directory (data/...)
+inline std::string RCPakNormalizePath(std::string path)
+{
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		if (path[i] == '\\')
+			path[i] = '/';
+		else if (path[i] >= 'A' && path[i] <= 'Z')
+			path[i] = path[i] - 'A' + 'a';
+	}
+
+	while (path.compare(0, 2, "./") == 0)
+		path.erase(0, 2);
+
+	return path;
+}
+
+// 64-bit FNV-1a
+inline uint64_t RCPakHashPath(const std::string & normalizedPath)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < normalizedPath.size(); i++)
+	{
+		hash ^= (unsigned char)normalizedPath[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
\ No newline at end of file
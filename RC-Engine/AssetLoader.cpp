@@ -0,0 +1,190 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: AssetLoader.cpp                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "AssetLoader.h"
+#include "TextureManager.h"
+#include "LogManager.h"
+#include "StdInc.h"
+
+extern LogManager * gLogManager;
+extern TextureManager * gTextureManager;
+
+AssetLoader::AssetLoader()
+{
+	graph = NULL;
+	vulkan = NULL;
+}
+
+AssetLoader::~AssetLoader()
+{
+	graph = NULL;
+	vulkan = NULL;
+}
+
+void AssetLoader::Init(TaskGraph * graph, VulkanInterface * vulkan)
+{
+	this->graph = graph;
+	this->vulkan = vulkan;
+}
+
+void AssetLoader::Unload()
+{
+	// The graph has to be stopped first, models that never reached their callback are still owned here
+	std::lock_guard<std::mutex> lock(loaderMutex);
+
+	for (size_t i = 0; i < modelRequests.size(); i++)
+	{
+		if (!modelRequests[i].finished)
+			SAFE_UNLOAD(modelRequests[i].model, vulkan);
+	}
+	modelRequests.clear();
+
+	for (auto it = textureReads.begin(); it != textureReads.end(); it++)
+		SAFE_DELETE(it->second.file);
+	textureReads.clear();
+}
+
+TaskId AssetLoader::LoadModel(std::string filename, std::function<void(Model*)> callback)
+{
+	ModelRequest * request;
+	{
+		std::lock_guard<std::mutex> lock(loaderMutex);
+
+		ModelRequest newRequest;
+		newRequest.filename = filename;
+		newRequest.model = new Model();
+		newRequest.callback = callback;
+		newRequest.finished = false;
+		modelRequests.push_back(newRequest);
+		request = &modelRequests.back();
+	}
+
+	// Which textures the resources wait on is only known once the model file is read
+	TaskId resourceTask = graph->ReserveTask();
+
+	TaskId collisionTask = graph->AddTask(TASK_THREAD_WORKER, {}, [request]()
+	{
+		request->model->ReadCollisionFile(request->filename);
+		return TASK_RESULT_DONE;
+	});
+
+	graph->AddTask(TASK_THREAD_WORKER, {}, [this, request, collisionTask, resourceTask]()
+	{
+		return ReadModel(request, collisionTask, resourceTask);
+	});
+
+	return resourceTask;
+}
+
+TaskId AssetLoader::RequestTextureRead(std::string filename)
+{
+	std::lock_guard<std::mutex> lock(loaderMutex);
+
+	// Join the read that's already in flight
+	auto it = textureReads.find(filename);
+	if (it != textureReads.end())
+		return it->second.task;
+
+	TextureRead & read = textureReads[filename];
+	read.file = NULL;
+	read.contentHash = 0;
+
+	// The read stores its result under the lock, so it can't get there before its task id is set
+	read.task = graph->AddTask(TASK_THREAD_WORKER, {}, [this, filename]()
+	{
+		uint64_t contentHash;
+		MappedFile * file = TextureManager::MapTextureFile(filename, contentHash);
+
+		std::lock_guard<std::mutex> lock(loaderMutex);
+		TextureRead & read = textureReads[filename];
+		read.file = file;
+		read.contentHash = contentHash;
+
+		return TASK_RESULT_DONE;
+	});
+
+	return read.task;
+}
+
+TASK_RESULT AssetLoader::ReadModel(ModelRequest * request, TaskId collisionTask, TaskId resourceTask)
+{
+	if (!request->model->ReadRCMFile(request->filename))
+	{
+		gLogManager->AddMessage("ERROR: Failed to read model: " + request->filename);
+		return TASK_RESULT_FAILED;
+	}
+
+	std::vector<std::string> textureFilenames;
+	request->model->GetTextureFilenames(textureFilenames);
+
+	// The texture manager is only used from the main thread, that's where it's asked which textures it already has
+	graph->AddTask(TASK_THREAD_MAIN, {}, [this, request, textureFilenames, collisionTask, resourceTask]()
+	{
+		return RequestTextureReads(request, textureFilenames, collisionTask, resourceTask);
+	});
+
+	return TASK_RESULT_DONE;
+}
+
+TASK_RESULT AssetLoader::RequestTextureReads(ModelRequest * request, std::vector<std::string> textureFilenames, TaskId collisionTask,
+	TaskId resourceTask)
+{
+	std::vector<std::pair<std::string, TaskId>> textures;
+	std::vector<TaskId> dependencies;
+	dependencies.push_back(collisionTask);
+	for (size_t i = 0; i < textureFilenames.size(); i++)
+	{
+		// Textures that are loaded or cached are picked up by RequestTexture when the resources are created
+		if (gTextureManager->HasTexture(textureFilenames[i]))
+			continue;
+
+		TaskId textureTask = RequestTextureRead(textureFilenames[i]);
+		textures.push_back(std::make_pair(textureFilenames[i], textureTask));
+		dependencies.push_back(textureTask);
+	}
+
+	graph->SetTask(resourceTask, TASK_THREAD_MAIN, dependencies, [this, request, textures]()
+	{
+		return InitModelResources(request, textures);
+	});
+
+	return TASK_RESULT_DONE;
+}
+
+TASK_RESULT AssetLoader::InitModelResources(ModelRequest * request, std::vector<std::pair<std::string, TaskId>> textures)
+{
+	{
+		std::lock_guard<std::mutex> lock(loaderMutex);
+
+		// Hand the finished reads to the texture manager. An entry with another task is a newer read of the same
+		// file, started after another model already took the one this model waited on.
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			auto it = textureReads.find(textures[i].first);
+			if (it == textureReads.end() || it->second.task != textures[i].second)
+				continue;
+
+			if (it->second.file != NULL)
+				gTextureManager->AddPrefetchedTexture(it->first, it->second.file, it->second.contentHash);
+			textureReads.erase(it);
+		}
+	}
+
+	if (!request->model->InitResources(vulkan))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init model: " + request->filename);
+		return TASK_RESULT_FAILED;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(loaderMutex);
+		request->finished = true;
+	}
+	request->callback(request->model);
+
+	return TASK_RESULT_DONE;
+}
\ No newline at end of file
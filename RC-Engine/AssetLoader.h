@@ -0,0 +1,60 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: AssetLoader.h                                        |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+
+#include "Model.h"
+#include "TaskGraph.h"
+
+// Loads models as tasks of a task graph. The model file, its collision file and every texture it uses are read on
+// worker threads, the GPU resources are created on the render thread once all of them are done. Textures the texture
+// manager already has aren't read at all, and a texture asked for by several models while it's being read is read only
+// once, all of them wait on the same task.
+class AssetLoader
+{
+	private:
+		struct TextureRead
+		{
+			TaskId task;
+			MappedFile * file;
+			uint64_t contentHash;
+		};
+		struct ModelRequest
+		{
+			std::string filename;
+			Model * model;
+			std::function<void(Model*)> callback;
+			bool finished;
+		};
+
+		TaskGraph * graph;
+		VulkanInterface * vulkan;
+
+		std::mutex loaderMutex;
+		// Texture reads that haven't been handed to the texture manager yet
+		std::unordered_map<std::string, TextureRead> textureReads;
+		std::deque<ModelRequest> modelRequests;
+	private:
+		TaskId RequestTextureRead(std::string filename);
+		TASK_RESULT ReadModel(ModelRequest * request, TaskId collisionTask, TaskId resourceTask);
+		TASK_RESULT RequestTextureReads(ModelRequest * request, std::vector<std::string> textureFilenames, TaskId collisionTask,
+			TaskId resourceTask);
+		TASK_RESULT InitModelResources(ModelRequest * request, std::vector<std::pair<std::string, TaskId>> textures);
+	public:
+		AssetLoader();
+		~AssetLoader();
+
+		void Init(TaskGraph * graph, VulkanInterface * vulkan);
+		void Unload();
+		TaskId LoadModel(std::string filename, std::function<void(Model*)> callback);
+};
\ No newline at end of file
@@ -7,55 +7,58 @@
 
 #include "BufferManager.h"
 #include "StdInc.h"
+#include "XXHash.h"
 
-VulkanBuffer * BufferManager::RequestBuffer(std::string bufferName, VulkanDevice * device, VkBufferUsageFlags usage, const void * dataPtr,
-	VkDeviceSize dataSize, bool useStaging, VulkanCommandBuffer * cmdBuffer)
+extern StagingManager * gStagingManager;
+
+void BufferManager::SetBudget(VkDeviceSize budget)
 {
-	// Check if buffer is already loaded
-	for (unsigned int i = 0; i < buffersLoaded.size(); i++)
-	{
-		if (bufferName == buffersLoaded[i].bufferName)
-		{
-			buffersLoaded[i].useCount++;
-			return buffersLoaded[i].bufferPtr;
-		}
-	}
+	buffers.SetBudget(budget);
+}
+
+void BufferManager::Unload(VulkanDevice * device)
+{
+	buffers.Clear(device);
+}
+
+ResourceHandle BufferManager::RequestBuffer(uint64_t contentHash, VulkanDevice * device, VkBufferUsageFlags usage, const void * dataPtr,
+	VkDeviceSize dataSize, bool useStaging)
+{
+	// Buffers are shared by content, so identical data under different asset names is only uploaded once
+	uint64_t keyData[3] = { contentHash, (uint64_t)usage, (uint64_t)dataSize };
+	uint64_t key = XXHash::Hash64(keyData, sizeof(keyData));
+
+	ResourceHandle handle = buffers.Acquire(key);
+	if (handle.IsValid())
+		return handle;
 
 	// If buffer is not loaded, create new entry
 	VulkanBuffer * buffer = new VulkanBuffer();
-	if (!buffer->Init(device, usage, dataPtr, dataSize, useStaging, cmdBuffer))
-		return nullptr;
+	if (!buffer->Init(device, usage, dataPtr, dataSize, useStaging, gStagingManager))
+	{
+		SAFE_UNLOAD(buffer, device);
+		return ResourceHandle();
+	}
+
+	handle = buffers.Add(key, buffer, buffer->GetMemorySize());
 
-	BufferEntry entry;
-	entry.bufferName = bufferName;
-	entry.bufferPtr = buffer;
-	entry.useCount = 1;
-	buffersLoaded.push_back(entry);
+	// Make room for the new buffer by dropping unused ones if needed
+	buffers.Evict(device);
 
-	return buffer;
+	return handle;
 }
 
-void BufferManager::ReleaseBuffer(VulkanBuffer * buffer, VulkanDevice * device)
+VulkanBuffer * BufferManager::GetBuffer(ResourceHandle handle)
 {
-	for (unsigned int i = 0; i < buffersLoaded.size(); i++)
-	{
-		if (buffer == buffersLoaded[i].bufferPtr)
-		{
-			if (buffersLoaded[i].useCount > 1)
-				buffersLoaded[i].useCount--;
-			else
-			{
-				SAFE_UNLOAD(buffersLoaded[i].bufferPtr, device);
-				buffersLoaded.erase(buffersLoaded.begin() + i);
-			}
-
-			buffer = nullptr;
-			break;
-		}
-	}
+	return buffers.Get(handle);
 }
 
-size_t BufferManager::GetLoadedBuffersCount()
+void BufferManager::ReleaseBuffer(ResourceHandle handle, VulkanDevice * device)
 {
-	return buffersLoaded.size();
+	buffers.Release(handle, device);
 }
+
+size_t BufferManager::GetLoadedBuffersCount()
+{
+	return buffers.GetResidentCount();
+}
\ No newline at end of file
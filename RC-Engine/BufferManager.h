@@ -6,23 +6,20 @@
 ==========================================================================================*/
 #pragma once
 
-#include <vector>
-#include <string>
 #include "VulkanBuffer.h"
+#include "ResourceRegistry.h"
 
 class BufferManager
 {
 	private:
-		struct BufferEntry
-		{
-			std::string bufferName;
-			VulkanBuffer * bufferPtr;
-			unsigned int useCount;
-		};
-		std::vector<BufferEntry> buffersLoaded;
+		// Buffers are keyed by the hash of their contents, combined with their usage
+		ResourceRegistry<VulkanBuffer> buffers;
 	public:
-		VulkanBuffer * RequestBuffer(std::string bufferName, VulkanDevice * device, VkBufferUsageFlags usage, const void * dataPtr,
-			VkDeviceSize dataSize, bool useStaging, VulkanCommandBuffer * cmdBuffer = 0);
-		void ReleaseBuffer(VulkanBuffer * buffer, VulkanDevice * device);
+		void SetBudget(VkDeviceSize budget);
+		void Unload(VulkanDevice * device);
+		ResourceHandle RequestBuffer(uint64_t contentHash, VulkanDevice * device, VkBufferUsageFlags usage, const void * dataPtr,
+			VkDeviceSize dataSize, bool useStaging);
+		VulkanBuffer * GetBuffer(ResourceHandle handle);
+		void ReleaseBuffer(ResourceHandle handle, VulkanDevice * device);
 		size_t GetLoadedBuffersCount();
 };
\ No newline at end of file
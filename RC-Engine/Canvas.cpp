@@ -8,13 +8,19 @@
 #include "Canvas.h"
 #include "StdInc.h"
 #include "Settings.h"
+#include "LogManager.h"
+#include "UniformRing.h"
 
 extern Settings * gSettings;
+extern LogManager * gLogManager;
+extern UniformRing * gUniformRing;
 
 Canvas::Canvas()
 {
 	vertexBuffer = NULL;
-	vsUBO = NULL;
+	descriptorSet = VK_NULL_HANDLE;
+	descriptorSetPipeline = NULL;
+	descriptorImageView = VK_NULL_HANDLE;
 
 	posX = posY = 0.0f;
 	width = height = 0.25f;
@@ -24,7 +30,7 @@ Canvas::~Canvas()
 {
 	delete[] vertexData;
 
-	vsUBO = NULL;
+	descriptorSetPipeline = NULL;
 	vertexBuffer = NULL;
 }
 
@@ -42,15 +48,9 @@ bool Canvas::Init(VulkanInterface * vulkan)
 	if (!vertexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexData, sizeof(Vertex) * vertexCount, false))
 		return false;
 
-	// Uniform inits
+	// Uniform inits, the data goes to the uniform ring when the canvas is drawn
 	vertexUniformBuffer.MVP = glm::mat4();
 
-	// Vertex shader Uniform buffer
-	vsUBO = new VulkanBuffer();
-	if (!vsUBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &vertexUniformBuffer,
-		sizeof(vertexUniformBuffer), false))
-		return false;
-
 	// Init draw command buffers
 	for (size_t i = 0; i < vulkan->GetVulkanSwapchain()->GetSwapchainBufferCount(); i++)
 	{
@@ -70,7 +70,10 @@ void Canvas::Unload(VulkanInterface * vulkan)
 	for (size_t i = 0; i < vulkan->GetVulkanSwapchain()->GetSwapchainBufferCount(); i++)
 		SAFE_UNLOAD(drawCmdBuffers[i], vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
 
-	SAFE_UNLOAD(vsUBO, vulkan->GetVulkanDevice());
+	if (descriptorSet != VK_NULL_HANDLE)
+		descriptorSetPipeline->FreeDescriptorSet(vulkan->GetVulkanDevice(), descriptorSet);
+	descriptorSet = VK_NULL_HANDLE;
+
 	SAFE_UNLOAD(vertexBuffer, vulkan->GetVulkanDevice());
 }
 
@@ -85,18 +88,32 @@ void Canvas::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffe
 		updateVertexBuffer = false;
 	}
 
-	UpdateDescriptorSet(vulkan, vulkanPipeline, imageView);
-
 	// Update vertex uniform buffer
 	vertexUniformBuffer.MVP = orthoMatrix;
 
-	vsUBO->Update(vulkan->GetVulkanDevice(), &vertexUniformBuffer, sizeof(vertexUniformBuffer));
+	uint32_t vertexOffset;
+	if (!gUniformRing->Allocate(&vertexUniformBuffer, sizeof(vertexUniformBuffer), &vertexOffset))
+		return;
+
+	if (descriptorSet == VK_NULL_HANDLE)
+	{
+		if (!vulkanPipeline->AllocateDescriptorSet(vulkan->GetVulkanDevice(), &descriptorSet))
+		{
+			gLogManager->AddMessage("ERROR: Failed to allocate a canvas descriptor set!");
+			descriptorSet = VK_NULL_HANDLE;
+			return;
+		}
+		descriptorSetPipeline = vulkanPipeline;
+		UpdateDescriptorSet(vulkan, vulkanPipeline, imageView);
+	}
+	else if (descriptorImageView != *imageView)
+		UpdateDescriptorSet(vulkan, vulkanPipeline, imageView);
 
 	// Draw
 	drawCmdBuffers[frameBufferId]->BeginRecordingSecondary(vulkan->GetForwardRenderpass()->GetRenderpass(), vulkan->GetVulkanSwapchain()->GetFramebuffer((int)frameBufferId));
 	vulkan->InitViewportAndScissors(drawCmdBuffers[frameBufferId], (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
 		(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
-	vulkanPipeline->SetActive(drawCmdBuffers[frameBufferId]);
+	vulkanPipeline->SetActive(drawCmdBuffers[frameBufferId], descriptorSet, 1, &vertexOffset);
 
 	VkDeviceSize offsets[1] = { 0 };
 	vkCmdBindVertexBuffers(drawCmdBuffers[frameBufferId]->GetCommandBuffer(), 0, 1, vertexBuffer->GetBuffer(), offsets);
@@ -124,6 +141,11 @@ void Canvas::SetDimensions(float width, float height)
 	this->height = height;
 }
 
+VkDeviceSize Canvas::GetFrameUniformSize()
+{
+	return gUniformRing->GetAllocationSize(sizeof(vertexUniformBuffer));
+}
+
 void Canvas::UpdateVertexData()
 {
 	// Bottom right
@@ -171,32 +193,23 @@ void Canvas::UpdateVertexData()
 
 void Canvas::UpdateDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline, VkImageView * imageView)
 {
-	VkWriteDescriptorSet write[2];
-
-	write[0] = {};
-	write[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	write[0].pNext = NULL;
-	write[0].dstSet = vulkanPipeline->GetDescriptorSet();
-	write[0].descriptorCount = 1;
-	write[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	write[0].pBufferInfo = vsUBO->GetBufferInfo();
-	write[0].dstArrayElement = 0;
-	write[0].dstBinding = 0;
+	VkWriteDescriptorSet write[1];
 
 	VkDescriptorImageInfo positionTextureDesc{};
 	positionTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 	positionTextureDesc.imageView = *imageView;
 	positionTextureDesc.sampler = vulkan->GetColorSampler();
 
-	write[1] = {};
-	write[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	write[1].pNext = NULL;
-	write[1].dstSet = vulkanPipeline->GetDescriptorSet();
-	write[1].descriptorCount = 1;
-	write[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[1].pImageInfo = &positionTextureDesc;
-	write[1].dstArrayElement = 0;
-	write[1].dstBinding = 1;
+	write[0] = {};
+	write[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write[0].pNext = NULL;
+	write[0].dstSet = descriptorSet;
+	write[0].descriptorCount = 1;
+	write[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write[0].pImageInfo = &positionTextureDesc;
+	write[0].dstArrayElement = 0;
+	write[0].dstBinding = 1;
 
 	vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(write) / sizeof(write[0]), write, 0, NULL);
+	descriptorImageView = *imageView;
 }
\ No newline at end of file
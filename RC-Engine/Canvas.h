@@ -25,7 +25,12 @@ class Canvas
 		};
 		VertexUniformBuffer vertexUniformBuffer;
 
-		VulkanBuffer * vsUBO;
+		// Every canvas has its own set for its image, written again only when it's drawn with another one. The uniform
+		// data is read through the frame set of the pipeline.
+		VkDescriptorSet descriptorSet;
+		VulkanPipeline * descriptorSetPipeline;
+		VkImageView descriptorImageView;
+
 		VulkanBuffer * vertexBuffer;
 		Vertex * vertexData;
 
@@ -46,4 +51,5 @@ class Canvas
 			glm::mat4 orthoMatrix, VkImageView * imageView, int frameBufferId);
 		void SetPosition(float x, float y);
 		void SetDimensions(float width, float height);
+		VkDeviceSize GetFrameUniformSize();
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: CollisionFormat.h                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+
+// Layout of a cooked .rcc collision file:
+//   RCCollisionHeader
+//   welded vertices (vertexCount * 3 floats)
+//   triangle indices (triangleCount * 3 int32_t)
+//   serialized btOptimizedBvh at bvhOffset (RCC_BVH_ALIGNMENT aligned, bvhSize bytes)
+//
+// The BVH is written with btOptimizedBvh::serializeInPlace, its layout depends on the pointer size of the
+// cooking tool. When it doesn't match the engine, the BVH is rebuilt from the indexed mesh at load time.
+// A missing or outdated .rcc falls back to the source .col file with a warning.
+
+#define RCC_MAGIC 0x31434352
+#define RCC_VERSION 1
+#define RCC_BVH_ALIGNMENT 16
+
+struct RCCollisionHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+	float aabbMin[3];
+	float aabbMax[3];
+	uint32_t bvhPointerSize;
+	uint32_t bvhSize;
+	uint64_t bvhOffset;
+};
\ No newline at end of file
@@ -0,0 +1,126 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: CommandRecorder.cpp                                  |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "CommandRecorder.h"
+#include "LogManager.h"
+#include "StdInc.h"
+#include "UniformRing.h"
+
+extern LogManager * gLogManager;
+
+CommandRecorder::CommandRecorder()
+{
+	threadCount = 0;
+	nextThread = 0;
+	recordFunc = NULL;
+	generation = 0;
+	pendingCount = 0;
+	running = false;
+}
+
+CommandRecorder::~CommandRecorder()
+{
+	recordFunc = NULL;
+}
+
+bool CommandRecorder::Init(VulkanDevice * vulkanDevice)
+{
+	threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+	if (threadCount > COMMAND_RECORDER_MAX_THREADS)
+		threadCount = COMMAND_RECORDER_MAX_THREADS;
+
+	for (unsigned int i = 0; i < threadCount * UNIFORM_RING_FRAME_COUNT; i++)
+	{
+		VulkanCommandPool * commandPool = new VulkanCommandPool();
+		if (!commandPool->Init(vulkanDevice))
+		{
+			gLogManager->AddMessage("ERROR: Failed to create a recording command pool!");
+			SAFE_DELETE(commandPool);
+			return false;
+		}
+		commandPools.push_back(commandPool);
+	}
+
+	// Thread 0 is the render thread itself
+	running = true;
+	for (unsigned int i = 1; i < threadCount; i++)
+		workers.push_back(std::thread(&CommandRecorder::WorkerThread, this, i));
+
+	return true;
+}
+
+void CommandRecorder::Unload(VulkanDevice * vulkanDevice)
+{
+	{
+		std::lock_guard<std::mutex> lock(recordMutex);
+		running = false;
+	}
+	startCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+	workers.clear();
+
+	for (size_t i = 0; i < commandPools.size(); i++)
+		SAFE_UNLOAD(commandPools[i], vulkanDevice);
+	commandPools.clear();
+}
+
+void CommandRecorder::WorkerThread(unsigned int threadId)
+{
+	uint32_t lastGeneration = 0;
+
+	std::unique_lock<std::mutex> lock(recordMutex);
+	while (true)
+	{
+		startCondition.wait(lock, [&]() { return !running || generation != lastGeneration; });
+		if (!running)
+			return;
+		lastGeneration = generation;
+
+		lock.unlock();
+		(*recordFunc)(threadId);
+		lock.lock();
+
+		if (--pendingCount == 0)
+			doneCondition.notify_one();
+	}
+}
+
+unsigned int CommandRecorder::AssignThread()
+{
+	return nextThread++ % threadCount;
+}
+
+VulkanCommandPool * CommandRecorder::GetCommandPool(unsigned int threadId, uint32_t frameIndex)
+{
+	return commandPools[threadId * UNIFORM_RING_FRAME_COUNT + frameIndex];
+}
+
+unsigned int CommandRecorder::GetThreadCount()
+{
+	return threadCount;
+}
+
+void CommandRecorder::Record(const std::function<void(unsigned int)> & func)
+{
+	{
+		std::lock_guard<std::mutex> lock(recordMutex);
+		recordFunc = &func;
+		pendingCount = (unsigned int)workers.size();
+		generation++;
+	}
+	startCondition.notify_all();
+
+	func(0);
+
+	std::unique_lock<std::mutex> lock(recordMutex);
+	doneCondition.wait(lock, [&]() { return pendingCount == 0; });
+	recordFunc = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: CommandRecorder.h                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+#include "VulkanInterface.h"
+
+#define COMMAND_RECORDER_MAX_THREADS 8
+
+// Threads that record secondary command buffers for the render thread. Every thread has its own command pool for each
+// uniform ring slice, command buffers are only ever recorded by the thread that owns their pool.
+class CommandRecorder
+{
+	private:
+		std::vector<std::thread> workers;
+		// threadCount * UNIFORM_RING_FRAME_COUNT pools, the pools of one thread are next to each other
+		std::vector<VulkanCommandPool*> commandPools;
+		unsigned int threadCount;
+		std::atomic<unsigned int> nextThread;
+
+		std::mutex recordMutex;
+		std::condition_variable startCondition;
+		std::condition_variable doneCondition;
+		const std::function<void(unsigned int)> * recordFunc;
+		uint32_t generation;
+		unsigned int pendingCount;
+		bool running;
+	private:
+		void WorkerThread(unsigned int threadId);
+	public:
+		CommandRecorder();
+		~CommandRecorder();
+
+		bool Init(VulkanDevice * vulkanDevice);
+		void Unload(VulkanDevice * vulkanDevice);
+		// Round robin, so the objects drawn in a frame end up spread over all threads
+		unsigned int AssignThread();
+		VulkanCommandPool * GetCommandPool(unsigned int threadId, uint32_t frameIndex);
+		unsigned int GetThreadCount();
+		// Calls func(threadId) once on every thread, thread 0 being the calling one, and returns when all are done
+		void Record(const std::function<void(unsigned int)> & func);
+};
\ No newline at end of file
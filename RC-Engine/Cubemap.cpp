@@ -6,10 +6,17 @@
 ==========================================================================================*/
 
 #include <vector>
+#include <fstream>
+#include <algorithm>
 
 #include "Cubemap.h"
 #include "LogManager.h"
 #include "VulkanTools.h"
+#include "TextureFormat.h"
+#include "TextureTranscoder.h"
+#include "CubemapFilter.h"
+#include "ParallelFor.h"
+#include "XXHash.h"
 
 extern LogManager * gLogManager;
 
@@ -18,6 +25,9 @@ Cubemap::Cubemap()
 	textureImage = VK_NULL_HANDLE;
 	textureMemory = VK_NULL_HANDLE;
 	textureImageView = VK_NULL_HANDLE;
+	faceSize = 0;
+	mipMapLevels = 0;
+	memset(irradiance, 0, sizeof(irradiance));
 }
 
 Cubemap::~Cubemap()
@@ -27,200 +37,307 @@ Cubemap::~Cubemap()
 	textureImage = VK_NULL_HANDLE;
 }
 
-bool Cubemap::ReadCubeFace(std::string filename, std::vector<MipMap>& faceData)
+bool Cubemap::ReadCubeFace(MappedFile * file, std::vector<unsigned char> & faceData, std::vector<MipMap> & faceLevels)
 {
-	FILE * file = fopen(filename.c_str(), "rb");
-	if (file == NULL)
+	uint32_t format, flags;
+	std::vector<RCTextureLevel> levels;
+	if (!ReadTextureLevels(file->GetData(), file->GetSize(), format, flags, levels))
+		return false;
+
+	// The filter works on RGBA8, block compressed color faces are decoded first
+	bool decode = format != RCT_FORMAT_R8G8B8A8_UNORM;
+	if ((flags & RCT_FLAG_GRAYSCALE) || (decode && TextureTranscoder::GetDecodedFormat(format) != RCT_FORMAT_R8G8B8A8_UNORM))
 	{
-		gLogManager->AddMessage("ERROR: Texture file not found! (" + filename + ")");
+		gLogManager->AddMessage("ERROR: Cubemap faces must be color textures!");
 		return false;
 	}
 
-	// Read original image (as mipmap level 0)
-	MipMap originalImage;
-	fread(&originalImage.width, sizeof(unsigned int), 1, file);
-	fread(&originalImage.height, sizeof(unsigned int), 1, file);
-	fread(&originalImage.size, sizeof(unsigned int), 1, file);
-
-	originalImage.data = new unsigned char[originalImage.size];
-	fread(originalImage.data, sizeof(unsigned char), originalImage.size, file);
-	faceData.push_back(originalImage);
-
-	// Read mipmaps
-	int mipMapsCount;
-	fread(&mipMapsCount, sizeof(int), 1, file);
+	size_t decodedSize = 0;
+	for (unsigned int i = 0; i < levels.size() && decode; i++)
+		decodedSize += GetTextureLevelSize(RCT_FORMAT_R8G8B8A8_UNORM, levels[i].width, levels[i].height);
+	faceData.resize(decodedSize);
 
-	for (int i = 0; i < mipMapsCount; i++)
+	size_t offset = 0;
+	for (unsigned int i = 0; i < levels.size(); i++)
 	{
 		MipMap mipMap;
-		fread(&mipMap.width, sizeof(int), 1, file);
-		fread(&mipMap.height, sizeof(int), 1, file);
-		fread(&mipMap.size, sizeof(unsigned int), 1, file);
+		mipMap.width = levels[i].width;
+		mipMap.height = levels[i].height;
+		mipMap.size = (uint32_t)GetTextureLevelSize(RCT_FORMAT_R8G8B8A8_UNORM, levels[i].width, levels[i].height);
+		mipMap.data = file->GetData() + levels[i].offset;
 
-		mipMap.data = new unsigned char[mipMap.size];
-		fread(mipMap.data, sizeof(unsigned char), mipMap.size, file);
+		if (decode)
+		{
+			if (!TextureTranscoder::DecodeLevel(format, mipMap.data, mipMap.width, mipMap.height, faceData.data() + offset))
+			{
+				gLogManager->AddMessage("ERROR: Cubemap face has blocks that can't be decoded!");
+				return false;
+			}
+			mipMap.data = faceData.data() + offset;
+			offset += mipMap.size;
+		}
 
-		faceData.push_back(mipMap);
+		faceLevels.push_back(mipMap);
 	}
 
-	fclose(file);
+	return true;
+}
 
-	if (mipMapLevels == -1)
-		mipMapLevels = (uint32_t)faceData.size();
-	else
+size_t Cubemap::GetFilteredLevelOffsets(std::vector<size_t> & offsets)
+{
+	// Same layout in memory as in the cache file, the header included
+	size_t offset = sizeof(RCFilteredCubemapHeader);
+	for (int face = 0; face < 6; face++)
 	{
-		if (faceData.size() != mipMapLevels)
+		for (uint32_t level = 0; level < mipMapLevels; level++)
 		{
-			gLogManager->AddMessage("ERROR: Every cubemap face must have the same width, height and mipmaps!");
-			return false;
+			uint32_t levelSize = std::max(faceSize >> level, 1u);
+			offset = (offset + RCT_LEVEL_ALIGNMENT - 1) & ~(size_t)(RCT_LEVEL_ALIGNMENT - 1);
+			offsets.push_back(offset);
+			offset += GetTextureLevelSize(RCT_FORMAT_R8G8B8A8_UNORM, levelSize, levelSize);
 		}
 	}
 
-	return true;
+	return offset;
 }
 
-bool Cubemap::Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::string cubemapDir)
+bool Cubemap::ReadCache(std::string filename, uint64_t sourceHash)
 {
-	VkResult result;
-	void * pData;
-	mipMapLevels = -1;
-
-	std::vector<MipMap> mipMapsRight;
-	std::vector<MipMap> mipMapsLeft;
-	std::vector<MipMap> mipMapsTop;
-	std::vector<MipMap> mipMapsBottom;
-	std::vector<MipMap> mipMapsBack;
-	std::vector<MipMap> mipMapsFront;
-
-	// Read each cube face
-	if (!ReadCubeFace(cubemapDir + "/right.rct", mipMapsRight))
-		return false;
-	if (!ReadCubeFace(cubemapDir + "/left.rct", mipMapsLeft))
-		return false;
-	if (!ReadCubeFace(cubemapDir + "/up.rct", mipMapsTop))
-		return false;
-	if (!ReadCubeFace(cubemapDir + "/down.rct", mipMapsBottom))
-		return false;
-	if (!ReadCubeFace(cubemapDir + "/back.rct", mipMapsBack))
-		return false;
-	if (!ReadCubeFace(cubemapDir + "/front.rct", mipMapsFront))
+	// The cache is written next to the faces, it's never looked for in the archives
+	if (!cacheFile.Init(filename, false))
 		return false;
 
-	unsigned int totalTextureSize = 0;
-	for (unsigned int i = 0; i < mipMapsRight.size(); i++)
-		totalTextureSize += mipMapsRight[i].size;
-	for (unsigned int i = 0; i < mipMapsLeft.size(); i++)
-		totalTextureSize += mipMapsLeft[i].size;
-	for (unsigned int i = 0; i < mipMapsTop.size(); i++)
-		totalTextureSize += mipMapsTop[i].size;
-	for (unsigned int i = 0; i < mipMapsBottom.size(); i++)
-		totalTextureSize += mipMapsBottom[i].size;
-	for (unsigned int i = 0; i < mipMapsBack.size(); i++)
-		totalTextureSize += mipMapsBack[i].size;
-	for (unsigned int i = 0; i < mipMapsFront.size(); i++)
-		totalTextureSize += mipMapsFront[i].size;
-
-	// Create an array of bits which stores all of the texture data
-	std::vector<unsigned char> textureData;
-	for (unsigned int i = 0; i < mipMapsRight.size(); i++)
-		for (unsigned int j = 0; j < mipMapsRight[i].size; j++)
-			textureData.push_back(mipMapsRight[i].data[j]);
-	for (unsigned int i = 0; i < mipMapsLeft.size(); i++)
-		for (unsigned int j = 0; j < mipMapsLeft[i].size; j++)
-			textureData.push_back(mipMapsLeft[i].data[j]);
-	for (unsigned int i = 0; i < mipMapsTop.size(); i++)
-		for (unsigned int j = 0; j < mipMapsTop[i].size; j++)
-			textureData.push_back(mipMapsTop[i].data[j]);
-	for (unsigned int i = 0; i < mipMapsBottom.size(); i++)
-		for (unsigned int j = 0; j < mipMapsBottom[i].size; j++)
-			textureData.push_back(mipMapsBottom[i].data[j]);
-	for (unsigned int i = 0; i < mipMapsBack.size(); i++)
-		for (unsigned int j = 0; j < mipMapsBack[i].size; j++)
-			textureData.push_back(mipMapsBack[i].data[j]);
-	for (unsigned int i = 0; i < mipMapsFront.size(); i++)
-		for (unsigned int j = 0; j < mipMapsFront[i].size; j++)
-			textureData.push_back(mipMapsFront[i].data[j]);
-
-	for (int i = 0; i < mipMapsRight.size(); i++)
-		delete[] mipMapsRight[i].data;
-	for (int i = 0; i < mipMapsLeft.size(); i++)
-		delete[] mipMapsLeft[i].data;
-	for (int i = 0; i < mipMapsTop.size(); i++)
-		delete[] mipMapsTop[i].data;
-	for (int i = 0; i < mipMapsBottom.size(); i++)
-		delete[] mipMapsBottom[i].data;
-	for (int i = 0; i < mipMapsBack.size(); i++)
-		delete[] mipMapsBack[i].data;
-	for (int i = 0; i < mipMapsFront.size(); i++)
-		delete[] mipMapsFront[i].data;
-
-	VkMemoryRequirements memReq{};
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingMemory;
-
-	VkBufferCreateInfo bufferCI{};
-	bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferCI.size = totalTextureSize;
-	bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	result = vkCreateBuffer(device->GetDevice(), &bufferCI, VK_NULL_HANDLE, &stagingBuffer);
-	if (result != VK_SUCCESS)
+	RCFilteredCubemapHeader header;
+	if (!cacheFile.Read(&header, sizeof(RCFilteredCubemapHeader)) || header.magic != RCF_MAGIC || header.version != RCF_VERSION ||
+		header.sampleCount != CUBEMAP_FILTER_SAMPLE_COUNT || header.sourceHash != sourceHash || header.size == 0 ||
+		header.levelCount == 0 || header.levelCount > RCT_MAX_LEVELS)
+	{
+		cacheFile.Unload();
 		return false;
+	}
 
-	vkGetBufferMemoryRequirements(device->GetDevice(), stagingBuffer, &memReq);
+	faceSize = header.size;
+	mipMapLevels = header.levelCount;
+	memcpy(irradiance, header.irradiance, sizeof(irradiance));
 
-	allocInfo.allocationSize = memReq.size;
-	if (!device->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &allocInfo.memoryTypeIndex))
+	std::vector<size_t> offsets;
+	if (GetFilteredLevelOffsets(offsets) > cacheFile.GetSize())
+	{
+		cacheFile.Unload();
 		return false;
+	}
 
-	result = vkAllocateMemory(device->GetDevice(), &allocInfo, VK_NULL_HANDLE, &stagingMemory);
-	if (result != VK_SUCCESS)
-		return false;
+	for (int face = 0; face < 6; face++)
+	{
+		faceMipMaps[face].clear();
+		for (uint32_t level = 0; level < mipMapLevels; level++)
+		{
+			MipMap mipMap;
+			mipMap.width = mipMap.height = std::max(faceSize >> level, 1u);
+			mipMap.size = (uint32_t)GetTextureLevelSize(RCT_FORMAT_R8G8B8A8_UNORM, mipMap.width, mipMap.height);
+			mipMap.data = cacheFile.GetData() + offsets[face * mipMapLevels + level];
+			faceMipMaps[face].push_back(mipMap);
+		}
+	}
 
-	result = vkBindBufferMemory(device->GetDevice(), stagingBuffer, stagingMemory, 0);
-	if (result != VK_SUCCESS)
-		return false;
+	return true;
+}
 
-	result = vkMapMemory(device->GetDevice(), stagingMemory, 0, memReq.size, 0, &pData);
-	if (result != VK_SUCCESS)
-		return false;
+void Cubemap::WriteCache(std::string filename, uint64_t sourceHash)
+{
+	RCFilteredCubemapHeader header;
+	header.magic = RCF_MAGIC;
+	header.version = RCF_VERSION;
+	header.size = faceSize;
+	header.levelCount = mipMapLevels;
+	header.sampleCount = CUBEMAP_FILTER_SAMPLE_COUNT;
+	header.reserved = 0;
+	header.sourceHash = sourceHash;
+	memcpy(header.irradiance, irradiance, sizeof(irradiance));
+	memcpy(filteredData.data(), &header, sizeof(RCFilteredCubemapHeader));
+
+	// Write to a temporary file first, so a crash while saving can't leave a half written cache behind
+	std::string tempFilename = filename + ".tmp";
+
+	std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+	if (file.is_open() == false)
+	{
+		gLogManager->AddMessage("WARNING: Failed to save prefiltered cubemap! (" + filename + ")");
+		return;
+	}
+
+	file.write((const char*)filteredData.data(), filteredData.size());
+	bool writeFailed = file.fail();
+	file.close();
+
+	if (writeFailed || !MoveFileEx(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFile(tempFilename.c_str());
+		gLogManager->AddMessage("WARNING: Failed to save prefiltered cubemap! (" + filename + ")");
+	}
+}
+
+bool Cubemap::Init(VulkanDevice * device, StagingManager * stagingManager, std::string cubemapDir)
+{
+	return ReadFiles(cubemapDir) && InitResources(device, stagingManager);
+}
+
+bool Cubemap::ReadFiles(std::string cubemapDir)
+{
+	const char * faceNames[6] = { "right", "left", "up", "down", "back", "front" };
+
+	// Doesn't touch Vulkan, so it can run on a worker thread while loading
+	std::string filenames[6];
+	MappedFile faceFiles[6];
+	uint64_t faceHashes[6];
+	bool faceRead[6];
 
-	memcpy(pData, textureData.data(), textureData.size());
+	// Faces are mapped and hashed on all cores
+	ParallelFor(6, [&](unsigned int face)
+	{
+		filenames[face] = cubemapDir + "/" + faceNames[face] + ".rct";
+		faceRead[face] = faceFiles[face].Init(filenames[face]);
+		if (!faceRead[face])
+			return;
 
-	vkUnmapMemory(device->GetDevice(), stagingMemory);
+		faceFiles[face].Prefetch();
+		faceHashes[face] = XXHash::Hash64(faceFiles[face].GetData(), faceFiles[face].GetSize());
+	});
+
+	for (int face = 0; face < 6; face++)
+	{
+		if (!faceRead[face])
+		{
+			gLogManager->AddMessage("ERROR: Texture file not found! (" + filenames[face] + ")");
+			return false;
+		}
+	}
+
+	// Faces that didn't change since they were last filtered are read back from the cache
+	uint64_t sourceHash = XXHash::Hash64(faceHashes, sizeof(faceHashes));
+	std::string cacheFilename = cubemapDir + "/prefiltered.rcf";
+	if (ReadCache(cacheFilename, sourceHash))
+		return true;
+
+	// Decode each face on its own core
+	std::vector<unsigned char> faceData[6];
+	std::vector<MipMap> sourceLevels[6];
+	ParallelFor(6, [&](unsigned int face)
+	{
+		faceRead[face] = ReadCubeFace(&faceFiles[face], faceData[face], sourceLevels[face]);
+	});
+
+	for (int face = 0; face < 6; face++)
+	{
+		if (!faceRead[face])
+		{
+			gLogManager->AddMessage("ERROR: Failed to read cubemap face! (" + filenames[face] + ")");
+			return false;
+		}
+	}
+
+	// Faces share one image, so they need the same square size and mipmaps
+	faceSize = sourceLevels[0][0].width;
+	mipMapLevels = (uint32_t)sourceLevels[0].size();
+	for (int face = 0; face < 6; face++)
+	{
+		bool valid = sourceLevels[face].size() == mipMapLevels;
+		for (uint32_t level = 0; level < mipMapLevels && valid; level++)
+		{
+			uint32_t levelSize = std::max(faceSize >> level, 1u);
+			valid = sourceLevels[face][level].width == levelSize && sourceLevels[face][level].height == levelSize;
+		}
+
+		if (!valid)
+		{
+			gLogManager->AddMessage("ERROR: Every cubemap face must be square and have the same size and mipmaps!");
+			return false;
+		}
+	}
+
+	std::vector<size_t> offsets;
+	filteredData.resize(GetFilteredLevelOffsets(offsets));
+
+	std::vector<const unsigned char*> sourcePointers;
+	std::vector<unsigned char*> filteredPointers;
+	for (int face = 0; face < 6; face++)
+	{
+		faceMipMaps[face].clear();
+		for (uint32_t level = 0; level < mipMapLevels; level++)
+		{
+			MipMap mipMap = sourceLevels[face][level];
+			mipMap.data = filteredData.data() + offsets[face * mipMapLevels + level];
+			faceMipMaps[face].push_back(mipMap);
+
+			sourcePointers.push_back(sourceLevels[face][level].data);
+			filteredPointers.push_back(filteredData.data() + offsets[face * mipMapLevels + level]);
+		}
+	}
+
+	CubemapFilter::PrefilterSpecular(sourcePointers.data(), filteredPointers.data(), faceSize, mipMapLevels);
+	CubemapFilter::ProjectIrradiance(sourcePointers.data(), faceSize, mipMapLevels, irradiance);
+	WriteCache(cacheFilename, sourceHash);
+
+	return true;
+}
+
+bool Cubemap::InitResources(VulkanDevice * device, StagingManager * stagingManager)
+{
+	VkResult result;
+	uint32_t imageFormat = RCT_FORMAT_R8G8B8A8_UNORM;
+
+	VkDeviceSize totalTextureSize = 0;
+	for (int face = 0; face < 6; face++)
+	{
+		for (unsigned int i = 0; i < mipMapLevels; i++)
+		{
+			totalTextureSize = (totalTextureSize + RCT_LEVEL_ALIGNMENT - 1) & ~(VkDeviceSize)(RCT_LEVEL_ALIGNMENT - 1);
+			totalTextureSize += faceMipMaps[face][i].size;
+		}
+	}
+
+	// Copy every filtered level into staging memory
+	VkDeviceSize stagingOffset;
+	unsigned char * stagingData = stagingManager->Allocate(device, totalTextureSize, RCT_LEVEL_ALIGNMENT, &stagingOffset);
+	if (stagingData == NULL)
+		return false;
 
 	std::vector<VkBufferImageCopy> bufferCopyRegions;
-	uint32_t offset = 0;
+	VkDeviceSize offset = 0;
 
 	for (int face = 0; face < 6; face++)
 	{
 		for (unsigned int level = 0; level < mipMapLevels; level++)
 		{
+			const MipMap & mipMap = faceMipMaps[face][level];
+			offset = (offset + RCT_LEVEL_ALIGNMENT - 1) & ~(VkDeviceSize)(RCT_LEVEL_ALIGNMENT - 1);
+			memcpy(stagingData + offset, mipMap.data, mipMap.size);
+
 			VkBufferImageCopy bufferCopyRegion{};
 			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			bufferCopyRegion.imageSubresource.mipLevel = level;
 			bufferCopyRegion.imageSubresource.baseArrayLayer = face;
 			bufferCopyRegion.imageSubresource.layerCount = 1;
 			bufferCopyRegion.imageExtent.depth = 1;
-			bufferCopyRegion.bufferOffset = offset;
-
-			// Every face has the same width, height and mipmap
-			bufferCopyRegion.imageExtent.width = mipMapsRight[level].width;
-			bufferCopyRegion.imageExtent.height = mipMapsRight[level].height;
-			offset += (uint32_t)mipMapsRight[level].size;
+			bufferCopyRegion.bufferOffset = stagingOffset + offset;
+			bufferCopyRegion.imageExtent.width = mipMap.width;
+			bufferCopyRegion.imageExtent.height = mipMap.height;
+			offset += mipMap.size;
 
 			bufferCopyRegions.push_back(bufferCopyRegion);
 		}
 	}
 
+	// The levels are in staging memory now
+	for (int face = 0; face < 6; face++)
+		faceMipMaps[face].clear();
+	cacheFile.Unload();
+	std::vector<unsigned char>().swap(filteredData);
+
 	VkImageCreateInfo imageCI{};
 	imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageCI.imageType = VK_IMAGE_TYPE_2D;
-	imageCI.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageCI.format = (VkFormat)imageFormat;
 	imageCI.mipLevels = mipMapLevels;
 	imageCI.arrayLayers = 6;
 	imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -228,8 +345,8 @@ bool Cubemap::Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::
 	imageCI.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 	imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageCI.extent.width = mipMapsRight[0].width;
-	imageCI.extent.height = mipMapsRight[0].height;
+	imageCI.extent.width = faceSize;
+	imageCI.extent.height = faceSize;
 	imageCI.extent.depth = 1;
 	imageCI.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 
@@ -237,6 +354,7 @@ bool Cubemap::Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::
 	if (result != VK_SUCCESS)
 		return false;
 
+	VkMemoryRequirements memReq;
 	vkGetImageMemoryRequirements(device->GetDevice(), textureImage, &memReq);
 
 	VkMemoryAllocateInfo memAlloc{};
@@ -260,27 +378,23 @@ bool Cubemap::Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::
 	range.levelCount = mipMapLevels;
 	range.layerCount = 6;
 
-	cmdBuffer->BeginRecording();
+	// Copies are batched with other pending uploads and submitted when the staging manager is flushed
+	VulkanCommandBuffer * cmdBuffer = stagingManager->GetCommandBuffer();
+
 	VulkanTools::SetImageLayout(textureImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		&range, cmdBuffer, device, false);
 
-	vkCmdCopyBufferToImage(cmdBuffer->GetCommandBuffer(), stagingBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	vkCmdCopyBufferToImage(cmdBuffer->GetCommandBuffer(), stagingManager->GetBuffer(), textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		(uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
 
 	VulkanTools::SetImageLayout(textureImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 		&range, cmdBuffer, device, false);
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(device, NULL, NULL, NULL, true);
-
-	vkFreeMemory(device->GetDevice(), stagingMemory, VK_NULL_HANDLE);
-	vkDestroyBuffer(device->GetDevice(), stagingBuffer, VK_NULL_HANDLE);
-
 	VkImageViewCreateInfo viewCI{};
 	viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	viewCI.image = textureImage;
 	viewCI.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-	viewCI.format = VK_FORMAT_R8G8B8A8_UNORM;
+	viewCI.format = (VkFormat)imageFormat;
 	viewCI.components.r = VK_COMPONENT_SWIZZLE_R;
 	viewCI.components.g = VK_COMPONENT_SWIZZLE_G;
 	viewCI.components.b = VK_COMPONENT_SWIZZLE_B;
@@ -308,3 +422,13 @@ VkImageView * Cubemap::GetImageView()
 {
 	return &textureImageView;
 }
+
+const float * Cubemap::GetIrradiance()
+{
+	return &irradiance[0][0];
+}
+
+uint32_t Cubemap::GetRoughestLevel()
+{
+	return CubemapFilter::GetRoughestLevel(mipMapLevels);
+}
\ No newline at end of file
@@ -7,30 +7,50 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
-#include "VulkanCommandBuffer.h"
+#include "StagingManager.h"
+#include "MappedFile.h"
+#include "CubemapFilter.h"
 
+// Environment cubemap for image based lighting. The faces are prefiltered on the CPU so each level holds the GGX
+// reflection of the roughness the lighting shader reads it for, and the diffuse irradiance is projected to SH9. Both
+// are cached on disk next to the faces.
 class Cubemap
 {
 	private:
 		struct MipMap
 		{
-			unsigned char * data;
-			int width;
-			int height;
-			unsigned int size;
+			const unsigned char * data;
+			uint32_t width;
+			uint32_t height;
+			uint32_t size;
 		};
 		VkImage textureImage;
 		VkImageView textureImageView;
 		VkDeviceMemory textureMemory;
+		uint32_t faceSize;
 		uint32_t mipMapLevels;
+		float irradiance[CUBEMAP_SH_COEFFICIENT_COUNT][3];
+
+		// Filtered levels, either read back from the cache or filtered while reading the faces
+		MappedFile cacheFile;
+		std::vector<unsigned char> filteredData;
+		std::vector<MipMap> faceMipMaps[6];
 	private:
-		bool ReadCubeFace(std::string filename, std::vector<MipMap> & faceData);
+		bool ReadCubeFace(MappedFile * file, std::vector<unsigned char> & faceData, std::vector<MipMap> & faceLevels);
+		bool ReadCache(std::string filename, uint64_t sourceHash);
+		void WriteCache(std::string filename, uint64_t sourceHash);
+		size_t GetFilteredLevelOffsets(std::vector<size_t> & offsets);
 	public:
 		Cubemap();
 		~Cubemap();
 
-		bool Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::string cubemapDir);
+		bool Init(VulkanDevice * device, StagingManager * stagingManager, std::string cubemapDir);
+		bool ReadFiles(std::string cubemapDir);
+		bool InitResources(VulkanDevice * device, StagingManager * stagingManager);
 		void Unload(VulkanDevice * vulkanDevice);
 		VkImageView * GetImageView();
+		const float * GetIrradiance();
+		uint32_t GetRoughestLevel();
 };
\ No newline at end of file
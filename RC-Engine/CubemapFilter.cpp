@@ -0,0 +1,335 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: CubemapFilter.cpp                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <emmintrin.h>
+
+#include "CubemapFilter.h"
+#include "ParallelFor.h"
+
+#define PI 3.14159265f
+
+struct FilterSample
+{
+	// Light direction in the tangent space of the reflected view vector
+	float x, y, z;
+	float weight;
+	float sourceLevel;
+};
+
+static uint32_t GetLevelSize(uint32_t size, uint32_t level)
+{
+	return std::max(size >> level, 1u);
+}
+
+// Van der Corput sequence, the second coordinate of the Hammersley point set
+static float RadicalInverse(uint32_t bits)
+{
+	bits = (bits << 16) | (bits >> 16);
+	bits = ((bits & 0x55555555) << 1) | ((bits & 0xAAAAAAAA) >> 1);
+	bits = ((bits & 0x33333333) << 2) | ((bits & 0xCCCCCCCC) >> 2);
+	bits = ((bits & 0x0F0F0F0F) << 4) | ((bits & 0xF0F0F0F0) >> 4);
+	bits = ((bits & 0x00FF00FF) << 8) | ((bits & 0xFF00FF00) >> 8);
+
+	return (float)bits * 2.3283064365386963e-10f;
+}
+
+// Direction through a point of a face, u and v go from -1 to 1 across it
+static void GetFaceDirection(uint32_t face, float u, float v, float * dir)
+{
+	switch (face)
+	{
+		case 0: dir[0] = 1.0f; dir[1] = -v; dir[2] = -u; break;
+		case 1: dir[0] = -1.0f; dir[1] = -v; dir[2] = u; break;
+		case 2: dir[0] = u; dir[1] = 1.0f; dir[2] = v; break;
+		case 3: dir[0] = u; dir[1] = -1.0f; dir[2] = -v; break;
+		case 4: dir[0] = u; dir[1] = -v; dir[2] = 1.0f; break;
+		default: dir[0] = -u; dir[1] = -v; dir[2] = -1.0f; break;
+	}
+
+	float length = sqrtf(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+	dir[0] /= length;
+	dir[1] /= length;
+	dir[2] /= length;
+}
+
+static __m128 LoadTexel(const unsigned char * level, uint32_t size, uint32_t x, uint32_t y)
+{
+	int pixel;
+	memcpy(&pixel, level + ((size_t)y * size + x) * 4, 4);
+
+	__m128i zero = _mm_setzero_si128();
+	__m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero), zero);
+
+	return _mm_cvtepi32_ps(channels);
+}
+
+static __m128 Lerp(__m128 a, __m128 b, float t)
+{
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+}
+
+// Bilinear, clamped to the edges of the face
+static __m128 SampleLevel(const unsigned char * level, uint32_t size, float s, float t)
+{
+	float x = std::min(std::max(s * size - 0.5f, 0.0f), (float)(size - 1));
+	float y = std::min(std::max(t * size - 0.5f, 0.0f), (float)(size - 1));
+
+	uint32_t x0 = (uint32_t)x;
+	uint32_t y0 = (uint32_t)y;
+	uint32_t x1 = std::min(x0 + 1, size - 1);
+	uint32_t y1 = std::min(y0 + 1, size - 1);
+	float fx = x - x0;
+	float fy = y - y0;
+
+	__m128 top = Lerp(LoadTexel(level, size, x0, y0), LoadTexel(level, size, x1, y0), fx);
+	__m128 bottom = Lerp(LoadTexel(level, size, x0, y1), LoadTexel(level, size, x1, y1), fx);
+
+	return Lerp(top, bottom, fy);
+}
+
+// Trilinear sample of the cubemap in a direction, the same face selection the GPU does
+static __m128 SampleCube(const unsigned char * const * source, uint32_t size, uint32_t levelCount, const float * dir, float lod)
+{
+	float ax = fabsf(dir[0]);
+	float ay = fabsf(dir[1]);
+	float az = fabsf(dir[2]);
+
+	uint32_t face;
+	float sc, tc, ma;
+	if (ax >= ay && ax >= az)
+	{
+		face = dir[0] > 0.0f ? 0 : 1;
+		sc = dir[0] > 0.0f ? -dir[2] : dir[2];
+		tc = -dir[1];
+		ma = ax;
+	}
+	else if (ay >= az)
+	{
+		face = dir[1] > 0.0f ? 2 : 3;
+		sc = dir[0];
+		tc = dir[1] > 0.0f ? dir[2] : -dir[2];
+		ma = ay;
+	}
+	else
+	{
+		face = dir[2] > 0.0f ? 4 : 5;
+		sc = dir[2] > 0.0f ? dir[0] : -dir[0];
+		tc = -dir[1];
+		ma = az;
+	}
+
+	float s = (sc / ma + 1.0f) * 0.5f;
+	float t = (tc / ma + 1.0f) * 0.5f;
+
+	lod = std::min(std::max(lod, 0.0f), (float)(levelCount - 1));
+	uint32_t level0 = (uint32_t)lod;
+	uint32_t level1 = std::min(level0 + 1, levelCount - 1);
+	float blend = lod - level0;
+
+	const unsigned char * const * faceLevels = source + face * levelCount;
+	__m128 color = SampleLevel(faceLevels[level0], GetLevelSize(size, level0), s, t);
+	if (blend > 0.0f && level1 != level0)
+		color = Lerp(color, SampleLevel(faceLevels[level1], GetLevelSize(size, level1), s, t), blend);
+
+	return color;
+}
+
+uint32_t CubemapFilter::GetRoughestLevel(uint32_t levelCount)
+{
+	return std::min(levelCount - 1, (uint32_t)CUBEMAP_FILTER_ROUGHEST_LEVEL);
+}
+
+float CubemapFilter::GetLevelRoughness(uint32_t level, uint32_t levelCount)
+{
+	uint32_t roughestLevel = GetRoughestLevel(levelCount);
+	if (level >= roughestLevel)
+		return roughestLevel == 0 ? 0.0f : 1.0f;
+
+	return (float)level / roughestLevel;
+}
+
+void CubemapFilter::PrefilterSpecular(const unsigned char * const * source, unsigned char * const * filtered, uint32_t size,
+	uint32_t levelCount)
+{
+	float sourceTexelSolidAngle = 4.0f * PI / (6.0f * size * size);
+
+	for (uint32_t level = 0; level < levelCount; level++)
+	{
+		uint32_t levelSize = GetLevelSize(size, level);
+
+		// A perfect mirror reflects the environment map itself
+		float roughness = GetLevelRoughness(level, levelCount);
+		if (roughness == 0.0f)
+		{
+			for (uint32_t face = 0; face < 6; face++)
+				memcpy(filtered[face * levelCount + level], source[face * levelCount + level], (size_t)levelSize * levelSize * 4);
+			continue;
+		}
+
+		// The view direction is taken to be the reflection vector, so the samples only depend on the roughness. They
+		// are built once per level in tangent space and rotated around every texel's direction.
+		float alpha = roughness * roughness;
+		float alpha2 = alpha * alpha;
+
+		std::vector<FilterSample> samples;
+		float totalWeight = 0.0f;
+		for (uint32_t i = 0; i < CUBEMAP_FILTER_SAMPLE_COUNT; i++)
+		{
+			float phi = 2.0f * PI * (float)i / CUBEMAP_FILTER_SAMPLE_COUNT;
+			float xi = RadicalInverse(i);
+			float cosTheta = sqrtf((1.0f - xi) / (1.0f + (alpha2 - 1.0f) * xi));
+			float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+
+			FilterSample sample;
+			sample.x = 2.0f * cosTheta * sinTheta * cosf(phi);
+			sample.y = 2.0f * cosTheta * sinTheta * sinf(phi);
+			sample.z = 2.0f * cosTheta * cosTheta - 1.0f;
+			if (sample.z <= 0.0f)
+				continue;
+
+			// Filtered importance sampling: each sample reads the source level whose texels are about as large as the
+			// part of the lobe it stands for, so a few samples don't alias on a detailed environment
+			float d = alpha2 / (PI * powf(cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f, 2.0f));
+			float pdf = d * 0.25f;
+			float sampleSolidAngle = 1.0f / (CUBEMAP_FILTER_SAMPLE_COUNT * pdf);
+			sample.sourceLevel = std::max(0.5f * log2f(sampleSolidAngle / sourceTexelSolidAngle) + 1.0f, 0.0f);
+
+			sample.weight = sample.z;
+			totalWeight += sample.weight;
+			samples.push_back(sample);
+		}
+
+		// Each face row is filtered on its own, SSE works on the four channels of a texel at once
+		ParallelFor(6 * levelSize, [&](unsigned int row)
+		{
+			uint32_t face = row / levelSize;
+			uint32_t y = row % levelSize;
+			unsigned char * dst = filtered[face * levelCount + level] + (size_t)y * levelSize * 4;
+			__m128 normalize = _mm_set1_ps(1.0f / totalWeight);
+
+			for (uint32_t x = 0; x < levelSize; x++)
+			{
+				float n[3];
+				GetFaceDirection(face, 2.0f * (x + 0.5f) / levelSize - 1.0f, 2.0f * (y + 0.5f) / levelSize - 1.0f, n);
+
+				// Tangent frame around the texel's direction
+				float up[3] = { 0.0f, 0.0f, 1.0f };
+				if (fabsf(n[2]) > 0.999f)
+				{
+					up[0] = 1.0f;
+					up[2] = 0.0f;
+				}
+
+				float tangent[3] = { up[1] * n[2] - up[2] * n[1], up[2] * n[0] - up[0] * n[2], up[0] * n[1] - up[1] * n[0] };
+				float length = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+				tangent[0] /= length;
+				tangent[1] /= length;
+				tangent[2] /= length;
+
+				float bitangent[3] = { n[1] * tangent[2] - n[2] * tangent[1], n[2] * tangent[0] - n[0] * tangent[2],
+					n[0] * tangent[1] - n[1] * tangent[0] };
+
+				__m128 color = _mm_setzero_ps();
+				for (size_t i = 0; i < samples.size(); i++)
+				{
+					const FilterSample & sample = samples[i];
+
+					float l[3];
+					l[0] = tangent[0] * sample.x + bitangent[0] * sample.y + n[0] * sample.z;
+					l[1] = tangent[1] * sample.x + bitangent[1] * sample.y + n[1] * sample.z;
+					l[2] = tangent[2] * sample.x + bitangent[2] * sample.y + n[2] * sample.z;
+
+					__m128 sampleColor = SampleCube(source, size, levelCount, l, sample.sourceLevel);
+					color = _mm_add_ps(color, _mm_mul_ps(sampleColor, _mm_set1_ps(sample.weight)));
+				}
+
+				// Round and saturate all four channels back to bytes
+				__m128i channels = _mm_cvtps_epi32(_mm_mul_ps(color, normalize));
+				channels = _mm_packs_epi32(channels, channels);
+				channels = _mm_packus_epi16(channels, channels);
+
+				int pixel = _mm_cvtsi128_si32(channels);
+				memcpy(dst + x * 4, &pixel, 4);
+			}
+		});
+	}
+}
+
+void CubemapFilter::ProjectIrradiance(const unsigned char * const * source, uint32_t size, uint32_t levelCount,
+	float irradiance[CUBEMAP_SH_COEFFICIENT_COUNT][3])
+{
+	uint32_t level = 0;
+	while (level + 1 < levelCount && GetLevelSize(size, level) > CUBEMAP_IRRADIANCE_SOURCE_SIZE)
+		level++;
+	uint32_t levelSize = GetLevelSize(size, level);
+
+	// Every face is summed on its own core, SSE works on the four channels of a texel at once
+	__m128 faceSums[6][CUBEMAP_SH_COEFFICIENT_COUNT];
+	float faceSolidAngles[6];
+	ParallelFor(6, [&](unsigned int face)
+	{
+		__m128 * sums = faceSums[face];
+		for (int i = 0; i < CUBEMAP_SH_COEFFICIENT_COUNT; i++)
+			sums[i] = _mm_setzero_ps();
+		faceSolidAngles[face] = 0.0f;
+
+		for (uint32_t y = 0; y < levelSize; y++)
+		{
+			for (uint32_t x = 0; x < levelSize; x++)
+			{
+				float u = 2.0f * (x + 0.5f) / levelSize - 1.0f;
+				float v = 2.0f * (y + 0.5f) / levelSize - 1.0f;
+				float dir[3];
+				GetFaceDirection(face, u, v, dir);
+
+				// Texels near the corners of a face cover less of the sphere
+				float solidAngle = 4.0f / (levelSize * levelSize * powf(1.0f + u * u + v * v, 1.5f));
+				faceSolidAngles[face] += solidAngle;
+
+				float basis[CUBEMAP_SH_COEFFICIENT_COUNT] = {
+					0.282095f,
+					0.488603f * dir[1], 0.488603f * dir[2], 0.488603f * dir[0],
+					1.092548f * dir[0] * dir[1], 1.092548f * dir[1] * dir[2], 0.315392f * (3.0f * dir[2] * dir[2] - 1.0f),
+					1.092548f * dir[0] * dir[2], 0.546274f * (dir[0] * dir[0] - dir[1] * dir[1])
+				};
+
+				__m128 color = _mm_mul_ps(LoadTexel(source[face * levelCount + level], levelSize, x, y), _mm_set1_ps(solidAngle / 255.0f));
+				for (int i = 0; i < CUBEMAP_SH_COEFFICIENT_COUNT; i++)
+					sums[i] = _mm_add_ps(sums[i], _mm_mul_ps(color, _mm_set1_ps(basis[i])));
+			}
+		}
+	});
+
+	// Faces are added in order, so the result doesn't depend on the thread timing. The texel solid angles only add up
+	// to about 4 pi, the sum is scaled to the whole sphere.
+	float totalSolidAngle = 0.0f;
+	__m128 sums[CUBEMAP_SH_COEFFICIENT_COUNT];
+	for (int i = 0; i < CUBEMAP_SH_COEFFICIENT_COUNT; i++)
+		sums[i] = _mm_setzero_ps();
+	for (int face = 0; face < 6; face++)
+	{
+		totalSolidAngle += faceSolidAngles[face];
+		for (int i = 0; i < CUBEMAP_SH_COEFFICIENT_COUNT; i++)
+			sums[i] = _mm_add_ps(sums[i], faceSums[face][i]);
+	}
+
+	// Cosine lobe convolution divided by pi, per band
+	const float bandScales[3] = { 1.0f, 2.0f / 3.0f, 0.25f };
+	for (int i = 0; i < CUBEMAP_SH_COEFFICIENT_COUNT; i++)
+	{
+		float channels[4];
+		_mm_storeu_ps(channels, sums[i]);
+
+		float scale = bandScales[i == 0 ? 0 : (i < 4 ? 1 : 2)] * 4.0f * PI / totalSolidAngle;
+		for (int c = 0; c < 3; c++)
+			irradiance[i][c] = channels[c] * scale;
+	}
+}
\ No newline at end of file
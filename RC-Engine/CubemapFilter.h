@@ -0,0 +1,61 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: CubemapFilter.h                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Prefiltered cubemaps are cached next to their faces in prefiltered.rcf: RCFilteredCubemapHeader with the SH9
+// irradiance, then the RGBA8 levels of every face in face order, largest first, each one starting at a multiple of
+// RCT_LEVEL_ALIGNMENT. sourceHash covers the six face files, a cache made from other faces is filtered again.
+
+#define RCF_MAGIC 0x46524352
+#define RCF_VERSION 2
+
+// GGX samples taken for every texel of a filtered level
+#define CUBEMAP_FILTER_SAMPLE_COUNT 64
+// Roughness goes linearly from 0 at the first level to 1 at this one (or the last level of shorter chains), the
+// lighting shader reads level roughness * roughest level
+#define CUBEMAP_FILTER_ROUGHEST_LEVEL 5
+// The irradiance is projected from the first level at most this large, it has no detail a larger one would add
+#define CUBEMAP_IRRADIANCE_SOURCE_SIZE 32
+#define CUBEMAP_SH_COEFFICIENT_COUNT 9
+
+struct RCFilteredCubemapHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size;
+	uint32_t levelCount;
+	uint32_t sampleCount;
+	uint32_t reserved;
+	uint64_t sourceHash;
+	// RGB of every coefficient, see CubemapFilter::ProjectIrradiance
+	float irradiance[CUBEMAP_SH_COEFFICIENT_COUNT][3];
+};
+
+// CPU prefiltering of environment cubemaps for image based lighting
+namespace CubemapFilter
+{
+	// Level of a chain with levelCount levels that is filtered for roughness 1
+	uint32_t GetRoughestLevel(uint32_t levelCount);
+
+	// Roughness the lighting shader expects the environment map to be filtered for in a level
+	float GetLevelRoughness(uint32_t level, uint32_t levelCount);
+
+	// Convolves every level of the cubemap with the GGX lobe of its roughness, spread across all hardware threads.
+	// Faces are square RGBA8 images in the Vulkan face order (+X, -X, +Y, -Y, +Z, -Z), source[face * levelCount + level]
+	// points at the pixels of a source level and filtered[face * levelCount + level] at room for the same level. The
+	// whole source chain is used to filter the wide lobes, so it should go down to 1x1.
+	void PrefilterSpecular(const unsigned char * const * source, unsigned char * const * filtered, uint32_t size, uint32_t levelCount);
+
+	// Projects the diffuse irradiance of the cubemap onto the first 9 spherical harmonics, same source layout as above.
+	// The cosine lobe and the 1 / pi of a Lambert surface are already applied, so the lighting shader only sums the
+	// coefficients times the basis functions of the normal to get the diffuse light, in 0 to 1 per channel.
+	void ProjectIrradiance(const unsigned char * const * source, uint32_t size, uint32_t levelCount,
+		float irradiance[CUBEMAP_SH_COEFFICIENT_COUNT][3]);
+}
\ No newline at end of file
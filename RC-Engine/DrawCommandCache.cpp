@@ -0,0 +1,110 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: DrawCommandCache.cpp                                 |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "DrawCommandCache.h"
+#include "LogManager.h"
+#include "StdInc.h"
+#include "Settings.h"
+#include "UniformRing.h"
+#include "CommandRecorder.h"
+
+extern LogManager * gLogManager;
+extern Settings * gSettings;
+extern UniformRing * gUniformRing;
+extern CommandRecorder * gCommandRecorder;
+
+DrawCommandCache::DrawCommandCache()
+{
+	meshCount = 0;
+	recordingThread = 0;
+}
+
+DrawCommandCache::~DrawCommandCache()
+{
+	meshCount = 0;
+}
+
+bool DrawCommandCache::Init(VulkanInterface * vulkan, unsigned int meshCount)
+{
+	this->meshCount = meshCount;
+	recordingThread = gCommandRecorder->AssignThread();
+
+	for (unsigned int i = 0; i < meshCount * DRAW_PASS_COUNT * UNIFORM_RING_FRAME_COUNT; i++)
+	{
+		CachedDraw draw{};
+		draw.commandBuffer = new VulkanCommandBuffer();
+		if (!draw.commandBuffer->Init(vulkan->GetVulkanDevice(), GetCommandPool(i), false))
+		{
+			gLogManager->AddMessage("ERROR: Failed to create a draw command buffer!");
+			SAFE_DELETE(draw.commandBuffer);
+			return false;
+		}
+		draw.ringVersion = 0;
+		draw.recorded = false;
+		draws.push_back(draw);
+	}
+
+	return true;
+}
+
+void DrawCommandCache::Unload(VulkanInterface * vulkan)
+{
+	for (unsigned int i = 0; i < draws.size(); i++)
+		SAFE_UNLOAD(draws[i].commandBuffer, vulkan->GetVulkanDevice(), GetCommandPool(i));
+	draws.clear();
+}
+
+VulkanCommandPool * DrawCommandCache::GetCommandPool(unsigned int drawId)
+{
+	// The ring slice comes first in the draw order
+	return gCommandRecorder->GetCommandPool(recordingThread, drawId / (meshCount * DRAW_PASS_COUNT));
+}
+
+bool DrawCommandCache::IsSameState(const DrawState & a, const DrawState & b)
+{
+	if (a.pipeline != b.pipeline || a.descriptorSet != b.descriptorSet || a.setVersion != b.setVersion || a.lod != b.lod ||
+		a.dynamicOffsetCount != b.dynamicOffsetCount)
+		return false;
+
+	for (uint32_t i = 0; i < a.dynamicOffsetCount; i++)
+	{
+		if (a.dynamicOffsets[i] != b.dynamicOffsets[i])
+			return false;
+	}
+
+	return true;
+}
+
+VulkanCommandBuffer * DrawCommandCache::GetCommandBuffer(unsigned int meshId, int pass, const DrawState & state, bool & record)
+{
+	return GetCommandBuffer(meshId, pass, state, std::vector<uint32_t>(), record);
+}
+
+VulkanCommandBuffer * DrawCommandCache::GetCommandBuffer(unsigned int meshId, int pass, const DrawState & state,
+	const std::vector<uint32_t> & instanceData, bool & record)
+{
+	// Each ring slice has its own buffers, the dynamic offsets of the slots differ between them. The buffers of this slice
+	// were last executed two frames ago, that frame waited for its fences, so they can be recorded again.
+	CachedDraw & draw = draws[(gUniformRing->GetFrameIndex() * DRAW_PASS_COUNT + pass) * meshCount + meshId];
+
+	record = !gSettings->GetCommandCaching() || !draw.recorded || draw.ringVersion != gUniformRing->GetBufferVersion() ||
+		!IsSameState(draw.state, state) || draw.instanceData != instanceData;
+	if (record)
+	{
+		draw.state = state;
+		draw.instanceData = instanceData;
+		draw.ringVersion = gUniformRing->GetBufferVersion();
+		draw.recorded = true;
+	}
+
+	return draw.commandBuffer;
+}
+
+unsigned int DrawCommandCache::GetRecordingThread()
+{
+	return recordingThread;
+}
\ No newline at end of file
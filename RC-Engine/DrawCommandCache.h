@@ -0,0 +1,63 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: DrawCommandCache.h                                   |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <vector>
+
+#include "VulkanInterface.h"
+#include "VulkanPipeline.h"
+
+#define DRAW_PASS_DEFERRED 0
+#define DRAW_PASS_SHADOW 1
+#define DRAW_PASS_COUNT 2
+#define DRAW_MAX_DYNAMIC_OFFSETS 3
+
+// Everything a recorded draw depends on that can change between frames
+struct DrawState
+{
+	VulkanPipeline * pipeline;
+	VkDescriptorSet descriptorSet;
+	uint32_t setVersion;
+	unsigned int lod;
+	uint32_t dynamicOffsetCount;
+	uint32_t dynamicOffsets[DRAW_MAX_DYNAMIC_OFFSETS];
+};
+
+// Secondary command buffers of one model, one for every mesh, pass and uniform ring slice. A draw is only recorded again
+// when the state it was recorded with changes. The buffers come from the pools of one recording thread, the model has to
+// be drawn on that thread.
+class DrawCommandCache
+{
+	private:
+		struct CachedDraw
+		{
+			VulkanCommandBuffer * commandBuffer;
+			DrawState state;
+			std::vector<uint32_t> instanceData;
+			// The frame sets are written again when the uniform ring grows, which invalidates everything recorded with them
+			uint32_t ringVersion;
+			bool recorded;
+		};
+		std::vector<CachedDraw> draws;
+		unsigned int meshCount;
+		unsigned int recordingThread;
+	private:
+		VulkanCommandPool * GetCommandPool(unsigned int drawId);
+		bool IsSameState(const DrawState & a, const DrawState & b);
+	public:
+		DrawCommandCache();
+		~DrawCommandCache();
+
+		bool Init(VulkanInterface * vulkan, unsigned int meshCount);
+		void Unload(VulkanInterface * vulkan);
+		// Returns the command buffer of the draw, record is set if it has to be recorded before it's executed
+		VulkanCommandBuffer * GetCommandBuffer(unsigned int meshId, int pass, const DrawState & state, bool & record);
+		// Batches of instances also have to match the instance count of every LOD they were recorded with
+		VulkanCommandBuffer * GetCommandBuffer(unsigned int meshId, int pass, const DrawState & state,
+			const std::vector<uint32_t> & instanceData, bool & record);
+		unsigned int GetRecordingThread();
+};
\ No newline at end of file
@@ -19,9 +19,10 @@ GUIElement::GUIElement()
 	canvas = NULL;
 }
 
-bool GUIElement::Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, std::string filename)
+bool GUIElement::Init(VulkanInterface * vulkan, std::string filename)
 {
-	texture = gTextureManager->RequestTexture(filename, vulkan->GetVulkanDevice(), cmdBuffer);
+	textureHandle = gTextureManager->RequestTexture(filename, vulkan->GetVulkanDevice());
+	texture = gTextureManager->GetTexture(textureHandle);
 	if (texture == nullptr)
 		return false;
 
@@ -38,7 +39,7 @@ bool GUIElement::Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer,
 void GUIElement::Unload(VulkanInterface * vulkan)
 {
 	SAFE_UNLOAD(canvas, vulkan);
-	gTextureManager->ReleaseTexture(texture, vulkan->GetVulkanDevice());
+	gTextureManager->ReleaseTexture(textureHandle, vulkan->GetVulkanDevice());
 }
 
 void GUIElement::Render(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, VulkanPipeline * pipeline,
@@ -56,3 +57,8 @@ void GUIElement::SetDimensions(float width, float height)
 {
 	canvas->SetDimensions(width, height);
 }
+
+VkDeviceSize GUIElement::GetFrameUniformSize()
+{
+	return canvas->GetFrameUniformSize();
+}
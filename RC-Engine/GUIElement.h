@@ -6,6 +6,7 @@
 ==========================================================================================*/
 
 #include "Texture.h"
+#include "ResourceRegistry.h"
 #include "Canvas.h"
 #include "Camera.h"
 
@@ -14,15 +15,17 @@
 class GUIElement
 {
 	private:
+		ResourceHandle textureHandle;
 		Texture * texture;
 		Canvas * canvas;
 	public:
 		GUIElement();
 
-		bool Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, std::string filename);
+		bool Init(VulkanInterface * vulkan, std::string filename);
 		void Unload(VulkanInterface * vulkan);
 		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, VulkanPipeline * pipeline,
 			Camera * camera, int frameBufferId);
 		void SetPosition(float x, float y);
 		void SetDimensions(float width, float height);
+		VkDeviceSize GetFrameUniformSize();
 };
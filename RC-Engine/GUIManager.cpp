@@ -20,12 +20,12 @@ GUIManager::GUIManager()
 	guiEnabled = false;
 }
 
-bool GUIManager::Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer)
+bool GUIManager::Init(VulkanInterface * vulkan)
 {
 	baseDir = "data/textures/GUI/";
 
 	cursor = new GUIElement();
-	if (!cursor->Init(vulkan, cmdBuffer, baseDir + "cursor.rct"))
+	if (!cursor->Init(vulkan, baseDir + "cursor.rct"))
 	{
 		gLogManager->AddMessage("ERROR: Failed to init GUI cursor!");
 		return false;
@@ -70,3 +70,11 @@ void GUIManager::ToggleGUI(bool toggle)
 	guiEnabled = toggle;
 	cursorPosX = cursorPosY = 0.5f;
 }
+
+VkDeviceSize GUIManager::GetFrameUniformSize()
+{
+	if (!guiEnabled)
+		return 0;
+
+	return cursor->GetFrameUniformSize();
+}
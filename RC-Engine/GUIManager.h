@@ -21,9 +21,10 @@ class GUIManager
 	public:
 		GUIManager();
 
-		bool Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer);
+		bool Init(VulkanInterface * vulkan);
 		void Unload(VulkanInterface * vulkan);
 		void Update(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, VulkanPipeline * pipeline,
 			Camera * camera, int frameBufferId);
 		void ToggleGUI(bool toggle);
+		VkDeviceSize GetFrameUniformSize();
 };
@@ -0,0 +1,187 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: LZ4.cpp                                              |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <string.h>
+#include <stdint.h>
+
+#include "LZ4.h"
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MF_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_LOG 12
+
+static uint32_t Read32(const unsigned char * ptr)
+{
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(uint32_t));
+	return value;
+}
+
+static uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static unsigned char * WriteLength(unsigned char * op, int length)
+{
+	// Lengths of 15 and up continue with 255 valued bytes
+	while (length >= 255)
+	{
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = (unsigned char)length;
+
+	return op;
+}
+
+int LZ4::CompressBound(int srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+int LZ4::CompressBlock(const unsigned char * src, int srcSize, unsigned char * dst, int dstCapacity)
+{
+	if (dstCapacity < CompressBound(srcSize))
+		return 0;
+
+	int hashTable[1 << LZ4_HASH_LOG];
+	for (int i = 0; i < (1 << LZ4_HASH_LOG); i++)
+		hashTable[i] = -1;
+
+	unsigned char * op = dst;
+	int ip = 0;
+	int anchor = 0;
+
+	// The last match has to start at least LZ4_MF_LIMIT bytes before the end of the block
+	// and the last LZ4_LAST_LITERALS bytes are always literals
+	int matchLimit = srcSize - LZ4_LAST_LITERALS;
+
+	while (ip + LZ4_MF_LIMIT <= srcSize)
+	{
+		uint32_t sequence = Read32(src + ip);
+		uint32_t hash = HashSequence(sequence);
+		int ref = hashTable[hash];
+		hashTable[hash] = ip;
+
+		if (ref < 0 || ip - ref > LZ4_MAX_OFFSET || Read32(src + ref) != sequence)
+		{
+			ip++;
+			continue;
+		}
+
+		int matchLength = LZ4_MIN_MATCH;
+		while (ip + matchLength < matchLimit && src[ref + matchLength] == src[ip + matchLength])
+			matchLength++;
+
+		// Token
+		int literalLength = ip - anchor;
+		unsigned char * token = op++;
+		*token = (unsigned char)(((literalLength < 15 ? literalLength : 15) << 4));
+
+		// Literals
+		if (literalLength >= 15)
+			op = WriteLength(op, literalLength - 15);
+		memcpy(op, src + anchor, literalLength);
+		op += literalLength;
+
+		// Match
+		int offset = ip - ref;
+		*op++ = (unsigned char)(offset & 0xFF);
+		*op++ = (unsigned char)(offset >> 8);
+
+		int matchCode = matchLength - LZ4_MIN_MATCH;
+		*token |= (unsigned char)(matchCode < 15 ? matchCode : 15);
+		if (matchCode >= 15)
+			op = WriteLength(op, matchCode - 15);
+
+		ip += matchLength;
+		anchor = ip;
+	}
+
+	// Last literals
+	int literalLength = srcSize - anchor;
+	*op++ = (unsigned char)((literalLength < 15 ? literalLength : 15) << 4);
+	if (literalLength >= 15)
+		op = WriteLength(op, literalLength - 15);
+	memcpy(op, src + anchor, literalLength);
+	op += literalLength;
+
+	return (int)(op - dst);
+}
+
+int LZ4::DecompressBlock(const unsigned char * src, int srcSize, unsigned char * dst, int dstSize)
+{
+	int ip = 0;
+	int op = 0;
+
+	while (ip < srcSize)
+	{
+		unsigned char token = src[ip++];
+
+		// Literals
+		int literalLength = token >> 4;
+		if (literalLength == 15)
+		{
+			unsigned char value;
+			do
+			{
+				if (ip >= srcSize)
+					return -1;
+				value = src[ip++];
+				literalLength += value;
+			} while (value == 255);
+		}
+
+		if (literalLength > srcSize - ip || literalLength > dstSize - op)
+			return -1;
+
+		memcpy(dst + op, src + ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+
+		// Last sequence has no match part
+		if (ip >= srcSize)
+			break;
+
+		// Match
+		if (ip + 2 > srcSize)
+			return -1;
+
+		int offset = src[ip] | (src[ip + 1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			return -1;
+
+		int matchLength = token & 15;
+		if (matchLength == 15)
+		{
+			unsigned char value;
+			do
+			{
+				if (ip >= srcSize)
+					return -1;
+				value = src[ip++];
+				matchLength += value;
+			} while (value == 255);
+		}
+		matchLength += LZ4_MIN_MATCH;
+
+		if (matchLength > dstSize - op)
+			return -1;
+
+		// Matches can overlap the output, so copy byte by byte
+		const unsigned char * match = dst + op - offset;
+		for (int i = 0; i < matchLength; i++)
+			dst[op + i] = match[i];
+		op += matchLength;
+	}
+
+	return op;
+}
\ No newline at end of file
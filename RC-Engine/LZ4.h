@@ -0,0 +1,15 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: LZ4.h                                                |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+// Minimal implementation of the LZ4 block format, compatible with the reference decoder
+namespace LZ4
+{
+	int CompressBound(int srcSize);
+	int CompressBlock(const unsigned char * src, int srcSize, unsigned char * dst, int dstCapacity);
+	int DecompressBlock(const unsigned char * src, int srcSize, unsigned char * dst, int dstSize);
+}
\ No newline at end of file
@@ -25,6 +25,9 @@ LogManager::~LogManager()
 
 void LogManager::AddMessage(std::string msg)
 {
+	// Loader threads log too
+	std::lock_guard<std::mutex> lock(logMutex);
+
 	time_t t = time(NULL);
 	struct tm * now = localtime(&t);
 
@@ -9,12 +9,14 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <mutex>
 #include <glm.hpp>
 
 class LogManager
 {
 	private:
 		std::ofstream file;
+		std::mutex logMutex;
 	public:
 		bool Init();
 		~LogManager();
@@ -15,6 +15,7 @@
 #include "Input.h"
 #include "Timer.h"
 #include "SceneManager.h"
+#include "AssetArchive.h"
 
 LRESULT CALLBACK WinWindowProc(HWND hwnd, UINT umsg, WPARAM wparam, LPARAM lparam);
 
@@ -22,6 +23,7 @@ LogManager * gLogManager;
 Settings * gSettings;
 Input * gInput;
 Timer * gTimer;
+AssetArchive * gAssetArchive;
 
 bool gProgramRunning = true;
 
@@ -47,6 +49,13 @@ int main()
 	else
 		gLogManager->AddMessage("SUCCESS: Loaded settings.cfg!");
 
+	// Asset archive
+	gAssetArchive = new AssetArchive();
+	if (!gAssetArchive->Init("data.rcpak"))
+		gLogManager->AddMessage("WARNING: Couldn't mount data.rcpak! Using loose files...");
+	else
+		gLogManager->AddMessage("SUCCESS: Mounted data.rcpak!");
+
 	// Render window
 	WinWindow * window = new WinWindow();
 	if (!window->Create(PROGRAM_NAME, gSettings->GetWindowWidth(), gSettings->GetWindowHeight(), 500, 50, WinWindowProc))
@@ -141,6 +150,7 @@ int main()
 	SAFE_DELETE(vulkan);
 	SAFE_DELETE(gInput);
 	SAFE_DELETE(window);
+	SAFE_UNLOAD(gAssetArchive);
 	SAFE_DELETE(gSettings);
 	SAFE_DELETE(gLogManager);
 
@@ -0,0 +1,60 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: MapFormat.h                                          |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+
+// Layout of a converted .rcmap file:
+//   RCMapHeader
+//   RCMapAsset[assetCount]
+//   RCMapInstance[instanceCount], in the same order as the source .map file
+//   RCMapNode[nodeCount], bounding volume hierarchy over the instance bounds, root first
+//   uint32_t instanceIndices[instanceCount], instances referenced by the BVH leaves
+//   string table (stringTableSize bytes, null terminated asset paths)
+//
+// BVH nodes are stored depth first. An inner node (instanceCount == 0) has its left child right after it
+// and its right child at childOrFirstIndex. A leaf covers instanceIndices[childOrFirstIndex] onwards.
+
+#define RCMAP_MAGIC 0x50414D52
+#define RCMAP_VERSION 1
+#define RCMAP_MAX_LEAF_INSTANCES 4
+
+struct RCMapHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t assetCount;
+	uint32_t instanceCount;
+	uint32_t nodeCount;
+	uint32_t stringTableSize;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+struct RCMapAsset
+{
+	uint32_t pathOffset;
+	uint32_t pathLength;
+};
+
+struct RCMapInstance
+{
+	uint32_t assetIndex;
+	float position[3];
+	float rotation[3];
+	float mass;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+struct RCMapNode
+{
+	float boundsMin[3];
+	float boundsMax[3];
+	uint32_t childOrFirstIndex;
+	uint32_t instanceCount;
+};
\ No newline at end of file
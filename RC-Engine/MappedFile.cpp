@@ -0,0 +1,155 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: MappedFile.cpp                                       |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "MappedFile.h"
+#include "AssetArchive.h"
+
+extern AssetArchive * gAssetArchive;
+
+MappedFile::MappedFile()
+{
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+	data = NULL;
+	ownedData = NULL;
+	dataSize = 0;
+	readOffset = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Unload();
+}
+
+bool MappedFile::Init(std::string filename, bool searchArchive)
+{
+	// Files packed into the asset archive are preferred, loose files are the fallback
+	if (searchArchive && gAssetArchive != NULL && gAssetArchive->OpenFile(filename, this))
+		return true;
+
+	fileHandle = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+		return false;
+
+	dataSize = (size_t)fileSize.QuadPart;
+	readOffset = 0;
+
+	// Empty files can't be mapped, but they are still valid files
+	if (dataSize == 0)
+		return true;
+
+	mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL)
+		return false;
+
+	data = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL)
+		return false;
+
+	return true;
+}
+
+void MappedFile::InitFromMemory(const unsigned char * data, size_t size, unsigned char * ownedData)
+{
+	Unload();
+
+	this->data = data;
+	this->ownedData = ownedData;
+	dataSize = size;
+	readOffset = 0;
+}
+
+void MappedFile::Unload()
+{
+	// Data is either decompressed into our own memory, a view we mapped, or borrowed from the asset archive
+	if (ownedData != NULL)
+		delete[] ownedData;
+	else if (mappingHandle != NULL && data != NULL)
+		UnmapViewOfFile(data);
+	if (mappingHandle != NULL)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = NULL;
+	data = NULL;
+	ownedData = NULL;
+	dataSize = 0;
+	readOffset = 0;
+}
+
+void MappedFile::Prefetch()
+{
+	// Touches every page of a mapped view so the disk reads happen on the calling thread and not on first use
+	if (mappingHandle == NULL || data == NULL)
+		return;
+
+	volatile unsigned char sum = 0;
+	for (size_t offset = 0; offset < dataSize; offset += 4096)
+		sum += data[offset];
+}
+
+const void * MappedFile::Read(size_t size)
+{
+	// Returns a pointer into the mapped view and moves the read cursor past it
+	if (data == NULL || size > dataSize - readOffset)
+		return NULL;
+
+	const void * ptr = data + readOffset;
+	readOffset += size;
+
+	return ptr;
+}
+
+bool MappedFile::Read(void * dst, size_t size)
+{
+	const void * src = Read(size);
+	if (src == NULL)
+		return false;
+
+	memcpy(dst, src, size);
+	return true;
+}
+
+std::string MappedFile::ReadString(size_t size)
+{
+	const char * str = (const char*)Read(size);
+	if (str == NULL)
+		return std::string();
+
+	size_t length = 0;
+	while (length < size && str[length] != 0)
+		length++;
+
+	return std::string(str, length);
+}
+
+const unsigned char * MappedFile::GetData()
+{
+	return data;
+}
+
+size_t MappedFile::GetSize()
+{
+	return dataSize;
+}
+
+size_t MappedFile::GetReadOffset()
+{
+	return readOffset;
+}
+
+void MappedFile::SetReadOffset(size_t offset)
+{
+	readOffset = offset;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: MappedFile.h                                         |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <Windows.h>
+
+class MappedFile
+{
+	private:
+		HANDLE fileHandle;
+		HANDLE mappingHandle;
+		const unsigned char * data;
+		unsigned char * ownedData;
+		size_t dataSize;
+		size_t readOffset;
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Init(std::string filename, bool searchArchive = true);
+		void InitFromMemory(const unsigned char * data, size_t size, unsigned char * ownedData);
+		void Unload();
+		void Prefetch();
+		const void * Read(size_t size);
+		bool Read(void * dst, size_t size);
+		std::string ReadString(size_t size);
+		const unsigned char * GetData();
+		size_t GetSize();
+		size_t GetReadOffset();
+		void SetReadOffset(size_t offset);
+};
\ No newline at end of file
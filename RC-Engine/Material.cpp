@@ -47,6 +47,14 @@ void Material::SetRoughnessOffset(float value)
 	roughnessOffset = value;
 }
 
+void Material::RequestTextureResolution(float pixelsPerUV)
+{
+	diffuseTexture->RequestResolution(pixelsPerUV);
+	materialTexture->RequestResolution(pixelsPerUV);
+	if (normalTexture != nullptr)
+		normalTexture->RequestResolution(pixelsPerUV);
+}
+
 Texture * Material::GetDiffuseTexture()
 {
 	return diffuseTexture;
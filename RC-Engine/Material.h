@@ -25,6 +25,7 @@ class Material
 		void SetNormalTexture(Texture * texture);
 		void SetMetallicOffset(float value);
 		void SetRoughnessOffset(float value);
+		void RequestTextureResolution(float pixelsPerUV);
 		Texture * GetDiffuseTexture();
 		Texture * GetMaterialTexture();
 		Texture * GetNormalTexture();
@@ -5,16 +5,61 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
+#include <gtc/packing.hpp>
+
 #include "Mesh.h"
 #include "StdInc.h"
 #include "BufferManager.h"
+#include "XXHash.h"
+#include "MeshOptimizer.h"
+#include "Settings.h"
 
 extern BufferManager * gBufferManager;
+extern Settings * gSettings;
+
+// Texture coordinate change per model unit, averaged by area over the triangles of the full mesh
+static float CalculateUVDensity(const unsigned char * vertices, unsigned int vertexCount, size_t vertexSize, bool packedVertices,
+	const void * indices, bool shortIndices, const RCMeshLod & lod)
+{
+	double modelArea = 0.0, uvArea = 0.0;
+	for (uint32_t i = lod.firstIndex; i + 2 < lod.firstIndex + lod.indexCount; i += 3)
+	{
+		glm::vec3 positions[3];
+		glm::vec2 uvs[3];
+		for (int j = 0; j < 3; j++)
+		{
+			uint32_t index = shortIndices ? ((const uint16_t*)indices)[i + j] : ((const uint32_t*)indices)[i + j];
+			if (index >= vertexCount)
+				return 0.0f;
+
+			// Both vertex layouts start with the float position followed by the texture coordinates
+			const unsigned char * vertex = vertices + index * vertexSize;
+			memcpy(&positions[j], vertex, sizeof(float) * 3);
+			if (packedVertices)
+			{
+				uint16_t packedUV[2];
+				memcpy(packedUV, vertex + sizeof(float) * 3, sizeof(packedUV));
+				uvs[j] = glm::vec2(glm::unpackHalf1x16(packedUV[0]), glm::unpackHalf1x16(packedUV[1]));
+			}
+			else
+				memcpy(&uvs[j], vertex + sizeof(float) * 3, sizeof(float) * 2);
+		}
+
+		glm::vec2 uvEdge0 = uvs[1] - uvs[0], uvEdge1 = uvs[2] - uvs[0];
+		modelArea += glm::length(glm::cross(positions[1] - positions[0], positions[2] - positions[0]));
+		uvArea += fabs(uvEdge0.x * uvEdge1.y - uvEdge0.y * uvEdge1.x);
+	}
+
+	return modelArea > 0.0 ? (float)sqrt(uvArea / modelArea) : 0.0f;
+}
 
 Mesh::Mesh()
 {
+	uvDensity = 0.0f;
 	vertexBuffer = NULL;
 	indexBuffer = NULL;
+	vertexData = NULL;
+	indexData = NULL;
 }
 
 Mesh::~Mesh()
@@ -23,90 +68,130 @@ Mesh::~Mesh()
 	vertexBuffer = NULL;
 }
 
-bool Mesh::Init(VulkanInterface * vulkan, FILE * modelFile, std::string meshName)
+bool Mesh::Read(MappedFile * modelFile, uint32_t meshFlags)
 {
-	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
-	VulkanCommandPool * cmdPool = vulkan->GetVulkanCommandPool();
+	vertexSize = GetMeshVertexSize(meshFlags, false);
 
-	fread(&vertexCount, sizeof(unsigned int), 1, modelFile);
-	fread(&indexCount, sizeof(unsigned int), 1, modelFile);
+	if (!modelFile->Read(&vertexCount, sizeof(unsigned int)) || !modelFile->Read(&indexCount, sizeof(unsigned int)))
+		return false;
 
-	Vertex * vertexData = new Vertex[vertexCount];
-	uint32_t * indexData = new uint32_t[indexCount];
+	// Cooked static meshes carry their LOD chain, everything else only has the full mesh
+	if (meshFlags & RCM_FLAG_LODS)
+	{
+		uint32_t lodCount;
+		if (!modelFile->Read(&lodCount, sizeof(uint32_t)) || lodCount == 0 || lodCount > RCM_MAX_LODS)
+			return false;
+
+		lods.resize(lodCount);
+		if (!modelFile->Read(lods.data(), sizeof(RCMeshLod) * lodCount))
+			return false;
+
+		for (unsigned int i = 0; i < lodCount; i++)
+		{
+			if ((uint64_t)lods[i].firstIndex + lods[i].indexCount > indexCount)
+				return false;
+		}
+	}
+	else
+	{
+		RCMeshLod lod = { 0, indexCount, 0.0f };
+		lods.assign(1, lod);
+	}
+
+	// Vertex and index data are used straight from the mapped file, it has to stay mapped until Init
+	vertexData = modelFile->Read(vertexSize * vertexCount);
+	indexData = modelFile->Read(GetMeshIndexDataSize(meshFlags, vertexCount, indexCount));
+	if (vertexData == NULL || indexData == NULL)
+		return false;
 
-	fread(vertexData, sizeof(Vertex), vertexCount, modelFile);
-	fread(indexData, sizeof(uint32_t), indexCount, modelFile);
+	bool shortIndices = HasShortIndices(meshFlags, vertexCount);
 
-	// Command buffer used for creating buffers
-	VulkanCommandBuffer * cmdBuffer = new VulkanCommandBuffer();
-	if (!cmdBuffer->Init(vulkanDevice, cmdPool, true))
-		return false;
+	// Meshes that weren't cooked are optimized here instead, that needs a copy of the mesh data
+	if (!(meshFlags & RCM_FLAG_OPTIMIZED) && gSettings->GetOptimizeMeshes())
+	{
+		if (!MeshOptimizer::OptimizeMesh(vertexData, vertexCount, vertexSize, (const uint32_t*)indexData, indexCount,
+			optimizedVertexData, optimizedIndexData, shortIndices))
+			return false;
 
-	cmdBuffer->BeginRecording();
+		vertexData = optimizedVertexData.data();
+		indexData = optimizedIndexData.data();
+	}
 
-	// Vertex buffer
-	vertexBuffer = gBufferManager->RequestBuffer(meshName + "VB", vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		vertexData, sizeof(Vertex) * vertexCount, true, cmdBuffer);
-	if (vertexBuffer == nullptr)
-		return false;
+	indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+	indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
-	// Index buffer
-	indexBuffer = gBufferManager->RequestBuffer(meshName + "IB", vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		indexData, sizeof(uint32_t) * indexCount, true, cmdBuffer);
-	if (indexBuffer == nullptr)
-		return false;
+	// Streamed textures pick their levels from it while the mesh is drawn
+	uvDensity = CalculateUVDensity((const unsigned char*)vertexData, vertexCount, vertexSize, (meshFlags & RCM_FLAG_PACKED_VERTICES) != 0,
+		indexData, shortIndices, lods[0]);
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(vulkanDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, true);
+	// Hashed here, so it's done on the loader threads
+	vertexDataHash = XXHash::Hash64(vertexData, vertexSize * vertexCount);
+	indexDataHash = XXHash::Hash64(indexData, indexSize * indexCount);
 
-	SAFE_UNLOAD(cmdBuffer, vulkanDevice, cmdPool);
+	return true;
+}
 
-	delete[] vertexData;
-	delete[] indexData;
+bool Mesh::Init(VulkanInterface * vulkan)
+{
+	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
 
-	// Material uniform buffer
-	materialUniformBuffer.hasNormalMap = 0.0f;
-	materialUniformBuffer.metallicOffset = 0.0f;
-	materialUniformBuffer.roughnessOffset = 0.0f;
-	materialUniformBuffer.padding = 0.0f;
+	// Vertex buffer, uploaded with the next staging flush
+	vertexBufferHandle = gBufferManager->RequestBuffer(vertexDataHash, vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		vertexData, vertexSize * vertexCount, true);
+	vertexBuffer = gBufferManager->GetBuffer(vertexBufferHandle);
+	if (vertexBuffer == nullptr)
+		return false;
 
-	// Fragment shader uniform buffer
-	materialUBO = new VulkanBuffer();
-	if (!materialUBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &materialUniformBuffer,
-		sizeof(materialUniformBuffer), false))
+	// Index buffer
+	indexBufferHandle = gBufferManager->RequestBuffer(indexDataHash, vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		indexData, indexSize * indexCount, true);
+	indexBuffer = gBufferManager->GetBuffer(indexBufferHandle);
+	if (indexBuffer == nullptr)
 		return false;
 
+	vertexData = NULL;
+	indexData = NULL;
+	optimizedVertexData = std::vector<unsigned char>();
+	optimizedIndexData = std::vector<unsigned char>();
+
 	return true;
 }
 
 void Mesh::Unload(VulkanInterface * vulkan)
 {
-	SAFE_UNLOAD(materialUBO, vulkan->GetVulkanDevice());
-	gBufferManager->ReleaseBuffer(indexBuffer, vulkan->GetVulkanDevice());
-	gBufferManager->ReleaseBuffer(vertexBuffer, vulkan->GetVulkanDevice());
+	gBufferManager->ReleaseBuffer(indexBufferHandle, vulkan->GetVulkanDevice());
+	gBufferManager->ReleaseBuffer(vertexBufferHandle, vulkan->GetVulkanDevice());
 }
 
-void Mesh::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer)
+void Mesh::Bind(VulkanCommandBuffer * commandBuffer)
 {
 	VkDeviceSize offsets[1] = { 0 };
 	vkCmdBindVertexBuffers(commandBuffer->GetCommandBuffer(), 0, 1, vertexBuffer->GetBuffer(), offsets);
-	vkCmdBindIndexBuffer(commandBuffer->GetCommandBuffer(), *indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-	vkCmdDrawIndexed(commandBuffer->GetCommandBuffer(), indexCount, 1, 0, 0, 0);
+	vkCmdBindIndexBuffer(commandBuffer->GetCommandBuffer(), *indexBuffer->GetBuffer(), 0, indexType);
 }
 
-void Mesh::SetMaterial(Material * material)
+void Mesh::Draw(VulkanCommandBuffer * commandBuffer, unsigned int lod, uint32_t instanceCount, uint32_t firstInstance)
 {
-	this->material = material;
+	vkCmdDrawIndexed(commandBuffer->GetCommandBuffer(), lods[lod].indexCount, instanceCount, lods[lod].firstIndex, 0, firstInstance);
 }
 
-void Mesh::UpdateUniformBuffer(VulkanInterface * vulkan)
+unsigned int Mesh::SelectLod(float pixelsPerUnit, float maxPixelError, unsigned int currentLod)
 {
-	materialUniformBuffer.hasNormalMap = (material->HasNormalMap() ? 1.0f : 0.0f);
-	materialUniformBuffer.metallicOffset = material->GetMetallicOffset();
-	materialUniformBuffer.roughnessOffset = material->GetRoughnessOffset();
+	// Coarsest LOD whose error stays under the limit on screen. Switching to a coarser LOD needs some margin under it
+	// and the current one is kept until it's that much over it, so models near the switching distance don't flicker.
+	for (unsigned int i = (unsigned int)lods.size() - 1; i > 0; i--)
+	{
+		float limit = maxPixelError * (i > currentLod ? 1.0f - LOD_HYSTERESIS : 1.0f + LOD_HYSTERESIS);
+		if (lods[i].error * pixelsPerUnit <= limit)
+			return i;
+	}
+
+	return 0;
+}
 
-	materialUBO->Update(vulkan->GetVulkanDevice(), &materialUniformBuffer, sizeof(materialUniformBuffer));
+void Mesh::SetMaterial(Material * material)
+{
+	this->material = material;
 }
 
 Material * Mesh::GetMaterial()
@@ -114,7 +199,12 @@ Material * Mesh::GetMaterial()
 	return material;
 }
 
-VkDescriptorBufferInfo * Mesh::GetMaterialBufferInfo()
+unsigned int Mesh::GetLodCount()
 {
-	return materialUBO->GetBufferInfo();
+	return (unsigned int)lods.size();
 }
+
+float Mesh::GetUVDensity()
+{
+	return uvDensity;
+}
\ No newline at end of file
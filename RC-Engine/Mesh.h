@@ -9,7 +9,13 @@
 #include "VulkanInterface.h"
 #include "VulkanPipeline.h"
 #include "VulkanBuffer.h"
+#include "ResourceRegistry.h"
 #include "Material.h"
+#include "MappedFile.h"
+#include "MeshFormat.h"
+
+// How far past the switching point a model has to get before it changes LOD, as a fraction of the allowed error
+#define LOD_HYSTERESIS 0.25f
 
 class Mesh
 {
@@ -24,30 +30,37 @@ class Mesh
 
 		unsigned int vertexCount;
 		unsigned int indexCount;
+		size_t vertexSize;
+		size_t indexSize;
+		VkIndexType indexType;
+		const void * vertexData;
+		const void * indexData;
+		std::vector<unsigned char> optimizedVertexData;
+		std::vector<unsigned char> optimizedIndexData;
+		uint64_t vertexDataHash;
+		uint64_t indexDataHash;
+		std::vector<RCMeshLod> lods;
+		float uvDensity;
 
-		struct MaterialUniformBuffer
-		{
-			float hasNormalMap;
-			float metallicOffset;
-			float roughnessOffset;
-			float padding;
-		};
-		MaterialUniformBuffer materialUniformBuffer;
-
+		ResourceHandle vertexBufferHandle;
+		ResourceHandle indexBufferHandle;
 		VulkanBuffer * vertexBuffer;
 		VulkanBuffer * indexBuffer;
-		VulkanBuffer * materialUBO;
 
 		Material * material;
 	public:
 		Mesh();
 		~Mesh();
 
-		bool Init(VulkanInterface * vulkan, FILE * modelFile, std::string meshName);
+		bool Read(MappedFile * modelFile, uint32_t meshFlags);
+		bool Init(VulkanInterface * vulkan);
 		void Unload(VulkanInterface * vulkan);
-		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer);
+		// Bound once per batch, every LOD of the batch draws its instances from the same buffers
+		void Bind(VulkanCommandBuffer * commandBuffer);
+		void Draw(VulkanCommandBuffer * commandBuffer, unsigned int lod, uint32_t instanceCount, uint32_t firstInstance);
+		unsigned int SelectLod(float pixelsPerUnit, float maxPixelError, unsigned int currentLod);
 		void SetMaterial(Material * material);
-		void UpdateUniformBuffer(VulkanInterface * vulkan);
 		Material * GetMaterial();
-		VkDescriptorBufferInfo * GetMaterialBufferInfo();
+		unsigned int GetLodCount();
+		float GetUVDensity();
 };
\ No newline at end of file
@@ -0,0 +1,159 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: MeshFormat.h                                         |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// .rcm and .rcs files start with the mesh count when they come straight from the exporter, with float vertices
+// (Mesh::Vertex, SkinnedMesh::Vertex) and 32-bit indices. Files cooked by RC-Tools start with RCMeshHeader instead,
+// everything after it keeps the same layout and the flags tell what changed. A real mesh count never equals
+// RCM_COOKED_MAGIC, so the loaders can tell them apart.
+//
+// Packed attributes and the formats the vertex fetch reads them with:
+//   position      R32G32B32_SFLOAT
+//   uv            R16G16_SFLOAT
+//   normal        R16G16_SNORM, octahedral
+//   tangent       R8G8B8A8_SNORM, octahedral in xy, z is the sign of the bitangent (cross(normal, tangent) * sign), w unused
+//   bone weights  R8G8B8A8_UNORM
+//   bone IDs      R8G8B8A8_SINT
+// The packed shader variants decode the normal and tangent, the bitangent isn't stored.
+
+#define RCM_COOKED_MAGIC 0x56504352
+#define RCM_COOKED_VERSION 4
+
+// Vertices are RCPackedVertex / RCPackedSkinnedVertex
+#define RCM_FLAG_PACKED_VERTICES 0x1
+// Triangles are ordered for the post-transform cache and vertices in order of first use. Meshes with at most
+// RCM_SHORT_INDEX_MAX_VERTICES vertices store 16-bit indices, padded to 4 bytes.
+#define RCM_FLAG_OPTIMIZED 0x2
+
+// Each mesh has a LOD table right after its vertex and index counts: a uint32_t LOD count and that many RCMeshLod.
+// The index count covers every LOD, their triangles are stored one after another and all of them index the same
+// vertices. The first LOD is the full mesh. Only static meshes get LODs.
+#define RCM_FLAG_LODS 0x4
+
+// Never stored in a file, ReadMeshHeader sets it for packed files cooked before version 4. Their vertices are
+// RCLegacyPackedVertex / RCLegacyPackedSkinnedVertex, which only RC-Tools reads to convert them.
+#define RCM_FLAG_LEGACY_PACKED_VERTICES 0x80000000
+
+#define RCM_SHORT_INDEX_MAX_VERTICES 65536
+#define RCM_MAX_LODS 4
+
+#define RCM_VERTEX_SIZE 56
+#define RCS_VERTEX_SIZE 88
+
+struct RCMeshHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t flags;
+};
+
+struct RCMeshLod
+{
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	// Largest distance between this LOD and the full mesh, in model units
+	float error;
+};
+
+struct RCPackedVertex
+{
+	float position[3];
+	uint16_t uv[2];
+	int16_t normal[2];
+	int8_t tangent[4];
+};
+
+struct RCPackedSkinnedVertex
+{
+	float position[3];
+	uint16_t uv[2];
+	int16_t normal[2];
+	uint8_t boneWeights[4];
+	int8_t boneIDs[4];
+	int8_t tangent[4];
+};
+
+// Versions 1 to 3 stored the normal, tangent and bitangent as SNORM8 vectors (w unused)
+struct RCLegacyPackedVertex
+{
+	float position[3];
+	uint16_t uv[2];
+	int8_t normal[4];
+	int8_t tangent[4];
+	int8_t bitangent[4];
+};
+
+struct RCLegacyPackedSkinnedVertex
+{
+	float position[3];
+	uint16_t uv[2];
+	int8_t normal[4];
+	uint8_t boneWeights[4];
+	int8_t boneIDs[4];
+	int8_t tangent[4];
+	int8_t bitangent[4];
+};
+
+// Reads the header at the start of a .rcm/.rcs file. headerSize is 0 for files that weren't cooked,
+// version 1 files only had packed vertices and no flags, version 2 files had no LODs. Returns false for unknown versions.
+inline bool ReadMeshHeader(const unsigned char * data, size_t size, uint32_t & flags, size_t & headerSize)
+{
+	flags = 0;
+	headerSize = 0;
+
+	uint32_t magic, version;
+	if (size < sizeof(uint32_t) * 2)
+		return true;
+
+	memcpy(&magic, data, sizeof(uint32_t));
+	memcpy(&version, data + sizeof(uint32_t), sizeof(uint32_t));
+	if (magic != RCM_COOKED_MAGIC)
+		return true;
+
+	if (version == 1)
+	{
+		flags = RCM_FLAG_PACKED_VERTICES | RCM_FLAG_LEGACY_PACKED_VERTICES;
+		headerSize = sizeof(uint32_t) * 2;
+		return true;
+	}
+
+	if (version > RCM_COOKED_VERSION || size < sizeof(RCMeshHeader))
+		return false;
+
+	memcpy(&flags, data + sizeof(uint32_t) * 2, sizeof(uint32_t));
+	headerSize = sizeof(RCMeshHeader);
+	if (version < 4 && (flags & RCM_FLAG_PACKED_VERTICES))
+		flags |= RCM_FLAG_LEGACY_PACKED_VERTICES;
+	return true;
+}
+
+inline size_t GetMeshVertexSize(uint32_t flags, bool skinned)
+{
+	if (flags & RCM_FLAG_LEGACY_PACKED_VERTICES)
+		return skinned ? sizeof(RCLegacyPackedSkinnedVertex) : sizeof(RCLegacyPackedVertex);
+	if (flags & RCM_FLAG_PACKED_VERTICES)
+		return skinned ? sizeof(RCPackedSkinnedVertex) : sizeof(RCPackedVertex);
+
+	return skinned ? RCS_VERTEX_SIZE : RCM_VERTEX_SIZE;
+}
+
+inline bool HasShortIndices(uint32_t flags, uint32_t vertexCount)
+{
+	return (flags & RCM_FLAG_OPTIMIZED) && vertexCount <= RCM_SHORT_INDEX_MAX_VERTICES;
+}
+
+inline size_t GetMeshIndexDataSize(uint32_t flags, uint32_t vertexCount, uint32_t indexCount)
+{
+	if (HasShortIndices(flags, vertexCount))
+		return ((size_t)indexCount * sizeof(uint16_t) + 3) & ~(size_t)3;
+
+	return (size_t)indexCount * sizeof(uint32_t);
+}
\ No newline at end of file
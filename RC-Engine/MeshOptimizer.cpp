@@ -0,0 +1,562 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: MeshOptimizer.cpp                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+#include "MeshFormat.h"
+
+// Cache size the vertex scores are tuned for, larger than most hardware caches works well on all of them
+#define VERTEX_CACHE_SIZE 32
+
+#define INVALID_INDEX 0xFFFFFFFF
+
+// Sum of squared distances to a set of planes, weighted by triangle area. Stored as the upper half of a symmetric 4x4 matrix.
+struct Quadric
+{
+	double a00, a01, a02, a03;
+	double a11, a12, a13;
+	double a22, a23;
+	double a33;
+	double weight;
+};
+
+struct Vector3
+{
+	double x, y, z;
+};
+
+static Vector3 ReadPosition(const unsigned char * vertices, size_t vertexSize, uint32_t index)
+{
+	float position[3];
+	memcpy(position, vertices + index * vertexSize, sizeof(position));
+
+	Vector3 result = { position[0], position[1], position[2] };
+	return result;
+}
+
+static Vector3 TriangleNormal(const Vector3 & p0, const Vector3 & p1, const Vector3 & p2)
+{
+	Vector3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+	Vector3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+
+	Vector3 normal = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+	return normal;
+}
+
+static void AddQuadric(Quadric & q, const Quadric & other)
+{
+	q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02; q.a03 += other.a03;
+	q.a11 += other.a11; q.a12 += other.a12; q.a13 += other.a13;
+	q.a22 += other.a22; q.a23 += other.a23;
+	q.a33 += other.a33;
+	q.weight += other.weight;
+}
+
+static Quadric TriangleQuadric(const Vector3 & p0, const Vector3 & p1, const Vector3 & p2)
+{
+	Vector3 normal = TriangleNormal(p0, p1, p2);
+	double length = sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+
+	Quadric q;
+	memset(&q, 0, sizeof(Quadric));
+	if (length == 0.0)
+		return q;
+
+	// Plane through the triangle, weighted by its area
+	double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+	double d = -(a * p0.x + b * p0.y + c * p0.z);
+	double w = length * 0.5;
+
+	q.a00 = w * a * a; q.a01 = w * a * b; q.a02 = w * a * c; q.a03 = w * a * d;
+	q.a11 = w * b * b; q.a12 = w * b * c; q.a13 = w * b * d;
+	q.a22 = w * c * c; q.a23 = w * c * d;
+	q.a33 = w * d * d;
+	q.weight = w;
+
+	return q;
+}
+
+// Distance error of moving the vertices of q to p, the square root of the area weighted mean squared distance
+static double QuadricError(const Quadric & q, const Vector3 & p)
+{
+	if (q.weight <= 0.0)
+		return 0.0;
+
+	double error = q.a00 * p.x * p.x + 2.0 * q.a01 * p.x * p.y + 2.0 * q.a02 * p.x * p.z + 2.0 * q.a03 * p.x +
+		q.a11 * p.y * p.y + 2.0 * q.a12 * p.y * p.z + 2.0 * q.a13 * p.y +
+		q.a22 * p.z * p.z + 2.0 * q.a23 * p.z + q.a33;
+
+	return sqrt(std::max(error, 0.0) / q.weight);
+}
+
+static float VertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+	if (remainingTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// Vertices of the last triangle get a fixed score, so the next one doesn't always share the same edge
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = powf(1.0f - (float)(cachePosition - 3) / (VERTEX_CACHE_SIZE - 3), 1.5f);
+	}
+
+	// Vertices with few triangles left get finished first, so they don't have to come back into the cache later
+	score += 2.0f / sqrtf((float)remainingTriangles);
+
+	return score;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t * indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles that use each vertex, the first remainingTriangles[v] entries are the ones not emitted yet
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		remainingTriangles[indices[i]]++;
+
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+		triangleOffsets[i + 1] = triangleOffsets[i] + remainingTriangles[i];
+
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	std::vector<uint32_t> fillOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		vertexTriangles[fillOffsets[indices[i]]++] = (uint32_t)(i / 3);
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		vertexScores[i] = VertexScore(-1, remainingTriangles[i]);
+
+	std::vector<bool> emitted(triangleCount, false);
+	size_t bestTriangle = INVALID_INDEX;
+	float bestScore = -1.0f;
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		float score = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestTriangle = i;
+		}
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+
+	uint32_t cache[VERTEX_CACHE_SIZE + 3];
+	size_t cacheCount = 0;
+	size_t nextCandidate = 0;
+
+	while (result.size() < triangleCount * 3)
+	{
+		// Nothing in the cache has triangles left, continue with the first triangle not emitted yet
+		if (bestTriangle == INVALID_INDEX)
+		{
+			while (emitted[nextCandidate])
+				nextCandidate++;
+			bestTriangle = nextCandidate;
+		}
+
+		const uint32_t * triangle = indices + bestTriangle * 3;
+		result.insert(result.end(), triangle, triangle + 3);
+		emitted[bestTriangle] = true;
+
+		for (int i = 0; i < 3; i++)
+		{
+			uint32_t vertex = triangle[i];
+			uint32_t * triangles = &vertexTriangles[triangleOffsets[vertex]];
+			uint32_t count = remainingTriangles[vertex];
+
+			for (uint32_t j = 0; j < count; j++)
+			{
+				if (triangles[j] == bestTriangle)
+				{
+					triangles[j] = triangles[count - 1];
+					remainingTriangles[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// The triangle's vertices move to the front of the cache, the oldest entries fall out of it
+		uint32_t newCache[VERTEX_CACHE_SIZE + 3];
+		size_t newCacheCount = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			if (i > 0 && triangle[i] == triangle[0])
+				continue;
+			if (i > 1 && triangle[i] == triangle[1])
+				continue;
+			newCache[newCacheCount++] = triangle[i];
+		}
+
+		for (size_t i = 0; i < cacheCount; i++)
+		{
+			if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+				newCache[newCacheCount++] = cache[i];
+		}
+
+		for (size_t i = 0; i < newCacheCount; i++)
+		{
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+			vertexScores[vertex] = VertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+
+		// Only triangles around the vertices whose score changed need to be looked at
+		bestTriangle = INVALID_INDEX;
+		bestScore = -1.0f;
+		for (size_t i = 0; i < newCacheCount; i++)
+		{
+			uint32_t vertex = newCache[i];
+			const uint32_t * triangles = &vertexTriangles[triangleOffsets[vertex]];
+
+			for (uint32_t j = 0; j < remainingTriangles[vertex]; j++)
+			{
+				const uint32_t * candidate = indices + triangles[j] * 3;
+				float score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = triangles[j];
+				}
+			}
+		}
+
+		cacheCount = newCacheCount < VERTEX_CACHE_SIZE ? newCacheCount : VERTEX_CACHE_SIZE;
+		memcpy(cache, newCache, sizeof(uint32_t) * cacheCount);
+	}
+
+	memcpy(indices, result.data(), sizeof(uint32_t) * result.size());
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(unsigned char * vertices, size_t vertexCount, size_t vertexSize, uint32_t * indices, size_t indexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+	uint32_t newVertexCount = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		uint32_t & newIndex = remap[indices[i]];
+		if (newIndex == INVALID_INDEX)
+			newIndex = newVertexCount++;
+
+		indices[i] = newIndex;
+	}
+
+	std::vector<unsigned char> reordered((size_t)newVertexCount * vertexSize);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		if (remap[i] != INVALID_INDEX)
+			memcpy(&reordered[remap[i] * vertexSize], vertices + i * vertexSize, vertexSize);
+	}
+
+	memcpy(vertices, reordered.data(), reordered.size());
+
+	return newVertexCount;
+}
+
+bool MeshOptimizer::Optimize(std::vector<unsigned char> & vertices, size_t vertexSize, std::vector<uint32_t> & indices)
+{
+	size_t vertexCount = vertices.size() / vertexSize;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (indices[i] >= vertexCount)
+			return false;
+	}
+
+	// Some exporters already produce a good order, it's kept when the new one isn't better
+	std::vector<uint32_t> originalIndices = indices;
+	OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+	if (CalculateACMR(indices.data(), indices.size(), vertexCount, VERTEX_CACHE_SIZE) >
+		CalculateACMR(originalIndices.data(), originalIndices.size(), vertexCount, VERTEX_CACHE_SIZE))
+		indices.swap(originalIndices);
+
+	vertexCount = OptimizeVertexFetch(vertices.data(), vertexCount, vertexSize, indices.data(), indices.size());
+	vertices.resize(vertexCount * vertexSize);
+
+	return true;
+}
+
+bool MeshOptimizer::OptimizeMesh(const void * vertices, uint32_t & vertexCount, size_t vertexSize, const uint32_t * indices,
+	uint32_t indexCount, std::vector<unsigned char> & vertexOutput, std::vector<unsigned char> & indexOutput, bool & shortIndices)
+{
+	vertexOutput.assign((const unsigned char*)vertices, (const unsigned char*)vertices + (size_t)vertexCount * vertexSize);
+	std::vector<uint32_t> optimizedIndices(indices, indices + indexCount);
+
+	if (!Optimize(vertexOutput, vertexSize, optimizedIndices))
+		return false;
+
+	vertexCount = (uint32_t)(vertexOutput.size() / vertexSize);
+	shortIndices = HasShortIndices(RCM_FLAG_OPTIMIZED, vertexCount);
+
+	if (shortIndices)
+	{
+		indexOutput.resize((size_t)indexCount * sizeof(uint16_t));
+		uint16_t * shortIndexData = (uint16_t*)indexOutput.data();
+		for (uint32_t i = 0; i < indexCount; i++)
+			shortIndexData[i] = (uint16_t)optimizedIndices[i];
+	}
+	else
+		indexOutput.assign((const unsigned char*)optimizedIndices.data(), (const unsigned char*)(optimizedIndices.data() + indexCount));
+
+	return true;
+}
+
+float MeshOptimizer::Simplify(const unsigned char * vertices, size_t vertexCount, size_t vertexSize, const uint32_t * indices,
+	size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t> & lodIndices)
+{
+	lodIndices.assign(indices, indices + indexCount - indexCount % 3);
+
+	std::vector<Vector3> positions(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		positions[i] = ReadPosition(vertices, vertexSize, (uint32_t)i);
+
+	// Vertices at the same position are welded, so UV and normal seams can be found
+	std::vector<uint32_t> sortedVertices(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		sortedVertices[i] = (uint32_t)i;
+
+	auto comparePositions = [&](uint32_t a, uint32_t b)
+	{
+		if (positions[a].x != positions[b].x)
+			return positions[a].x < positions[b].x;
+		if (positions[a].y != positions[b].y)
+			return positions[a].y < positions[b].y;
+		return positions[a].z < positions[b].z;
+	};
+	std::sort(sortedVertices.begin(), sortedVertices.end(), comparePositions);
+
+	std::vector<uint32_t> weldedVertex(vertexCount);
+	std::vector<uint32_t> weldedCount(vertexCount, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		bool samePosition = i > 0 && !comparePositions(sortedVertices[i - 1], sortedVertices[i]);
+		weldedVertex[sortedVertices[i]] = samePosition ? weldedVertex[sortedVertices[i - 1]] : sortedVertices[i];
+		weldedCount[weldedVertex[sortedVertices[i]]]++;
+	}
+
+	// Seams and vertices on open edges have to stay where they are, otherwise the mesh gets holes
+	std::unordered_map<uint64_t, uint32_t> edgeUseCount;
+	for (size_t i = 0; i < lodIndices.size(); i += 3)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			uint64_t a = weldedVertex[lodIndices[i + j]], b = weldedVertex[lodIndices[i + (j + 1) % 3]];
+			edgeUseCount[a < b ? (a << 32) | b : (b << 32) | a]++;
+		}
+	}
+
+	std::vector<bool> locked(vertexCount, false);
+	for (size_t i = 0; i < vertexCount; i++)
+		locked[i] = weldedCount[weldedVertex[i]] > 1;
+
+	for (size_t i = 0; i < lodIndices.size(); i += 3)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			uint32_t v0 = lodIndices[i + j], v1 = lodIndices[i + (j + 1) % 3];
+			uint64_t a = weldedVertex[v0], b = weldedVertex[v1];
+			if (edgeUseCount[a < b ? (a << 32) | b : (b << 32) | a] != 2)
+			{
+				locked[v0] = true;
+				locked[v1] = true;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	memset(quadrics.data(), 0, sizeof(Quadric) * vertexCount);
+	for (size_t i = 0; i < lodIndices.size(); i += 3)
+	{
+		Quadric q = TriangleQuadric(positions[lodIndices[i]], positions[lodIndices[i + 1]], positions[lodIndices[i + 2]]);
+		for (int j = 0; j < 3; j++)
+			AddQuadric(quadrics[lodIndices[i + j]], q);
+	}
+
+	struct Collapse
+	{
+		double error;
+		uint32_t vertex;
+		uint32_t target;
+	};
+
+	float resultError = 0.0f;
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+	std::vector<uint32_t> vertexTriangles;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched(vertexCount);
+
+	while (lodIndices.size() > targetIndexCount)
+	{
+		size_t triangleCount = lodIndices.size() / 3;
+
+		// Triangles around each vertex
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (size_t i = 0; i < lodIndices.size(); i++)
+			triangleOffsets[lodIndices[i] + 1]++;
+		for (size_t i = 0; i < vertexCount; i++)
+			triangleOffsets[i + 1] += triangleOffsets[i];
+
+		vertexTriangles.resize(lodIndices.size());
+		std::vector<uint32_t> fillOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t i = 0; i < lodIndices.size(); i++)
+			vertexTriangles[fillOffsets[lodIndices[i]]++] = (uint32_t)(i / 3);
+
+		// Cheapest collapse of every vertex that can move, onto one of its neighbours
+		collapses.clear();
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (locked[v] || triangleOffsets[v] == triangleOffsets[v + 1])
+				continue;
+
+			Collapse best = { DBL_MAX, v, v };
+			for (uint32_t i = triangleOffsets[v]; i < triangleOffsets[v + 1]; i++)
+			{
+				const uint32_t * triangle = &lodIndices[vertexTriangles[i] * 3];
+				for (int j = 0; j < 3; j++)
+				{
+					uint32_t target = triangle[j];
+					if (target == v)
+						continue;
+
+					Quadric q = quadrics[v];
+					AddQuadric(q, quadrics[target]);
+					double error = QuadricError(q, positions[target]);
+					if (error >= best.error || error > maxError)
+						continue;
+
+					// Triangles that stay must not flip over
+					bool flips = false;
+					for (uint32_t k = triangleOffsets[v]; k < triangleOffsets[v + 1] && !flips; k++)
+					{
+						const uint32_t * other = &lodIndices[vertexTriangles[k] * 3];
+						if (other[0] == target || other[1] == target || other[2] == target)
+							continue;
+
+						Vector3 p[3], moved[3];
+						for (int l = 0; l < 3; l++)
+						{
+							p[l] = positions[other[l]];
+							moved[l] = other[l] == v ? positions[target] : p[l];
+						}
+
+						Vector3 n0 = TriangleNormal(p[0], p[1], p[2]);
+						Vector3 n1 = TriangleNormal(moved[0], moved[1], moved[2]);
+						if (n0.x * n1.x + n0.y * n1.y + n0.z * n1.z <= 0.0)
+							flips = true;
+					}
+
+					if (!flips)
+					{
+						best.error = error;
+						best.target = target;
+					}
+				}
+			}
+
+			if (best.target != v)
+				collapses.push_back(best);
+		}
+
+		if (collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse & a, const Collapse & b) { return a.error < b.error; });
+
+		// Collapses are applied cheapest first, a vertex can only take part in one per pass since its neighbourhood changes
+		std::fill(touched.begin(), touched.end(), false);
+		size_t collapsed = 0;
+		for (size_t i = 0; i < collapses.size() && triangleCount * 3 > targetIndexCount; i++)
+		{
+			const Collapse & collapse = collapses[i];
+
+			bool neighbourhoodTouched = false;
+			for (uint32_t j = triangleOffsets[collapse.vertex]; j < triangleOffsets[collapse.vertex + 1] && !neighbourhoodTouched; j++)
+			{
+				const uint32_t * triangle = &lodIndices[vertexTriangles[j] * 3];
+				neighbourhoodTouched = touched[triangle[0]] || touched[triangle[1]] || touched[triangle[2]];
+			}
+			if (neighbourhoodTouched)
+				continue;
+
+			for (uint32_t j = triangleOffsets[collapse.vertex]; j < triangleOffsets[collapse.vertex + 1]; j++)
+			{
+				uint32_t * triangle = &lodIndices[vertexTriangles[j] * 3];
+				for (int k = 0; k < 3; k++)
+					touched[triangle[k]] = true;
+
+				if (triangle[0] == collapse.target || triangle[1] == collapse.target || triangle[2] == collapse.target)
+					triangleCount--;
+
+				for (int k = 0; k < 3; k++)
+				{
+					if (triangle[k] == collapse.vertex)
+						triangle[k] = collapse.target;
+				}
+			}
+
+			AddQuadric(quadrics[collapse.target], quadrics[collapse.vertex]);
+			resultError = std::max(resultError, (float)collapse.error);
+			collapsed++;
+		}
+
+		// Drop the triangles that collapsed into lines
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < lodIndices.size(); i += 3)
+		{
+			uint32_t a = lodIndices[i], b = lodIndices[i + 1], c = lodIndices[i + 2];
+			if (a == b || b == c || a == c)
+				continue;
+
+			lodIndices[writeIndex++] = a;
+			lodIndices[writeIndex++] = b;
+			lodIndices[writeIndex++] = c;
+		}
+		lodIndices.resize(writeIndex);
+
+		if (collapsed == 0)
+			break;
+	}
+
+	return resultError;
+}
+
+float MeshOptimizer::CalculateACMR(const uint32_t * indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+{
+	if (indexCount < 3)
+		return 0.0f;
+
+	// Time each vertex entered the cache, it's still in there while fewer than cacheSize misses happened since
+	std::vector<size_t> cacheTimestamps(vertexCount, 0);
+	size_t misses = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		size_t & timestamp = cacheTimestamps[indices[i]];
+		if (timestamp == 0 || misses + 1 - timestamp > cacheSize)
+		{
+			misses++;
+			timestamp = misses;
+		}
+	}
+
+	return (float)misses / (float)(indexCount / 3);
+}
\ No newline at end of file
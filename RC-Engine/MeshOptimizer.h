@@ -0,0 +1,42 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: MeshOptimizer.h                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Index and vertex reordering shared by the mesh cooker and the loaders of meshes that weren't cooked,
+// and the simplification the cooker builds LODs with
+namespace MeshOptimizer
+{
+	// Reorders triangles for the post-transform vertex cache (Forsyth's linear-speed algorithm)
+	void OptimizeVertexCache(uint32_t * indices, size_t indexCount, size_t vertexCount);
+
+	// Reorders vertices in the order the indices first use them and remaps the indices.
+	// Unused vertices are dropped, returns the new vertex count.
+	size_t OptimizeVertexFetch(unsigned char * vertices, size_t vertexCount, size_t vertexSize, uint32_t * indices, size_t indexCount);
+
+	// Both of the above, the triangle order is only changed if it gets better. Vertices is resized to the vertices
+	// still in use. Returns false if an index is out of range.
+	bool Optimize(std::vector<unsigned char> & vertices, size_t vertexSize, std::vector<uint32_t> & indices);
+
+	// Optimizes a mesh that wasn't cooked the same way the cooker does, into vertexOutput and indexOutput.
+	// vertexCount is updated and the indices are 16-bit when shortIndices is set. Returns false if an index is out of range.
+	bool OptimizeMesh(const void * vertices, uint32_t & vertexCount, size_t vertexSize, const uint32_t * indices, uint32_t indexCount,
+		std::vector<unsigned char> & vertexOutput, std::vector<unsigned char> & indexOutput, bool & shortIndices);
+
+	// Simplifies the triangles down to about targetIndexCount indices with quadric error edge collapses, into lodIndices.
+	// Vertices are only removed and never moved, so every LOD can share the vertex buffer. Vertices on open borders
+	// and attribute seams are kept. The position has to be 3 floats at the start of each vertex.
+	// Returns the largest distance error of the collapses, no collapse goes over maxError.
+	float Simplify(const unsigned char * vertices, size_t vertexCount, size_t vertexSize, const uint32_t * indices, size_t indexCount,
+		size_t targetIndexCount, float maxError, std::vector<uint32_t> & lodIndices);
+
+	// Average cache miss ratio, vertex shader invocations per triangle with a FIFO cache of cacheSize entries
+	float CalculateACMR(const uint32_t * indices, size_t indexCount, size_t vertexCount, size_t cacheSize);
+}
\ No newline at end of file
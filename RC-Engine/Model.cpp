@@ -5,7 +5,7 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
-#include <fstream>
+#include <sstream>
 #include <gtc/type_ptr.hpp>
 
 #include "Model.h"
@@ -13,121 +13,506 @@
 #include "LogManager.h"
 #include "Settings.h"
 #include "TextureManager.h"
+#include "CollisionFormat.h"
+#include "MeshFormat.h"
+#include "UniformRing.h"
 
 extern LogManager * gLogManager;
 extern Settings * gSettings;
 extern TextureManager * gTextureManager;
+extern UniformRing * gUniformRing;
 
 Model::Model()
 {
-	deferredVS_UBO = NULL;
+	prefab = NULL;
+	meshFlags = 0;
+	drawCommandCache = NULL;
+	for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		frustumCullData.frustumCullCascade[i] = 0.0f;
+	instanceCapacity = 1;
+	for (int i = 0; i < DRAW_PASS_COUNT; i++)
+		instanceSlots[i] = UNIFORM_RING_NO_SLOT;
+	frustumSlot = UNIFORM_RING_NO_SLOT;
+	meshSetPipeline = NULL;
+	collisionShape = NULL;
+	collisionMesh = NULL;
+	collisionBvh = NULL;
+	collisionBvhData = NULL;
+	rigidBody = NULL;
 }
 
 Model::~Model()
 {
-	deferredVS_UBO = NULL;
+	collisionBvhData = NULL;
+	collisionBvh = NULL;
+	collisionMesh = NULL;
+	collisionShape = NULL;
+	meshSetPipeline = NULL;
+	drawCommandCache = NULL;
+	prefab = NULL;
 }
 
-bool Model::Init(std::string filename, VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer,
-	Physics * physics, float mass)
+bool Model::Init(std::string filename, VulkanInterface * vulkan, Physics * physics, float mass)
 {
-	this->physics = physics;
+	if (!ReadFiles(filename))
+		return false;
 
-	if (!InitUniformBuffers(vulkan->GetVulkanDevice()))
+	if (!InitResources(vulkan))
 		return false;
 
-	if (!ReadRCMFile(vulkan, cmdBuffer, filename))
+	InitPhysics(physics, mass);
+
+	return true;
+}
+
+bool Model::ReadFiles(std::string filename)
+{
+	// Only touches this model's own data, so different models can be read on different threads
+	if (!ReadRCMFile(filename))
 		return false;
 
 	ReadCollisionFile(filename);
 
+	return true;
+}
+
+bool Model::InitResources(VulkanInterface * vulkan)
+{
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		MeshResourceInfo & info = meshResourceInfo[i];
+
+		if (!meshes[i]->Init(vulkan))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init a mesh!");
+			return false;
+		}
+
+		// Init mesh material
+		Material * material = new Material();
+		materials.push_back(material);
+		meshes[i]->SetMaterial(material);
+
+		ResourceHandle diffuseHandle = gTextureManager->RequestTexture(info.diffuseTexturePath, vulkan->GetVulkanDevice(),
+			gSettings->GetTextureStreaming());
+		Texture * diffuse = gTextureManager->GetTexture(diffuseHandle);
+		if (diffuse == nullptr)
+			return false;
+
+		textures.push_back(diffuseHandle);
+		material->SetDiffuseTexture(diffuse);
+
+		if (!info.normalTexturePath.empty())
+		{
+			ResourceHandle normalHandle = gTextureManager->RequestTexture(info.normalTexturePath, vulkan->GetVulkanDevice(),
+				gSettings->GetTextureStreaming());
+			Texture * normal = gTextureManager->GetTexture(normalHandle);
+			if (normal == nullptr)
+				return false;
+
+			textures.push_back(normalHandle);
+			material->SetNormalTexture(normal);
+		}
+
+		ResourceHandle matTextureHandle = gTextureManager->RequestTexture(info.materialTexturePath, vulkan->GetVulkanDevice(),
+			gSettings->GetTextureStreaming());
+		Texture * matTexture = gTextureManager->GetTexture(matTextureHandle);
+		if (matTexture == nullptr)
+			return false;
+
+		textures.push_back(matTextureHandle);
+		material->SetMaterialTexture(matTexture);
+		material->SetMetallicOffset(info.metallicOffset);
+		material->SetRoughnessOffset(info.roughnessOffset);
+
+		meshLods.push_back(0);
+		shadowMeshLods.push_back(0);
+	}
+
+	if (!InitDrawCommands(vulkan))
+		return false;
+
+	// Mesh data has been copied to the staging buffer, the file isn't needed anymore
+	meshResourceInfo.clear();
+	modelFile.Unload();
+
+	return true;
+}
+
+bool Model::InitDrawCommands(VulkanInterface * vulkan)
+{
+	drawCommandCache = new DrawCommandCache();
+	if (!drawCommandCache->Init(vulkan, (unsigned int)meshes.size()))
+		return false;
+
+	// The ring grows when its slots are used up, so this only fails when the device is out of memory
+	for (int i = 0; i < DRAW_PASS_COUNT; i++)
+	{
+		if (!gUniformRing->AllocateSlot((size_t)GetInstanceDataSize(i), &instanceSlots[i]))
+		{
+			gLogManager->AddMessage("ERROR: Failed to allocate a uniform ring slot!");
+			return false;
+		}
+	}
+	if (!gUniformRing->AllocateSlot(sizeof(frustumCullData), &frustumSlot))
+	{
+		gLogManager->AddMessage("ERROR: Failed to allocate a uniform ring slot!");
+		return false;
+	}
+
+	return true;
+}
+
+void Model::InitPhysics(Physics * physics, float mass)
+{
+	this->physics = physics;
+
 	SetupPhysicsObject(mass);
+}
+
+bool Model::InitPrefab(std::string filename, VulkanInterface * vulkan, float mass, unsigned int maxInstances)
+{
+	// The instance data of the whole batch is written to the slots of the prefab
+	instanceCapacity = maxInstances;
+
+	if (!ReadFiles(filename))
+		return false;
+
+	if (!InitResources(vulkan))
+		return false;
+
+	// Prefabs are never drawn or simulated, they only hold what their instances share
+	SetupCollisionShape(mass);
 
 	return true;
 }
 
+bool Model::InitInstance(Model * prefab, VulkanInterface * vulkan, Physics * physics)
+{
+	this->prefab = prefab;
+	this->physics = physics;
+
+	meshes = prefab->meshes;
+	materials = prefab->materials;
+	frustumCullRadius = prefab->frustumCullRadius;
+	meshFlags = prefab->meshFlags;
+
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		meshLods.push_back(0);
+		shadowMeshLods.push_back(0);
+	}
+
+	collisionMeshPresent = prefab->collisionMeshPresent;
+	physicsStatic = prefab->physicsStatic;
+	collisionShape = prefab->collisionShape;
+	mass = prefab->mass;
+	inertia = prefab->inertia;
+
+	// The body is only added to the physics world when the instance is spawned
+	btTransform transform;
+	transform.setIdentity();
+	CreateRigidBody(transform, false);
+
+	return true;
+}
+
+void Model::Spawn(glm::vec3 position, glm::vec3 velocity)
+{
+	// Pooled bodies are reused, only their state is reset
+	btTransform transform;
+	transform.setIdentity();
+	transform.setOrigin(btVector3(position.x, position.y, position.z));
+
+	rigidBody->getMotionState()->setWorldTransform(transform);
+	rigidBody->setCenterOfMassTransform(transform);
+	rigidBody->setLinearVelocity(btVector3(velocity.x, velocity.y, velocity.z));
+	rigidBody->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+	rigidBody->clearForces();
+	rigidBody->activate(true);
+
+	physics->GetDynamicsWorld()->addRigidBody(rigidBody);
+}
+
+void Model::Despawn()
+{
+	physics->GetDynamicsWorld()->removeRigidBody(rigidBody);
+}
+
+void Model::GetTextureFilenames(std::vector<std::string> & filenames)
+{
+	for (unsigned int i = 0; i < meshResourceInfo.size(); i++)
+	{
+		filenames.push_back(meshResourceInfo[i].diffuseTexturePath);
+		if (!meshResourceInfo[i].normalTexturePath.empty())
+			filenames.push_back(meshResourceInfo[i].normalTexturePath);
+		filenames.push_back(meshResourceInfo[i].materialTexturePath);
+	}
+}
+
 void Model::Unload(VulkanInterface * vulkan)
 {
 	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
 	
 	RemoveRigidBody();
 
-	if (physicsStatic == false)
-		SAFE_DELETE(collisionShape);
+	SAFE_UNLOAD(drawCommandCache, vulkan);
+	for (int i = 0; i < DRAW_PASS_COUNT; i++)
+	{
+		gUniformRing->FreeSlot(instanceSlots[i]);
+		instanceSlots[i] = UNIFORM_RING_NO_SLOT;
+	}
+	gUniformRing->FreeSlot(frustumSlot);
+	frustumSlot = UNIFORM_RING_NO_SLOT;
 
-	if (collisionMeshPresent == true)
+	// Only the owner of the meshes has descriptor sets
+	for (unsigned int i = 0; i < meshDescriptorSets.size(); i++)
 	{
-		SAFE_DELETE(collisionMesh);
+		if (meshDescriptorSets[i].set != VK_NULL_HANDLE)
+			meshSetPipeline->FreeDescriptorSet(vulkanDevice, meshDescriptorSets[i].set);
 	}
-	else
-		SAFE_DELETE(emptyCollisionShape);
+	meshDescriptorSets.clear();
 
-	SAFE_UNLOAD(shadowGS_UBO, vulkanDevice);
-	SAFE_UNLOAD(deferredVS_UBO, vulkanDevice);
+	// Everything else belongs to the prefab
+	if (prefab != NULL)
+		return;
+
+	// The cooked BVH lives inside collisionBvhData, so it's released after the shape that uses it
+	SAFE_DELETE(collisionShape);
+	if (collisionBvhData != NULL)
+	{
+		btAlignedFree(collisionBvhData);
+		collisionBvhData = NULL;
+		collisionBvh = NULL;
+	}
+	SAFE_DELETE(collisionMesh);
+	collisionIndices.clear();
+	collisionFile.Unload();
+	modelFile.Unload();
 
 	for (unsigned int i = 0; i < textures.size(); i++)
 		gTextureManager->ReleaseTexture(textures[i], vulkanDevice);
 
-	for (unsigned int i = 0; i < meshes.size(); i++)
-	{
-		SAFE_UNLOAD(drawCmdBuffers[i], vulkanDevice, vulkan->GetVulkanCommandPool());
+	// A model whose loading was cut short may have fewer materials than meshes
+	for (unsigned int i = 0; i < materials.size(); i++)
 		SAFE_DELETE(materials[i]);
+	for (unsigned int i = 0; i < meshes.size(); i++)
 		SAFE_UNLOAD(meshes[i], vulkan);
+}
+
+static int GetDrawPass(VulkanPipeline * pipeline)
+{
+	return (pipeline->GetPipelineName() == "SHADOW" ? DRAW_PASS_SHADOW : DRAW_PASS_DEFERRED);
+}
+
+static void BeginDrawRecording(VulkanInterface * vulkan, VulkanCommandBuffer * drawCmdBuffer, int pass, ShadowMaps * shadowMaps)
+{
+	if (pass == DRAW_PASS_DEFERRED)
+	{
+		drawCmdBuffer->BeginRecordingSecondary(vulkan->GetDeferredRenderpass()->GetRenderpass(), vulkan->GetDeferredFramebuffer());
+
+		vulkan->InitViewportAndScissors(drawCmdBuffer, (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
+			(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
+	}
+	else
+	{
+		drawCmdBuffer->BeginRecordingSecondary(shadowMaps->GetShadowRenderpass()->GetRenderpass(), shadowMaps->GetFramebuffer());
+
+		vulkan->InitViewportAndScissors(drawCmdBuffer, (float)shadowMaps->GetMapSize(), (float)shadowMaps->GetMapSize(),
+			shadowMaps->GetMapSize(), shadowMaps->GetMapSize());
+
+		shadowMaps->SetDepthBias(drawCmdBuffer);
 	}
 }
 
-void Model::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer, VulkanPipeline * vulkanPipeline,
+void Model::Render(VulkanInterface * vulkan, std::vector<VkCommandBuffer> & drawCommands, VulkanPipeline * vulkanPipeline,
 	Camera * camera, ShadowMaps * shadowMaps)
 {
-	btTransform transform;
+	// A model on its own is drawn as a batch of one
+	Model * self = this;
+	(prefab != NULL ? prefab : this)->RenderInstances(vulkan, drawCommands, vulkanPipeline, camera, shadowMaps, &self, 1);
+}
 
-	rigidBody->getMotionState()->getWorldTransform(transform);
+void Model::RenderInstances(VulkanInterface * vulkan, std::vector<VkCommandBuffer> & drawCommands, VulkanPipeline * vulkanPipeline,
+	Camera * camera, ShadowMaps * shadowMaps, Model * const * instances, unsigned int instanceCount)
+{
+	int pass = GetDrawPass(vulkanPipeline);
 
-	transform.getOpenGLMatrix((btScalar*)&vertexUniformBuffer.worldMatrix);
+	// PrefabManager never has more instances alive than the prefab has room for
+	unsigned int batchCount = glm::min(instanceCount, instanceCapacity);
+	if (batchCount == 0)
+		return;
 
-	// Update vertex uniform buffer
-	if (vulkanPipeline->GetPipelineName() == "DEFERRED")
-		vertexUniformBuffer.MVP = camera->GetProjectionMatrix() * camera->GetViewMatrix() * vertexUniformBuffer.worldMatrix;
+	// The batch is drawn into every cascade one of its instances is in
+	FrustumUniformBuffer batchCullData;
+	for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		batchCullData.frustumCullCascade[i] = 0.0f;
+
+	batchInstances.resize(batchCount);
+	for (unsigned int i = 0; i < batchCount; i++)
+	{
+		BatchInstance & instance = batchInstances[i];
+		instance.model = instances[i];
+		instance.model->GetDrawData(camera, instance.worldMatrix, instance.pixelsPerUnit);
+
+		for (int j = 0; j < SHADOW_CASCADE_COUNT; j++)
+			batchCullData.frustumCullCascade[j] = glm::max(batchCullData.frustumCullCascade[j],
+				instance.model->frustumCullData.frustumCullCascade[j]);
+	}
 
-	deferredVS_UBO->Update(vulkan->GetVulkanDevice(), &vertexUniformBuffer, sizeof(vertexUniformBuffer));
+	// Every mesh gets batchCount elements of the instance array, sorted by LOD so each LOD is one instanced draw
+	glm::mat4 viewProjection = camera->GetProjectionMatrix() * camera->GetViewMatrix();
+	if (pass == DRAW_PASS_DEFERRED)
+		deferredInstanceData.resize(meshes.size() * batchCount);
+	else
+		shadowInstanceData.resize(meshes.size() * batchCount);
+	instanceLods.resize(batchCount);
+	batchData.clear();
 
 	for (unsigned int i = 0; i < meshes.size(); i++)
 	{
-		if (vulkanPipeline->GetPipelineName() == "DEFERRED")
+		unsigned int lodCount = meshes[i]->GetLodCount();
+		lodInstanceCounts.assign(lodCount, 0);
+		for (unsigned int j = 0; j < batchCount; j++)
 		{
-			meshes[i]->UpdateUniformBuffer(vulkan);
-			UpdateDescriptorSet(vulkan, vulkanPipeline, meshes[i], NULL);
+			BatchInstance & instance = batchInstances[j];
+			if (pass == DRAW_PASS_DEFERRED)
+			{
+				// Streamed textures load the levels that have about one texel per pixel at this distance
+				meshes[i]->GetMaterial()->RequestTextureResolution(instance.pixelsPerUnit / meshes[i]->GetUVDensity());
+			}
+
+			instanceLods[j] = instance.model->SelectMeshLod(pass, i, instance.pixelsPerUnit);
+			lodInstanceCounts[instanceLods[j]]++;
+		}
 
-			// Record draw command
-			drawCmdBuffers[i]->BeginRecordingSecondary(vulkan->GetDeferredRenderpass()->GetRenderpass(), vulkan->GetDeferredFramebuffer());
+		// The counts of every mesh are what its draw is recorded with, the instances are placed after the counts of
+		// the lower LODs
+		uint32_t first = i * batchCount;
+		for (unsigned int lod = 0; lod < lodCount; lod++)
+		{
+			batchData.push_back(lodInstanceCounts[lod]);
+			uint32_t count = lodInstanceCounts[lod];
+			lodInstanceCounts[lod] = first;
+			first += count;
+		}
 
-			vulkan->InitViewportAndScissors(drawCmdBuffers[i], (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
-				(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
-			vulkanPipeline->SetActive(drawCmdBuffers[i]);
-			meshes[i]->Render(vulkan, drawCmdBuffers[i]);
+		Material * material = meshes[i]->GetMaterial();
+		for (unsigned int j = 0; j < batchCount; j++)
+		{
+			uint32_t index = lodInstanceCounts[instanceLods[j]]++;
+			if (pass == DRAW_PASS_DEFERRED)
+			{
+				DeferredInstanceData & data = deferredInstanceData[index];
+				data.MVP = viewProjection * batchInstances[j].worldMatrix;
+				data.worldMatrix = batchInstances[j].worldMatrix;
+				data.materialParams = glm::vec4(material->HasNormalMap() ? 1.0f : 0.0f, material->GetMetallicOffset(),
+					material->GetRoughnessOffset(), 0.0f);
+			}
+			else
+				shadowInstanceData[index].worldMatrix = batchInstances[j].worldMatrix;
+		}
+	}
+
+	DrawState state;
+	state.pipeline = vulkanPipeline;
+	state.lod = 0;
+
+	// Each pass gets its own copy of the instance data in the uniform ring
+	bool written;
+	if (pass == DRAW_PASS_DEFERRED)
+		written = gUniformRing->Write(instanceSlots[pass], &deferredInstanceData[0], deferredInstanceData.size() * sizeof(DeferredInstanceData),
+			&state.dynamicOffsets[0]);
+	else
+		written = gUniformRing->Write(instanceSlots[pass], &shadowInstanceData[0], shadowInstanceData.size() * sizeof(ShadowInstanceData),
+			&state.dynamicOffsets[0]);
+	if (!written)
+		return;
+
+	if (pass == DRAW_PASS_SHADOW)
+	{
+		state.dynamicOffsetCount = 3;
+		state.dynamicOffsets[1] = shadowMaps->GetUniformOffset();
+		if (!gUniformRing->Write(frustumSlot, &batchCullData, sizeof(batchCullData), &state.dynamicOffsets[2]))
+			return;
+	}
+	else
+		state.dynamicOffsetCount = 1;
 
-			drawCmdBuffers[i]->EndRecording();
-			drawCmdBuffers[i]->ExecuteSecondary(commandBuffer);
+	unsigned int batchDataStart = 0;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		unsigned int lodCount = meshes[i]->GetLodCount();
+		lodInstanceCounts.assign(batchData.begin() + batchDataStart, batchData.begin() + batchDataStart + lodCount);
+		batchDataStart += lodCount;
+
+		// Shadow draws only read the uniform ring, the frame set of the pipeline is all they bind
+		state.descriptorSet = VK_NULL_HANDLE;
+		state.setVersion = 0;
+		if (pass == DRAW_PASS_DEFERRED)
+		{
+			state.descriptorSet = GetDescriptorSet(vulkan, vulkanPipeline, i, state.setVersion);
+			if (state.descriptorSet == VK_NULL_HANDLE)
+				continue;
 		}
-		else if (vulkanPipeline->GetPipelineName() == "SHADOW")
+
+		// Recorded again only when instances come into view, leave it or switch their LOD
+		bool record;
+		VulkanCommandBuffer * drawCmdBuffer = drawCommandCache->GetCommandBuffer(i, pass, state, lodInstanceCounts, record);
+		if (record)
 		{
-			shadowGS_UBO->Update(vulkan->GetVulkanDevice(), &frustumCullData, sizeof(frustumCullData));
-			UpdateDescriptorSet(vulkan, vulkanPipeline, meshes[i], shadowMaps);
+			BeginDrawRecording(vulkan, drawCmdBuffer, pass, shadowMaps);
+
+			vulkanPipeline->SetActive(drawCmdBuffer, state.descriptorSet, state.dynamicOffsetCount, state.dynamicOffsets);
+			meshes[i]->Bind(drawCmdBuffer);
+			uint32_t firstInstance = i * batchCount;
+			for (unsigned int lod = 0; lod < lodCount; lod++)
+			{
+				if (lodInstanceCounts[lod] > 0)
+					meshes[i]->Draw(drawCmdBuffer, lod, lodInstanceCounts[lod], firstInstance);
+				firstInstance += lodInstanceCounts[lod];
+			}
+
+			drawCmdBuffer->EndRecording();
+		}
+
+		drawCommands.push_back(drawCmdBuffer->GetCommandBuffer());
+	}
+}
+
+void Model::GetDrawData(Camera * camera, glm::mat4 & worldMatrix, float & pixelsPerUnit)
+{
+	btTransform transform;
 
-			// Record draw command
-			drawCmdBuffers[i]->BeginRecordingSecondary(shadowMaps->GetShadowRenderpass()->GetRenderpass(), shadowMaps->GetFramebuffer());
+	rigidBody->getMotionState()->getWorldTransform(transform);
 
-			vulkan->InitViewportAndScissors(drawCmdBuffers[i], (float)shadowMaps->GetMapSize(), (float)shadowMaps->GetMapSize(),
-				shadowMaps->GetMapSize(), shadowMaps->GetMapSize());
+	transform.getOpenGLMatrix((btScalar*)&worldMatrix);
 
-			shadowMaps->SetDepthBias(drawCmdBuffers[i]);
-			vulkanPipeline->SetActive(drawCmdBuffers[i]);
-			meshes[i]->Render(vulkan, drawCmdBuffers[i]);
+	// How many pixels one unit covers on screen at the closest point of the bounding sphere, LODs are picked
+	// from their error projected with this
+	glm::vec3 origin(transform.getOrigin().getX(), transform.getOrigin().getY(), transform.getOrigin().getZ());
+	float distance = glm::max(glm::length(camera->GetPosition() - origin) - frustumCullRadius, camera->GetNearClip());
+	pixelsPerUnit = (float)gSettings->GetWindowHeight() / (2.0f * tanf(camera->GetFieldOfView() * 0.5f) * distance);
+}
 
-			drawCmdBuffers[i]->EndRecording();
-			drawCmdBuffers[i]->ExecuteSecondary(commandBuffer);
-		}
+VkDeviceSize Model::GetInstanceDataSize(int pass)
+{
+	VkDeviceSize elementSize = (pass == DRAW_PASS_DEFERRED ? sizeof(DeferredInstanceData) : sizeof(ShadowInstanceData));
+	return meshes.size() * instanceCapacity * elementSize;
+}
+
+unsigned int Model::SelectMeshLod(int pass, unsigned int meshId, float pixelsPerUnit)
+{
+	// Shadow maps get away with coarser LODs and keep their own selection
+	if (pass == DRAW_PASS_SHADOW)
+	{
+		shadowMeshLods[meshId] = meshes[meshId]->SelectLod(pixelsPerUnit, gSettings->GetLodPixelError() * gSettings->GetShadowLodBias(),
+			shadowMeshLods[meshId]);
+		return shadowMeshLods[meshId];
 	}
+
+	meshLods[meshId] = meshes[meshId]->SelectLod(pixelsPerUnit, gSettings->GetLodPixelError(), meshLods[meshId]);
+	return meshLods[meshId];
 }
 
 void Model::SetPosition(float x, float y, float z)
@@ -220,305 +605,343 @@ glm::vec3 Model::GetPosition()
 	return glm::vec3(origin.getX(), origin.getY(), origin.getZ());
 }
 
-void Model::UpdateDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, Mesh * mesh, ShadowMaps * shadowMaps)
-{
-	if (pipeline->GetPipelineName() == "DEFERRED")
-	{
-		VkWriteDescriptorSet descriptorWrite[5];
-
-		descriptorWrite[0] = {};
-		descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[0].pNext = NULL;
-		descriptorWrite[0].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[0].descriptorCount = 1;
-		descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[0].pBufferInfo = deferredVS_UBO->GetBufferInfo();
-		descriptorWrite[0].dstArrayElement = 0;
-		descriptorWrite[0].dstBinding = 0;
-
-		// Write mesh diffuse texture
-		VkDescriptorImageInfo diffuseTextureDesc{};
-		diffuseTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-		diffuseTextureDesc.imageView = *mesh->GetMaterial()->GetDiffuseTexture()->GetImageView();
-		diffuseTextureDesc.sampler = vulkan->GetColorSampler();
-
-		descriptorWrite[1] = {};
-		descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[1].pNext = NULL;
-		descriptorWrite[1].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[1].descriptorCount = 1;
-		descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite[1].pImageInfo = &diffuseTextureDesc;
-		descriptorWrite[1].dstArrayElement = 0;
-		descriptorWrite[1].dstBinding = 1;
-
-		// Write mesh material texture
-		VkDescriptorImageInfo materialTextureDesc{};
-		materialTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-		materialTextureDesc.imageView = *mesh->GetMaterial()->GetMaterialTexture()->GetImageView();
-		materialTextureDesc.sampler = vulkan->GetColorSampler();
-
-		descriptorWrite[2] = {};
-		descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[2].pNext = NULL;
-		descriptorWrite[2].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[2].descriptorCount = 1;
-		descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite[2].pImageInfo = &materialTextureDesc;
-		descriptorWrite[2].dstArrayElement = 0;
-		descriptorWrite[2].dstBinding = 2;
-
-		// Write mesh normal texture if available
-		VkDescriptorImageInfo normalTextureDesc{};
-		if (mesh->GetMaterial()->HasNormalMap())
+bool Model::HasPackedVertices()
+{
+	return (meshFlags & RCM_FLAG_PACKED_VERTICES) != 0;
+}
+
+unsigned int Model::GetRecordingThread()
+{
+	return (prefab != NULL ? prefab : this)->drawCommandCache->GetRecordingThread();
+}
+
+Model * Model::GetPrefab()
+{
+	return prefab;
+}
+
+VkDescriptorSet Model::GetDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, unsigned int meshId, uint32_t & setVersion)
+{
+	setVersion = 0;
+
+	if (meshDescriptorSets.empty())
+	{
+		MeshDescriptorSet emptySet = { VK_NULL_HANDLE, { 0, 0, 0 }, 0 };
+		meshDescriptorSets.resize(meshes.size(), emptySet);
+	}
+
+	MeshDescriptorSet & meshSet = meshDescriptorSets[meshId];
+	Material * material = meshes[meshId]->GetMaterial();
+	uint32_t imageVersions[3] = { material->GetDiffuseTexture()->GetImageVersion(), material->GetMaterialTexture()->GetImageVersion(),
+		material->HasNormalMap() ? material->GetNormalTexture()->GetImageVersion() : 0 };
+
+	if (meshSet.set == VK_NULL_HANDLE)
+	{
+		if (!pipeline->AllocateDescriptorSet(vulkan->GetVulkanDevice(), &meshSet.set))
 		{
-			normalTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-			normalTextureDesc.imageView = *mesh->GetMaterial()->GetNormalTexture()->GetImageView();
-			normalTextureDesc.sampler = vulkan->GetColorSampler();
+			gLogManager->AddMessage("ERROR: Failed to allocate a mesh descriptor set!");
+			meshSet.set = VK_NULL_HANDLE;
+			return VK_NULL_HANDLE;
 		}
-
-		descriptorWrite[3] = {};
-		descriptorWrite[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[3].pNext = NULL;
-		descriptorWrite[3].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[3].descriptorCount = 1;
-		descriptorWrite[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite[3].pImageInfo = (mesh->GetMaterial()->HasNormalMap() ? &normalTextureDesc : &diffuseTextureDesc);
-		descriptorWrite[3].dstArrayElement = 0;
-		descriptorWrite[3].dstBinding = 3;
-
-		// Update material uniform buffer
-		descriptorWrite[4] = {};
-		descriptorWrite[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[4].pNext = NULL;
-		descriptorWrite[4].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[4].descriptorCount = 1;
-		descriptorWrite[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[4].pBufferInfo = mesh->GetMaterialBufferInfo();
-		descriptorWrite[4].dstArrayElement = 0;
-		descriptorWrite[4].dstBinding = 4;
-
-		vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
-	}
-	else if (pipeline->GetPipelineName() == "SHADOW")
-	{
-		VkWriteDescriptorSet descriptorWrite[3];
-
-		descriptorWrite[0] = {};
-		descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[0].pNext = NULL;
-		descriptorWrite[0].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[0].descriptorCount = 1;
-		descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[0].pBufferInfo = deferredVS_UBO->GetBufferInfo();
-		descriptorWrite[0].dstArrayElement = 0;
-		descriptorWrite[0].dstBinding = 0;
-
-		descriptorWrite[1] = {};
-		descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[1].pNext = NULL;
-		descriptorWrite[1].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[1].descriptorCount = 1;
-		descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[1].pBufferInfo = shadowMaps->GetBufferInfo();
-		descriptorWrite[1].dstArrayElement = 0;
-		descriptorWrite[1].dstBinding = 1;
-
-		descriptorWrite[2] = {};
-		descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[2].pNext = NULL;
-		descriptorWrite[2].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[2].descriptorCount = 1;
-		descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[2].pBufferInfo = shadowGS_UBO->GetBufferInfo();
-		descriptorWrite[2].dstArrayElement = 0;
-		descriptorWrite[2].dstBinding = 2;
-
-		vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
-	}
-}
-
-bool Model::InitUniformBuffers(VulkanDevice * vulkanDevice)
-{
-	deferredVS_UBO = new VulkanBuffer();
-	if (!deferredVS_UBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &vertexUniformBuffer,
-		sizeof(vertexUniformBuffer), false))
-	{
-		gLogManager->AddMessage("ERROR: Failed to init deferred vs uniform buffer!");
-		return false;
+		meshSetPipeline = pipeline;
+	}
+	else if (memcmp(meshSet.imageVersions, imageVersions, sizeof(imageVersions)) == 0)
+	{
+		setVersion = meshSet.version;
+		return meshSet.set;
 	}
 
-	for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
-		frustumCullData.frustumCullCascade[i] = 0.0f;
-	shadowGS_UBO = new VulkanBuffer();
-	if (!shadowGS_UBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &frustumCullData,
-		sizeof(frustumCullData), false))
+	// The deferred pass of the last frame is done with the set by now, it waited for its fence. Draws recorded with
+	// the old contents are invalid after the update, the new version makes them record again.
+	UpdateDescriptorSet(vulkan, meshSet.set, meshes[meshId]);
+	memcpy(meshSet.imageVersions, imageVersions, sizeof(imageVersions));
+	meshSet.version++;
+	setVersion = meshSet.version;
+
+	return meshSet.set;
+}
+
+void Model::UpdateDescriptorSet(VulkanInterface * vulkan, VkDescriptorSet set, Mesh * mesh)
+{
+	// The instance data is read through the frame set of the pipeline, the mesh set only holds the textures
+	VkWriteDescriptorSet descriptorWrite[3];
+
+	// Write mesh diffuse texture
+	VkDescriptorImageInfo diffuseTextureDesc{};
+	diffuseTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	diffuseTextureDesc.imageView = *mesh->GetMaterial()->GetDiffuseTexture()->GetImageView();
+	diffuseTextureDesc.sampler = vulkan->GetColorSampler();
+
+	descriptorWrite[0] = {};
+	descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[0].pNext = NULL;
+	descriptorWrite[0].dstSet = set;
+	descriptorWrite[0].descriptorCount = 1;
+	descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite[0].pImageInfo = &diffuseTextureDesc;
+	descriptorWrite[0].dstArrayElement = 0;
+	descriptorWrite[0].dstBinding = 1;
+
+	// Write mesh material texture
+	VkDescriptorImageInfo materialTextureDesc{};
+	materialTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	materialTextureDesc.imageView = *mesh->GetMaterial()->GetMaterialTexture()->GetImageView();
+	materialTextureDesc.sampler = vulkan->GetColorSampler();
+
+	descriptorWrite[1] = {};
+	descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[1].pNext = NULL;
+	descriptorWrite[1].dstSet = set;
+	descriptorWrite[1].descriptorCount = 1;
+	descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite[1].pImageInfo = &materialTextureDesc;
+	descriptorWrite[1].dstArrayElement = 0;
+	descriptorWrite[1].dstBinding = 2;
+
+	// Write mesh normal texture if available
+	VkDescriptorImageInfo normalTextureDesc{};
+	if (mesh->GetMaterial()->HasNormalMap())
 	{
-		gLogManager->AddMessage("ERROR: Failed to init shadow gs uniform buffer!");
-		return false;
+		normalTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		normalTextureDesc.imageView = *mesh->GetMaterial()->GetNormalTexture()->GetImageView();
+		normalTextureDesc.sampler = vulkan->GetColorSampler();
 	}
 
-	return true;
+	descriptorWrite[2] = {};
+	descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[2].pNext = NULL;
+	descriptorWrite[2].dstSet = set;
+	descriptorWrite[2].descriptorCount = 1;
+	descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite[2].pImageInfo = (mesh->GetMaterial()->HasNormalMap() ? &normalTextureDesc : &diffuseTextureDesc);
+	descriptorWrite[2].dstArrayElement = 0;
+	descriptorWrite[2].dstBinding = 3;
+
+	vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
 }
 
-bool Model::ReadRCMFile(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, std::string filename)
+bool Model::ReadRCMFile(std::string filename)
 {
-	// Open .rcm file
-	FILE * file = fopen(filename.c_str(), "rb");
-	if (file == NULL)
+	// Map .rcm file, it stays mapped until the mesh data is uploaded in InitResources
+	if (!modelFile.Init(filename))
 	{
 		gLogManager->AddMessage("ERROR: Model file not found!");
 		return false;
 	}
+	modelFile.Prefetch();
 
 	// Open .mat file
 	size_t pos = filename.rfind('.');
 	filename.replace(pos, 4, ".mat");
 
-	std::ifstream matFile(filename.c_str());
-	if (!matFile.is_open())
+	MappedFile materialFile;
+	if (!materialFile.Init(filename))
 	{
 		gLogManager->AddMessage("ERROR: Model .mat file not found! (" + filename + ")");
 		return false;
 	}
 
+	std::istringstream matFile(std::string((const char*)materialFile.GetData(), materialFile.GetSize()));
+	materialFile.Unload();
+
+	// Files cooked by RC-Tools start with a header, its flags tell how the meshes are stored
+	size_t headerSize;
+	if (!ReadMeshHeader(modelFile.GetData(), modelFile.GetSize(), meshFlags, headerSize))
+	{
+		gLogManager->AddMessage("ERROR: Model file has an unknown version! (" + filename + ")");
+		return false;
+	}
+	if (meshFlags & RCM_FLAG_LEGACY_PACKED_VERTICES)
+	{
+		gLogManager->AddMessage("ERROR: Model file has old packed vertices, re-cook it with RC-Tools cookmesh! (" + filename + ")");
+		return false;
+	}
+	modelFile.SetReadOffset(headerSize);
+
 	unsigned int meshCount;
-	fread(&meshCount, sizeof(unsigned int), 1, file);
-	fread(&frustumCullRadius, sizeof(float), 1, file);
+	if (!modelFile.Read(&meshCount, sizeof(unsigned int)) || !modelFile.Read(&frustumCullRadius, sizeof(float)))
+	{
+		gLogManager->AddMessage("ERROR: Model file is corrupted! (" + filename + ")");
+		return false;
+	}
 
 	for (unsigned int i = 0; i < meshCount; i++)
 	{
 		// Create and read mesh data
-		char meshIdentifier[16];
-		sprintf(meshIdentifier, "_mesh%d", i);
-
 		Mesh * mesh = new Mesh();
-		if (!mesh->Init(vulkan, file, filename + meshIdentifier))
+		meshes.push_back(mesh);
+		if (!mesh->Read(&modelFile, meshFlags))
 		{
-			gLogManager->AddMessage("ERROR: Failed to init a mesh!");
+			gLogManager->AddMessage("ERROR: Model file is corrupted! (" + filename + ")");
 			return false;
 		}
-		meshes.push_back(mesh);
-
-		std::string texturePath;
-		char diffuseTextureName[64];
-		char normalTextureName[64];
 
-		// Init mesh material
-		Material * material = new Material();
+		MeshResourceInfo info;
 
 		// Read diffuse texture
-		fread(diffuseTextureName, sizeof(char), 64, file);
-		if (strcmp(diffuseTextureName, "NONE") == 0)
-			texturePath = "data/textures/default_diffuse.rct";
+		std::string diffuseTextureName = modelFile.ReadString(64);
+		if (diffuseTextureName == "NONE")
+			info.diffuseTexturePath = "data/textures/default_diffuse.rct";
 		else
-			texturePath = "data/textures/" + std::string(diffuseTextureName);
-
-		Texture * diffuse = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice(), cmdBuffer);
-		if (diffuse == nullptr)
-			return false;
-
-		textures.push_back(diffuse);
-
-		material->SetDiffuseTexture(diffuse);
+			info.diffuseTexturePath = "data/textures/" + diffuseTextureName;
 
 		// Read normal texture if it's available
-		fread(normalTextureName, sizeof(char), 64, file);
-		if (strcmp(normalTextureName, "NONE") != 0)
-		{
-			texturePath = "data/textures/" + std::string(normalTextureName);
-
-			Texture * normal = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice(), cmdBuffer);
-			if (normal == nullptr)
-				return false;
-
-			textures.push_back(normal);
-
-			material->SetNormalTexture(normal);
-		}
+		std::string normalTextureName = modelFile.ReadString(64);
+		if (normalTextureName != "NONE")
+			info.normalTexturePath = "data/textures/" + normalTextureName;
 
 		std::string matName, matTextureName;
-		float metallicOffset, roughnessOffset;
-		matFile >> matName >> matTextureName >> metallicOffset >> roughnessOffset;
+		matFile >> matName >> matTextureName >> info.metallicOffset >> info.roughnessOffset;
 
 		// Read material texture
 		if (matTextureName == "NONE")
-			texturePath = "data/textures/default_material.rct";
+			info.materialTexturePath = "data/textures/default_material.rct";
 		else
-			texturePath = "data/textures/" + matTextureName;
+			info.materialTexturePath = "data/textures/" + matTextureName;
 
-		Texture * matTexture = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice(), cmdBuffer);
-		if (matTexture == nullptr)
-			return false;
+		meshResourceInfo.push_back(info);
+	}
 
-		textures.push_back(matTexture);
+	return true;
+}
 
-		material->SetMaterialTexture(matTexture);
-		material->SetMetallicOffset(metallicOffset);
-		material->SetRoughnessOffset(roughnessOffset);
+void Model::ReadCollisionFile(std::string filename)
+{
+	collisionMeshPresent = false;
 
-		materials.push_back(material);
-		meshes[i]->SetMaterial(material);
+	size_t pos = filename.rfind('.');
+	std::string cookedFilename = filename.substr(0, pos) + ".rcc";
+	std::string sourceFilename = filename.substr(0, pos) + ".col";
 
-		// Init draw command buffers for each meash
-		VulkanCommandBuffer * drawCmdBuffer = new VulkanCommandBuffer();
-		if (!drawCmdBuffer->Init(vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool(), false))
-		{
-			gLogManager->AddMessage("ERROR: Failed to create a draw command buffer!");
-			return false;
-		}
-		drawCmdBuffers.push_back(drawCmdBuffer);
+	bool cookedFound = collisionFile.Init(cookedFilename);
+	if (cookedFound && ReadCookedCollision(cookedFilename))
+		return;
+	collisionFile.Unload();
+
+	// Models without collision have neither file
+	if (!collisionFile.Init(sourceFilename))
+	{
+		collisionFile.Unload();
+		if (cookedFound)
+			gLogManager->AddMessage("ERROR: Model has no usable collision mesh! (" + filename + ")");
+		return;
 	}
 
-	fclose(file);
-	matFile.close();
+	if (!cookedFound)
+		gLogManager->AddMessage("WARNING: Collision mesh isn't cooked, building it from the source file! Run RC-Tools cookcol. (" +
+			sourceFilename + ")");
 
-	return true;
+	ReadSourceCollision(sourceFilename);
 }
 
-void Model::ReadCollisionFile(std::string filename)
+bool Model::ReadCookedCollision(std::string filename)
 {
-	size_t pos = filename.rfind('.');
-	filename.replace(pos, 4, ".col");
+	const RCCollisionHeader * header = (const RCCollisionHeader*)collisionFile.Read(sizeof(RCCollisionHeader));
+	if (header == NULL || header->magic != RCC_MAGIC)
+	{
+		gLogManager->AddMessage("ERROR: Collision file has an unknown format, re-cook it with RC-Tools cookcol! (" + filename + ")");
+		return false;
+	}
 
-	FILE * colFile = fopen(filename.c_str(), "rb");
-	if (colFile == NULL)
-		collisionMeshPresent = false;
-	else
+	if (header->version != RCC_VERSION)
 	{
-		collisionMeshPresent = true;
+		gLogManager->AddMessage("WARNING: Collision file was cooked for version " + std::to_string(header->version) + " instead of " +
+			std::to_string(RCC_VERSION) + ", re-cook it with RC-Tools cookcol! (" + filename + ")");
+		return false;
+	}
 
-		collisionMesh = new btTriangleMesh();
+	const float * vertices = (const float*)collisionFile.Read(sizeof(float) * 3 * header->vertexCount);
+	const int * indices = (const int*)collisionFile.Read(sizeof(int) * 3 * header->triangleCount);
+	if (vertices == NULL || indices == NULL || header->triangleCount == 0 ||
+		header->bvhOffset > collisionFile.GetSize() || header->bvhSize > collisionFile.GetSize() - header->bvhOffset)
+	{
+		gLogManager->AddMessage("ERROR: Collision file is corrupted, re-cook it with RC-Tools cookcol! (" + filename + ")");
+		return false;
+	}
 
-		struct ColVertex
-		{
-			float x, y, z;
-		};
+	// Bullet reads the welded vertices and indices straight from the file data
+	SetupCollisionMesh(vertices, header->vertexCount, indices, header->triangleCount,
+		btVector3(header->aabbMin[0], header->aabbMin[1], header->aabbMin[2]), btVector3(header->aabbMax[0], header->aabbMax[1], header->aabbMax[2]));
 
-		unsigned int colVertexCount;
+	// Bullet fixes up the serialized BVH in place, so it gets its own aligned and writable copy
+	if (header->bvhSize > 0 && header->bvhPointerSize == sizeof(void*))
+	{
+		collisionBvhData = btAlignedAlloc(header->bvhSize, RCC_BVH_ALIGNMENT);
+		memcpy(collisionBvhData, collisionFile.GetData() + header->bvhOffset, header->bvhSize);
 
-		fread(&colVertexCount, sizeof(unsigned int), 1, colFile);
-		for (unsigned int i = 0; i < colVertexCount / 3; i++)
+		collisionBvh = btOptimizedBvh::deSerializeInPlace(collisionBvhData, header->bvhSize, false);
+		if (collisionBvh == NULL)
 		{
-			btVector3 v0, v1, v2;
-			ColVertex colVertex;
+			btAlignedFree(collisionBvhData);
+			collisionBvhData = NULL;
+		}
+	}
 
-			fread(&colVertex, sizeof(ColVertex), 1, colFile);
-			v0 = btVector3(colVertex.x, colVertex.y, colVertex.z);
-			fread(&colVertex, sizeof(ColVertex), 1, colFile);
-			v1 = btVector3(colVertex.x, colVertex.y, colVertex.z);
-			fread(&colVertex, sizeof(ColVertex), 1, colFile);
-			v2 = btVector3(colVertex.x, colVertex.y, colVertex.z);
+	return true;
+}
 
-			collisionMesh->addTriangle(v0, v1, v2);
-		}
+void Model::ReadSourceCollision(std::string filename)
+{
+	// Triangle soup, three vertices per triangle. The vertices are used from the file data and get sequential indices,
+	// the BVH is built when the shape is created.
+	unsigned int vertexCount = 0;
+	collisionFile.Read(&vertexCount, sizeof(unsigned int));
+	unsigned int triangleCount = vertexCount / 3;
+
+	const float * vertices = (const float*)collisionFile.Read(sizeof(float) * 9 * triangleCount);
+	if (vertices == NULL || triangleCount == 0)
+	{
+		gLogManager->AddMessage("ERROR: Collision file is corrupted! (" + filename + ")");
+		collisionFile.Unload();
+		return;
 	}
 
-	if (colFile)
-		fclose(colFile);
+	collisionIndices.resize(triangleCount * 3);
+	btVector3 aabbMin(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+	btVector3 aabbMax(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+	for (unsigned int i = 0; i < triangleCount * 3; i++)
+	{
+		collisionIndices[i] = (int)i;
+
+		btVector3 vertex(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+		aabbMin.setMin(vertex);
+		aabbMax.setMax(vertex);
+	}
+
+	SetupCollisionMesh(vertices, triangleCount * 3, collisionIndices.data(), triangleCount, aabbMin, aabbMax);
+}
+
+void Model::SetupCollisionMesh(const float * vertices, unsigned int vertexCount, const int * indices, unsigned int triangleCount,
+	btVector3 aabbMin, btVector3 aabbMax)
+{
+	btIndexedMesh indexedMesh;
+	indexedMesh.m_numTriangles = triangleCount;
+	indexedMesh.m_triangleIndexBase = (const unsigned char*)indices;
+	indexedMesh.m_triangleIndexStride = sizeof(int) * 3;
+	indexedMesh.m_numVertices = vertexCount;
+	indexedMesh.m_vertexBase = (const unsigned char*)vertices;
+	indexedMesh.m_vertexStride = sizeof(float) * 3;
+	indexedMesh.m_indexType = PHY_INTEGER;
+	indexedMesh.m_vertexType = PHY_FLOAT;
+
+	collisionMesh = new btTriangleIndexVertexArray();
+	collisionMesh->addIndexedMesh(indexedMesh, PHY_INTEGER);
+	collisionMesh->setPremadeAabb(aabbMin, aabbMax);
+
+	collisionMeshPresent = true;
 }
 
 void Model::SetupPhysicsObject(float mass)
+{
+	SetupCollisionShape(mass);
+
+	btTransform transform;
+	transform.setIdentity();
+
+	CreateRigidBody(transform);
+}
+
+void Model::SetupCollisionShape(float mass)
 {
 	this->mass = (btScalar)mass;
 
@@ -528,56 +951,54 @@ void Model::SetupPhysicsObject(float mass)
 
 	if (collisionMeshPresent == false)
 	{
-		emptyCollisionShape = new btEmptyShape();
+		collisionShape = new btEmptyShape();
 		physicsStatic = true;
 	}
-	else
+	else if (physicsStatic == true)
 	{
-		collisionShape = new btGImpactMeshShape(collisionMesh);
-		collisionShape->setLocalScaling(btVector3(1, 1, 1));
-		collisionShape->setMargin(0.0f);
-		collisionShape->updateBound();
-	}
-
-	btTransform transform;
-	transform.setIdentity();
+		// Static meshes use the cooked BVH, it's only built here if the cooked one couldn't be used
+		btVector3 aabbMin, aabbMax;
+		collisionMesh->getPremadeAabb(&aabbMin, &aabbMax);
 
-	inertia = btVector3(0.0f, 0.0f, 0.0f);
+		btBvhTriangleMeshShape * meshShape = new btBvhTriangleMeshShape(collisionMesh, true, aabbMin, aabbMax, collisionBvh == NULL);
+		if (collisionBvh != NULL)
+			meshShape->setOptimizedBvh(collisionBvh);
 
-	if (physicsStatic == true)
-	{
-		if (collisionMeshPresent)
-		{
-			collisionShape->calculateLocalInertia(mass, inertia);
-			mainCollisionShape = collisionShape;
-		}
-		else
-		{
-			emptyCollisionShape->calculateLocalInertia(mass, inertia);
-			mainCollisionShape = emptyCollisionShape;
-		}
+		collisionShape = meshShape;
 	}
 	else
 	{
-		collisionShape->calculateLocalInertia(mass, inertia);
-		mainCollisionShape = collisionShape;
+		// Moving concave meshes need GImpact
+		btGImpactMeshShape * meshShape = new btGImpactMeshShape(collisionMesh);
+		meshShape->setLocalScaling(btVector3(1, 1, 1));
+		meshShape->setMargin(0.0f);
+		meshShape->updateBound();
+
+		collisionShape = meshShape;
 	}
 
-	CreateRigidBody(transform);
+	inertia = btVector3(0.0f, 0.0f, 0.0f);
+
+	if (physicsStatic == false)
+		collisionShape->calculateLocalInertia(mass, inertia);
 }
 
-void Model::CreateRigidBody(btTransform transform)
+void Model::CreateRigidBody(btTransform transform, bool addToWorld)
 {
 	btDefaultMotionState * motionState = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo rigidBodyCI(mass, motionState, mainCollisionShape, inertia);
+	btRigidBody::btRigidBodyConstructionInfo rigidBodyCI(mass, motionState, collisionShape, inertia);
 	rigidBody = new btRigidBody(rigidBodyCI);
-
-	physics->GetDynamicsWorld()->addRigidBody(rigidBody);
 	rigidBody->setFriction(1.0f);
+
+	if (addToWorld)
+		physics->GetDynamicsWorld()->addRigidBody(rigidBody);
 }
 
 void Model::RemoveRigidBody()
 {
+	if (rigidBody == NULL)
+		return;
+
 	physics->GetDynamicsWorld()->removeRigidBody(rigidBody);
 	delete rigidBody->getMotionState();
 	SAFE_DELETE(rigidBody);
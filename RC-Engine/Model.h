@@ -7,66 +7,149 @@
 #pragma once
 
 #include <BulletCollision/Gimpact/btGimpactShape.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
 
 #include "Mesh.h"
 #include "Camera.h"
 #include "Texture.h"
+#include "ResourceRegistry.h"
 #include "Material.h"
 #include "Physics.h"
 #include "ShadowMaps.h"
+#include "MappedFile.h"
+#include "DrawCommandCache.h"
 
 class Model
 {
 	private:
+		// Instances share the meshes, materials, textures and collision shape of their prefab
+		Model * prefab;
+
 		std::vector<Mesh*> meshes;
-		std::vector<Texture*> textures;
+		std::vector<ResourceHandle> textures;
 		std::vector<Material*> materials;
-		std::vector<VulkanCommandBuffer*> drawCmdBuffers;
+		// Only models without a prefab have one, instances are drawn by their prefab
+		DrawCommandCache * drawCommandCache;
+		std::vector<unsigned int> meshLods;
+		std::vector<unsigned int> shadowMeshLods;
 		float frustumCullRadius;
+		uint32_t meshFlags;
+
+		// Everything read from the model files that's needed to create the GPU resources
+		struct MeshResourceInfo
+		{
+			std::string diffuseTexturePath;
+			std::string normalTexturePath;
+			std::string materialTexturePath;
+			float metallicOffset;
+			float roughnessOffset;
+		};
+		std::vector<MeshResourceInfo> meshResourceInfo;
+		MappedFile modelFile;
 
-		struct VertexUniformBuffer
+		// Read by the shaders with gl_InstanceIndex. Every mesh has its own part of the array with room for all instances,
+		// sorted by the LOD they draw the mesh with.
+		struct DeferredInstanceData
 		{
 			glm::mat4 MVP;
 			glm::mat4 worldMatrix;
+			// hasNormalMap, metallicOffset, roughnessOffset, padding
+			glm::vec4 materialParams;
 		};
-		VertexUniformBuffer vertexUniformBuffer;
+		struct ShadowInstanceData
+		{
+			glm::mat4 worldMatrix;
+		};
+		std::vector<DeferredInstanceData> deferredInstanceData;
+		std::vector<ShadowInstanceData> shadowInstanceData;
 
 		struct FrustumUniformBuffer
 		{
 			float frustumCullCascade[SHADOW_CASCADE_COUNT];
 		};
 		FrustumUniformBuffer frustumCullData;
+		// Uniform ring slots of the model that owns the meshes, each pass writes its own copy of the instance data
+		unsigned int instanceCapacity;
+		uint32_t instanceSlots[DRAW_PASS_COUNT];
+		uint32_t frustumSlot;
 
-		VulkanBuffer * deferredVS_UBO;
-		VulkanBuffer * shadowGS_UBO;
+		// Descriptor sets stay with the model that owns the meshes, instances draw with the ones of their prefab.
+		// A mesh set only holds textures and is written again when one of them gets a new image, the version tells
+		// recorded draws that the set has changed. Shadow draws read nothing but the uniform ring and have no set.
+		struct MeshDescriptorSet
+		{
+			VkDescriptorSet set;
+			uint32_t imageVersions[3];
+			uint32_t version;
+		};
+		std::vector<MeshDescriptorSet> meshDescriptorSets;
+		VulkanPipeline * meshSetPipeline;
+
+		// Visible instances of a prefab are drawn together, one command buffer for each mesh with an instanced draw for
+		// every LOD. The cached draw is keyed by the instance count of each LOD.
+		struct BatchInstance
+		{
+			Model * model;
+			glm::mat4 worldMatrix;
+			float pixelsPerUnit;
+		};
+		std::vector<BatchInstance> batchInstances;
+		std::vector<unsigned int> instanceLods;
+		std::vector<uint32_t> lodInstanceCounts;
+		std::vector<uint32_t> batchData;
 
 		Physics * physics;
 		bool collisionMeshPresent;
 		bool physicsStatic;
-		btCollisionShape * emptyCollisionShape;
-		btGImpactMeshShape * collisionShape;
-		btCollisionShape * mainCollisionShape;
-		btTriangleMesh * collisionMesh;
+		MappedFile collisionFile;
+		// Only used when the mesh is built from an uncooked .col file
+		std::vector<int> collisionIndices;
+		btCollisionShape * collisionShape;
+		btTriangleIndexVertexArray * collisionMesh;
+		btOptimizedBvh * collisionBvh;
+		void * collisionBvhData;
 		btRigidBody * rigidBody;
 		btScalar mass;
 		btVector3 inertia;
 	private:
-		bool InitUniformBuffers(VulkanDevice * vulkanDevice);
-		bool ReadRCMFile(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, std::string filename);
-		void ReadCollisionFile(std::string filename);
 		void SetupPhysicsObject(float mass);
-		void CreateRigidBody(btTransform transform);
+		void SetupCollisionShape(float mass);
+		bool ReadCookedCollision(std::string filename);
+		void ReadSourceCollision(std::string filename);
+		void SetupCollisionMesh(const float * vertices, unsigned int vertexCount, const int * indices, unsigned int triangleCount,
+			btVector3 aabbMin, btVector3 aabbMax);
+		void CreateRigidBody(btTransform transform, bool addToWorld = true);
 		void RemoveRigidBody();
-		void UpdateDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, Mesh * mesh, ShadowMaps * shadowMaps);
+		bool InitDrawCommands(VulkanInterface * vulkan);
+		void GetDrawData(Camera * camera, glm::mat4 & worldMatrix, float & pixelsPerUnit);
+		VkDeviceSize GetInstanceDataSize(int pass);
+		unsigned int SelectMeshLod(int pass, unsigned int meshId, float pixelsPerUnit);
+		VkDescriptorSet GetDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, unsigned int meshId, uint32_t & setVersion);
+		void UpdateDescriptorSet(VulkanInterface * vulkan, VkDescriptorSet set, Mesh * mesh);
 	public:
 		Model();
 		~Model();
 
-		bool Init(std::string filename, VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer,
-			Physics * physics, float mass);
+		bool Init(std::string filename, VulkanInterface * vulkan, Physics * physics, float mass);
+		bool ReadFiles(std::string filename);
+		// The two halves of ReadFiles, they touch different data and can run on different threads at the same time
+		bool ReadRCMFile(std::string filename);
+		void ReadCollisionFile(std::string filename);
+		bool InitResources(VulkanInterface * vulkan);
+		void InitPhysics(Physics * physics, float mass);
+		// A prefab draws at most maxInstances instances at once
+		bool InitPrefab(std::string filename, VulkanInterface * vulkan, float mass, unsigned int maxInstances);
+		bool InitInstance(Model * prefab, VulkanInterface * vulkan, Physics * physics);
+		void Spawn(glm::vec3 position, glm::vec3 velocity);
+		void Despawn();
+		void GetTextureFilenames(std::vector<std::string> & filenames);
 		void Unload(VulkanInterface * vulkan);
-		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer, VulkanPipeline * vulkanPipeline,
+		// Both have to be called from the recording thread of the model. An instance drawn with Render is a batch of one,
+		// all instances of a prefab have to be drawn with one call each pass.
+		void Render(VulkanInterface * vulkan, std::vector<VkCommandBuffer> & drawCommands, VulkanPipeline * vulkanPipeline,
 			Camera * camera, ShadowMaps * shadowMaps);
+		void RenderInstances(VulkanInterface * vulkan, std::vector<VkCommandBuffer> & drawCommands, VulkanPipeline * vulkanPipeline,
+			Camera * camera, ShadowMaps * shadowMaps, Model * const * instances, unsigned int instanceCount);
 		void SetPosition(float x, float y, float z);
 		void SetRotation(float x, float y, float z);
 		void SetVelocity(float x, float y, float z);
@@ -76,4 +159,7 @@ class Model
 		Material * GetMaterial(int materialId);
 		float GetFrustumCullRadius();
 		glm::vec3 GetPosition();
+		bool HasPackedVertices();
+		unsigned int GetRecordingThread();
+		Model * GetPrefab();
 };
\ No newline at end of file
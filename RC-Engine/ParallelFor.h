@@ -0,0 +1,40 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: ParallelFor.h                                        |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+
+// Runs func(0) ... func(count - 1) spread across all hardware threads, the calling thread helps as well.
+// Returns when every index has been processed.
+inline void ParallelFor(unsigned int count, const std::function<void(unsigned int)> & func)
+{
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+	if (threadCount > count)
+		threadCount = count;
+
+	std::atomic<unsigned int> nextIndex(0);
+	auto worker = [&]()
+	{
+		unsigned int index;
+		while ((index = nextIndex++) < count)
+			func(index);
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threadCount; i++)
+		workers.push_back(std::thread(worker));
+
+	worker();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
\ No newline at end of file
@@ -5,9 +5,12 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
+#include <stddef.h>
+
 #include "PipelineManager.h"
 #include "LogManager.h"
 #include "StdInc.h"
+#include "MeshFormat.h"
 
 extern LogManager * gLogManager;
 
@@ -16,6 +19,8 @@ PipelineManager::PipelineManager()
 	defaultShader = NULL;
 	skinnedShader = NULL;
 	deferredShader = NULL;
+	skinnedPackedShader = NULL;
+	deferredPackedShader = NULL;
 	wireframeShader = NULL;
 	skydomeShader = NULL;
 	canvasShader = NULL;
@@ -29,6 +34,10 @@ PipelineManager::PipelineManager()
 	canvasPipeline = NULL;
 	shadowPipeline = NULL;
 	shadowSkinnedPipeline = NULL;
+	skinnedPackedPipeline = NULL;
+	deferredPackedPipeline = NULL;
+	shadowPackedPipeline = NULL;
+	shadowSkinnedPackedPipeline = NULL;
 }
 
 bool PipelineManager::InitUIPipelines(VulkanInterface * vulkan)
@@ -73,6 +82,21 @@ bool PipelineManager::InitGamePipelines(VulkanInterface * vulkan, ShadowMaps * s
 		return false;
 	}
 
+	// Packed vertices need their normal and tangent decoded, only the vertex shaders differ
+	skinnedPackedShader = new Shader();
+	if (!skinnedPackedShader->Init(vulkan->GetVulkanDevice(), "skinnedpacked", false))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init skinned packed shader!");
+		return false;
+	}
+
+	deferredPackedShader = new Shader();
+	if (!deferredPackedShader->Init(vulkan->GetVulkanDevice(), "deferredpacked", false))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init deferred packed shader!");
+		return false;
+	}
+
 	wireframeShader = new Shader();
 	if (!wireframeShader->Init(vulkan->GetVulkanDevice(), "wireframe", false))
 	{
@@ -143,6 +167,10 @@ bool PipelineManager::InitGamePipelines(VulkanInterface * vulkan, ShadowMaps * s
 
 void PipelineManager::Unload(VulkanInterface * vulkan)
 {
+	SAFE_UNLOAD(shadowSkinnedPackedPipeline, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(shadowPackedPipeline, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(deferredPackedPipeline, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(skinnedPackedPipeline, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(shadowSkinnedPipeline, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(shadowPipeline, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(canvasPipeline, vulkan->GetVulkanDevice());
@@ -157,24 +185,39 @@ void PipelineManager::Unload(VulkanInterface * vulkan)
 	SAFE_UNLOAD(canvasShader, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(skydomeShader, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(wireframeShader, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(deferredPackedShader, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(skinnedPackedShader, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(deferredShader, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(skinnedShader, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(defaultShader, vulkan->GetVulkanDevice());
 }
 
+void PipelineManager::UpdateFrameSets(VulkanDevice * vulkanDevice)
+{
+	VulkanPipeline * pipelines[] = { defaultPipeline, skinnedPipeline, deferredPipeline, wireframePipeline, skydomePipeline,
+		canvasPipeline, shadowPipeline, shadowSkinnedPipeline, skinnedPackedPipeline, deferredPackedPipeline, shadowPackedPipeline,
+		shadowSkinnedPackedPipeline };
+
+	for (size_t i = 0; i < sizeof(pipelines) / sizeof(pipelines[0]); i++)
+	{
+		if (pipelines[i] != NULL)
+			pipelines[i]->UpdateFrameSet(vulkanDevice);
+	}
+}
+
 VulkanPipeline * PipelineManager::GetDefault()
 {
 	return defaultPipeline;
 }
 
-VulkanPipeline * PipelineManager::GetSkinned()
+VulkanPipeline * PipelineManager::GetSkinned(bool packedVertices)
 {
-	return skinnedPipeline;
+	return packedVertices ? skinnedPackedPipeline : skinnedPipeline;
 }
 
-VulkanPipeline * PipelineManager::GetDeferred()
+VulkanPipeline * PipelineManager::GetDeferred(bool packedVertices)
 {
-	return deferredPipeline;
+	return packedVertices ? deferredPackedPipeline : deferredPipeline;
 }
 
 VulkanPipeline * PipelineManager::GetWireframe()
@@ -192,14 +235,14 @@ VulkanPipeline * PipelineManager::GetCanvas()
 	return canvasPipeline;
 }
 
-VulkanPipeline * PipelineManager::GetShadow()
+VulkanPipeline * PipelineManager::GetShadow(bool packedVertices)
 {
-	return shadowPipeline;
+	return packedVertices ? shadowPackedPipeline : shadowPipeline;
 }
 
-VulkanPipeline * PipelineManager::GetShadowSkinned()
+VulkanPipeline * PipelineManager::GetShadowSkinned(bool packedVertices)
 {
-	return shadowSkinnedPipeline;
+	return packedVertices ? shadowSkinnedPackedPipeline : shadowSkinnedPipeline;
 }
 
 bool PipelineManager::BuildDefaultPipeline(VulkanInterface * vulkan)
@@ -218,71 +261,59 @@ bool PipelineManager::BuildDefaultPipeline(VulkanInterface * vulkan)
 	vertexLayoutDefault[1].offset = sizeof(float) * 3;
 
 	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsDefault[10];
+	VkDescriptorSetLayoutBinding layoutBindingsDefault[8];
 
-	layoutBindingsDefault[0].binding = 0;
-	layoutBindingsDefault[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	layoutBindingsDefault[0].binding = 1;
+	layoutBindingsDefault[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[0].descriptorCount = 1;
-	layoutBindingsDefault[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	layoutBindingsDefault[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[0].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[1].binding = 1;
+	layoutBindingsDefault[1].binding = 2;
 	layoutBindingsDefault[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[1].descriptorCount = 1;
 	layoutBindingsDefault[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[1].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[2].binding = 2;
+	layoutBindingsDefault[2].binding = 3;
 	layoutBindingsDefault[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[2].descriptorCount = 1;
 	layoutBindingsDefault[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[2].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[3].binding = 3;
+	layoutBindingsDefault[3].binding = 4;
 	layoutBindingsDefault[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[3].descriptorCount = 1;
 	layoutBindingsDefault[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[3].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[4].binding = 4;
+	layoutBindingsDefault[4].binding = 5;
 	layoutBindingsDefault[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[4].descriptorCount = 1;
 	layoutBindingsDefault[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[4].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[5].binding = 5;
+	layoutBindingsDefault[5].binding = 7;
 	layoutBindingsDefault[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[5].descriptorCount = 1;
 	layoutBindingsDefault[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[5].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[6].binding = 6;
+	layoutBindingsDefault[6].binding = 8;
 	layoutBindingsDefault[6].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	layoutBindingsDefault[6].descriptorCount = 1;
 	layoutBindingsDefault[6].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[6].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[7].binding = 7;
+	layoutBindingsDefault[7].binding = 9;
 	layoutBindingsDefault[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDefault[7].descriptorCount = 1;
 	layoutBindingsDefault[7].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDefault[7].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDefault[8].binding = 8;
-	layoutBindingsDefault[8].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsDefault[8].descriptorCount = 1;
-	layoutBindingsDefault[8].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsDefault[8].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsDefault[9].binding = 9;
-	layoutBindingsDefault[9].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	layoutBindingsDefault[9].descriptorCount = 1;
-	layoutBindingsDefault[9].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsDefault[9].pImmutableSamplers = VK_NULL_HANDLE;
-
 	// Type counts
-	VkDescriptorPoolSize typeCounts[10];
-	typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	VkDescriptorPoolSize typeCounts[8];
+	typeCounts[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[0].descriptorCount = 1;
 	typeCounts[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[1].descriptorCount = 1;
@@ -298,10 +329,28 @@ bool PipelineManager::BuildDefaultPipeline(VulkanInterface * vulkan)
 	typeCounts[6].descriptorCount = 1;
 	typeCounts[7].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[7].descriptorCount = 1;
-	typeCounts[8].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[8].descriptorCount = 1;
-	typeCounts[9].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	typeCounts[9].descriptorCount = 1;
+
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsDefault[2];
+
+	frameBindingsDefault[0].binding = 0;
+	frameBindingsDefault[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsDefault[0].descriptorCount = 1;
+	frameBindingsDefault[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsDefault[0].pImmutableSamplers = VK_NULL_HANDLE;
+
+	frameBindingsDefault[1].binding = 6;
+	frameBindingsDefault[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsDefault[1].descriptorCount = 1;
+	frameBindingsDefault[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	frameBindingsDefault[1].pImmutableSamplers = VK_NULL_HANDLE;
+
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCounts[2];
+	frameTypeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[0].descriptorCount = 1;
+	frameTypeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[1].descriptorCount = 1;
 
 	struct DefaultVertex {
 		float x, y, z;
@@ -315,8 +364,11 @@ bool PipelineManager::BuildDefaultPipeline(VulkanInterface * vulkan)
 	pipelineCI.vertexLayout = vertexLayoutDefault;
 	pipelineCI.numVertexLayout = 2;
 	pipelineCI.layoutBindings = layoutBindingsDefault;
-	pipelineCI.numLayoutBindings = 10;
+	pipelineCI.numLayoutBindings = 8;
 	pipelineCI.typeCounts = typeCounts;
+	pipelineCI.frameLayoutBindings = frameBindingsDefault;
+	pipelineCI.numFrameLayoutBindings = 2;
+	pipelineCI.frameTypeCounts = frameTypeCounts;
 	pipelineCI.strideSize = sizeof(DefaultVertex);
 	pipelineCI.numColorAttachments = 1;
 	pipelineCI.wireframeEnabled = false;
@@ -379,59 +431,64 @@ bool PipelineManager::BuildSkinnedPipeline(VulkanInterface * vulkan)
 	vertexLayoutSkinned[6].offset = sizeof(float) * 15 + sizeof(uint32_t) * 4;
 
 	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsSkinned[6];
+	VkDescriptorSetLayoutBinding layoutBindingsSkinned[4];
 
-	layoutBindingsSkinned[0].binding = 0;
-	layoutBindingsSkinned[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	layoutBindingsSkinned[0].binding = 2;
+	layoutBindingsSkinned[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsSkinned[0].descriptorCount = 1;
-	layoutBindingsSkinned[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	layoutBindingsSkinned[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsSkinned[0].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsSkinned[1].binding = 1;
-	layoutBindingsSkinned[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	layoutBindingsSkinned[1].binding = 3;
+	layoutBindingsSkinned[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsSkinned[1].descriptorCount = 1;
-	layoutBindingsSkinned[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	layoutBindingsSkinned[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsSkinned[1].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsSkinned[2].binding = 2;
+	layoutBindingsSkinned[2].binding = 4;
 	layoutBindingsSkinned[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsSkinned[2].descriptorCount = 1;
 	layoutBindingsSkinned[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsSkinned[2].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsSkinned[3].binding = 3;
-	layoutBindingsSkinned[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	layoutBindingsSkinned[3].binding = 5;
+	layoutBindingsSkinned[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	layoutBindingsSkinned[3].descriptorCount = 1;
 	layoutBindingsSkinned[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsSkinned[3].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsSkinned[4].binding = 4;
-	layoutBindingsSkinned[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	layoutBindingsSkinned[4].descriptorCount = 1;
-	layoutBindingsSkinned[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsSkinned[4].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsSkinned[5].binding = 5;
-	layoutBindingsSkinned[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsSkinned[5].descriptorCount = 1;
-	layoutBindingsSkinned[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsSkinned[5].pImmutableSamplers = VK_NULL_HANDLE;
-
 	// Type counts
-	VkDescriptorPoolSize typeCounts[6];
-
-	typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	VkDescriptorPoolSize typeCounts[4];
+	typeCounts[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[0].descriptorCount = 1;
-	typeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	typeCounts[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[1].descriptorCount = 1;
 	typeCounts[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[2].descriptorCount = 1;
-	typeCounts[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	typeCounts[3].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	typeCounts[3].descriptorCount = 1;
-	typeCounts[4].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	typeCounts[4].descriptorCount = 1;
-	typeCounts[5].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[5].descriptorCount = 1;
+
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsSkinned[2];
+
+	frameBindingsSkinned[0].binding = 0;
+	frameBindingsSkinned[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsSkinned[0].descriptorCount = 1;
+	frameBindingsSkinned[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsSkinned[0].pImmutableSamplers = VK_NULL_HANDLE;
+
+	frameBindingsSkinned[1].binding = 1;
+	frameBindingsSkinned[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsSkinned[1].descriptorCount = 1;
+	frameBindingsSkinned[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsSkinned[1].pImmutableSamplers = VK_NULL_HANDLE;
+
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCounts[2];
+	frameTypeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[0].descriptorCount = 1;
+	frameTypeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[1].descriptorCount = 1;
 
 	struct SkinnedVertex {
 		float x, y, z;
@@ -450,8 +507,11 @@ bool PipelineManager::BuildSkinnedPipeline(VulkanInterface * vulkan)
 	pipelineCI.vertexLayout = vertexLayoutSkinned;
 	pipelineCI.numVertexLayout = 7;
 	pipelineCI.layoutBindings = layoutBindingsSkinned;
-	pipelineCI.numLayoutBindings = 6;
+	pipelineCI.numLayoutBindings = 4;
 	pipelineCI.typeCounts = typeCounts;
+	pipelineCI.frameLayoutBindings = frameBindingsSkinned;
+	pipelineCI.numFrameLayoutBindings = 2;
+	pipelineCI.frameTypeCounts = frameTypeCounts;
 	pipelineCI.strideSize = sizeof(SkinnedVertex);
 	pipelineCI.numColorAttachments = 4;
 	pipelineCI.wireframeEnabled = false;
@@ -463,6 +523,30 @@ bool PipelineManager::BuildSkinnedPipeline(VulkanInterface * vulkan)
 	if (!skinnedPipeline->Init(vulkan, &pipelineCI))
 		return false;
 
+	// Packed vertex variant, its shader decodes the octahedral normal and tangent and has no bitangent input
+	VkVertexInputAttributeDescription vertexLayoutSkinnedPacked[6];
+	memcpy(vertexLayoutSkinnedPacked, vertexLayoutSkinned, sizeof(vertexLayoutSkinnedPacked));
+
+	vertexLayoutSkinnedPacked[1].format = VK_FORMAT_R16G16_SFLOAT;
+	vertexLayoutSkinnedPacked[1].offset = offsetof(RCPackedSkinnedVertex, uv);
+	vertexLayoutSkinnedPacked[2].format = VK_FORMAT_R16G16_SNORM;
+	vertexLayoutSkinnedPacked[2].offset = offsetof(RCPackedSkinnedVertex, normal);
+	vertexLayoutSkinnedPacked[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+	vertexLayoutSkinnedPacked[3].offset = offsetof(RCPackedSkinnedVertex, boneWeights);
+	vertexLayoutSkinnedPacked[4].format = VK_FORMAT_R8G8B8A8_SINT;
+	vertexLayoutSkinnedPacked[4].offset = offsetof(RCPackedSkinnedVertex, boneIDs);
+	vertexLayoutSkinnedPacked[5].format = VK_FORMAT_R8G8B8A8_SNORM;
+	vertexLayoutSkinnedPacked[5].offset = offsetof(RCPackedSkinnedVertex, tangent);
+
+	pipelineCI.shader = skinnedPackedShader;
+	pipelineCI.vertexLayout = vertexLayoutSkinnedPacked;
+	pipelineCI.numVertexLayout = 6;
+	pipelineCI.strideSize = sizeof(RCPackedSkinnedVertex);
+
+	skinnedPackedPipeline = new VulkanPipeline();
+	if (!skinnedPackedPipeline->Init(vulkan, &pipelineCI))
+		return false;
+
 	return true;
 }
 
@@ -497,51 +581,48 @@ bool PipelineManager::BuildDeferredPipeline(VulkanInterface * vulkan)
 	vertexLayoutDeferred[4].offset = sizeof(float) * 11;
 
 	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsDeferred[5];
+	VkDescriptorSetLayoutBinding layoutBindingsDeferred[3];
 
-	layoutBindingsDeferred[0].binding = 0;
-	layoutBindingsDeferred[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	layoutBindingsDeferred[0].binding = 1;
+	layoutBindingsDeferred[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDeferred[0].descriptorCount = 1;
-	layoutBindingsDeferred[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	layoutBindingsDeferred[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDeferred[0].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDeferred[1].binding = 1;
+	layoutBindingsDeferred[1].binding = 2;
 	layoutBindingsDeferred[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDeferred[1].descriptorCount = 1;
 	layoutBindingsDeferred[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDeferred[1].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDeferred[2].binding = 2;
+	layoutBindingsDeferred[2].binding = 3;
 	layoutBindingsDeferred[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsDeferred[2].descriptorCount = 1;
 	layoutBindingsDeferred[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsDeferred[2].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsDeferred[3].binding = 3;
-	layoutBindingsDeferred[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	layoutBindingsDeferred[3].descriptorCount = 1;
-	layoutBindingsDeferred[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsDeferred[3].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsDeferred[4].binding = 4;
-	layoutBindingsDeferred[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsDeferred[4].descriptorCount = 1;
-	layoutBindingsDeferred[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsDeferred[4].pImmutableSamplers = VK_NULL_HANDLE;
-
 	// Type counts
-	VkDescriptorPoolSize typeCounts[5];
-
-	typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	VkDescriptorPoolSize typeCounts[3];
+	typeCounts[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[0].descriptorCount = 1;
 	typeCounts[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[1].descriptorCount = 1;
 	typeCounts[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[2].descriptorCount = 1;
-	typeCounts[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	typeCounts[3].descriptorCount = 1;
-	typeCounts[4].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[4].descriptorCount = 1;
+
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsDeferred[1];
+
+	frameBindingsDeferred[0].binding = 0;
+	frameBindingsDeferred[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	frameBindingsDeferred[0].descriptorCount = 1;
+	frameBindingsDeferred[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsDeferred[0].pImmutableSamplers = VK_NULL_HANDLE;
+
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCounts[1];
+	frameTypeCounts[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	frameTypeCounts[0].descriptorCount = 1;
 
 	struct DeferredVertex {
 		float x, y, z;
@@ -558,8 +639,11 @@ bool PipelineManager::BuildDeferredPipeline(VulkanInterface * vulkan)
 	pipelineCI.vertexLayout = vertexLayoutDeferred;
 	pipelineCI.numVertexLayout = 5;
 	pipelineCI.layoutBindings = layoutBindingsDeferred;
-	pipelineCI.numLayoutBindings = 5;
+	pipelineCI.numLayoutBindings = 3;
 	pipelineCI.typeCounts = typeCounts;
+	pipelineCI.frameLayoutBindings = frameBindingsDeferred;
+	pipelineCI.numFrameLayoutBindings = 1;
+	pipelineCI.frameTypeCounts = frameTypeCounts;
 	pipelineCI.strideSize = sizeof(DeferredVertex);
 	pipelineCI.numColorAttachments = 4;
 	pipelineCI.wireframeEnabled = false;
@@ -571,6 +655,26 @@ bool PipelineManager::BuildDeferredPipeline(VulkanInterface * vulkan)
 	if (!deferredPipeline->Init(vulkan, &pipelineCI))
 		return false;
 
+	// Packed vertex variant, its shader decodes the octahedral normal and tangent and has no bitangent input
+	VkVertexInputAttributeDescription vertexLayoutDeferredPacked[4];
+	memcpy(vertexLayoutDeferredPacked, vertexLayoutDeferred, sizeof(vertexLayoutDeferredPacked));
+
+	vertexLayoutDeferredPacked[1].format = VK_FORMAT_R16G16_SFLOAT;
+	vertexLayoutDeferredPacked[1].offset = offsetof(RCPackedVertex, uv);
+	vertexLayoutDeferredPacked[2].format = VK_FORMAT_R16G16_SNORM;
+	vertexLayoutDeferredPacked[2].offset = offsetof(RCPackedVertex, normal);
+	vertexLayoutDeferredPacked[3].format = VK_FORMAT_R8G8B8A8_SNORM;
+	vertexLayoutDeferredPacked[3].offset = offsetof(RCPackedVertex, tangent);
+
+	pipelineCI.shader = deferredPackedShader;
+	pipelineCI.vertexLayout = vertexLayoutDeferredPacked;
+	pipelineCI.numVertexLayout = 4;
+	pipelineCI.strideSize = sizeof(RCPackedVertex);
+
+	deferredPackedPipeline = new VulkanPipeline();
+	if (!deferredPackedPipeline->Init(vulkan, &pipelineCI))
+		return false;
+
 	return true;
 }
 
@@ -641,27 +745,27 @@ bool PipelineManager::BuildSkydomePipeline(VulkanInterface * vulkan)
 	vertexLayoutSkydome[0].format = VK_FORMAT_R32G32B32_SFLOAT;
 	vertexLayoutSkydome[0].offset = 0;
 
-	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsSkydome[2];
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsSkydome[2];
 
-	layoutBindingsSkydome[0].binding = 0;
-	layoutBindingsSkydome[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsSkydome[0].descriptorCount = 1;
-	layoutBindingsSkydome[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	layoutBindingsSkydome[0].pImmutableSamplers = VK_NULL_HANDLE;
+	frameBindingsSkydome[0].binding = 0;
+	frameBindingsSkydome[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsSkydome[0].descriptorCount = 1;
+	frameBindingsSkydome[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsSkydome[0].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsSkydome[1].binding = 1;
-	layoutBindingsSkydome[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsSkydome[1].descriptorCount = 1;
-	layoutBindingsSkydome[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsSkydome[1].pImmutableSamplers = VK_NULL_HANDLE;
+	frameBindingsSkydome[1].binding = 1;
+	frameBindingsSkydome[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsSkydome[1].descriptorCount = 1;
+	frameBindingsSkydome[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	frameBindingsSkydome[1].pImmutableSamplers = VK_NULL_HANDLE;
 
-	// Type counts
-	VkDescriptorPoolSize typeCounts[2];
-	typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[0].descriptorCount = 1;
-	typeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[1].descriptorCount = 1;
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCounts[2];
+	frameTypeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[0].descriptorCount = 1;
+	frameTypeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[1].descriptorCount = 1;
 
 	struct SkydomeVertex {
 		float x, y, z;
@@ -673,9 +777,12 @@ bool PipelineManager::BuildSkydomePipeline(VulkanInterface * vulkan)
 	pipelineCI.vulkanRenderpass = vulkan->GetForwardRenderpass();
 	pipelineCI.vertexLayout = vertexLayoutSkydome;
 	pipelineCI.numVertexLayout = 1;
-	pipelineCI.layoutBindings = layoutBindingsSkydome;
-	pipelineCI.numLayoutBindings = 2;
-	pipelineCI.typeCounts = typeCounts;
+	pipelineCI.layoutBindings = NULL;
+	pipelineCI.numLayoutBindings = 0;
+	pipelineCI.typeCounts = NULL;
+	pipelineCI.frameLayoutBindings = frameBindingsSkydome;
+	pipelineCI.numFrameLayoutBindings = 2;
+	pipelineCI.frameTypeCounts = frameTypeCounts;
 	pipelineCI.strideSize = sizeof(SkydomeVertex);
 	pipelineCI.numColorAttachments = 1;
 	pipelineCI.wireframeEnabled = false;
@@ -706,26 +813,32 @@ bool PipelineManager::BuildCanvasPipeline(VulkanInterface * vulkan)
 	vertexLayoutCanvas[1].offset = sizeof(float) * 3;
 
 	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsCanvas[2];
+	VkDescriptorSetLayoutBinding layoutBindingsCanvas[1];
 
-	layoutBindingsCanvas[0].binding = 0;
-	layoutBindingsCanvas[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	layoutBindingsCanvas[0].binding = 1;
+	layoutBindingsCanvas[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	layoutBindingsCanvas[0].descriptorCount = 1;
-	layoutBindingsCanvas[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	layoutBindingsCanvas[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 	layoutBindingsCanvas[0].pImmutableSamplers = VK_NULL_HANDLE;
 
-	layoutBindingsCanvas[1].binding = 1;
-	layoutBindingsCanvas[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	layoutBindingsCanvas[1].descriptorCount = 1;
-	layoutBindingsCanvas[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	layoutBindingsCanvas[1].pImmutableSamplers = VK_NULL_HANDLE;
-
 	// Type counts
-	VkDescriptorPoolSize typeCounts[2];
-	typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	VkDescriptorPoolSize typeCounts[1];
+	typeCounts[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	typeCounts[0].descriptorCount = 1;
-	typeCounts[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	typeCounts[1].descriptorCount = 1;
+
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsCanvas[1];
+
+	frameBindingsCanvas[0].binding = 0;
+	frameBindingsCanvas[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsCanvas[0].descriptorCount = 1;
+	frameBindingsCanvas[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsCanvas[0].pImmutableSamplers = VK_NULL_HANDLE;
+
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCounts[1];
+	frameTypeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[0].descriptorCount = 1;
 
 	struct CanvasVertex {
 		float x, y, z;
@@ -739,8 +852,11 @@ bool PipelineManager::BuildCanvasPipeline(VulkanInterface * vulkan)
 	pipelineCI.vertexLayout = vertexLayoutCanvas;
 	pipelineCI.numVertexLayout = 2;
 	pipelineCI.layoutBindings = layoutBindingsCanvas;
-	pipelineCI.numLayoutBindings = 2;
+	pipelineCI.numLayoutBindings = 1;
 	pipelineCI.typeCounts = typeCounts;
+	pipelineCI.frameLayoutBindings = frameBindingsCanvas;
+	pipelineCI.numFrameLayoutBindings = 1;
+	pipelineCI.frameTypeCounts = frameTypeCounts;
 	pipelineCI.strideSize = sizeof(CanvasVertex);
 	pipelineCI.numColorAttachments = 1;
 	pipelineCI.wireframeEnabled = false;
@@ -765,35 +881,35 @@ bool PipelineManager::BuildShadowPipeline(VulkanInterface * vulkan, ShadowMaps *
 	vertexLayoutShadow[0].format = VK_FORMAT_R32G32B32_SFLOAT;
 	vertexLayoutShadow[0].offset = 0;
 
-	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsShadow[3];
-
-	layoutBindingsShadow[0].binding = 0;
-	layoutBindingsShadow[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsShadow[0].descriptorCount = 1;
-	layoutBindingsShadow[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	layoutBindingsShadow[0].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsShadow[1].binding = 1;
-	layoutBindingsShadow[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsShadow[1].descriptorCount = 1;
-	layoutBindingsShadow[1].stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
-	layoutBindingsShadow[1].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsShadow[2].binding = 2;
-	layoutBindingsShadow[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsShadow[2].descriptorCount = 1;
-	layoutBindingsShadow[2].stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
-	layoutBindingsShadow[2].pImmutableSamplers = VK_NULL_HANDLE;
-
-	// Type counts
-	VkDescriptorPoolSize typeCounts[3];
-	typeCounts[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[0].descriptorCount = 1;
-	typeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[1].descriptorCount = 1;
-	typeCounts[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCounts[2].descriptorCount = 1;
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsShadow[3];
+
+	frameBindingsShadow[0].binding = 0;
+	frameBindingsShadow[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	frameBindingsShadow[0].descriptorCount = 1;
+	frameBindingsShadow[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsShadow[0].pImmutableSamplers = VK_NULL_HANDLE;
+
+	frameBindingsShadow[1].binding = 1;
+	frameBindingsShadow[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsShadow[1].descriptorCount = 1;
+	frameBindingsShadow[1].stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
+	frameBindingsShadow[1].pImmutableSamplers = VK_NULL_HANDLE;
+
+	frameBindingsShadow[2].binding = 2;
+	frameBindingsShadow[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsShadow[2].descriptorCount = 1;
+	frameBindingsShadow[2].stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
+	frameBindingsShadow[2].pImmutableSamplers = VK_NULL_HANDLE;
+
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCounts[3];
+	frameTypeCounts[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	frameTypeCounts[0].descriptorCount = 1;
+	frameTypeCounts[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[1].descriptorCount = 1;
+	frameTypeCounts[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCounts[2].descriptorCount = 1;
 
 	struct DeferredVertex {
 		float x, y, z;
@@ -809,9 +925,12 @@ bool PipelineManager::BuildShadowPipeline(VulkanInterface * vulkan, ShadowMaps *
 	pipelineCI.vulkanRenderpass = shadowMaps->GetShadowRenderpass();
 	pipelineCI.vertexLayout = vertexLayoutShadow;
 	pipelineCI.numVertexLayout = 1;
-	pipelineCI.layoutBindings = layoutBindingsShadow;
-	pipelineCI.numLayoutBindings = 3;
-	pipelineCI.typeCounts = typeCounts;
+	pipelineCI.layoutBindings = NULL;
+	pipelineCI.numLayoutBindings = 0;
+	pipelineCI.typeCounts = NULL;
+	pipelineCI.frameLayoutBindings = frameBindingsShadow;
+	pipelineCI.numFrameLayoutBindings = 3;
+	pipelineCI.frameTypeCounts = frameTypeCounts;
 	pipelineCI.strideSize = sizeof(DeferredVertex);
 	pipelineCI.numColorAttachments = 0;
 	pipelineCI.wireframeEnabled = false;
@@ -823,6 +942,13 @@ bool PipelineManager::BuildShadowPipeline(VulkanInterface * vulkan, ShadowMaps *
 	if (!shadowPipeline->Init(vulkan, &pipelineCI))
 		return false;
 
+	// Packed vertices keep a float position, only the stride changes
+	pipelineCI.strideSize = sizeof(RCPackedVertex);
+
+	shadowPackedPipeline = new VulkanPipeline();
+	if (!shadowPackedPipeline->Init(vulkan, &pipelineCI))
+		return false;
+
 	// Shadow skinned pipeline
 
 	// Vertex layout
@@ -846,35 +972,35 @@ bool PipelineManager::BuildShadowPipeline(VulkanInterface * vulkan, ShadowMaps *
 	vertexLayoutShadowSkinned[2].format = VK_FORMAT_R32G32B32A32_SINT;
 	vertexLayoutShadowSkinned[2].offset = sizeof(float) * 12;
 
-	// Layout bindings
-	VkDescriptorSetLayoutBinding layoutBindingsShadowSkinned[3];
-
-	layoutBindingsShadowSkinned[0].binding = 0;
-	layoutBindingsShadowSkinned[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsShadowSkinned[0].descriptorCount = 1;
-	layoutBindingsShadowSkinned[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	layoutBindingsShadowSkinned[0].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsShadowSkinned[1].binding = 1;
-	layoutBindingsShadowSkinned[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsShadowSkinned[1].descriptorCount = 1;
-	layoutBindingsShadowSkinned[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-	layoutBindingsShadowSkinned[1].pImmutableSamplers = VK_NULL_HANDLE;
-
-	layoutBindingsShadowSkinned[2].binding = 2;
-	layoutBindingsShadowSkinned[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	layoutBindingsShadowSkinned[2].descriptorCount = 1;
-	layoutBindingsShadowSkinned[2].stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
-	layoutBindingsShadowSkinned[2].pImmutableSamplers = VK_NULL_HANDLE;
-
-	// Type counts
-	VkDescriptorPoolSize typeCountsSkinned[3];
-	typeCountsSkinned[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCountsSkinned[0].descriptorCount = 1;
-	typeCountsSkinned[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCountsSkinned[1].descriptorCount = 1;
-	typeCountsSkinned[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	typeCountsSkinned[2].descriptorCount = 1;
+	// Frame set bindings, the uniform ring buffers read with dynamic offsets
+	VkDescriptorSetLayoutBinding frameBindingsShadowSkinned[3];
+
+	frameBindingsShadowSkinned[0].binding = 0;
+	frameBindingsShadowSkinned[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsShadowSkinned[0].descriptorCount = 1;
+	frameBindingsShadowSkinned[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsShadowSkinned[0].pImmutableSamplers = VK_NULL_HANDLE;
+
+	frameBindingsShadowSkinned[1].binding = 1;
+	frameBindingsShadowSkinned[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsShadowSkinned[1].descriptorCount = 1;
+	frameBindingsShadowSkinned[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	frameBindingsShadowSkinned[1].pImmutableSamplers = VK_NULL_HANDLE;
+
+	frameBindingsShadowSkinned[2].binding = 2;
+	frameBindingsShadowSkinned[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameBindingsShadowSkinned[2].descriptorCount = 1;
+	frameBindingsShadowSkinned[2].stageFlags = VK_SHADER_STAGE_GEOMETRY_BIT;
+	frameBindingsShadowSkinned[2].pImmutableSamplers = VK_NULL_HANDLE;
+
+	// Frame set type counts
+	VkDescriptorPoolSize frameTypeCountsSkinned[3];
+	frameTypeCountsSkinned[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCountsSkinned[0].descriptorCount = 1;
+	frameTypeCountsSkinned[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCountsSkinned[1].descriptorCount = 1;
+	frameTypeCountsSkinned[2].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	frameTypeCountsSkinned[2].descriptorCount = 1;
 
 	struct SkinnedVertex {
 		float x, y, z;
@@ -891,9 +1017,12 @@ bool PipelineManager::BuildShadowPipeline(VulkanInterface * vulkan, ShadowMaps *
 	pipelineCI.shader = shadowSkinnedShader;
 	pipelineCI.vertexLayout = vertexLayoutShadowSkinned;
 	pipelineCI.numVertexLayout = 3;
-	pipelineCI.layoutBindings = layoutBindingsShadowSkinned;
-	pipelineCI.numLayoutBindings = 3;
-	pipelineCI.typeCounts = typeCountsSkinned;
+	pipelineCI.layoutBindings = NULL;
+	pipelineCI.numLayoutBindings = 0;
+	pipelineCI.typeCounts = NULL;
+	pipelineCI.frameLayoutBindings = frameBindingsShadowSkinned;
+	pipelineCI.numFrameLayoutBindings = 3;
+	pipelineCI.frameTypeCounts = frameTypeCountsSkinned;
 	pipelineCI.strideSize = sizeof(SkinnedVertex);
 	pipelineCI.cullMode = VK_CULL_MODE_BACK_BIT;
 
@@ -901,5 +1030,21 @@ bool PipelineManager::BuildShadowPipeline(VulkanInterface * vulkan, ShadowMaps *
 	if (!shadowSkinnedPipeline->Init(vulkan, &pipelineCI))
 		return false;
 
+	// Packed vertex variant
+	VkVertexInputAttributeDescription vertexLayoutShadowSkinnedPacked[3];
+	memcpy(vertexLayoutShadowSkinnedPacked, vertexLayoutShadowSkinned, sizeof(vertexLayoutShadowSkinned));
+
+	vertexLayoutShadowSkinnedPacked[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+	vertexLayoutShadowSkinnedPacked[1].offset = offsetof(RCPackedSkinnedVertex, boneWeights);
+	vertexLayoutShadowSkinnedPacked[2].format = VK_FORMAT_R8G8B8A8_SINT;
+	vertexLayoutShadowSkinnedPacked[2].offset = offsetof(RCPackedSkinnedVertex, boneIDs);
+
+	pipelineCI.vertexLayout = vertexLayoutShadowSkinnedPacked;
+	pipelineCI.strideSize = sizeof(RCPackedSkinnedVertex);
+
+	shadowSkinnedPackedPipeline = new VulkanPipeline();
+	if (!shadowSkinnedPackedPipeline->Init(vulkan, &pipelineCI))
+		return false;
+
 	return true;
 }
\ No newline at end of file
@@ -23,6 +23,8 @@ class PipelineManager
 		Shader * canvasShader;
 		Shader * shadowShader;
 		Shader * shadowSkinnedShader;
+		Shader * skinnedPackedShader;
+		Shader * deferredPackedShader;
 
 		VulkanPipeline * defaultPipeline;
 		VulkanPipeline * skinnedPipeline;
@@ -32,6 +34,12 @@ class PipelineManager
 		VulkanPipeline * canvasPipeline;
 		VulkanPipeline * shadowPipeline;
 		VulkanPipeline * shadowSkinnedPipeline;
+
+		// Same passes for models cooked with packed vertices (MeshFormat.h)
+		VulkanPipeline * skinnedPackedPipeline;
+		VulkanPipeline * deferredPackedPipeline;
+		VulkanPipeline * shadowPackedPipeline;
+		VulkanPipeline * shadowSkinnedPackedPipeline;
 	private:
 		bool BuildDefaultPipeline(VulkanInterface * vulkan);
 		bool BuildSkinnedPipeline(VulkanInterface * vulkan);
@@ -46,13 +54,15 @@ class PipelineManager
 		bool InitUIPipelines(VulkanInterface * vulkan);
 		bool InitGamePipelines(VulkanInterface * vulkan, ShadowMaps * shadowMaps);
 		void Unload(VulkanInterface * vulkan);
+		// Writes the frame sets again after the uniform ring got a new buffer
+		void UpdateFrameSets(VulkanDevice * vulkanDevice);
 
 		VulkanPipeline * GetDefault();
-		VulkanPipeline * GetSkinned();
-		VulkanPipeline * GetDeferred();
+		VulkanPipeline * GetSkinned(bool packedVertices);
+		VulkanPipeline * GetDeferred(bool packedVertices);
 		VulkanPipeline * GetWireframe();
 		VulkanPipeline * GetSkydome();
 		VulkanPipeline * GetCanvas();
-		VulkanPipeline * GetShadow();
-		VulkanPipeline * GetShadowSkinned();
+		VulkanPipeline * GetShadow(bool packedVertices);
+		VulkanPipeline * GetShadowSkinned(bool packedVertices);
 };
\ No newline at end of file
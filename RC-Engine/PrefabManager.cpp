@@ -0,0 +1,162 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: PrefabManager.cpp                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <algorithm>
+
+#include "PrefabManager.h"
+#include "LogManager.h"
+#include "StdInc.h"
+
+extern LogManager * gLogManager;
+
+PrefabManager::PrefabManager()
+{
+	physics = NULL;
+}
+
+PrefabManager::~PrefabManager()
+{
+	physics = NULL;
+}
+
+void PrefabManager::Init(Physics * physics)
+{
+	this->physics = physics;
+}
+
+void PrefabManager::Unload(VulkanInterface * vulkan)
+{
+	// Instances go first, they use the resources of their prefab
+	for (auto it = prefabs.begin(); it != prefabs.end(); it++)
+	{
+		Prefab * prefab = it->second;
+		for (size_t i = 0; i < prefab->liveInstances.size(); i++)
+			SAFE_UNLOAD(prefab->liveInstances[i], vulkan);
+		for (size_t i = 0; i < prefab->freeInstances.size(); i++)
+			SAFE_UNLOAD(prefab->freeInstances[i], vulkan);
+
+		SAFE_UNLOAD(prefab->model, vulkan);
+		SAFE_DELETE(prefab);
+	}
+
+	prefabs.clear();
+	instancePrefabs.clear();
+	spawnedModels.clear();
+}
+
+bool PrefabManager::LoadPrefab(std::string filename, float mass, unsigned int poolSize, VulkanInterface * vulkan)
+{
+	if (prefabs.count(filename) > 0)
+		return true;
+
+	Prefab * prefab = new Prefab();
+	prefab->model = new Model();
+	if (!prefab->model->InitPrefab(filename, vulkan, mass, PREFAB_MAX_INSTANCES))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init prefab: " + filename);
+		SAFE_UNLOAD(prefab->model, vulkan);
+		SAFE_DELETE(prefab);
+		return false;
+	}
+	prefabs[filename] = prefab;
+
+	// Fill the pool up front, so the first spawns don't have to create anything either
+	for (unsigned int i = 0; i < poolSize; i++)
+	{
+		Model * model = CreateInstance(prefab, vulkan);
+		if (model == NULL)
+			return false;
+
+		prefab->freeInstances.push_back(model);
+	}
+
+	return true;
+}
+
+Model * PrefabManager::CreateInstance(Prefab * prefab, VulkanInterface * vulkan)
+{
+	Model * model = new Model();
+	if (!model->InitInstance(prefab->model, vulkan, physics))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init a prefab instance!");
+		SAFE_UNLOAD(model, vulkan);
+		return NULL;
+	}
+	instancePrefabs[model] = prefab;
+
+	return model;
+}
+
+Model * PrefabManager::Spawn(std::string filename, glm::vec3 position, glm::vec3 velocity, VulkanInterface * vulkan)
+{
+	auto it = prefabs.find(filename);
+	if (it == prefabs.end())
+	{
+		gLogManager->AddMessage("ERROR: Prefab is not loaded: " + filename);
+		return NULL;
+	}
+	Prefab * prefab = it->second;
+
+	// Over the budget the oldest instance is recycled, otherwise one comes from the pool
+	if (prefab->liveInstances.size() >= PREFAB_MAX_INSTANCES)
+		Despawn(prefab->liveInstances.front());
+
+	Model * model;
+	if (!prefab->freeInstances.empty())
+	{
+		model = prefab->freeInstances.back();
+		prefab->freeInstances.pop_back();
+	}
+	else
+	{
+		model = CreateInstance(prefab, vulkan);
+		if (model == NULL)
+			return NULL;
+	}
+
+	model->Spawn(position, velocity);
+	prefab->liveInstances.push_back(model);
+	spawnedModels.push_back(model);
+
+	return model;
+}
+
+void PrefabManager::Despawn(Model * model)
+{
+	auto it = instancePrefabs.find(model);
+	if (it == instancePrefabs.end())
+		return;
+
+	Prefab * prefab = it->second;
+	auto live = std::find(prefab->liveInstances.begin(), prefab->liveInstances.end(), model);
+	if (live == prefab->liveInstances.end())
+		return;
+	prefab->liveInstances.erase(live);
+
+	auto spawned = std::find(spawnedModels.begin(), spawnedModels.end(), model);
+	*spawned = spawnedModels.back();
+	spawnedModels.pop_back();
+
+	model->Despawn();
+	prefab->freeInstances.push_back(model);
+}
+
+void PrefabManager::Update()
+{
+	for (size_t i = 0; i < spawnedModels.size();)
+	{
+		if (spawnedModels[i]->GetPosition().y < PREFAB_DESPAWN_HEIGHT)
+			Despawn(spawnedModels[i]);
+		else
+			i++;
+	}
+}
+
+std::vector<Model*> & PrefabManager::GetSpawnedModels()
+{
+	return spawnedModels;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: PrefabManager.h                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+#include "Model.h"
+
+// Spawned instances of one prefab above this count recycle the oldest one
+#define PREFAB_MAX_INSTANCES 64
+// Instances that fall below this height are despawned
+#define PREFAB_DESPAWN_HEIGHT -50.0f
+
+// Models spawned at runtime are instances of prefabs. The prefab is loaded once and holds the meshes, materials
+// and collision shape, instances only own their rigid body. The visible instances are drawn together by their prefab
+// with one instanced draw for each mesh and LOD. Despawned instances are kept in a pool, so spawning one again doesn't allocate anything.
+class PrefabManager
+{
+	private:
+		struct Prefab
+		{
+			Model * model;
+			// Spawned instances, oldest first
+			std::deque<Model*> liveInstances;
+			std::vector<Model*> freeInstances;
+		};
+		std::unordered_map<std::string, Prefab*> prefabs;
+		std::unordered_map<Model*, Prefab*> instancePrefabs;
+		std::vector<Model*> spawnedModels;
+
+		Physics * physics;
+	private:
+		Model * CreateInstance(Prefab * prefab, VulkanInterface * vulkan);
+	public:
+		PrefabManager();
+		~PrefabManager();
+
+		void Init(Physics * physics);
+		void Unload(VulkanInterface * vulkan);
+		bool LoadPrefab(std::string filename, float mass, unsigned int poolSize, VulkanInterface * vulkan);
+		Model * Spawn(std::string filename, glm::vec3 position, glm::vec3 velocity, VulkanInterface * vulkan);
+		void Despawn(Model * model);
+		void Update();
+		std::vector<Model*> & GetSpawnedModels();
+};
\ No newline at end of file
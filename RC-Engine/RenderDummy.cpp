@@ -8,31 +8,30 @@
 #include "RenderDummy.h"
 #include "StdInc.h"
 #include "Settings.h"
+#include "StagingManager.h"
+#include "UniformRing.h"
 
 extern Settings * gSettings;
+extern StagingManager * gStagingManager;
+extern UniformRing * gUniformRing;
 
 RenderDummy::RenderDummy()
 {
 	vertexBuffer = NULL;
 	indexBuffer = NULL;
-	vsUBO = NULL;
-	fsUBO = NULL;
 }
 
 RenderDummy::~RenderDummy()
 {
-	fsUBO = NULL;
-	vsUBO = NULL;
 	indexBuffer = NULL;
 	vertexBuffer = NULL;
 }
 
 bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline, VkImageView * positionView, VkImageView * normalView,
 	VkImageView * albedoView, VkImageView * materialView, VkImageView * depthView, ShadowMaps * shadowMaps,
-	LightManager * lightManager, VkImageView * cubemapView)
+	LightManager * lightManager, Cubemap * cubemap)
 {
 	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
-	VulkanCommandPool * cmdPool = vulkan->GetVulkanCommandPool();
 
 	vertexCount = 4;
 	indexCount = 6;
@@ -76,30 +75,18 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	indexData[4] = 3;
 	indexData[5] = 0;
 
-	// Command buffer used for creating buffers
-	VulkanCommandBuffer * cmdBuffer = new VulkanCommandBuffer();
-	if (!cmdBuffer->Init(vulkanDevice, cmdPool, true))
-		return false;
-
-	cmdBuffer->BeginRecording();
-
 	// Vertex buffer
 	vertexBuffer = new VulkanBuffer();
 	if (!vertexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexData,
-		sizeof(Vertex) * vertexCount, true, cmdBuffer))
+		sizeof(Vertex) * vertexCount, true, gStagingManager))
 		return false;
 
 	// Index buffer
 	indexBuffer = new VulkanBuffer();
 	if (!indexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexData,
-		sizeof(uint32_t) * indexCount, true, cmdBuffer))
+		sizeof(uint32_t) * indexCount, true, gStagingManager))
 		return false;
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(vulkanDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, true);
-
-	SAFE_UNLOAD(cmdBuffer, vulkanDevice, cmdPool);
-
 	delete[] vertexData;
 	delete[] indexData;
 
@@ -110,34 +97,35 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	fragmentUniformBuffer.cameraPosition = glm::vec3();
 	fragmentUniformBuffer.lightStrength = 0.0f;
 
-	// Vertex shader Uniform buffer
-	vsUBO = new VulkanBuffer();
-	if (!vsUBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &vertexUniformBuffer,
-		sizeof(vertexUniformBuffer), false))
-		return false;
+	// The environment doesn't change, Render leaves these alone
+	const float * irradiance = cubemap->GetIrradiance();
+	for (int i = 0; i < CUBEMAP_SH_COEFFICIENT_COUNT; i++)
+		fragmentUniformBuffer.irradiance[i] = glm::vec4(irradiance[i * 3], irradiance[i * 3 + 1], irradiance[i * 3 + 2], 0.0f);
+	fragmentUniformBuffer.environmentRoughestLevel = (float)cubemap->GetRoughestLevel();
 
-	// Fragment shader Uniform buffer
-	fsUBO = new VulkanBuffer();
-	if (!fsUBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &fragmentUniformBuffer,
-		sizeof(fragmentUniformBuffer), false))
-		return false;
+	// Vertex and fragment shader uniform data is written to the uniform ring every draw and read through the frame
+	// set of the pipeline, this set only holds the images and the light buffer
+	VkWriteDescriptorSet write[8];
 
-	VkWriteDescriptorSet write[10];
+	VkDescriptorImageInfo positionTextureDesc{};
+	positionTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	positionTextureDesc.imageView = *positionView;
+	positionTextureDesc.sampler = vulkan->GetColorSampler();
 
 	write[0] = {};
 	write[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	write[0].pNext = NULL;
 	write[0].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[0].descriptorCount = 1;
-	write[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	write[0].pBufferInfo = vsUBO->GetBufferInfo();
+	write[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write[0].pImageInfo = &positionTextureDesc;
 	write[0].dstArrayElement = 0;
-	write[0].dstBinding = 0;
+	write[0].dstBinding = 1;
 
-	VkDescriptorImageInfo positionTextureDesc{};
-	positionTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	positionTextureDesc.imageView = *positionView;
-	positionTextureDesc.sampler = vulkan->GetColorSampler();
+	VkDescriptorImageInfo normalTextureDesc{};
+	normalTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	normalTextureDesc.imageView = *normalView;
+	normalTextureDesc.sampler = vulkan->GetColorSampler();
 
 	write[1] = {};
 	write[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -145,14 +133,14 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[1].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[1].descriptorCount = 1;
 	write[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[1].pImageInfo = &positionTextureDesc;
+	write[1].pImageInfo = &normalTextureDesc;
 	write[1].dstArrayElement = 0;
-	write[1].dstBinding = 1;
+	write[1].dstBinding = 2;
 
-	VkDescriptorImageInfo normalTextureDesc{};
-	normalTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	normalTextureDesc.imageView = *normalView;
-	normalTextureDesc.sampler = vulkan->GetColorSampler();
+	VkDescriptorImageInfo albedoTextureDesc{};
+	albedoTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	albedoTextureDesc.imageView = *albedoView;
+	albedoTextureDesc.sampler = vulkan->GetColorSampler();
 
 	write[2] = {};
 	write[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -160,14 +148,14 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[2].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[2].descriptorCount = 1;
 	write[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[2].pImageInfo = &normalTextureDesc;
+	write[2].pImageInfo = &albedoTextureDesc;
 	write[2].dstArrayElement = 0;
-	write[2].dstBinding = 2;
+	write[2].dstBinding = 3;
 
-	VkDescriptorImageInfo albedoTextureDesc{};
-	albedoTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	albedoTextureDesc.imageView = *albedoView;
-	albedoTextureDesc.sampler = vulkan->GetColorSampler();
+	VkDescriptorImageInfo materialTextureDesc{};
+	materialTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	materialTextureDesc.imageView = *materialView;
+	materialTextureDesc.sampler = vulkan->GetColorSampler();
 
 	write[3] = {};
 	write[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -175,14 +163,14 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[3].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[3].descriptorCount = 1;
 	write[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[3].pImageInfo = &albedoTextureDesc;
+	write[3].pImageInfo = &materialTextureDesc;
 	write[3].dstArrayElement = 0;
-	write[3].dstBinding = 3;
+	write[3].dstBinding = 4;
 
-	VkDescriptorImageInfo materialTextureDesc{};
-	materialTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	materialTextureDesc.imageView = *materialView;
-	materialTextureDesc.sampler = vulkan->GetColorSampler();
+	VkDescriptorImageInfo depthTextureDesc{};
+	depthTextureDesc.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthTextureDesc.imageView = *depthView;
+	depthTextureDesc.sampler = vulkan->GetColorSampler();
 
 	write[4] = {};
 	write[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -190,14 +178,14 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[4].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[4].descriptorCount = 1;
 	write[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[4].pImageInfo = &materialTextureDesc;
+	write[4].pImageInfo = &depthTextureDesc;
 	write[4].dstArrayElement = 0;
-	write[4].dstBinding = 4;
+	write[4].dstBinding = 5;
 
-	VkDescriptorImageInfo depthTextureDesc{};
-	depthTextureDesc.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-	depthTextureDesc.imageView = *depthView;
-	depthTextureDesc.sampler = vulkan->GetColorSampler();
+	VkDescriptorImageInfo shadowTextureDesc{};
+	shadowTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	shadowTextureDesc.imageView = *shadowMaps->GetImageView();
+	shadowTextureDesc.sampler = shadowMaps->GetSampler();
 
 	write[5] = {};
 	write[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -205,9 +193,9 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[5].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[5].descriptorCount = 1;
 	write[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[5].pImageInfo = &depthTextureDesc;
+	write[5].pImageInfo = &shadowTextureDesc;
 	write[5].dstArrayElement = 0;
-	write[5].dstBinding = 5;
+	write[5].dstBinding = 7;
 
 	write[6] = {};
 	write[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -215,14 +203,14 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[6].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[6].descriptorCount = 1;
 	write[6].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	write[6].pBufferInfo = fsUBO->GetBufferInfo();
+	write[6].pBufferInfo = lightManager->GetBufferInfo();
 	write[6].dstArrayElement = 0;
-	write[6].dstBinding = 6;
+	write[6].dstBinding = 8;
 
-	VkDescriptorImageInfo shadowTextureDesc{};
-	shadowTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	shadowTextureDesc.imageView = *shadowMaps->GetImageView();
-	shadowTextureDesc.sampler = shadowMaps->GetSampler();
+	VkDescriptorImageInfo cubemapTextureDesc{};
+	cubemapTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	cubemapTextureDesc.imageView = *cubemap->GetImageView();
+	cubemapTextureDesc.sampler = vulkan->GetColorSampler();
 
 	write[7] = {};
 	write[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -230,34 +218,9 @@ bool RenderDummy::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline
 	write[7].dstSet = vulkanPipeline->GetDescriptorSet();
 	write[7].descriptorCount = 1;
 	write[7].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[7].pImageInfo = &shadowTextureDesc;
+	write[7].pImageInfo = &cubemapTextureDesc;
 	write[7].dstArrayElement = 0;
-	write[7].dstBinding = 7;
-
-	write[8] = {};
-	write[8].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	write[8].pNext = NULL;
-	write[8].dstSet = vulkanPipeline->GetDescriptorSet();
-	write[8].descriptorCount = 1;
-	write[8].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	write[8].pBufferInfo = lightManager->GetBufferInfo();
-	write[8].dstArrayElement = 0;
-	write[8].dstBinding = 8;
-
-	VkDescriptorImageInfo cubemapTextureDesc{};
-	cubemapTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	cubemapTextureDesc.imageView = *cubemapView;
-	cubemapTextureDesc.sampler = vulkan->GetColorSampler();
-
-	write[9] = {};
-	write[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	write[9].pNext = NULL;
-	write[9].dstSet = vulkanPipeline->GetDescriptorSet();
-	write[9].descriptorCount = 1;
-	write[9].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	write[9].pImageInfo = &cubemapTextureDesc;
-	write[9].dstArrayElement = 0;
-	write[9].dstBinding = 9;
+	write[7].dstBinding = 9;
 
 	vkUpdateDescriptorSets(vulkanDevice->GetDevice(), sizeof(write) / sizeof(write[0]), write, 0, NULL);
 
@@ -279,8 +242,6 @@ void RenderDummy::Unload(VulkanInterface * vulkan)
 	for (size_t i = 0; i < vulkan->GetVulkanSwapchain()->GetSwapchainBufferCount(); i++)
 		SAFE_UNLOAD(drawCmdBuffers[i], vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
 
-	SAFE_UNLOAD(fsUBO, vulkan->GetVulkanDevice());
-	SAFE_UNLOAD(vsUBO, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(indexBuffer, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(vertexBuffer, vulkan->GetVulkanDevice());
 }
@@ -290,8 +251,6 @@ void RenderDummy::Render(VulkanInterface * vulkan, VulkanCommandBuffer * command
 {
 	// Update vertex uniform buffer
 	vertexUniformBuffer.MVP = orthoMatrix;
-	
-	vsUBO->Update(vulkan->GetVulkanDevice(), &vertexUniformBuffer, sizeof(vertexUniformBuffer));
 
 	// Update fragment uniform buffer
 	fragmentUniformBuffer.lightDirection = light->GetLightDirection();
@@ -302,13 +261,16 @@ void RenderDummy::Render(VulkanInterface * vulkan, VulkanCommandBuffer * command
 	for (int i = 0; i < SHADOW_CASCADE_COUNT; i++)
 		fragmentUniformBuffer.lightViewMatrix[i] = shadowMaps->GetLightViewProj(i);
 
-	fsUBO->Update(vulkan->GetVulkanDevice(), &fragmentUniformBuffer, sizeof(fragmentUniformBuffer));
+	uint32_t dynamicOffsets[2];
+	if (!gUniformRing->Allocate(&vertexUniformBuffer, sizeof(vertexUniformBuffer), &dynamicOffsets[0]) ||
+		!gUniformRing->Allocate(&fragmentUniformBuffer, sizeof(fragmentUniformBuffer), &dynamicOffsets[1]))
+		return;
 
 	// Draw
 	drawCmdBuffers[frameBufferId]->BeginRecordingSecondary(vulkan->GetForwardRenderpass()->GetRenderpass(), vulkan->GetVulkanSwapchain()->GetFramebuffer((int)frameBufferId));
 	vulkan->InitViewportAndScissors(drawCmdBuffers[frameBufferId], (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
 		(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
-	vulkanPipeline->SetActive(drawCmdBuffers[frameBufferId]);
+	vulkanPipeline->SetActive(drawCmdBuffers[frameBufferId], 2, dynamicOffsets);
 
 	VkDeviceSize offsets[1] = { 0 };
 	vkCmdBindVertexBuffers(drawCmdBuffers[frameBufferId]->GetCommandBuffer(), 0, 1, vertexBuffer->GetBuffer(), offsets);
@@ -319,3 +281,8 @@ void RenderDummy::Render(VulkanInterface * vulkan, VulkanCommandBuffer * command
 	drawCmdBuffers[frameBufferId]->EndRecording();
 	drawCmdBuffers[frameBufferId]->ExecuteSecondary(commandBuffer);
 }
+
+VkDeviceSize RenderDummy::GetFrameUniformSize()
+{
+	return gUniformRing->GetAllocationSize(sizeof(vertexUniformBuffer)) + gUniformRing->GetAllocationSize(sizeof(fragmentUniformBuffer));
+}
@@ -13,6 +13,7 @@
 #include "Camera.h"
 #include "ShadowMaps.h"
 #include "LightManager.h"
+#include "Cubemap.h"
 
 class RenderDummy
 {
@@ -35,14 +36,15 @@ class RenderDummy
 			int imageIndex;
 			glm::vec3 cameraPosition;
 			float lightStrength;
+			// Diffuse light from the environment as SH9, RGB in xyz
+			glm::vec4 irradiance[CUBEMAP_SH_COEFFICIENT_COUNT];
+			float environmentRoughestLevel;
 		};
 		VertexUniformBuffer vertexUniformBuffer;
 		FragmentUniformBuffer fragmentUniformBuffer;
 
 		VulkanBuffer * vertexBuffer;
 		VulkanBuffer * indexBuffer;
-		VulkanBuffer * vsUBO;
-		VulkanBuffer * fsUBO;
 
 		std::vector<VulkanCommandBuffer*> drawCmdBuffers;
 	public:
@@ -51,8 +53,9 @@ class RenderDummy
 
 		bool Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline, VkImageView * positionView, VkImageView * normalView,
 			VkImageView * albedoView, VkImageView * materialView, VkImageView * depthView, ShadowMaps * shadowMaps,
-			LightManager * lightManager, VkImageView * cubemapView);
+			LightManager * lightManager, Cubemap * cubemap);
 		void Unload(VulkanInterface * vulkan);
 		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer, VulkanPipeline * vulkanPipeline,
 			glm::mat4 orthoMatrix, Sunlight * light, int imageIndex, Camera * camera, ShadowMaps * shadowMaps, int frameBufferId);
+		VkDeviceSize GetFrameUniformSize();
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: ResourceRegistry.h                                   |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "VulkanDevice.h"
+#include "StdInc.h"
+
+#define INVALID_RESOURCE_INDEX 0xFFFFFFFF
+
+// Generational handle, stays safe to pass around after the resource it pointed to is gone
+struct ResourceHandle
+{
+	uint32_t index;
+	uint32_t generation;
+
+	ResourceHandle() : index(INVALID_RESOURCE_INDEX), generation(0) {}
+	ResourceHandle(uint32_t index, uint32_t generation) : index(index), generation(generation) {}
+	bool IsValid() const { return index != INVALID_RESOURCE_INDEX; }
+};
+
+// Reference counted storage for GPU resources, keyed by 64-bit hashes. Resources that nobody uses anymore are kept
+// in an LRU list and only unloaded when the memory of everything resident goes over the budget.
+// T needs Unload(VulkanDevice*), the memory size of each resource is passed in when it's added.
+template <class T>
+class ResourceRegistry
+{
+	private:
+		struct Slot
+		{
+			T * resource;
+			std::vector<uint64_t> keys;
+			VkDeviceSize memorySize;
+			uint32_t generation;
+			uint32_t useCount;
+			uint32_t lruPrev;
+			uint32_t lruNext;
+		};
+		std::vector<Slot> slots;
+		std::vector<uint32_t> freeSlots;
+		std::unordered_map<uint64_t, uint32_t> keyMapping;
+
+		// Most recently released resources are at the head, eviction starts at the tail
+		uint32_t lruHead;
+		uint32_t lruTail;
+
+		VkDeviceSize budget;
+		VkDeviceSize residentSize;
+		size_t residentCount;
+	private:
+		void LinkLRU(uint32_t index)
+		{
+			slots[index].lruPrev = INVALID_RESOURCE_INDEX;
+			slots[index].lruNext = lruHead;
+			if (lruHead != INVALID_RESOURCE_INDEX)
+				slots[lruHead].lruPrev = index;
+			lruHead = index;
+			if (lruTail == INVALID_RESOURCE_INDEX)
+				lruTail = index;
+		}
+
+		void UnlinkLRU(uint32_t index)
+		{
+			Slot & slot = slots[index];
+			if (slot.lruPrev != INVALID_RESOURCE_INDEX)
+				slots[slot.lruPrev].lruNext = slot.lruNext;
+			else
+				lruHead = slot.lruNext;
+			if (slot.lruNext != INVALID_RESOURCE_INDEX)
+				slots[slot.lruNext].lruPrev = slot.lruPrev;
+			else
+				lruTail = slot.lruPrev;
+
+			slot.lruPrev = slot.lruNext = INVALID_RESOURCE_INDEX;
+		}
+
+		void Destroy(uint32_t index, VulkanDevice * device)
+		{
+			Slot & slot = slots[index];
+			for (size_t i = 0; i < slot.keys.size(); i++)
+				keyMapping.erase(slot.keys[i]);
+			slot.keys.clear();
+
+			SAFE_UNLOAD(slot.resource, device);
+			residentSize -= slot.memorySize;
+			residentCount--;
+
+			// Bumping the generation invalidates every handle that still points here
+			slot.generation++;
+			slot.memorySize = 0;
+			freeSlots.push_back(index);
+		}
+	public:
+		ResourceRegistry()
+		{
+			lruHead = lruTail = INVALID_RESOURCE_INDEX;
+			budget = 0;
+			residentSize = 0;
+			residentCount = 0;
+		}
+
+		void SetBudget(VkDeviceSize budget)
+		{
+			this->budget = budget;
+		}
+
+		// Returns the resource stored under key and takes a reference to it, or an invalid handle
+		ResourceHandle Acquire(uint64_t key)
+		{
+			std::unordered_map<uint64_t, uint32_t>::iterator it = keyMapping.find(key);
+			if (it == keyMapping.end())
+				return ResourceHandle();
+
+			Slot & slot = slots[it->second];
+			if (slot.useCount == 0)
+				UnlinkLRU(it->second);
+			slot.useCount++;
+
+			return ResourceHandle(it->second, slot.generation);
+		}
+
+		// Stores a newly created resource with a single reference
+		ResourceHandle Add(uint64_t key, T * resource, VkDeviceSize memorySize)
+		{
+			uint32_t index;
+			if (!freeSlots.empty())
+			{
+				index = freeSlots.back();
+				freeSlots.pop_back();
+			}
+			else
+			{
+				index = (uint32_t)slots.size();
+				slots.push_back(Slot());
+				slots[index].generation = 1;
+			}
+
+			Slot & slot = slots[index];
+			slot.resource = resource;
+			slot.keys.push_back(key);
+			slot.memorySize = memorySize;
+			slot.useCount = 1;
+			slot.lruPrev = slot.lruNext = INVALID_RESOURCE_INDEX;
+			keyMapping[key] = index;
+
+			residentSize += memorySize;
+			residentCount++;
+
+			return ResourceHandle(index, slot.generation);
+		}
+
+		bool Contains(uint64_t key)
+		{
+			return keyMapping.count(key) > 0;
+		}
+
+		// Makes the resource reachable under another key as well
+		void AddKey(ResourceHandle handle, uint64_t key)
+		{
+			if (Get(handle) == NULL || keyMapping.count(key) > 0)
+				return;
+
+			slots[handle.index].keys.push_back(key);
+			keyMapping[key] = handle.index;
+		}
+
+		T * Get(ResourceHandle handle)
+		{
+			if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+				return NULL;
+
+			return slots[handle.index].resource;
+		}
+
+		// Drops a reference, unused resources stay cached until the budget needs their memory
+		void Release(ResourceHandle handle, VulkanDevice * device)
+		{
+			if (Get(handle) == NULL)
+				return;
+
+			Slot & slot = slots[handle.index];
+			if (slot.useCount == 0)
+				return;
+
+			slot.useCount--;
+			if (slot.useCount == 0)
+				LinkLRU(handle.index);
+
+			Evict(device);
+		}
+
+		void Evict(VulkanDevice * device)
+		{
+			while (residentSize > budget && lruTail != INVALID_RESOURCE_INDEX)
+			{
+				uint32_t index = lruTail;
+				UnlinkLRU(index);
+				Destroy(index, device);
+			}
+		}
+
+		// Unloads every cached resource, resources still in use are left alone
+		void Clear(VulkanDevice * device)
+		{
+			while (lruTail != INVALID_RESOURCE_INDEX)
+			{
+				uint32_t index = lruTail;
+				UnlinkLRU(index);
+				Destroy(index, device);
+			}
+		}
+
+		// For resources whose memory grows or shrinks while they are loaded
+		void SetMemorySize(ResourceHandle handle, VkDeviceSize memorySize)
+		{
+			if (Get(handle) == NULL)
+				return;
+
+			residentSize = residentSize - slots[handle.index].memorySize + memorySize;
+			slots[handle.index].memorySize = memorySize;
+		}
+
+		// Calls func(handle, resource) for every loaded resource, used or cached
+		template <class F>
+		void ForEach(F func)
+		{
+			for (uint32_t i = 0; i < slots.size(); i++)
+			{
+				if (slots[i].resource != NULL)
+					func(ResourceHandle(i, slots[i].generation), slots[i].resource);
+			}
+		}
+
+		VkDeviceSize GetBudget()
+		{
+			return budget;
+		}
+
+		size_t GetResidentCount()
+		{
+			return residentCount;
+		}
+
+		VkDeviceSize GetResidentSize()
+		{
+			return residentSize;
+		}
+};
\ No newline at end of file
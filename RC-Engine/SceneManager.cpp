@@ -5,7 +5,8 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
-#include <fstream>
+#include <sstream>
+#include <algorithm>
 
 #include "SceneManager.h"
 #include "StdInc.h"
@@ -15,11 +16,18 @@
 #include "StdInc.h"
 #include "TextureManager.h"
 #include "BufferManager.h"
+#include "StagingManager.h"
+#include "UniformRing.h"
+#include "Settings.h"
 
 TextureManager * gTextureManager;
 BufferManager * gBufferManager;
+StagingManager * gStagingManager;
+UniformRing * gUniformRing;
+CommandRecorder * gCommandRecorder;
 
 extern LogManager * gLogManager;
+extern Settings * gSettings;
 extern Input * gInput;
 extern Timer * gTimer;
 
@@ -31,6 +39,10 @@ SceneManager::SceneManager()
 	camera = NULL;
 	sunlight = NULL;
 	pipelineManager = NULL;
+	lightManager = NULL;
+	guiManager = NULL;
+	timeCycle = NULL;
+	testCubemap = NULL;
 
 	initCommandBuffer = NULL;
 	deferredCommandBuffer = NULL;
@@ -46,10 +58,18 @@ SceneManager::SceneManager()
 	jumpAnim = NULL;
 	runAnim = NULL;
 
+	male = NULL;
 	player = NULL;
+	sceneMap = NULL;
+	prefabManager = NULL;
 
 	splashScreen = NULL;
+	splashScreenTimer = NULL;
 	showSplashScreen = true;
+
+	loadingGraph = NULL;
+	loadingBar = NULL;
+	assetLoader = NULL;
 }
 
 SceneManager::~SceneManager()
@@ -73,9 +93,35 @@ SceneManager::~SceneManager()
 
 bool SceneManager::Init(VulkanInterface * vulkan)
 {
-	// Init resource managers
+	// Init resource managers, unused resources stay cached until the budgets (in MB) are exceeded
 	gTextureManager = new TextureManager();
+	gTextureManager->Init();
+	gTextureManager->SetBudget((VkDeviceSize)gSettings->GetTextureBudget() * 1024 * 1024);
 	gBufferManager = new BufferManager();
+	gBufferManager->SetBudget((VkDeviceSize)gSettings->GetBufferBudget() * 1024 * 1024);
+
+	gStagingManager = new StagingManager();
+	if (!gStagingManager->Init(vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool()))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init staging manager!");
+		return false;
+	}
+
+	gUniformRing = new UniformRing();
+	if (!gUniformRing->Init(vulkan->GetVulkanDevice(), UNIFORM_RING_FRAME_SIZE, UNIFORM_RING_SLOT_COUNT))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init uniform ring!");
+		return false;
+	}
+
+	gCommandRecorder = new CommandRecorder();
+	if (!gCommandRecorder->Init(vulkan->GetVulkanDevice()))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init command recorder!");
+		return false;
+	}
+	threadRenderLists.resize(gCommandRecorder->GetThreadCount());
+	threadDrawCommands.resize(gCommandRecorder->GetThreadCount());
 
 	// Init command buffers
 	initCommandBuffer = new VulkanCommandBuffer();
@@ -113,7 +159,7 @@ bool SceneManager::Init(VulkanInterface * vulkan)
 
 	// Init GUI manager
 	guiManager = new GUIManager();
-	if (!guiManager->Init(vulkan, initCommandBuffer))
+	if (!guiManager->Init(vulkan))
 		return false;
 
 	// Camera setup
@@ -125,7 +171,7 @@ bool SceneManager::Init(VulkanInterface * vulkan)
 
 	// Splash screen logo
 	splashScreen = new GUIElement();
-	if (!splashScreen->Init(vulkan, initCommandBuffer, "data/textures/logo.rct"))
+	if (!splashScreen->Init(vulkan, "data/textures/logo.rct"))
 	{
 		gLogManager->AddMessage("ERROR: Failed to init splash screen logo!");
 		return false;
@@ -133,142 +179,264 @@ bool SceneManager::Init(VulkanInterface * vulkan)
 	splashScreen->SetDimensions(0.4f, 0.5f);
 	splashScreen->SetPosition(0.3f, 0.25f);
 
+	// Loading progress bar below the logo
+	loadingBar = new GUIElement();
+	if (!loadingBar->Init(vulkan, "data/textures/red.rct"))
+	{
+		gLogManager->AddMessage("ERROR: Failed to init loading bar!");
+		return false;
+	}
+	loadingBar->SetDimensions(0.0f, LOADING_BAR_HEIGHT);
+	loadingBar->SetPosition(0.5f - LOADING_BAR_WIDTH * 0.5f, 0.8f);
+
 	splashScreenTimer = new GameplayTimer();
 
+	// Submit all texture uploads recorded so far
+	gStagingManager->Flush(vulkan->GetVulkanDevice());
+
 	ChangeGameState(GAME_STATE_SPLASH_SCREEN);
 	return true;
 }
 
 bool SceneManager::LoadGame(VulkanInterface * vulkan)
 {
-	// Init shadow maps
-	shadowMaps = new ShadowMaps();
-	if (!shadowMaps->Init(vulkan, initCommandBuffer, camera))
+	// Loading runs as a graph of tasks, file reading on worker threads and everything that touches Vulkan on the
+	// render thread a few milliseconds per frame, so the loading screen keeps presenting
+	loadingGraph = new TaskGraph();
+	assetLoader = new AssetLoader();
+	assetLoader->Init(loadingGraph, vulkan);
+
+	TaskId shadowTask = loadingGraph->AddTask(TASK_THREAD_MAIN, {}, [this, vulkan]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init shadow maps!");
-		return false;
-	}
+		// Init shadow maps
+		shadowMaps = new ShadowMaps();
+		if (!shadowMaps->Init(vulkan, initCommandBuffer, camera))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init shadow maps!");
+			return TASK_RESULT_FAILED;
+		}
+
+		// Init light manager
+		lightManager = new LightManager();
+		if (!lightManager->Init(vulkan->GetVulkanDevice()))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init light manager!");
+			return TASK_RESULT_FAILED;
+		}
+
+		return TASK_RESULT_DONE;
+	});
 
-	// Init light manager
-	lightManager = new LightManager();
-	if (!lightManager->Init(vulkan->GetVulkanDevice()))
+	TaskId worldTask = loadingGraph->AddTask(TASK_THREAD_MAIN, {}, [this]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init light manager!");
-		return false;
-	}
+		// Physics init
+		physics = new Physics();
+		physics->Init();
 
-	// Physics init
-	physics = new Physics();
-	physics->Init();
+		// Init frustum culler
+		frustumCuller = new FrustumCuller();
 
-	// Init frustum culler
-	frustumCuller = new FrustumCuller();
+		// Light setup
+		sunlight = new Sunlight();
 
-	// Light setup
-	sunlight = new Sunlight();
+		return TASK_RESULT_DONE;
+	});
 
-	// Init test cubemap
-	testCubemap = new Cubemap();
-	if (!testCubemap->Init(vulkan->GetVulkanDevice(), initCommandBuffer, "data/cubemaps/testcubemap"))
+	// The cubemap is read and prefiltered on a worker, only its upload runs on the render thread
+	TaskId cubemapReadTask = loadingGraph->AddTask(TASK_THREAD_WORKER, {}, [this]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init cubemap!");
-		return false;
-	}
+		testCubemap = new Cubemap();
+		return testCubemap->ReadFiles("data/cubemaps/testcubemap") ? TASK_RESULT_DONE : TASK_RESULT_FAILED;
+	}, 2.0f);
 
-	if (!pipelineManager->InitGamePipelines(vulkan, shadowMaps))
+	TaskId cubemapTask = loadingGraph->AddTask(TASK_THREAD_MAIN, { cubemapReadTask }, [this, vulkan]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init game pipelines!");
-		return false;
-	}
+		// Init test cubemap
+		if (!testCubemap->InitResources(vulkan->GetVulkanDevice(), gStagingManager))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init cubemap!");
+			return TASK_RESULT_FAILED;
+		}
 
-	// Init render dummy
-	renderDummy = new RenderDummy();
-	if (!renderDummy->Init(vulkan, pipelineManager->GetDefault(), vulkan->GetPositionAttachment()->GetImageView(), vulkan->GetNormalAttachment()->GetImageView(),
-		vulkan->GetAlbedoAttachment()->GetImageView(), vulkan->GetMaterialAttachment()->GetImageView(), vulkan->GetDepthAttachment()->GetImageView(),
-		shadowMaps, lightManager, testCubemap->GetImageView()))
-	{
-		gLogManager->AddMessage("ERROR: Failed to init render dummy!");
-		return false;
-	}
+		return TASK_RESULT_DONE;
+	});
 
-	// Init skydome
-	skydome = new Skydome();
-	if (!skydome->Init(vulkan, pipelineManager->GetSkydome()))
+	TaskId pipelineTask = loadingGraph->AddTask(TASK_THREAD_MAIN, { shadowTask }, [this, vulkan]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init skydome!");
-		return false;
-	}
-	skydome->SetGroundColor(0.2f, 0.2f, 0.2f, 1.0f);
-	
-	// Init timecycle
-	timeCycle = new TimeCycle();
-	if (!timeCycle->Init(skydome, sunlight))
+		if (!pipelineManager->InitGamePipelines(vulkan, shadowMaps))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init game pipelines!");
+			return TASK_RESULT_FAILED;
+		}
+
+		return TASK_RESULT_DONE;
+	});
+
+	TaskId sceneTask = loadingGraph->AddTask(TASK_THREAD_MAIN, { pipelineTask, cubemapTask, worldTask }, [this, vulkan]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init timecycle!");
-		return false;
-	}
-	timeCycle->SetTime(9, 0);
-	timeCycle->SetWeather("sunny");
+		// Init render dummy
+		renderDummy = new RenderDummy();
+		if (!renderDummy->Init(vulkan, pipelineManager->GetDefault(), vulkan->GetPositionAttachment()->GetImageView(), vulkan->GetNormalAttachment()->GetImageView(),
+			vulkan->GetAlbedoAttachment()->GetImageView(), vulkan->GetMaterialAttachment()->GetImageView(), vulkan->GetDepthAttachment()->GetImageView(),
+			shadowMaps, lightManager, testCubemap))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init render dummy!");
+			return TASK_RESULT_FAILED;
+		}
 
-	// Load map files
-	if (!LoadMapFile("data/testmap.map", vulkan))
-		return false;
+		// Init skydome
+		skydome = new Skydome();
+		if (!skydome->Init(vulkan, pipelineManager->GetSkydome()))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init skydome!");
+			return TASK_RESULT_FAILED;
+		}
+		skydome->SetGroundColor(0.2f, 0.2f, 0.2f, 1.0f);
 
-	// Skinned models and animations
-	male = new SkinnedModel();
-	if (!male->Init("data/models/male.rcs", vulkan, initCommandBuffer))
+		// Init timecycle
+		timeCycle = new TimeCycle();
+		if (!timeCycle->Init(skydome, sunlight))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init timecycle!");
+			return TASK_RESULT_FAILED;
+		}
+		timeCycle->SetTime(9, 0);
+		timeCycle->SetWeather("sunny");
+
+		return TASK_RESULT_DONE;
+	});
+
+	// Map models are loaded through the asset loader, the physics task can only wait on them once the map is read
+	TaskId mapPhysicsTask = loadingGraph->ReserveTask();
+	loadingGraph->AddTask(TASK_THREAD_WORKER, {}, [this, worldTask, mapPhysicsTask]()
 	{
-		gLogManager->AddMessage("ERROR: Failed to init male model!");
-		return false;
-	}
+		std::vector<TaskId> modelTasks;
+		if (!ReadMapFile("data/testmap.rcmap", modelTasks))
+			return TASK_RESULT_FAILED;
 
-	// Animations
-	idleAnim = new Animation();
-	if (!idleAnim->Init("data/anims/idle.fbx", 52, true))
-		return false;
-	idleAnim->SetAnimationSpeed(0.0005f);
+		modelTasks.push_back(worldTask);
+		loadingGraph->SetTask(mapPhysicsTask, TASK_THREAD_MAIN, modelTasks, [this]()
+		{
+			InitMapPhysics();
+			return TASK_RESULT_DONE;
+		});
 
-	walkAnim = new Animation();
-	if (!walkAnim->Init("data/anims/walk.fbx", 52, true))
-		return false;
+		return TASK_RESULT_DONE;
+	});
 
-	fallAnim = new Animation();
-	if (!fallAnim->Init("data/anims/falling.fbx", 52, true))
-		return false;
-	fallAnim->SetAnimationSpeed(0.002f);
+	TaskId prefabTask = loadingGraph->AddTask(TASK_THREAD_MAIN, { worldTask }, [this, vulkan]()
+	{
+		// Props spawned while playing are instances of these, their pools are filled here
+		prefabManager = new PrefabManager();
+		prefabManager->Init(physics);
+		if (!prefabManager->LoadPrefab("data/models/box.rcm", 100.0f, PROP_POOL_SIZE, vulkan) ||
+			!prefabManager->LoadPrefab("data/models/teapot.rcm", 1.0f, PROP_POOL_SIZE, vulkan))
+			return TASK_RESULT_FAILED;
 
-	jumpAnim = new Animation();
-	if (!jumpAnim->Init("data/anims/jump.fbx", 52, false))
-		return false;
-	jumpAnim->SetAnimationSpeed(0.001f);
+		return TASK_RESULT_DONE;
+	});
 
-	runAnim = new Animation();
-	if (!runAnim->Init("data/anims/run.fbx", 52, true))
-		return false;
+	TaskId animationTask = loadingGraph->AddTask(TASK_THREAD_WORKER, {}, [this]()
+	{
+		// Animations
+		idleAnim = new Animation();
+		if (!idleAnim->Init("data/anims/idle.rca", 52, true))
+			return TASK_RESULT_FAILED;
+		idleAnim->SetAnimationSpeed(0.0005f);
+
+		walkAnim = new Animation();
+		if (!walkAnim->Init("data/anims/walk.rca", 52, true))
+			return TASK_RESULT_FAILED;
+
+		fallAnim = new Animation();
+		if (!fallAnim->Init("data/anims/falling.rca", 52, true))
+			return TASK_RESULT_FAILED;
+		fallAnim->SetAnimationSpeed(0.002f);
+
+		jumpAnim = new Animation();
+		if (!jumpAnim->Init("data/anims/jump.rca", 52, false))
+			return TASK_RESULT_FAILED;
+		jumpAnim->SetAnimationSpeed(0.001f);
+
+		runAnim = new Animation();
+		if (!runAnim->Init("data/anims/run.rca", 52, true))
+			return TASK_RESULT_FAILED;
+
+		return TASK_RESULT_DONE;
+	});
+
+	TaskId playerTask = loadingGraph->AddTask(TASK_THREAD_MAIN, { worldTask, animationTask }, [this, vulkan]()
+	{
+		// Skinned models and animations
+		male = new SkinnedModel();
+		if (!male->Init("data/models/male.rcs", vulkan))
+		{
+			gLogManager->AddMessage("ERROR: Failed to init male model!");
+			return TASK_RESULT_FAILED;
+		}
+		male->SetAnimation(idleAnim);
 
-	male->SetAnimation(idleAnim);
+		AnimationPack animPack;
+		animPack.idleAnimation = idleAnim;
+		animPack.walkAnimation = walkAnim;
+		animPack.fallAnimation = fallAnim;
+		animPack.jumpAnimation = jumpAnim;
+		animPack.runAnimation = runAnim;
 
-	AnimationPack animPack;
-	animPack.idleAnimation = idleAnim;
-	animPack.walkAnimation = walkAnim;
-	animPack.fallAnimation = fallAnim;
-	animPack.jumpAnimation = jumpAnim;
-	animPack.runAnimation = runAnim;
+		player = new Player();
+		player->Init(male, physics, animPack);
+		player->SetPosition(0.0f, 5.0f, 0.0f);
 
-	player = new Player();
-	player->Init(male, physics, animPack);
-	player->SetPosition(0.0f, 5.0f, 0.0f);
+		return TASK_RESULT_DONE;
+	});
+
+	// The game starts once all texture and buffer uploads recorded while loading are done on the GPU
+	loadingGraph->AddTask(TASK_THREAD_MAIN, { sceneTask, mapPhysicsTask, prefabTask, playerTask }, [vulkan]()
+	{
+		gStagingManager->Flush(vulkan->GetVulkanDevice());
+		return TASK_RESULT_DONE;
+	});
+
+	loadingGraph->Start(std::max(std::thread::hardware_concurrency(), 2u) - 1);
 
 	return true;
 }
 
+void SceneManager::UpdateLoading(VulkanInterface * vulkan)
+{
+	if (!loadingGraph->RunMainTasks(LOADING_FRAME_BUDGET))
+	{
+		gLogManager->AddMessage("ERROR: Failed to load the game!");
+		THROW_ERROR();
+	}
+
+	loadingBar->SetDimensions(LOADING_BAR_WIDTH * loadingGraph->GetProgress(), LOADING_BAR_HEIGHT);
+
+	if (loadingGraph->IsFinished())
+	{
+		SAFE_UNLOAD(loadingGraph);
+		SAFE_UNLOAD(assetLoader);
+		ChangeGameState(GAME_STATE_INGAME);
+	}
+}
+
 void SceneManager::Unload(VulkanInterface * vulkan)
 {
+	// Loading may still be running when the game is closed
+	SAFE_UNLOAD(loadingGraph);
+	SAFE_UNLOAD(assetLoader);
+	for (unsigned int i = 0; i < mapEntries.size(); i++)
+		SAFE_UNLOAD(mapEntries[i].model, vulkan);
+	mapEntries.clear();
+
+	SAFE_UNLOAD(loadingBar, vulkan);
 	SAFE_UNLOAD(splashScreen, vulkan);
 
 	SAFE_UNLOAD(male, vulkan);
+	SAFE_UNLOAD(prefabManager, vulkan);
 	for (unsigned int i = 0; i < modelList.size(); i++)
 		SAFE_UNLOAD(modelList[i], vulkan);
+	SAFE_UNLOAD(sceneMap);
 
 	SAFE_UNLOAD(skydome, vulkan);
 	SAFE_UNLOAD(renderDummy, vulkan);
@@ -284,12 +452,20 @@ void SceneManager::Unload(VulkanInterface * vulkan)
 		SAFE_UNLOAD(renderCommandBuffers[i], vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
 	SAFE_UNLOAD(deferredCommandBuffer, vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
 	SAFE_UNLOAD(initCommandBuffer, vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
+	gBufferManager->Unload(vulkan->GetVulkanDevice());
+	gTextureManager->Unload(vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(gCommandRecorder, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(gUniformRing, vulkan->GetVulkanDevice());
+	SAFE_UNLOAD(gStagingManager, vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
 }
 
 int imageIndex = 5;
 
 void SceneManager::Render(VulkanInterface * vulkan)
 {
+	// Per draw uniform data of this frame goes to the next slice of the ring
+	gUniformRing->BeginFrame();
+
 	// Splash screen
 	if (showSplashScreen == true && splashScreenTimer)
 			splashScreenTimer->StartTimer();
@@ -299,9 +475,7 @@ void SceneManager::Render(VulkanInterface * vulkan)
 		if (splashScreenTimer->TimePassed(1000))
 		{
 			ChangeGameState(GAME_STATE_LOADING);
-			if (LoadGame(vulkan))
-				ChangeGameState(GAME_STATE_INGAME);
-			else
+			if (!LoadGame(vulkan))
 				THROW_ERROR();
 
 			showSplashScreen = false;
@@ -309,9 +483,13 @@ void SceneManager::Render(VulkanInterface * vulkan)
 		}
 	}
 
+	if (currentGameState == GAME_STATE_LOADING)
+		UpdateLoading(vulkan);
+
 	if (currentGameState == GAME_STATE_INGAME)
 	{
 		physics->Update();
+		prefabManager->Update();
 		frustumCuller->BuildFrustum(camera->GetProjectionMatrix() * camera->GetViewMatrix());
 		timeCycle->Update();
 
@@ -322,30 +500,14 @@ void SceneManager::Render(VulkanInterface * vulkan)
 
 		if (gInput->WasKeyPressed(KEYBOARD_KEY_E))
 		{
-			Model * model = new Model();
-			model->Init("data/models/box.rcm", vulkan, initCommandBuffer, physics, 100.0f);
-
-			glm::vec3 pos = camera->GetPosition();
-			glm::vec3 dir = camera->GetDirection();
 			float power = 5.0f;
-			model->SetPosition(pos.x, pos.y, pos.z);
-			model->SetVelocity(dir.x * power, dir.y * power, dir.z * power);
-
-			modelList.push_back(model);
+			prefabManager->Spawn("data/models/box.rcm", camera->GetPosition(), camera->GetDirection() * power, vulkan);
 		}
 
 		if (gInput->WasKeyPressed(KEYBOARD_KEY_R))
 		{
-			Model * model = new Model();
-			model->Init("data/models/teapot.rcm", vulkan, initCommandBuffer, physics, 1.0f);
-
-			glm::vec3 pos = camera->GetPosition();
-			glm::vec3 dir = camera->GetDirection();
 			float power = 5.0f;
-			model->SetPosition(pos.x, pos.y, pos.z);
-			model->SetVelocity(dir.x * power, dir.y * power, dir.z * power);
-
-			modelList.push_back(model);
+			prefabManager->Spawn("data/models/teapot.rcm", camera->GetPosition(), camera->GetDirection() * power, vulkan);
 		}
 
 		if (gInput->WasKeyPressed(KEYBOARD_KEY_O))
@@ -361,8 +523,8 @@ void SceneManager::Render(VulkanInterface * vulkan)
 		if (gInput->WasKeyPressed(KEYBOARD_KEY_Q))
 		{
 			char msg[64];
-			sprintf(msg, "OBJ: %zu TXD: %zu BUF: %zu", modelList.size(), gTextureManager->GetLoadedTexturesCount(),
-				gBufferManager->GetLoadedBuffersCount());
+			sprintf(msg, "OBJ: %zu TXD: %zu BUF: %zu", modelList.size() + prefabManager->GetSpawnedModels().size(),
+				gTextureManager->GetLoadedTexturesCount(), gBufferManager->GetLoadedBuffersCount());
 			gLogManager->AddMessage(msg);
 		}
 		if (gInput->WasKeyPressed(KEYBOARD_KEY_Z))
@@ -390,41 +552,67 @@ void SceneManager::Render(VulkanInterface * vulkan)
 
 		player->Update(vulkan, camera);
 
+		// Apply the texture levels streamed in or dropped since the last frame, the deferred pass that sampled the
+		// old images has finished by now
+		gTextureManager->UpdateStreaming(vulkan->GetVulkanDevice());
+
+		std::vector<Model*> & spawnedModels = prefabManager->GetSpawnedModels();
+		renderList.assign(modelList.begin(), modelList.end());
+		renderList.insert(renderList.end(), spawnedModels.begin(), spawnedModels.end());
+
+		// Slots allocated for loaded or spawned models may have grown the ring, nothing is recorded with the frame sets yet
+		pipelineManager->UpdateFrameSets(vulkan->GetVulkanDevice());
+
 		// Shadow pass
 		shadowMaps->UpdatePartitions(vulkan, camera, sunlight);
 		
 		shadowMaps->BeginShadowPass(deferredCommandBuffer);
 
+		// Models hand over their draws, cached or recorded this frame, and each pass executes them all at once
+		ClearRenderLists();
+
 		float frustumCullData[SHADOW_CASCADE_COUNT];
-		for (unsigned int i = 0; i < modelList.size(); i++)
+		for (unsigned int i = 0; i < renderList.size(); i++)
 		{
 			// Check if model is inside shadow map bound
-			if (shadowMaps->GetFrustumCuller(SHADOW_CASCADE_COUNT)->IsInsideFrustum(modelList[i]))
+			if (shadowMaps->GetFrustumCuller(SHADOW_CASCADE_COUNT)->IsInsideFrustum(renderList[i]))
 			{
 				for (int j = 0; j < SHADOW_CASCADE_COUNT; j++)
 				{
-					if (shadowMaps->GetFrustumCuller(j)->IsInsideFrustum(modelList[i]))
+					if (shadowMaps->GetFrustumCuller(j)->IsInsideFrustum(renderList[i]))
 						frustumCullData[j] = 1.0f;
 					else
 						frustumCullData[j] = 0.0f;
 				}
-				modelList[i]->SetFrustumCullData(frustumCullData);
-				modelList[i]->Render(vulkan, deferredCommandBuffer, pipelineManager->GetShadow(), NULL, shadowMaps);
+				renderList[i]->SetFrustumCullData(frustumCullData);
+				AddVisibleModel(renderList[i]);
 			}
 		}
 
-		player->GetModel()->Render(vulkan, deferredCommandBuffer, pipelineManager->GetShadowSkinned(), NULL, shadowMaps);
+		RecordModelDraws(vulkan, true);
+
+		// The player is drawn once the recording threads are done, so the pools of its thread are free
+		player->GetModel()->Render(vulkan, drawCommands,
+			pipelineManager->GetShadowSkinned(player->GetModel()->HasPackedVertices()), NULL, shadowMaps);
 
+		deferredCommandBuffer->ExecuteSecondaries(drawCommands);
 		shadowMaps->EndShadowPass(vulkan->GetVulkanDevice(), deferredCommandBuffer);
 		
 		// Deferred rendering
 		vulkan->BeginSceneDeferred(deferredCommandBuffer);
 
-		for (unsigned int i = 0; i < modelList.size(); i++)
-			if (frustumCuller->IsInsideFrustum(modelList[i]))
-				modelList[i]->Render(vulkan, deferredCommandBuffer, pipelineManager->GetDeferred(), camera, NULL);
+		ClearRenderLists();
 
-		player->GetModel()->Render(vulkan, deferredCommandBuffer, pipelineManager->GetSkinned(), camera, NULL);
+		for (unsigned int i = 0; i < renderList.size(); i++)
+			if (frustumCuller->IsInsideFrustum(renderList[i]))
+				AddVisibleModel(renderList[i]);
+
+		RecordModelDraws(vulkan, false);
+
+		player->GetModel()->Render(vulkan, drawCommands,
+			pipelineManager->GetSkinned(player->GetModel()->HasPackedVertices()), camera, NULL);
+
+		deferredCommandBuffer->ExecuteSecondaries(drawCommands);
 
 		vulkan->EndSceneDeferred(deferredCommandBuffer);
 	}
@@ -434,7 +622,20 @@ void SceneManager::Render(VulkanInterface * vulkan)
 		vulkan->EndSceneDeferred(deferredCommandBuffer);
 	}
 
-	// Forward rendering
+	// Forward rendering, the uniform data of every swapchain image is reserved up front because growing the ring
+	// would replace the buffer the images recorded before already use
+	VkDeviceSize forwardUniformSize = guiManager->GetFrameUniformSize();
+	if (currentGameState == GAME_STATE_INGAME)
+		forwardUniformSize += skydome->GetFrameUniformSize() + renderDummy->GetFrameUniformSize();
+	else if (currentGameState == GAME_STATE_SPLASH_SCREEN)
+		forwardUniformSize += splashScreen->GetFrameUniformSize();
+	else if (currentGameState == GAME_STATE_LOADING)
+		forwardUniformSize += splashScreen->GetFrameUniformSize() + loadingBar->GetFrameUniformSize();
+
+	if (!gUniformRing->Reserve(forwardUniformSize * vulkan->GetVulkanSwapchain()->GetSwapchainBufferCount()))
+		THROW_ERROR();
+	pipelineManager->UpdateFrameSets(vulkan->GetVulkanDevice());
+
 	for (size_t i = 0; i < vulkan->GetVulkanSwapchain()->GetSwapchainBufferCount(); i++)
 	{
 		vulkan->BeginSceneForward(renderCommandBuffers[i], (int)i);
@@ -447,6 +648,11 @@ void SceneManager::Render(VulkanInterface * vulkan)
 		}
 		else if (currentGameState == GAME_STATE_SPLASH_SCREEN)
 			splashScreen->Render(vulkan, renderCommandBuffers[i], pipelineManager->GetCanvas(), camera, (int)i);
+		else if (currentGameState == GAME_STATE_LOADING)
+		{
+			splashScreen->Render(vulkan, renderCommandBuffers[i], pipelineManager->GetCanvas(), camera, (int)i);
+			loadingBar->Render(vulkan, renderCommandBuffers[i], pipelineManager->GetCanvas(), camera, (int)i);
+		}
 		else
 		{
 			gLogManager->AddMessage("ERROR: Unknown game state!");
@@ -462,44 +668,119 @@ void SceneManager::Render(VulkanInterface * vulkan)
 	vulkan->Present(renderCommandBuffers);
 }
 
-bool SceneManager::LoadMapFile(std::string filename, VulkanInterface * vulkan)
+bool SceneManager::ReadMapFile(std::string filename, std::vector<TaskId> & modelTasks)
 {
-	std::ifstream file(filename);
-	if (!file.is_open())
-	{
-		gLogManager->AddMessage("ERROR: Couldn't find map file: " + filename);
+	sceneMap = new SceneMap();
+	if (!sceneMap->Init(filename))
 		return false;
-	}
 
-	while (!file.eof())
+	mapEntries.resize(sceneMap->GetInstanceCount());
+	for (unsigned int i = 0; i < mapEntries.size(); i++)
 	{
-		std::string modelPath;
-		std::string modelName;
-		float posX, posY, posZ;
-		float rotX, rotY, rotZ;
-		float mass;
-
-		file >> modelName >> posX >> posY >> posZ >> rotX >> rotY >> rotZ >> mass;
+		mapEntries[i].instance = sceneMap->GetInstance(i);
+		mapEntries[i].modelPath = sceneMap->GetAssetPath(mapEntries[i].instance->assetIndex);
+		mapEntries[i].model = NULL;
+	}
 
-		modelName.append(".rcm");
+	// Instances around the camera are loaded first, the rest of the map follows in file order
+	std::vector<unsigned int> loadOrder;
+	sceneMap->QuerySphere(camera->GetPosition(), MAP_PRIORITY_RADIUS, loadOrder);
 
-		modelPath = "data/models/" + modelName;
+	std::vector<bool> queued(mapEntries.size(), false);
+	for (unsigned int i = 0; i < loadOrder.size(); i++)
+		queued[loadOrder[i]] = true;
+	for (unsigned int i = 0; i < mapEntries.size(); i++)
+	{
+		if (!queued[i])
+			loadOrder.push_back(i);
+	}
 
-		Model * model = new Model();
-		if (!model->Init(modelPath, vulkan, initCommandBuffer, physics, mass))
+	for (unsigned int i = 0; i < loadOrder.size(); i++)
+	{
+		MapEntry * entry = &mapEntries[loadOrder[i]];
+		modelTasks.push_back(assetLoader->LoadModel(entry->modelPath, [entry](Model * model)
 		{
-			gLogManager->AddMessage("ERROR: Failed to init model: " + modelName);
-			return false;
-		}
+			entry->model = model;
+		}));
+	}
 
-		model->SetPosition(posX, posY, posZ);
-		model->SetRotation(rotX, rotY, rotZ);
+	return true;
+}
+
+void SceneManager::InitMapPhysics()
+{
+	// Rigid bodies are added in map order so the physics world ends up the same as before
+	for (unsigned int i = 0; i < mapEntries.size(); i++)
+	{
+		const RCMapInstance * instance = mapEntries[i].instance;
+
+		Model * model = mapEntries[i].model;
+		model->InitPhysics(physics, instance->mass);
+		model->SetPosition(instance->position[0], instance->position[1], instance->position[2]);
+		model->SetRotation(instance->rotation[0], instance->rotation[1], instance->rotation[2]);
 
 		modelList.push_back(model);
 	}
 
-	file.close();
-	return true;
+	mapEntries.clear();
+	gTextureManager->ReleasePrefetchedTextures();
+}
+
+void SceneManager::ClearRenderLists()
+{
+	for (unsigned int i = 0; i < threadRenderLists.size(); i++)
+		threadRenderLists[i].clear();
+
+	// The lists of the prefabs are kept, so they don't have to be allocated again
+	for (auto it = prefabInstances.begin(); it != prefabInstances.end(); it++)
+		it->second.clear();
+}
+
+void SceneManager::AddVisibleModel(Model * model)
+{
+	Model * prefab = model->GetPrefab();
+	if (prefab == NULL)
+	{
+		threadRenderLists[model->GetRecordingThread()].push_back(model);
+		return;
+	}
+
+	// The prefab takes the place of its first visible instance
+	std::vector<Model*> & instances = prefabInstances[prefab];
+	if (instances.empty())
+		threadRenderLists[prefab->GetRecordingThread()].push_back(prefab);
+	instances.push_back(model);
+}
+
+void SceneManager::RecordModelDraws(VulkanInterface * vulkan, bool shadowPass)
+{
+	// Every thread only draws the models whose command buffers come from its pools
+	gCommandRecorder->Record([&](unsigned int threadId)
+	{
+		std::vector<Model*> & models = threadRenderLists[threadId];
+		std::vector<VkCommandBuffer> & commands = threadDrawCommands[threadId];
+		commands.clear();
+
+		for (unsigned int i = 0; i < models.size(); i++)
+		{
+			VulkanPipeline * pipeline = (shadowPass ? pipelineManager->GetShadow(models[i]->HasPackedVertices()) :
+				pipelineManager->GetDeferred(models[i]->HasPackedVertices()));
+			ShadowMaps * passShadowMaps = (shadowPass ? shadowMaps : NULL);
+
+			// Only read here, every thread looks up its own prefabs
+			auto instances = prefabInstances.find(models[i]);
+			if (instances != prefabInstances.end())
+				models[i]->RenderInstances(vulkan, commands, pipeline, camera, passShadowMaps, &instances->second[0],
+					(unsigned int)instances->second.size());
+			else
+				models[i]->Render(vulkan, commands, pipeline, camera, passShadowMaps);
+		}
+	});
+
+	// Executed in thread order, so the draw order doesn't depend on which thread finished first
+	drawCommands.clear();
+	for (unsigned int i = 0; i < threadDrawCommands.size(); i++)
+		drawCommands.insert(drawCommands.end(), threadDrawCommands[i].begin(), threadDrawCommands[i].end());
 }
 
 void SceneManager::ChangeGameState(GAME_STATE newGameState)
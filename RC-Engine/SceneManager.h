@@ -28,6 +28,19 @@
 #include "TimeCycle.h"
 #include "LightManager.h"
 #include "Cubemap.h"
+#include "SceneMap.h"
+#include "PrefabManager.h"
+#include "TaskGraph.h"
+#include "AssetLoader.h"
+#include "CommandRecorder.h"
+
+#define MAP_PRIORITY_RADIUS 50.0f
+// Instances of each spawnable prop created while loading
+#define PROP_POOL_SIZE 16
+// Milliseconds of every loading frame spent on the loading tasks that have to run on the render thread
+#define LOADING_FRAME_BUDGET 10.0f
+#define LOADING_BAR_WIDTH 0.4f
+#define LOADING_BAR_HEIGHT 0.02f
 
 enum GAME_STATE
 {
@@ -65,7 +78,25 @@ class SceneManager
 		Animation * jumpAnim;
 		Animation * runAnim;
 
+		SceneMap * sceneMap;
+		struct MapEntry
+		{
+			const RCMapInstance * instance;
+			std::string modelPath;
+			Model * model;
+		};
+		std::vector<MapEntry> mapEntries;
 		std::vector<Model*> modelList;
+		PrefabManager * prefabManager;
+		// Map models and spawned props, gathered every frame
+		std::vector<Model*> renderList;
+		// Visible models of the pass being recorded, split by the thread that records them. Prefabs stand in for their
+		// visible instances, which are drawn together.
+		std::vector<std::vector<Model*>> threadRenderLists;
+		std::unordered_map<Model*, std::vector<Model*>> prefabInstances;
+		// Secondary command buffers of the pass being recorded, for each thread and then all of them in thread order
+		std::vector<std::vector<VkCommandBuffer>> threadDrawCommands;
+		std::vector<VkCommandBuffer> drawCommands;
 		SkinnedModel * male;
 		Player * player;
 
@@ -73,11 +104,20 @@ class SceneManager
 		GameplayTimer * splashScreenTimer;
 		bool showSplashScreen;
 
+		TaskGraph * loadingGraph;
+		AssetLoader * assetLoader;
+		GUIElement * loadingBar;
+
 		Cubemap * testCubemap;
 	private:
-		bool LoadMapFile(std::string filename, VulkanInterface * vulkan);
+		bool ReadMapFile(std::string filename, std::vector<TaskId> & modelTasks);
+		void InitMapPhysics();
 		bool LoadGame(VulkanInterface * vulkan);
+		void UpdateLoading(VulkanInterface * vulkan);
 		void ChangeGameState(GAME_STATE newGameState);
+		void ClearRenderLists();
+		void AddVisibleModel(Model * model);
+		void RecordModelDraws(VulkanInterface * vulkan, bool shadowPass);
 	public:
 		SceneManager();
 		~SceneManager();
@@ -0,0 +1,197 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: SceneMap.cpp                                         |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "SceneMap.h"
+#include "LogManager.h"
+
+extern LogManager * gLogManager;
+
+SceneMap::SceneMap()
+{
+	header = NULL;
+	assets = NULL;
+	instances = NULL;
+	nodes = NULL;
+	instanceIndices = NULL;
+	strings = NULL;
+}
+
+SceneMap::~SceneMap()
+{
+	strings = NULL;
+	instanceIndices = NULL;
+	nodes = NULL;
+	instances = NULL;
+	assets = NULL;
+	header = NULL;
+}
+
+bool SceneMap::Init(std::string filename)
+{
+	if (!mapFile.Init(filename))
+	{
+		gLogManager->AddMessage("ERROR: Couldn't find map file: " + filename);
+		return false;
+	}
+
+	header = (const RCMapHeader*)mapFile.Read(sizeof(RCMapHeader));
+	if (header == NULL || header->magic != RCMAP_MAGIC || header->version != RCMAP_VERSION)
+	{
+		gLogManager->AddMessage("ERROR: Map file has an unknown format or version! (" + filename + ")");
+		return false;
+	}
+
+	// Every table is used straight from the file data
+	assets = (const RCMapAsset*)mapFile.Read(sizeof(RCMapAsset) * header->assetCount);
+	instances = (const RCMapInstance*)mapFile.Read(sizeof(RCMapInstance) * header->instanceCount);
+	nodes = (const RCMapNode*)mapFile.Read(sizeof(RCMapNode) * header->nodeCount);
+	instanceIndices = (const uint32_t*)mapFile.Read(sizeof(uint32_t) * header->instanceCount);
+	strings = (const char*)mapFile.Read(header->stringTableSize);
+
+	if (assets == NULL || instances == NULL || nodes == NULL || instanceIndices == NULL || strings == NULL)
+	{
+		gLogManager->AddMessage("ERROR: Map file is corrupted! (" + filename + ")");
+		return false;
+	}
+
+	// Validate indices once, so queries don't have to
+	for (uint32_t i = 0; i < header->assetCount; i++)
+	{
+		if (assets[i].pathOffset + assets[i].pathLength >= header->stringTableSize)
+		{
+			gLogManager->AddMessage("ERROR: Map file is corrupted! (" + filename + ")");
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header->instanceCount; i++)
+	{
+		if (instances[i].assetIndex >= header->assetCount || instanceIndices[i] >= header->instanceCount)
+		{
+			gLogManager->AddMessage("ERROR: Map file is corrupted! (" + filename + ")");
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header->nodeCount; i++)
+	{
+		const RCMapNode & node = nodes[i];
+		bool valid;
+		if (node.instanceCount > 0)
+			valid = node.childOrFirstIndex + node.instanceCount <= header->instanceCount;
+		else
+			valid = node.childOrFirstIndex > i + 1 && node.childOrFirstIndex < header->nodeCount;
+
+		if (!valid)
+		{
+			gLogManager->AddMessage("ERROR: Map file is corrupted! (" + filename + ")");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void SceneMap::Unload()
+{
+	mapFile.Unload();
+
+	header = NULL;
+	assets = NULL;
+	instances = NULL;
+	nodes = NULL;
+	instanceIndices = NULL;
+	strings = NULL;
+}
+
+void SceneMap::QueryBox(glm::vec3 boxMin, glm::vec3 boxMax, std::vector<unsigned int> & result)
+{
+	if (header == NULL || header->nodeCount == 0)
+		return;
+
+	// Child indices always point forward, so the stack can never hold more than nodeCount entries
+	std::vector<uint32_t> stack;
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		const RCMapNode & node = nodes[stack.back()];
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		if (node.boundsMin[0] > boxMax.x || node.boundsMax[0] < boxMin.x ||
+			node.boundsMin[1] > boxMax.y || node.boundsMax[1] < boxMin.y ||
+			node.boundsMin[2] > boxMax.z || node.boundsMax[2] < boxMin.z)
+			continue;
+
+		if (node.instanceCount == 0)
+		{
+			stack.push_back(node.childOrFirstIndex);
+			stack.push_back(nodeIndex + 1);
+			continue;
+		}
+
+		for (uint32_t i = 0; i < node.instanceCount; i++)
+		{
+			uint32_t instanceId = instanceIndices[node.childOrFirstIndex + i];
+			const RCMapInstance & instance = instances[instanceId];
+
+			if (instance.boundsMin[0] > boxMax.x || instance.boundsMax[0] < boxMin.x ||
+				instance.boundsMin[1] > boxMax.y || instance.boundsMax[1] < boxMin.y ||
+				instance.boundsMin[2] > boxMax.z || instance.boundsMax[2] < boxMin.z)
+				continue;
+
+			result.push_back(instanceId);
+		}
+	}
+}
+
+void SceneMap::QuerySphere(glm::vec3 center, float radius, std::vector<unsigned int> & result)
+{
+	std::vector<unsigned int> candidates;
+	QueryBox(center - glm::vec3(radius), center + glm::vec3(radius), candidates);
+
+	// Keep instances whose bounds actually touch the sphere
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		const RCMapInstance & instance = instances[candidates[i]];
+		glm::vec3 closest = glm::clamp(center, glm::vec3(instance.boundsMin[0], instance.boundsMin[1], instance.boundsMin[2]),
+			glm::vec3(instance.boundsMax[0], instance.boundsMax[1], instance.boundsMax[2]));
+
+		glm::vec3 delta = closest - center;
+		if (glm::dot(delta, delta) <= radius * radius)
+			result.push_back(candidates[i]);
+	}
+}
+
+unsigned int SceneMap::GetInstanceCount()
+{
+	if (header == NULL)
+		return 0;
+
+	return header->instanceCount;
+}
+
+const RCMapInstance * SceneMap::GetInstance(unsigned int instanceId)
+{
+	return &instances[instanceId];
+}
+
+std::string SceneMap::GetAssetPath(unsigned int assetId)
+{
+	return std::string(strings + assets[assetId].pathOffset, assets[assetId].pathLength);
+}
+
+glm::vec3 SceneMap::GetBoundsMin()
+{
+	return glm::vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]);
+}
+
+glm::vec3 SceneMap::GetBoundsMax()
+{
+	return glm::vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]);
+}
\ No newline at end of file
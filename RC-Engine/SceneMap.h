@@ -0,0 +1,39 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: SceneMap.h                                           |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm.hpp>
+
+#include "MappedFile.h"
+#include "MapFormat.h"
+
+class SceneMap
+{
+	private:
+		MappedFile mapFile;
+		const RCMapHeader * header;
+		const RCMapAsset * assets;
+		const RCMapInstance * instances;
+		const RCMapNode * nodes;
+		const uint32_t * instanceIndices;
+		const char * strings;
+	public:
+		SceneMap();
+		~SceneMap();
+
+		bool Init(std::string filename);
+		void Unload();
+		void QueryBox(glm::vec3 boxMin, glm::vec3 boxMax, std::vector<unsigned int> & result);
+		void QuerySphere(glm::vec3 center, float radius, std::vector<unsigned int> & result);
+		unsigned int GetInstanceCount();
+		const RCMapInstance * GetInstance(unsigned int instanceId);
+		std::string GetAssetPath(unsigned int assetId);
+		glm::vec3 GetBoundsMin();
+		glm::vec3 GetBoundsMax();
+};
\ No newline at end of file
@@ -15,6 +15,13 @@ Settings::Settings()
 	windowWidth = 800;
 	windowHeight = 600;
 	fullscreen = false;
+	textureBudget = 512;
+	bufferBudget = 128;
+	optimizeMeshes = true;
+	lodPixelError = 1.0f;
+	shadowLodBias = 4.0f;
+	textureStreaming = true;
+	commandCaching = true;
 }
 
 bool Settings::ReadSettings()
@@ -44,6 +51,20 @@ bool Settings::ReadSettings()
 			file >> windowHeight;
 		else if (identifier == "fullscreen")
 			file >> (bool)fullscreen;
+		else if (identifier == "texturebudget")
+			file >> textureBudget;
+		else if (identifier == "bufferbudget")
+			file >> bufferBudget;
+		else if (identifier == "optimizemeshes")
+			file >> optimizeMeshes;
+		else if (identifier == "lodpixelerror")
+			file >> lodPixelError;
+		else if (identifier == "shadowlodbias")
+			file >> shadowLodBias;
+		else if (identifier == "texturestreaming")
+			file >> textureStreaming;
+		else if (identifier == "commandcaching")
+			file >> commandCaching;
 		else
 		{
 			Settings();
@@ -68,3 +89,37 @@ bool Settings::GetFullscreenMode()
 	return fullscreen;
 }
 
+int Settings::GetTextureBudget()
+{
+	return textureBudget;
+}
+
+int Settings::GetBufferBudget()
+{
+	return bufferBudget;
+}
+
+bool Settings::GetOptimizeMeshes()
+{
+	return optimizeMeshes;
+}
+
+float Settings::GetLodPixelError()
+{
+	return lodPixelError;
+}
+
+float Settings::GetShadowLodBias()
+{
+	return shadowLodBias;
+}
+
+bool Settings::GetTextureStreaming()
+{
+	return textureStreaming;
+}
+
+bool Settings::GetCommandCaching()
+{
+	return commandCaching;
+}
\ No newline at end of file
@@ -13,6 +13,11 @@ class Settings
 	private:
 		int windowWidth, windowHeight;
 		bool fullscreen;
+		int textureBudget, bufferBudget;
+		bool optimizeMeshes;
+		float lodPixelError, shadowLodBias;
+		bool textureStreaming;
+		bool commandCaching;
 	public:
 		Settings();
 
@@ -21,4 +26,11 @@ class Settings
 		int GetWindowWidth();
 		int GetWindowHeight();
 		bool GetFullscreenMode();
+		int GetTextureBudget();
+		int GetBufferBudget();
+		bool GetOptimizeMeshes();
+		float GetLodPixelError();
+		float GetShadowLodBias();
+		bool GetTextureStreaming();
+		bool GetCommandCaching();
 };
\ No newline at end of file
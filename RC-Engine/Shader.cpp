@@ -8,6 +8,7 @@
 #include <fstream>
 
 #include "Shader.h"
+#include "MappedFile.h"
 #include "LogManager.h"
 
 extern LogManager * gLogManager;
@@ -38,31 +39,19 @@ bool Shader::Init(VulkanDevice * vulkanDevice, std::string shaderName, bool hasG
 	for(uint32_t i = 0; i < stageCount; i++)
 		shaderStages[i] = {};
 
-	FILE * file = NULL;
-
 	// Vertex shader
 	std::string vertexShaderPath = shaderDir + shaderName + "VS.spv";
-	file = fopen(vertexShaderPath.c_str(), "rb");
-	if (file == NULL)
+	MappedFile vsFile;
+	if (!vsFile.Init(vertexShaderPath))
 	{
 		gLogManager->AddMessage("ERROR: Couldn't find vertex shader file: " + shaderName + "VS.spv");
 		return false;
 	}
 
-	fseek(file, 0, SEEK_END);
-	long size = ftell(file);
-	rewind(file);
-
-	char * vsBuffer = new char[size];
-	fread(vsBuffer, 1, size, file);
-
-	fclose(file);
-	file = NULL;
-
 	VkShaderModuleCreateInfo vertexShaderCI{};
 	vertexShaderCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	vertexShaderCI.codeSize = size;
-	vertexShaderCI.pCode = (uint32_t*)vsBuffer;
+	vertexShaderCI.codeSize = vsFile.GetSize();
+	vertexShaderCI.pCode = (const uint32_t*)vsFile.GetData();
 	vertexShaderCI.pNext = VK_NULL_HANDLE;
 	vertexShaderCI.flags = 0;
 
@@ -77,31 +66,21 @@ bool Shader::Init(VulkanDevice * vulkanDevice, std::string shaderName, bool hasG
 		return false;
 
 	currentShaderStage++;
-	delete[] vsBuffer;
+	vsFile.Unload();
 
 	// Fragment shader
 	std::string fragmentShaderPath = shaderDir + shaderName + "FS.spv";
-	file = fopen(fragmentShaderPath.c_str(), "rb");
-	if (file == NULL)
+	MappedFile fsFile;
+	if (!fsFile.Init(fragmentShaderPath))
 	{
 		gLogManager->AddMessage("ERROR: Couldn't find fragment shader file: " + shaderName + "FS.spv");
 		return false;
 	}
 
-	fseek(file, 0, SEEK_END);
-	size = ftell(file);
-	rewind(file);
-
-	char * fsBuffer = new char[size];
-	fread(fsBuffer, 1, size, file);
-
-	fclose(file);
-	file = NULL;
-
 	VkShaderModuleCreateInfo fragmentShaderCI{};
 	fragmentShaderCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	fragmentShaderCI.codeSize = size;
-	fragmentShaderCI.pCode = (uint32_t*)fsBuffer;
+	fragmentShaderCI.codeSize = fsFile.GetSize();
+	fragmentShaderCI.pCode = (const uint32_t*)fsFile.GetData();
 	fragmentShaderCI.pNext = VK_NULL_HANDLE;
 	fragmentShaderCI.flags = 0;
 
@@ -116,33 +95,23 @@ bool Shader::Init(VulkanDevice * vulkanDevice, std::string shaderName, bool hasG
 		return false;
 
 	currentShaderStage++;
-	delete[] fsBuffer;
+	fsFile.Unload();
 
 	// Geometry shader
 	if (hasGeometryShader)
 	{
 		std::string geometryShaderPath = shaderDir + shaderName + "GS.spv";
-		file = fopen(geometryShaderPath.c_str(), "rb");
-		if (file == NULL)
+		MappedFile gsFile;
+		if (!gsFile.Init(geometryShaderPath))
 		{
 			gLogManager->AddMessage("ERROR: Couldn't find geometry shader file: " + shaderName + "GS.spv");
 			return false;
 		}
 
-		fseek(file, 0, SEEK_END);
-		size = ftell(file);
-		rewind(file);
-
-		char * gsBuffer = new char[size];
-		fread(gsBuffer, 1, size, file);
-
-		fclose(file);
-		file = NULL;
-
 		VkShaderModuleCreateInfo geometryShaderCI{};
 		geometryShaderCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		geometryShaderCI.codeSize = size;
-		geometryShaderCI.pCode = (uint32_t*)gsBuffer;
+		geometryShaderCI.codeSize = gsFile.GetSize();
+		geometryShaderCI.pCode = (const uint32_t*)gsFile.GetData();
 		geometryShaderCI.pNext = VK_NULL_HANDLE;
 		geometryShaderCI.flags = 0;
 
@@ -157,7 +126,7 @@ bool Shader::Init(VulkanDevice * vulkanDevice, std::string shaderName, bool hasG
 			return false;
 
 		currentShaderStage++;
-		delete[] gsBuffer;
+		gsFile.Unload();
 	}
 
 	return true;
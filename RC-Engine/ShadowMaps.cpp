@@ -10,15 +10,18 @@
 #include "StdInc.h"
 #include "VulkanTools.h"
 #include "Input.h"
+#include "UniformRing.h"
 
 extern LogManager * gLogManager;
 extern Input * gInput;
+extern UniformRing * gUniformRing;
 
 ShadowMaps::ShadowMaps()
 {
 	depthAttachment = NULL;
 	renderpass = NULL;
-	shadowGS_UBO = NULL;
+	uniformSlot = UNIFORM_RING_NO_SLOT;
+	uniformOffset = 0;
 }
 
 bool ShadowMaps::Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer, Camera * camera)
@@ -111,10 +114,8 @@ bool ShadowMaps::Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer,
 	projectionMatrixPartitions[2] = glm::perspective(camera->GetFieldOfView(), camera->GetAspectRatio(), 10.0f, 50.0f);
 	depthRadius = camera->GetFarClip();
 
-	// Create geometry shader uniform buffer
-	shadowGS_UBO = new VulkanBuffer();
-	if (!shadowGS_UBO->Init(vulkan->GetVulkanDevice(), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &geometryUniformBuffer,
-		sizeof(geometryUniformBuffer), false))
+	// Geometry shader uniform data lives in the uniform ring
+	if (!gUniformRing->AllocateSlot(sizeof(geometryUniformBuffer), &uniformSlot))
 		return false;
 
 	// Create a frustum culler for each cascade
@@ -127,11 +128,13 @@ bool ShadowMaps::Init(VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer,
 
 void ShadowMaps::Unload(VulkanInterface * vulkan)
 {
+	gUniformRing->FreeSlot(uniformSlot);
+	uniformSlot = UNIFORM_RING_NO_SLOT;
+
 	for (int i = 0; i < SHADOW_CASCADE_COUNT + 1; i++)
 		SAFE_DELETE(cascadeFrustumCullers[i]);
 	SAFE_DELETE(cascadeFrustumCullers);
 
-	SAFE_UNLOAD(shadowGS_UBO, vulkan->GetVulkanDevice());
 	SAFE_DELETE(projectionMatrixPartitions);
 	SAFE_DELETE(viewMatrices);
 	SAFE_DELETE(orthoMatrices);
@@ -238,7 +241,7 @@ void ShadowMaps::UpdatePartitions(VulkanInterface * vulkan, Camera * viewcamera,
 	cascadeFrustumCullers[SHADOW_CASCADE_COUNT]->BuildFrustum(orthoMatrices[SHADOW_CASCADE_COUNT - 1]
 		* viewMatrices[SHADOW_CASCADE_COUNT - 1]);
 
-	shadowGS_UBO->Update(vulkan->GetVulkanDevice(), &geometryUniformBuffer, sizeof(geometryUniformBuffer));
+	gUniformRing->Write(uniformSlot, &geometryUniformBuffer, sizeof(geometryUniformBuffer), &uniformOffset);
 }
 
 VulkanRenderpass * ShadowMaps::GetShadowRenderpass()
@@ -256,9 +259,9 @@ VkImageView * ShadowMaps::GetImageView()
 	return depthAttachment->GetImageView();
 }
 
-VkDescriptorBufferInfo * ShadowMaps::GetBufferInfo()
+uint32_t ShadowMaps::GetUniformOffset()
 {
-	return shadowGS_UBO->GetBufferInfo();
+	return uniformOffset;
 }
 
 glm::mat4 ShadowMaps::GetLightViewProj(int index)
@@ -36,7 +36,10 @@ class ShadowMaps
 			glm::mat4 lightViewProj[SHADOW_CASCADE_COUNT];
 		};
 		GeometryUniformBuffer geometryUniformBuffer;
-		VulkanBuffer * shadowGS_UBO;
+		// Written to the uniform ring once per frame, shared by every shadow caster. The slot keeps the offset the same
+		// every frame, so the recorded shadow draws stay valid.
+		uint32_t uniformSlot;
+		uint32_t uniformOffset;
 
 		FrustumCuller ** cascadeFrustumCullers;
 	public:
@@ -51,7 +54,7 @@ class ShadowMaps
 		VulkanRenderpass * GetShadowRenderpass();
 		VkFramebuffer GetFramebuffer();
 		VkImageView * GetImageView();
-		VkDescriptorBufferInfo * GetBufferInfo();
+		uint32_t GetUniformOffset();
 		glm::mat4 GetLightViewProj(int index);
 		VkSampler GetSampler();
 		uint32_t GetMapSize();
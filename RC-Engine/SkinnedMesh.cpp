@@ -8,8 +8,13 @@
 #include "SkinnedMesh.h"
 #include "StdInc.h"
 #include "BufferManager.h"
+#include "XXHash.h"
+#include "MeshFormat.h"
+#include "MeshOptimizer.h"
+#include "Settings.h"
 
 extern BufferManager * gBufferManager;
+extern Settings * gSettings;
 
 SkinnedMesh::SkinnedMesh()
 {
@@ -23,47 +28,54 @@ SkinnedMesh::~SkinnedMesh()
 	vertexBuffer = NULL;
 }
 
-bool SkinnedMesh::Init(VulkanInterface * vulkan, FILE * modelFile, std::string meshName)
+bool SkinnedMesh::Init(VulkanInterface * vulkan, MappedFile * modelFile, uint32_t meshFlags)
 {
 	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
-	VulkanCommandPool * cmdPool = vulkan->GetVulkanCommandPool();
+	size_t vertexSize = GetMeshVertexSize(meshFlags, true);
 
-	fread(&vertexCount, sizeof(unsigned int), 1, modelFile);
-	fread(&indexCount, sizeof(unsigned int), 1, modelFile);
+	if (!modelFile->Read(&vertexCount, sizeof(unsigned int)) || !modelFile->Read(&indexCount, sizeof(unsigned int)))
+		return false;
 
-	Vertex * vertexData = new Vertex[vertexCount];
-	uint32_t * indexData = new uint32_t[indexCount];
+	// Vertex and index data are used straight from the mapped file
+	const void * vertexData = modelFile->Read(vertexSize * vertexCount);
+	const void * indexData = modelFile->Read(GetMeshIndexDataSize(meshFlags, vertexCount, indexCount));
+	if (vertexData == NULL || indexData == NULL)
+		return false;
 
-	fread(vertexData, sizeof(Vertex), vertexCount, modelFile);
-	fread(indexData, sizeof(uint32_t), indexCount, modelFile);
+	bool shortIndices = HasShortIndices(meshFlags, vertexCount);
 
-	// Command buffer used for creating buffers
-	VulkanCommandBuffer * cmdBuffer = new VulkanCommandBuffer();
-	if (!cmdBuffer->Init(vulkanDevice, cmdPool, true))
-		return false;
+	// Meshes that weren't cooked are optimized here instead, that needs a copy of the mesh data
+	std::vector<unsigned char> optimizedVertexData, optimizedIndexData;
+	if (!(meshFlags & RCM_FLAG_OPTIMIZED) && gSettings->GetOptimizeMeshes())
+	{
+		if (!MeshOptimizer::OptimizeMesh(vertexData, vertexCount, vertexSize, (const uint32_t*)indexData, indexCount,
+			optimizedVertexData, optimizedIndexData, shortIndices))
+			return false;
+
+		vertexData = optimizedVertexData.data();
+		indexData = optimizedIndexData.data();
+	}
+
+	size_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+	indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
-	cmdBuffer->BeginRecording();
+	uint64_t vertexDataHash = XXHash::Hash64(vertexData, vertexSize * vertexCount);
+	uint64_t indexDataHash = XXHash::Hash64(indexData, indexSize * indexCount);
 
-	// Vertex buffer
-	vertexBuffer = gBufferManager->RequestBuffer(meshName + "VB", vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		vertexData, sizeof(Vertex) * vertexCount, true, cmdBuffer);
+	// Vertex buffer, uploaded with the next staging flush
+	vertexBufferHandle = gBufferManager->RequestBuffer(vertexDataHash, vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		vertexData, vertexSize * vertexCount, true);
+	vertexBuffer = gBufferManager->GetBuffer(vertexBufferHandle);
 	if (vertexBuffer == nullptr)
 		return false;
 
 	// Index buffer
-	indexBuffer = gBufferManager->RequestBuffer(meshName + "IB", vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		indexData, sizeof(uint32_t) * indexCount, true, cmdBuffer);
+	indexBufferHandle = gBufferManager->RequestBuffer(indexDataHash, vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		indexData, indexSize * indexCount, true);
+	indexBuffer = gBufferManager->GetBuffer(indexBufferHandle);
 	if (indexBuffer == nullptr)
 		return false;
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(vulkanDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, true);
-
-	SAFE_UNLOAD(cmdBuffer, vulkanDevice, cmdPool);
-
-	delete[] vertexData;
-	delete[] indexData;
-
 	// Material uniform buffer
 	materialUniformBuffer.hasNormalMap = 0.0f;
 	materialUniformBuffer.metallicOffset = 0.0f;
@@ -82,25 +94,31 @@ bool SkinnedMesh::Init(VulkanInterface * vulkan, FILE * modelFile, std::string m
 void SkinnedMesh::Unload(VulkanInterface * vulkan)
 {
 	SAFE_UNLOAD(materialUBO, vulkan->GetVulkanDevice());
-	gBufferManager->ReleaseBuffer(indexBuffer, vulkan->GetVulkanDevice());
-	gBufferManager->ReleaseBuffer(vertexBuffer, vulkan->GetVulkanDevice());
+	gBufferManager->ReleaseBuffer(indexBufferHandle, vulkan->GetVulkanDevice());
+	gBufferManager->ReleaseBuffer(vertexBufferHandle, vulkan->GetVulkanDevice());
 }
 
 void SkinnedMesh::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer)
 {
 	VkDeviceSize offsets[1] = { 0 };
 	vkCmdBindVertexBuffers(commandBuffer->GetCommandBuffer(), 0, 1, vertexBuffer->GetBuffer(), offsets);
-	vkCmdBindIndexBuffer(commandBuffer->GetCommandBuffer(), *indexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(commandBuffer->GetCommandBuffer(), *indexBuffer->GetBuffer(), 0, indexType);
 
 	vkCmdDrawIndexed(commandBuffer->GetCommandBuffer(), indexCount, 1, 0, 0, 0);
 }
 
 void SkinnedMesh::UpdateUniformBuffer(VulkanInterface * vulkan)
 {
-	materialUniformBuffer.hasNormalMap = (material->HasNormalMap() ? 1.0f : 0.0f);
-	materialUniformBuffer.metallicOffset = material->GetMetallicOffset();
-	materialUniformBuffer.roughnessOffset = material->GetRoughnessOffset();
+	MaterialUniformBuffer newData = materialUniformBuffer;
+	newData.hasNormalMap = (material->HasNormalMap() ? 1.0f : 0.0f);
+	newData.metallicOffset = material->GetMetallicOffset();
+	newData.roughnessOffset = material->GetRoughnessOffset();
+
+	// Materials rarely change, only touch the buffer when they do
+	if (memcmp(&newData, &materialUniformBuffer, sizeof(materialUniformBuffer)) == 0)
+		return;
 
+	materialUniformBuffer = newData;
 	materialUBO->Update(vulkan->GetVulkanDevice(), &materialUniformBuffer, sizeof(materialUniformBuffer));
 }
 
@@ -9,7 +9,9 @@
 #include "VulkanInterface.h"
 #include "VulkanPipeline.h"
 #include "VulkanBuffer.h"
+#include "ResourceRegistry.h"
 #include "Material.h"
+#include "MappedFile.h"
 
 class SkinnedMesh
 {
@@ -26,6 +28,7 @@ class SkinnedMesh
 
 		unsigned int vertexCount;
 		unsigned int indexCount;
+		VkIndexType indexType;
 
 		struct MaterialUniformBuffer
 		{
@@ -36,6 +39,8 @@ class SkinnedMesh
 		};
 		MaterialUniformBuffer materialUniformBuffer;
 
+		ResourceHandle vertexBufferHandle;
+		ResourceHandle indexBufferHandle;
 		VulkanBuffer * vertexBuffer;
 		VulkanBuffer * indexBuffer;
 		VulkanBuffer * materialUBO;
@@ -45,7 +50,7 @@ class SkinnedMesh
 		SkinnedMesh();
 		~SkinnedMesh();
 
-		bool Init(VulkanInterface * vulkan, FILE * modelFile, std::string meshName);
+		bool Init(VulkanInterface * vulkan, MappedFile * modelFile, uint32_t meshFlags);
 		void Unload(VulkanInterface * vulkan);
 		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer);
 		void UpdateUniformBuffer(VulkanInterface * vulkan);
@@ -5,7 +5,7 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
-#include <fstream>
+#include <sstream>
 
 #include "SkinnedModel.h"
 #include "StdInc.h"
@@ -13,51 +13,46 @@
 #include "Timer.h"
 #include "Settings.h"
 #include "TextureManager.h"
+#include "MeshFormat.h"
+#include "UniformRing.h"
 
 extern LogManager * gLogManager;
 extern Timer * gTimer;
 extern Settings * gSettings;
 extern TextureManager * gTextureManager;
+extern UniformRing * gUniformRing;
 
 SkinnedModel::SkinnedModel()
 {
-	skinnedVS_UBO = NULL;
-	skinnedVS_bone_UBO = NULL;
 	currentAnim = NULL;
+	meshFlags = 0;
+	drawCommandCache = NULL;
+	for (int i = 0; i < DRAW_PASS_COUNT; i++)
+	{
+		vertexSlots[i] = UNIFORM_RING_NO_SLOT;
+		boneSlots[i] = UNIFORM_RING_NO_SLOT;
+	}
+	meshSetPipeline = NULL;
 }
 
 SkinnedModel::~SkinnedModel()
 {
+	meshSetPipeline = NULL;
+	drawCommandCache = NULL;
 	currentAnim = NULL;
-	skinnedVS_bone_UBO = NULL;
-	skinnedVS_UBO = NULL;
 }
 
-bool SkinnedModel::Init(std::string filename, VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer)
+bool SkinnedModel::Init(std::string filename, VulkanInterface * vulkan)
 {
-	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
-
-	// Uniform buffer init
+	// Uniform data, written to the uniform ring every time the model is drawn
 	vertexUniformBuffer.worldMatrix = glm::mat4(1.0f);
 	vertexUniformBuffer.MVP = glm::mat4();
 	for (unsigned int i = 0; i < MAX_BONES; i++)
 		boneUniformBufferData.bones[i] = glm::mat4();
 
-	// Vertex shader - Uniform buffer
-	skinnedVS_UBO = new VulkanBuffer();
-	if (!skinnedVS_UBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &vertexUniformBuffer,
-		sizeof(vertexUniformBuffer), false))
-		return false;
-
-	// Vertex shader - Bone Uniform buffer
-	skinnedVS_bone_UBO = new VulkanBuffer();
-	if (!skinnedVS_bone_UBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &boneUniformBufferData,
-		sizeof(boneUniformBufferData), false))
-		return false;
-
-	// Open .rcs file
-	FILE * file = fopen(filename.c_str(), "rb");
-	if (file == NULL)
+	// Map .rcs file
+	MappedFile file;
+	if (!file.Init(filename))
 	{
 		gLogManager->AddMessage("ERROR: Model file not found! (" + filename + ")");
 		return false;
@@ -67,24 +62,42 @@ bool SkinnedModel::Init(std::string filename, VulkanInterface * vulkan, VulkanCo
 	size_t pos = filename.rfind('.');
 	filename.replace(pos, 4, ".mat");
 
-	std::ifstream matFile(filename.c_str());
-	if (!matFile.is_open())
+	MappedFile materialFile;
+	if (!materialFile.Init(filename))
 	{
 		gLogManager->AddMessage("ERROR: Model .mat file not found! (" + filename + ")");
 		return false;
 	}
 
+	std::istringstream matFile(std::string((const char*)materialFile.GetData(), materialFile.GetSize()));
+	materialFile.Unload();
+
+	// Files cooked by RC-Tools start with a header, its flags tell how the meshes are stored
+	size_t headerSize;
+	if (!ReadMeshHeader(file.GetData(), file.GetSize(), meshFlags, headerSize))
+	{
+		gLogManager->AddMessage("ERROR: Model file has an unknown version! (" + filename + ")");
+		return false;
+	}
+	if (meshFlags & RCM_FLAG_LEGACY_PACKED_VERTICES)
+	{
+		gLogManager->AddMessage("ERROR: Model file has old packed vertices, re-cook it with RC-Tools cookmesh! (" + filename + ")");
+		return false;
+	}
+	file.SetReadOffset(headerSize);
+
 	unsigned int meshCount;
-	fread(&meshCount, sizeof(unsigned int), 1, file);
+	if (!file.Read(&meshCount, sizeof(unsigned int)))
+	{
+		gLogManager->AddMessage("ERROR: Model file is corrupted! (" + filename + ")");
+		return false;
+	}
 
 	for (unsigned int i = 0; i < meshCount; i++)
 	{
 		// Create and read mesh data
-		char meshIdentifier[16];
-		sprintf(meshIdentifier, "_mesh%d", i);
-
 		SkinnedMesh * mesh = new SkinnedMesh();
-		if (!mesh->Init(vulkan, file, filename + meshIdentifier))
+		if (!mesh->Init(vulkan, &file, meshFlags))
 		{
 			gLogManager->AddMessage("ERROR: Failed to init a mesh!");
 			return false;
@@ -92,38 +105,38 @@ bool SkinnedModel::Init(std::string filename, VulkanInterface * vulkan, VulkanCo
 		meshes.push_back(mesh);
 
 		std::string texturePath;
-		char diffuseTextureName[64];
-		char normalTextureName[64];
 
 		// Init mesh material
 		Material * material = new Material();
 
 		// Read diffuse texture
-		fread(diffuseTextureName, sizeof(char), 64, file);
-		if (strcmp(diffuseTextureName, "NONE") == 0)
+		std::string diffuseTextureName = file.ReadString(64);
+		if (diffuseTextureName == "NONE")
 			texturePath = "data/textures/default_diffuse.rct";
 		else
-			texturePath = "data/textures/" + std::string(diffuseTextureName);
+			texturePath = "data/textures/" + diffuseTextureName;
 
-		Texture * diffuse = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice(), cmdBuffer);
+		ResourceHandle diffuseHandle = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice());
+		Texture * diffuse = gTextureManager->GetTexture(diffuseHandle);
 		if (diffuse == nullptr)
 			return false;
 
-		textures.push_back(diffuse);
+		textures.push_back(diffuseHandle);
 
 		material->SetDiffuseTexture(diffuse);
 
 		// Read normal texture if available
-		fread(normalTextureName, sizeof(char), 64, file);
-		if (strcmp(normalTextureName, "NONE") != 0)
+		std::string normalTextureName = file.ReadString(64);
+		if (normalTextureName != "NONE")
 		{
-			texturePath = "data/textures/" + std::string(normalTextureName);
+			texturePath = "data/textures/" + normalTextureName;
 
-			Texture * normal = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice(), cmdBuffer);
+			ResourceHandle normalHandle = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice());
+			Texture * normal = gTextureManager->GetTexture(normalHandle);
 			if (normal == nullptr)
 				return false;
 
-			textures.push_back(normal);
+			textures.push_back(normalHandle);
 
 			material->SetNormalTexture(normal);
 		}
@@ -138,11 +151,12 @@ bool SkinnedModel::Init(std::string filename, VulkanInterface * vulkan, VulkanCo
 		else
 			texturePath = "data/textures/" + matTextureName;
 
-		Texture * matTexture = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice(), cmdBuffer);
+		ResourceHandle matTextureHandle = gTextureManager->RequestTexture(texturePath, vulkan->GetVulkanDevice());
+		Texture * matTexture = gTextureManager->GetTexture(matTextureHandle);
 		if (matTexture == nullptr)
 			return false;
 
-		textures.push_back(matTexture);
+		textures.push_back(matTextureHandle);
 
 		material->SetMaterialTexture(matTexture);
 		material->SetMetallicOffset(metallicOffset);
@@ -150,43 +164,39 @@ bool SkinnedModel::Init(std::string filename, VulkanInterface * vulkan, VulkanCo
 
 		materials.push_back(material);
 		meshes[i]->SetMaterial(material);
+	}
 
-		// Init draw command buffers for each meash
-		VulkanCommandBuffer * drawCmdBuffer = new VulkanCommandBuffer();
-		if (!drawCmdBuffer->Init(vulkanDevice, vulkan->GetVulkanCommandPool(), false))
+	drawCommandCache = new DrawCommandCache();
+	if (!drawCommandCache->Init(vulkan, (unsigned int)meshes.size()))
+		return false;
+
+	// The ring grows when its slots are used up, so this only fails when the device is out of memory
+	for (int i = 0; i < DRAW_PASS_COUNT; i++)
+	{
+		if (!gUniformRing->AllocateSlot(sizeof(vertexUniformBuffer), &vertexSlots[i]) ||
+			!gUniformRing->AllocateSlot(sizeof(boneUniformBufferData), &boneSlots[i]))
 		{
-			gLogManager->AddMessage("ERROR: Failed to create a draw command buffer!");
+			gLogManager->AddMessage("ERROR: Failed to allocate a uniform ring slot!");
 			return false;
 		}
-		drawCmdBuffers.push_back(drawCmdBuffer);
 	}
 
-	matFile.close();
 
-	// Read bone offsets
-	fread(&numBones, sizeof(unsigned int), 1, file);
-	boneOffsets.resize(numBones);
-	fread(boneOffsets.data(), sizeof(aiMatrix4x4), numBones, file);
+	// Read bone offsets, stored row major
+	if (!file.Read(&numBones, sizeof(unsigned int)) || numBones > MAX_BONES)
+		return false;
+
+	const float * boneOffsetData = (const float*)file.Read(sizeof(float) * 16 * numBones);
+	if (boneOffsetData == NULL)
+		return false;
 
-	// Read bone mappings
+	boneOffsets.resize(numBones);
 	for (unsigned int i = 0; i < numBones; i++)
-	{
-		unsigned int strSize;
-		char * str;
-		std::string boneName;
-		uint32_t id;
-
-		fread(&strSize, sizeof(unsigned int), 1, file);
-		str = new char[strSize+1];
-		fread(str, sizeof(char), strSize, file);
-		fread(&id, sizeof(uint32_t), 1, file);
-
-		str[strSize] = 0;
-		boneName = str;
-		boneMapping[boneName] = id;
-	}
+		boneOffsets[i] = glm::transpose(glm::make_mat4(boneOffsetData + i * 16));
 
-	fclose(file);
+	// Bone names that follow are only needed when baking animation clips
+
+	file.Unload();
 
 	return true;
 }
@@ -195,63 +205,99 @@ void SkinnedModel::Unload(VulkanInterface * vulkan)
 {
 	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
 
-	SAFE_UNLOAD(skinnedVS_bone_UBO, vulkanDevice);
-	SAFE_UNLOAD(skinnedVS_UBO, vulkanDevice);
+	for (unsigned int i = 0; i < meshDescriptorSets.size(); i++)
+	{
+		if (meshDescriptorSets[i].set != VK_NULL_HANDLE)
+			meshSetPipeline->FreeDescriptorSet(vulkanDevice, meshDescriptorSets[i].set);
+	}
+	meshDescriptorSets.clear();
+
+	SAFE_UNLOAD(drawCommandCache, vulkan);
+	for (int i = 0; i < DRAW_PASS_COUNT; i++)
+	{
+		gUniformRing->FreeSlot(vertexSlots[i]);
+		gUniformRing->FreeSlot(boneSlots[i]);
+		vertexSlots[i] = UNIFORM_RING_NO_SLOT;
+		boneSlots[i] = UNIFORM_RING_NO_SLOT;
+	}
 
 	for (unsigned int i = 0; i < textures.size(); i++)
 		gTextureManager->ReleaseTexture(textures[i], vulkanDevice);
 
 	for (unsigned int i = 0; i < meshes.size(); i++)
 	{
-		SAFE_UNLOAD(drawCmdBuffers[i], vulkanDevice, vulkan->GetVulkanCommandPool());
 		SAFE_DELETE(materials[i]);
 		SAFE_UNLOAD(meshes[i], vulkan);
 	}
 }
 
-void SkinnedModel::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer, VulkanPipeline * vulkanPipeline,
+void SkinnedModel::Render(VulkanInterface * vulkan, std::vector<VkCommandBuffer> & drawCommands, VulkanPipeline * vulkanPipeline,
 	Camera * camera, ShadowMaps * shadowMaps)
 {
-	if(vulkanPipeline->GetPipelineName() == "SKINNED")
+	int pass = (vulkanPipeline->GetPipelineName() == "SHADOWSKINNED" ? DRAW_PASS_SHADOW : DRAW_PASS_DEFERRED);
+
+	if (pass == DRAW_PASS_DEFERRED)
 		vertexUniformBuffer.MVP = camera->GetProjectionMatrix() * camera->GetViewMatrix() * vertexUniformBuffer.worldMatrix;
 
-	skinnedVS_UBO->Update(vulkan->GetVulkanDevice(), &vertexUniformBuffer, sizeof(vertexUniformBuffer));
+	// Both passes read their own copy of the vertex and bone data
+	DrawState state;
+	state.pipeline = vulkanPipeline;
+	state.lod = 0;
+	if (!gUniformRing->Write(vertexSlots[pass], &vertexUniformBuffer, sizeof(vertexUniformBuffer), &state.dynamicOffsets[0]) ||
+		!gUniformRing->Write(boneSlots[pass], &boneUniformBufferData, sizeof(boneUniformBufferData), &state.dynamicOffsets[1]))
+		return;
+
+	if (pass == DRAW_PASS_SHADOW)
+	{
+		state.dynamicOffsetCount = 3;
+		state.dynamicOffsets[2] = shadowMaps->GetUniformOffset();
+	}
+	else
+		state.dynamicOffsetCount = 2;
 
 	for (unsigned int i = 0; i < meshes.size(); i++)
 	{
-		if (vulkanPipeline->GetPipelineName() == "SKINNED")
+		// Shadow draws only read the uniform ring, the frame set of the pipeline is all they bind
+		state.descriptorSet = VK_NULL_HANDLE;
+		state.setVersion = 0;
+		if (pass == DRAW_PASS_DEFERRED)
 		{
-			meshes[i]->UpdateUniformBuffer(vulkan);
-			UpdateDescriptorSet(vulkan, vulkanPipeline, meshes[i], NULL);
+			state.descriptorSet = GetDescriptorSet(vulkan, vulkanPipeline, i, state.setVersion);
+			if (state.descriptorSet == VK_NULL_HANDLE)
+				continue;
 
-			// Record draw command
-			drawCmdBuffers[i]->BeginRecordingSecondary(vulkan->GetDeferredRenderpass()->GetRenderpass(), vulkan->GetDeferredFramebuffer());
-
-			vulkan->InitViewportAndScissors(drawCmdBuffers[i], (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
-				(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
-			vulkanPipeline->SetActive(drawCmdBuffers[i]);
-			meshes[i]->Render(vulkan, drawCmdBuffers[i]);
-
-			drawCmdBuffers[i]->EndRecording();
-			drawCmdBuffers[i]->ExecuteSecondary(commandBuffer);
+			meshes[i]->UpdateUniformBuffer(vulkan);
 		}
-		else if (vulkanPipeline->GetPipelineName() == "SHADOWSKINNED")
+
+		// Animation only changes the bone data, the recorded draws stay the same
+		bool record;
+		VulkanCommandBuffer * drawCmdBuffer = drawCommandCache->GetCommandBuffer(i, pass, state, record);
+		if (record)
 		{
-			UpdateDescriptorSet(vulkan, vulkanPipeline, meshes[i], shadowMaps);
+			if (pass == DRAW_PASS_DEFERRED)
+			{
+				drawCmdBuffer->BeginRecordingSecondary(vulkan->GetDeferredRenderpass()->GetRenderpass(), vulkan->GetDeferredFramebuffer());
 
-			// Record draw command
-			drawCmdBuffers[i]->BeginRecordingSecondary(shadowMaps->GetShadowRenderpass()->GetRenderpass(), shadowMaps->GetFramebuffer());
+				vulkan->InitViewportAndScissors(drawCmdBuffer, (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
+					(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
+			}
+			else
+			{
+				drawCmdBuffer->BeginRecordingSecondary(shadowMaps->GetShadowRenderpass()->GetRenderpass(), shadowMaps->GetFramebuffer());
 
-			vulkan->InitViewportAndScissors(drawCmdBuffers[i], (float)shadowMaps->GetMapSize(), (float)shadowMaps->GetMapSize(),
-				shadowMaps->GetMapSize(), shadowMaps->GetMapSize());
+				vulkan->InitViewportAndScissors(drawCmdBuffer, (float)shadowMaps->GetMapSize(), (float)shadowMaps->GetMapSize(),
+					shadowMaps->GetMapSize(), shadowMaps->GetMapSize());
 
-			shadowMaps->SetDepthBias(drawCmdBuffers[i]);
-			vulkanPipeline->SetActive(drawCmdBuffers[i]);
-			meshes[i]->Render(vulkan, drawCmdBuffers[i]);
+				shadowMaps->SetDepthBias(drawCmdBuffer);
+			}
 
-			drawCmdBuffers[i]->EndRecording();
-			drawCmdBuffers[i]->ExecuteSecondary(commandBuffer);
+			vulkanPipeline->SetActive(drawCmdBuffer, state.descriptorSet, state.dynamicOffsetCount, state.dynamicOffsets);
+			meshes[i]->Render(vulkan, drawCmdBuffer);
+
+			drawCmdBuffer->EndRecording();
 		}
+
+		drawCommands.push_back(drawCmdBuffer->GetCommandBuffer());
 	}
 }
 
@@ -259,12 +305,10 @@ void SkinnedModel::UpdateAnimation(VulkanInterface * vulkan)
 {
 	if (currentAnim != NULL)
 	{
-		currentAnim->Update(gTimer->GetDelta(), boneOffsets, boneMapping);
+		currentAnim->Update(gTimer->GetDelta(), boneOffsets);
 	
 		std::vector<glm::mat4> boneTransforms = currentAnim->GetBoneTransforms();
 		memcpy(boneUniformBufferData.bones, boneTransforms.data(), sizeof(glm::mat4) * boneTransforms.size());
-
-		skinnedVS_bone_UBO->Update(vulkan->GetVulkanDevice(), &boneUniformBufferData, sizeof(boneUniformBufferData));
 	}
 }
 
@@ -278,130 +322,116 @@ void SkinnedModel::SetAnimation(Animation * anim)
 	currentAnim = anim;
 }
 
-void SkinnedModel::UpdateDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, SkinnedMesh * mesh, ShadowMaps * shadowMaps)
+bool SkinnedModel::HasPackedVertices()
 {
-	if (pipeline->GetPipelineName() == "SKINNED")
+	return (meshFlags & RCM_FLAG_PACKED_VERTICES) != 0;
+}
+
+VkDescriptorSet SkinnedModel::GetDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, unsigned int meshId, uint32_t & setVersion)
+{
+	setVersion = 0;
+
+	if (meshDescriptorSets.empty())
+	{
+		MeshDescriptorSet emptySet = { VK_NULL_HANDLE, { 0, 0, 0 }, 0 };
+		meshDescriptorSets.resize(meshes.size(), emptySet);
+	}
+
+	MeshDescriptorSet & meshSet = meshDescriptorSets[meshId];
+	Material * material = meshes[meshId]->GetMaterial();
+	uint32_t imageVersions[3] = { material->GetDiffuseTexture()->GetImageVersion(), material->GetMaterialTexture()->GetImageVersion(),
+		material->HasNormalMap() ? material->GetNormalTexture()->GetImageVersion() : 0 };
+
+	if (meshSet.set == VK_NULL_HANDLE)
 	{
-		VkWriteDescriptorSet descriptorWrite[6];
-
-		descriptorWrite[0] = {};
-		descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[0].pNext = NULL;
-		descriptorWrite[0].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[0].descriptorCount = 1;
-		descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[0].pBufferInfo = skinnedVS_UBO->GetBufferInfo();
-		descriptorWrite[0].dstArrayElement = 0;
-		descriptorWrite[0].dstBinding = 0;
-
-		descriptorWrite[1] = {};
-		descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[1].pNext = NULL;
-		descriptorWrite[1].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[1].descriptorCount = 1;
-		descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[1].pBufferInfo = skinnedVS_bone_UBO->GetBufferInfo();
-		descriptorWrite[1].dstArrayElement = 0;
-		descriptorWrite[1].dstBinding = 1;
-
-		// Write mesh diffuse texture
-		VkDescriptorImageInfo diffuseTextureDesc{};
-		diffuseTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-		diffuseTextureDesc.imageView = *mesh->GetMaterial()->GetDiffuseTexture()->GetImageView();
-		diffuseTextureDesc.sampler = vulkan->GetColorSampler();
-
-		descriptorWrite[2] = {};
-		descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[2].pNext = NULL;
-		descriptorWrite[2].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[2].descriptorCount = 1;
-		descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite[2].pImageInfo = &diffuseTextureDesc;
-		descriptorWrite[2].dstArrayElement = 0;
-		descriptorWrite[2].dstBinding = 2;
-
-		// Write mesh material texture
-		VkDescriptorImageInfo materialTextureDesc{};
-		materialTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-		materialTextureDesc.imageView = *mesh->GetMaterial()->GetMaterialTexture()->GetImageView();
-		materialTextureDesc.sampler = vulkan->GetColorSampler();
-
-		descriptorWrite[3] = {};
-		descriptorWrite[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[3].pNext = NULL;
-		descriptorWrite[3].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[3].descriptorCount = 1;
-		descriptorWrite[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite[3].pImageInfo = &materialTextureDesc;
-		descriptorWrite[3].dstArrayElement = 0;
-		descriptorWrite[3].dstBinding = 3;
-
-		// Write mesh normal texture if available
-		VkDescriptorImageInfo normalTextureDesc{};
-		if (mesh->GetMaterial()->HasNormalMap())
+		if (!pipeline->AllocateDescriptorSet(vulkan->GetVulkanDevice(), &meshSet.set))
 		{
-			normalTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-			normalTextureDesc.imageView = *mesh->GetMaterial()->GetNormalTexture()->GetImageView();
-			normalTextureDesc.sampler = vulkan->GetColorSampler();
+			gLogManager->AddMessage("ERROR: Failed to allocate a mesh descriptor set!");
+			meshSet.set = VK_NULL_HANDLE;
+			return VK_NULL_HANDLE;
 		}
-
-		descriptorWrite[4] = {};
-		descriptorWrite[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[4].pNext = NULL;
-		descriptorWrite[4].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[4].descriptorCount = 1;
-		descriptorWrite[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorWrite[4].pImageInfo = (mesh->GetMaterial()->HasNormalMap() ? &normalTextureDesc : &diffuseTextureDesc);
-		descriptorWrite[4].dstArrayElement = 0;
-		descriptorWrite[4].dstBinding = 4;
-
-		// Update material uniform buffer
-		descriptorWrite[5] = {};
-		descriptorWrite[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[5].pNext = NULL;
-		descriptorWrite[5].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[5].descriptorCount = 1;
-		descriptorWrite[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[5].pBufferInfo = mesh->GetMaterialBufferInfo();
-		descriptorWrite[5].dstArrayElement = 0;
-		descriptorWrite[5].dstBinding = 5;
-
-		vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
+		meshSetPipeline = pipeline;
 	}
-	else if (pipeline->GetPipelineName() == "SHADOWSKINNED")
+	else if (memcmp(meshSet.imageVersions, imageVersions, sizeof(imageVersions)) == 0)
 	{
-		VkWriteDescriptorSet descriptorWrite[3];
-
-		descriptorWrite[0] = {};
-		descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[0].pNext = NULL;
-		descriptorWrite[0].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[0].descriptorCount = 1;
-		descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[0].pBufferInfo = skinnedVS_UBO->GetBufferInfo();
-		descriptorWrite[0].dstArrayElement = 0;
-		descriptorWrite[0].dstBinding = 0;
-
-		descriptorWrite[1] = {};
-		descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[1].pNext = NULL;
-		descriptorWrite[1].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[1].descriptorCount = 1;
-		descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[1].pBufferInfo = skinnedVS_bone_UBO->GetBufferInfo();
-		descriptorWrite[1].dstArrayElement = 0;
-		descriptorWrite[1].dstBinding = 1;
-
-		descriptorWrite[2] = {};
-		descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorWrite[2].pNext = NULL;
-		descriptorWrite[2].dstSet = pipeline->GetDescriptorSet();
-		descriptorWrite[2].descriptorCount = 1;
-		descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorWrite[2].pBufferInfo = shadowMaps->GetBufferInfo();
-		descriptorWrite[2].dstArrayElement = 0;
-		descriptorWrite[2].dstBinding = 2;
-
-		vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
+		setVersion = meshSet.version;
+		return meshSet.set;
 	}
+
+	UpdateDescriptorSet(vulkan, meshSet.set, meshes[meshId]);
+	memcpy(meshSet.imageVersions, imageVersions, sizeof(imageVersions));
+	meshSet.version++;
+	setVersion = meshSet.version;
+
+	return meshSet.set;
+}
+
+void SkinnedModel::UpdateDescriptorSet(VulkanInterface * vulkan, VkDescriptorSet set, SkinnedMesh * mesh)
+{
+	// The vertex and bone data is read through the frame set of the pipeline
+	VkWriteDescriptorSet descriptorWrite[4];
+
+	// Write mesh diffuse texture
+	VkDescriptorImageInfo diffuseTextureDesc{};
+	diffuseTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	diffuseTextureDesc.imageView = *mesh->GetMaterial()->GetDiffuseTexture()->GetImageView();
+	diffuseTextureDesc.sampler = vulkan->GetColorSampler();
+
+	descriptorWrite[0] = {};
+	descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[0].pNext = NULL;
+	descriptorWrite[0].dstSet = set;
+	descriptorWrite[0].descriptorCount = 1;
+	descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite[0].pImageInfo = &diffuseTextureDesc;
+	descriptorWrite[0].dstArrayElement = 0;
+	descriptorWrite[0].dstBinding = 2;
+
+	// Write mesh material texture
+	VkDescriptorImageInfo materialTextureDesc{};
+	materialTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	materialTextureDesc.imageView = *mesh->GetMaterial()->GetMaterialTexture()->GetImageView();
+	materialTextureDesc.sampler = vulkan->GetColorSampler();
+
+	descriptorWrite[1] = {};
+	descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[1].pNext = NULL;
+	descriptorWrite[1].dstSet = set;
+	descriptorWrite[1].descriptorCount = 1;
+	descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite[1].pImageInfo = &materialTextureDesc;
+	descriptorWrite[1].dstArrayElement = 0;
+	descriptorWrite[1].dstBinding = 3;
+
+	// Write mesh normal texture if available
+	VkDescriptorImageInfo normalTextureDesc{};
+	if (mesh->GetMaterial()->HasNormalMap())
+	{
+		normalTextureDesc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		normalTextureDesc.imageView = *mesh->GetMaterial()->GetNormalTexture()->GetImageView();
+		normalTextureDesc.sampler = vulkan->GetColorSampler();
+	}
+
+	descriptorWrite[2] = {};
+	descriptorWrite[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[2].pNext = NULL;
+	descriptorWrite[2].dstSet = set;
+	descriptorWrite[2].descriptorCount = 1;
+	descriptorWrite[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite[2].pImageInfo = (mesh->GetMaterial()->HasNormalMap() ? &normalTextureDesc : &diffuseTextureDesc);
+	descriptorWrite[2].dstArrayElement = 0;
+	descriptorWrite[2].dstBinding = 4;
+
+	// Update material uniform buffer
+	descriptorWrite[3] = {};
+	descriptorWrite[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite[3].pNext = NULL;
+	descriptorWrite[3].dstSet = set;
+	descriptorWrite[3].descriptorCount = 1;
+	descriptorWrite[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptorWrite[3].pBufferInfo = mesh->GetMaterialBufferInfo();
+	descriptorWrite[3].dstArrayElement = 0;
+	descriptorWrite[3].dstBinding = 5;
+
+	vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
 }
\ No newline at end of file
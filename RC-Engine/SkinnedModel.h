@@ -9,22 +9,24 @@
 #include "SkinnedMesh.h"
 #include "Camera.h"
 #include "Texture.h"
+#include "ResourceRegistry.h"
 #include "Material.h"
 #include "Animation.h"
 #include "ShadowMaps.h"
+#include "DrawCommandCache.h"
 
 class SkinnedModel
 {
 	private:
 		std::vector<SkinnedMesh*> meshes;
-		std::vector<Texture*> textures;
+		std::vector<ResourceHandle> textures;
 		std::vector<Material*> materials;
-		std::vector<VulkanCommandBuffer*> drawCmdBuffers;
+		DrawCommandCache * drawCommandCache;
+		uint32_t meshFlags;
 		
 		Animation * currentAnim;
 		unsigned int numBones;
-		std::vector <aiMatrix4x4> boneOffsets;
-		std::map <std::string, uint32_t> boneMapping;
+		std::vector <glm::mat4> boneOffsets;
 
 		struct VertexUniformBuffer
 		{
@@ -38,20 +40,33 @@ class SkinnedModel
 			glm::mat4 bones[MAX_BONES];
 		};
 		BoneUniformBuffer boneUniformBufferData;
+		// Uniform ring slots of this model, each pass writes its own copy of the data
+		uint32_t vertexSlots[DRAW_PASS_COUNT];
+		uint32_t boneSlots[DRAW_PASS_COUNT];
 
-		VulkanBuffer * skinnedVS_UBO;
-		VulkanBuffer * skinnedVS_bone_UBO;
+		// A mesh set only holds the textures and the material buffer, it's written again when one of the textures gets
+		// a new image and the version tells recorded draws that the set has changed. Shadow draws have no set.
+		struct MeshDescriptorSet
+		{
+			VkDescriptorSet set;
+			uint32_t imageVersions[3];
+			uint32_t version;
+		};
+		std::vector<MeshDescriptorSet> meshDescriptorSets;
+		VulkanPipeline * meshSetPipeline;
 	private:
-		void UpdateDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, SkinnedMesh * mesh, ShadowMaps * shadowMaps);
+		VkDescriptorSet GetDescriptorSet(VulkanInterface * vulkan, VulkanPipeline * pipeline, unsigned int meshId, uint32_t & setVersion);
+		void UpdateDescriptorSet(VulkanInterface * vulkan, VkDescriptorSet set, SkinnedMesh * mesh);
 	public:
 		SkinnedModel();
 		~SkinnedModel();
 
-		bool Init(std::string filename, VulkanInterface * vulkan, VulkanCommandBuffer * cmdBuffer);
+		bool Init(std::string filename, VulkanInterface * vulkan);
 		void Unload(VulkanInterface * vulkan);
-		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer, VulkanPipeline * vulkanPipeline,
+		void Render(VulkanInterface * vulkan, std::vector<VkCommandBuffer> & drawCommands, VulkanPipeline * vulkanPipeline,
 			Camera * camera, ShadowMaps * shadowMaps);
 		void UpdateAnimation(VulkanInterface * vulkan);
 		void SetWorldMatrix(glm::mat4 &worldMatrix);
 		void SetAnimation(Animation * anim);
+		bool HasPackedVertices();
 };
\ No newline at end of file
@@ -8,21 +8,21 @@
 #include "Skydome.h"
 #include "StdInc.h"
 #include "Settings.h"
+#include "StagingManager.h"
+#include "UniformRing.h"
 
 extern Settings * gSettings;
+extern StagingManager * gStagingManager;
+extern UniformRing * gUniformRing;
 
 Skydome::Skydome()
 {
 	vertexBuffer = NULL;
 	indexBuffer = NULL;
-	vsUBO = NULL;
-	fsUBO = NULL;
 }
 
 Skydome::~Skydome()
 {
-	fsUBO = NULL;
-	vsUBO = NULL;
 	indexBuffer = NULL;
 	vertexBuffer = NULL;
 }
@@ -30,7 +30,6 @@ Skydome::~Skydome()
 bool Skydome::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline)
 {
 	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
-	VulkanCommandPool * cmdPool = vulkan->GetVulkanCommandPool();
 
 	Vertex * vertexData;
 	uint32_t * indexData;
@@ -111,30 +110,18 @@ bool Skydome::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline)
 	memcpy(vertexData, vertices.data(), sizeof(Vertex) * vertexCount);
 	memcpy(indexData, indices.data(), sizeof(uint32_t) * indexCount);
 
-	// Command buffer used for creating buffers
-	VulkanCommandBuffer * cmdBuffer = new VulkanCommandBuffer();
-	if (!cmdBuffer->Init(vulkanDevice, cmdPool, true))
-		return false;
-
-	cmdBuffer->BeginRecording();
-
 	// Vertex buffer
 	vertexBuffer = new VulkanBuffer();
 	if (!vertexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexData,
-		sizeof(Vertex) * vertexCount, true, cmdBuffer))
+		sizeof(Vertex) * vertexCount, true, gStagingManager))
 		return false;
 
 	// Index buffer
 	indexBuffer = new VulkanBuffer();
 	if (!indexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexData,
-		sizeof(uint32_t) * indexCount, true, cmdBuffer))
+		sizeof(uint32_t) * indexCount, true, gStagingManager))
 		return false;
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(vulkanDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, true);
-
-	SAFE_UNLOAD(cmdBuffer, vulkanDevice, cmdPool);
-
 	delete[] vertexData;
 	delete[] indexData;
 
@@ -146,43 +133,6 @@ bool Skydome::Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline)
 	fragmentUniformBuffer.atmosphereHeight = 0.0f;
 	fragmentUniformBuffer.padding = glm::vec3(0.0f, 0.0f, 0.0f);
 
-	// Vertex shader Uniform buffer
-	vsUBO = new VulkanBuffer();
-	if (!vsUBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &vertexUniformBuffer,
-		sizeof(vertexUniformBuffer), false))
-		return false;
-
-	// Fragment shader uniform buffer
-	fsUBO = new VulkanBuffer();
-	if (!fsUBO->Init(vulkanDevice, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, &fragmentUniformBuffer,
-		sizeof(fragmentUniformBuffer), false))
-		return false;
-
-	// Write descriptor set
-	VkWriteDescriptorSet descriptorWrite[2];
-
-	descriptorWrite[0] = {};
-	descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrite[0].pNext = NULL;
-	descriptorWrite[0].dstSet = vulkanPipeline->GetDescriptorSet();
-	descriptorWrite[0].descriptorCount = 1;
-	descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	descriptorWrite[0].pBufferInfo = vsUBO->GetBufferInfo();
-	descriptorWrite[0].dstArrayElement = 0;
-	descriptorWrite[0].dstBinding = 0;
-
-	descriptorWrite[1] = {};
-	descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrite[1].pNext = NULL;
-	descriptorWrite[1].dstSet = vulkanPipeline->GetDescriptorSet();
-	descriptorWrite[1].descriptorCount = 1;
-	descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	descriptorWrite[1].pBufferInfo = fsUBO->GetBufferInfo();
-	descriptorWrite[1].dstArrayElement = 0;
-	descriptorWrite[1].dstBinding = 1;
-
-	vkUpdateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), sizeof(descriptorWrite) / sizeof(descriptorWrite[0]), descriptorWrite, 0, NULL);
-
 	worldMatrix = glm::mat4(1.0f);
 
 	// Init draw command buffers
@@ -203,8 +153,6 @@ void Skydome::Unload(VulkanInterface * vulkan)
 	for (size_t i = 0; i < vulkan->GetVulkanSwapchain()->GetSwapchainBufferCount(); i++)
 		SAFE_UNLOAD(drawCmdBuffers[i], vulkan->GetVulkanDevice(), vulkan->GetVulkanCommandPool());
 
-	SAFE_UNLOAD(fsUBO, vulkan->GetVulkanDevice());
-	SAFE_UNLOAD(vsUBO, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(indexBuffer, vulkan->GetVulkanDevice());
 	SAFE_UNLOAD(vertexBuffer, vulkan->GetVulkanDevice());
 }
@@ -217,21 +165,23 @@ void Skydome::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuff
 	worldMatrix = glm::translate(glm::mat4(1.0f), camPos);
 	vertexUniformBuffer.MVP = camera->GetProjectionMatrix() * camera->GetViewMatrix() * worldMatrix;
 
-	vsUBO->Update(vulkan->GetVulkanDevice(), &vertexUniformBuffer, sizeof(vertexUniformBuffer));
-
 	// Update fragment uniform buffer
 	fragmentUniformBuffer.skyColor = skyColor;
 	fragmentUniformBuffer.atmosphereColor = atmosphereColor;
 	fragmentUniformBuffer.groundColor = groundColor;
 	fragmentUniformBuffer.atmosphereHeight = atmosphereHeight;
 
-	fsUBO->Update(vulkan->GetVulkanDevice(), &fragmentUniformBuffer, sizeof(fragmentUniformBuffer));
+	// Both buffers are read through the frame set of the pipeline
+	uint32_t dynamicOffsets[2];
+	if (!gUniformRing->Allocate(&vertexUniformBuffer, sizeof(vertexUniformBuffer), &dynamicOffsets[0]) ||
+		!gUniformRing->Allocate(&fragmentUniformBuffer, sizeof(fragmentUniformBuffer), &dynamicOffsets[1]))
+		return;
 
 	// Render
 	drawCmdBuffers[framebufferId]->BeginRecordingSecondary(vulkan->GetForwardRenderpass()->GetRenderpass(), vulkan->GetVulkanSwapchain()->GetFramebuffer(framebufferId));
 	vulkan->InitViewportAndScissors(drawCmdBuffers[framebufferId], (float)gSettings->GetWindowWidth(), (float)gSettings->GetWindowHeight(),
 		(uint32_t)gSettings->GetWindowWidth(), (uint32_t)gSettings->GetWindowHeight());
-	pipeline->SetActive(drawCmdBuffers[framebufferId]);
+	pipeline->SetActive(drawCmdBuffers[framebufferId], 2, dynamicOffsets);
 
 	VkDeviceSize offsets[1] = { 0 };
 	vkCmdBindVertexBuffers(drawCmdBuffers[framebufferId]->GetCommandBuffer(), 0, 1, vertexBuffer->GetBuffer(), offsets);
@@ -243,6 +193,11 @@ void Skydome::Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuff
 	drawCmdBuffers[framebufferId]->ExecuteSecondary(commandBuffer);
 }
 
+VkDeviceSize Skydome::GetFrameUniformSize()
+{
+	return gUniformRing->GetAllocationSize(sizeof(vertexUniformBuffer)) + gUniformRing->GetAllocationSize(sizeof(fragmentUniformBuffer));
+}
+
 void Skydome::SetSkyColor(float r, float g, float b, float a)
 {
 	skyColor = glm::vec4(r, g, b, a);
@@ -37,7 +37,6 @@ class Skydome
 			glm::mat4 MVP;
 		};
 		VertexUniformBuffer vertexUniformBuffer;
-		VulkanBuffer * vsUBO;
 
 		// Fragment shader uniform buffer
 		struct FragmentUniformBuffer
@@ -49,7 +48,6 @@ class Skydome
 			glm::vec3 padding;
 		};
 		FragmentUniformBuffer fragmentUniformBuffer;
-		VulkanBuffer * fsUBO;
 
 		std::vector<VulkanCommandBuffer*> drawCmdBuffers;
 	public:
@@ -59,6 +57,7 @@ class Skydome
 		bool Init(VulkanInterface * vulkan, VulkanPipeline * vulkanPipeline);
 		void Unload(VulkanInterface * vulkan);
 		void Render(VulkanInterface * vulkan, VulkanCommandBuffer * commandBuffer, VulkanPipeline * pipeline, Camera * camera, int framebufferId);
+		VkDeviceSize GetFrameUniformSize();
 		void SetSkyColor(float r, float g, float b, float a);
 		void SetAtmosphereColor(float r, float g, float b, float a);
 		void SetGroundColor(float r, float g, float b, float a);
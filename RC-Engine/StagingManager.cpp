@@ -0,0 +1,181 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: StagingManager.cpp                                   |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "StagingManager.h"
+#include "LogManager.h"
+#include "StdInc.h"
+
+extern LogManager * gLogManager;
+
+StagingManager::StagingManager()
+{
+	stagingBuffer = VK_NULL_HANDLE;
+	stagingMemory = VK_NULL_HANDLE;
+	mappedData = NULL;
+	cmdBuffer = NULL;
+	capacity = 0;
+	usedSize = 0;
+	recording = false;
+}
+
+StagingManager::~StagingManager()
+{
+	cmdBuffer = NULL;
+	mappedData = NULL;
+	stagingMemory = VK_NULL_HANDLE;
+	stagingBuffer = VK_NULL_HANDLE;
+}
+
+bool StagingManager::Init(VulkanDevice * vulkanDevice, VulkanCommandPool * cmdPool)
+{
+	cmdBuffer = new VulkanCommandBuffer();
+	if (!cmdBuffer->Init(vulkanDevice, cmdPool, true))
+	{
+		gLogManager->AddMessage("ERROR: Failed to create a command buffer! (stagingCommandBuffer)");
+		return false;
+	}
+
+	if (!CreateStagingBuffer(vulkanDevice, STAGING_BUFFER_SIZE))
+	{
+		gLogManager->AddMessage("ERROR: Failed to create staging buffer!");
+		return false;
+	}
+
+	return true;
+}
+
+void StagingManager::Unload(VulkanDevice * vulkanDevice, VulkanCommandPool * cmdPool)
+{
+	Flush(vulkanDevice);
+	DestroyStagingBuffer(vulkanDevice);
+	SAFE_UNLOAD(cmdBuffer, vulkanDevice, cmdPool);
+}
+
+bool StagingManager::CreateStagingBuffer(VulkanDevice * vulkanDevice, VkDeviceSize size)
+{
+	VkResult result;
+
+	VkBufferCreateInfo bufferCI{};
+	bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCI.size = size;
+	bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	result = vkCreateBuffer(vulkanDevice->GetDevice(), &bufferCI, VK_NULL_HANDLE, &stagingBuffer);
+	if (result != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements memReq;
+	vkGetBufferMemoryRequirements(vulkanDevice->GetDevice(), stagingBuffer, &memReq);
+
+	// Coherent memory, so the persistent mapping never has to be flushed
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memReq.size;
+	if (!vulkanDevice->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&allocInfo.memoryTypeIndex))
+		return false;
+
+	result = vkAllocateMemory(vulkanDevice->GetDevice(), &allocInfo, VK_NULL_HANDLE, &stagingMemory);
+	if (result != VK_SUCCESS)
+		return false;
+
+	result = vkBindBufferMemory(vulkanDevice->GetDevice(), stagingBuffer, stagingMemory, 0);
+	if (result != VK_SUCCESS)
+		return false;
+
+	result = vkMapMemory(vulkanDevice->GetDevice(), stagingMemory, 0, VK_WHOLE_SIZE, 0, (void**)&mappedData);
+	if (result != VK_SUCCESS)
+		return false;
+
+	capacity = size;
+	usedSize = 0;
+
+	return true;
+}
+
+void StagingManager::DestroyStagingBuffer(VulkanDevice * vulkanDevice)
+{
+	if (mappedData != NULL)
+		vkUnmapMemory(vulkanDevice->GetDevice(), stagingMemory);
+	vkFreeMemory(vulkanDevice->GetDevice(), stagingMemory, VK_NULL_HANDLE);
+	vkDestroyBuffer(vulkanDevice->GetDevice(), stagingBuffer, VK_NULL_HANDLE);
+
+	mappedData = NULL;
+	stagingMemory = VK_NULL_HANDLE;
+	stagingBuffer = VK_NULL_HANDLE;
+	capacity = 0;
+	usedSize = 0;
+}
+
+unsigned char * StagingManager::Allocate(VulkanDevice * vulkanDevice, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize * offset)
+{
+	VkDeviceSize alignedOffset = (usedSize + alignment - 1) & ~(alignment - 1);
+
+	// Not enough space left, submit everything recorded so far and start from the beginning
+	if (alignedOffset + size > capacity)
+	{
+		Flush(vulkanDevice);
+		alignedOffset = 0;
+
+		// A single upload bigger than the whole buffer, grow it
+		if (size > capacity)
+		{
+			VkDeviceSize newCapacity = capacity * 2;
+			while (newCapacity < size)
+				newCapacity *= 2;
+
+			DestroyStagingBuffer(vulkanDevice);
+			if (!CreateStagingBuffer(vulkanDevice, newCapacity))
+			{
+				gLogManager->AddMessage("ERROR: Failed to grow staging buffer!");
+				return NULL;
+			}
+		}
+	}
+
+	usedSize = alignedOffset + size;
+	*offset = alignedOffset;
+
+	return mappedData + alignedOffset;
+}
+
+VulkanCommandBuffer * StagingManager::GetCommandBuffer()
+{
+	if (!recording)
+	{
+		cmdBuffer->BeginRecording();
+		recording = true;
+	}
+
+	return cmdBuffer;
+}
+
+void StagingManager::Flush(VulkanDevice * vulkanDevice)
+{
+	if (recording)
+	{
+		// Make the copies visible to everything that reads the uploaded resources afterwards
+		VkMemoryBarrier memoryBarrier{};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		vkCmdPipelineBarrier(cmdBuffer->GetCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 1, &memoryBarrier, 0, NULL, 0, NULL);
+
+		cmdBuffer->EndRecording();
+		cmdBuffer->Execute(vulkanDevice, NULL, NULL, NULL, true);
+		recording = false;
+	}
+
+	usedSize = 0;
+}
+
+VkBuffer StagingManager::GetBuffer()
+{
+	return stagingBuffer;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: StagingManager.h                                     |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include "VulkanCommandBuffer.h"
+
+#define STAGING_BUFFER_SIZE (32 * 1024 * 1024)
+
+class StagingManager
+{
+	private:
+		VkBuffer stagingBuffer;
+		VkDeviceMemory stagingMemory;
+		unsigned char * mappedData;
+		VkDeviceSize capacity;
+		VkDeviceSize usedSize;
+
+		VulkanCommandBuffer * cmdBuffer;
+		bool recording;
+	private:
+		bool CreateStagingBuffer(VulkanDevice * vulkanDevice, VkDeviceSize size);
+		void DestroyStagingBuffer(VulkanDevice * vulkanDevice);
+	public:
+		StagingManager();
+		~StagingManager();
+
+		bool Init(VulkanDevice * vulkanDevice, VulkanCommandPool * cmdPool);
+		void Unload(VulkanDevice * vulkanDevice, VulkanCommandPool * cmdPool);
+		unsigned char * Allocate(VulkanDevice * vulkanDevice, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize * offset);
+		VulkanCommandBuffer * GetCommandBuffer();
+		void Flush(VulkanDevice * vulkanDevice);
+		VkBuffer GetBuffer();
+};
\ No newline at end of file
@@ -0,0 +1,214 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TaskGraph.cpp                                        |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "TaskGraph.h"
+#include "GameplayTimer.h"
+
+TaskGraph::TaskGraph()
+{
+	running = false;
+	failed = false;
+	finishedCount = 0;
+	totalWeight = 0.0f;
+	finishedWeight = 0.0f;
+}
+
+TaskGraph::~TaskGraph()
+{
+	running = false;
+}
+
+void TaskGraph::Start(unsigned int workerCount)
+{
+	running = true;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&TaskGraph::WorkerThread, this));
+}
+
+void TaskGraph::Unload()
+{
+	{
+		std::lock_guard<std::mutex> lock(graphMutex);
+		running = false;
+	}
+	graphCondition.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+	workers.clear();
+}
+
+TaskId TaskGraph::AddTask(TASK_THREAD thread, const std::vector<TaskId> & dependencies, std::function<TASK_RESULT()> func,
+	float weight)
+{
+	TaskId id = ReserveTask(weight);
+	SetTask(id, thread, dependencies, func);
+
+	return id;
+}
+
+TaskId TaskGraph::ReserveTask(float weight)
+{
+	std::lock_guard<std::mutex> lock(graphMutex);
+
+	TaskId id = (TaskId)tasks.size();
+	tasks.push_back(Task());
+
+	// The reservation itself counts as a dependency until SetTask
+	Task & task = tasks.back();
+	task.thread = TASK_THREAD_MAIN;
+	task.pendingDependencies = 1;
+	task.weight = weight;
+	task.finished = false;
+	totalWeight += weight;
+
+	return id;
+}
+
+void TaskGraph::SetTask(TaskId id, TASK_THREAD thread, const std::vector<TaskId> & dependencies, std::function<TASK_RESULT()> func)
+{
+	std::unique_lock<std::mutex> lock(graphMutex);
+
+	Task & task = tasks[id];
+	task.func = func;
+	task.thread = thread;
+
+	for (size_t i = 0; i < dependencies.size(); i++)
+	{
+		if (!tasks[dependencies[i]].finished)
+		{
+			tasks[dependencies[i]].dependents.push_back(id);
+			task.pendingDependencies++;
+		}
+	}
+
+	if (--task.pendingDependencies > 0)
+		return;
+
+	if (thread == TASK_THREAD_WORKER)
+	{
+		readyWorkerTasks.push_back(id);
+		lock.unlock();
+		graphCondition.notify_one();
+	}
+	else
+		readyMainTasks.push_back(id);
+}
+
+void TaskGraph::WorkerThread()
+{
+	for (;;)
+	{
+		TaskId id;
+		std::function<TASK_RESULT()> func;
+		{
+			std::unique_lock<std::mutex> lock(graphMutex);
+			graphCondition.wait(lock, [this]() { return !running || !readyWorkerTasks.empty(); });
+			if (!running)
+				return;
+
+			id = readyWorkerTasks.front();
+			readyWorkerTasks.pop_front();
+			func = tasks[id].func;
+		}
+
+		// Worker tasks run once, there is no next frame to continue them in
+		TASK_RESULT result = func();
+		FinishTask(id, result == TASK_RESULT_FAILED ? TASK_RESULT_FAILED : TASK_RESULT_DONE);
+	}
+}
+
+void TaskGraph::FinishTask(TaskId id, TASK_RESULT result)
+{
+	bool workersReady = false;
+	{
+		std::lock_guard<std::mutex> lock(graphMutex);
+
+		Task & task = tasks[id];
+		task.finished = true;
+		task.func = nullptr;
+		finishedCount++;
+		finishedWeight += task.weight;
+
+		// Tasks depending on a failed one never run, the graph can only be unloaded after that
+		if (result == TASK_RESULT_FAILED)
+		{
+			failed = true;
+			return;
+		}
+
+		for (size_t i = 0; i < task.dependents.size(); i++)
+		{
+			Task & dependent = tasks[task.dependents[i]];
+			if (--dependent.pendingDependencies > 0)
+				continue;
+
+			if (dependent.thread == TASK_THREAD_WORKER)
+			{
+				readyWorkerTasks.push_back(task.dependents[i]);
+				workersReady = true;
+			}
+			else
+				readyMainTasks.push_back(task.dependents[i]);
+		}
+	}
+
+	if (workersReady)
+		graphCondition.notify_all();
+}
+
+bool TaskGraph::RunMainTasks(float timeBudget)
+{
+	GameplayTimer budgetTimer;
+	budgetTimer.StartTimer();
+
+	do
+	{
+		TaskId id;
+		std::function<TASK_RESULT()> func;
+		{
+			std::lock_guard<std::mutex> lock(graphMutex);
+			if (failed)
+				return false;
+			if (readyMainTasks.empty())
+				return true;
+
+			id = readyMainTasks.front();
+			func = tasks[id].func;
+		}
+
+		TASK_RESULT result = func();
+		if (result == TASK_RESULT_CONTINUE)
+			continue;
+
+		{
+			std::lock_guard<std::mutex> lock(graphMutex);
+			readyMainTasks.pop_front();
+		}
+		FinishTask(id, result);
+	} while (!budgetTimer.TimePassed(timeBudget));
+
+	return !HasFailed();
+}
+
+bool TaskGraph::IsFinished()
+{
+	std::lock_guard<std::mutex> lock(graphMutex);
+	return finishedCount == tasks.size();
+}
+
+bool TaskGraph::HasFailed()
+{
+	std::lock_guard<std::mutex> lock(graphMutex);
+	return failed;
+}
+
+float TaskGraph::GetProgress()
+{
+	std::lock_guard<std::mutex> lock(graphMutex);
+	return totalWeight > 0.0f ? finishedWeight / totalWeight : 1.0f;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TaskGraph.h                                          |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+enum TASK_THREAD
+{
+	TASK_THREAD_WORKER,
+	TASK_THREAD_MAIN
+};
+
+enum TASK_RESULT
+{
+	TASK_RESULT_DONE,
+	// Main thread tasks return this to be called again, so long work is spread over several frames
+	TASK_RESULT_CONTINUE,
+	TASK_RESULT_FAILED
+};
+
+typedef unsigned int TaskId;
+
+// Tasks that run once all tasks they depend on are done. Worker tasks run on background threads and must not
+// touch Vulkan, main thread tasks run from RunMainTasks for as long as the frame budget allows. Tasks can be added
+// from any thread, a reserved task can be depended on before it's known what it will do.
+class TaskGraph
+{
+	private:
+		struct Task
+		{
+			std::function<TASK_RESULT()> func;
+			TASK_THREAD thread;
+			std::vector<TaskId> dependents;
+			unsigned int pendingDependencies;
+			float weight;
+			bool finished;
+		};
+		std::deque<Task> tasks;
+		std::deque<TaskId> readyWorkerTasks;
+		std::deque<TaskId> readyMainTasks;
+
+		std::vector<std::thread> workers;
+		std::mutex graphMutex;
+		std::condition_variable graphCondition;
+		bool running;
+		bool failed;
+		unsigned int finishedCount;
+		float totalWeight;
+		float finishedWeight;
+	private:
+		void WorkerThread();
+		void FinishTask(TaskId id, TASK_RESULT result);
+	public:
+		TaskGraph();
+		~TaskGraph();
+
+		void Start(unsigned int workerCount);
+		void Unload();
+		TaskId AddTask(TASK_THREAD thread, const std::vector<TaskId> & dependencies, std::function<TASK_RESULT()> func,
+			float weight = 1.0f);
+		TaskId ReserveTask(float weight = 1.0f);
+		void SetTask(TaskId id, TASK_THREAD thread, const std::vector<TaskId> & dependencies, std::function<TASK_RESULT()> func);
+		bool RunMainTasks(float timeBudget);
+		bool IsFinished();
+		bool HasFailed();
+		float GetProgress();
+};
\ No newline at end of file
@@ -6,10 +6,13 @@
 ==========================================================================================*/
 
 #include <vector>
+#include <algorithm>
 
 #include "Texture.h"
 #include "LogManager.h"
 #include "VulkanTools.h"
+#include "MappedFile.h"
+#include "TextureTranscoder.h"
 
 extern LogManager * gLogManager;
 
@@ -18,6 +21,15 @@ Texture::Texture()
 	textureImage = VK_NULL_HANDLE;
 	textureMemory = VK_NULL_HANDLE;
 	textureImageView = VK_NULL_HANDLE;
+	memorySize = 0;
+	imageVersion = 0;
+	streamed = false;
+	residentLevel = 0;
+	tailLevel = 0;
+	requestedLevel = 0;
+	visible = false;
+	lastVisibleFrame = 0;
+	streamPending = false;
 }
 
 Texture::~Texture()
@@ -27,219 +39,378 @@ Texture::~Texture()
 	textureImage = VK_NULL_HANDLE;
 }
 
-bool Texture::Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::string filename)
+bool Texture::Init(VulkanDevice * device, StagingManager * stagingManager, std::string filename, MappedFile * textureFile, bool streamed)
 {
-	struct MipMap
+	// The file may already have been mapped by a loader thread
+	MappedFile localFile;
+	MappedFile * file = textureFile;
+	if (file == NULL)
 	{
-		unsigned char * data;
-		int width;
-		int height;
-		unsigned int size;
-	};
-
-	VkResult result;
-	void * pData;
-
-	std::vector<MipMap> mipMaps;
+		if (!localFile.Init(filename))
+		{
+			gLogManager->AddMessage("ERROR: Texture file not found! (" + filename + ")");
+			return false;
+		}
+		file = &localFile;
+	}
 
-	FILE * file = fopen(filename.c_str(), "rb");
-	if (file == NULL)
+	if (!ReadTextureLevels(file->GetData(), file->GetSize(), fileFormat, flags, levels))
 	{
-		gLogManager->AddMessage("ERROR: Texture file not found! (" + filename + ")");
+		gLogManager->AddMessage("ERROR: Texture file is corrupted! (" + filename + ")");
 		return false;
 	}
+	mipMapsCount = (int)levels.size() - 1;
 
-	// Read original image (as mipmap level 0)
-	MipMap originalImage;
-	fread(&originalImage.width, sizeof(unsigned int), 1, file);
-	fread(&originalImage.height, sizeof(unsigned int), 1, file);
-	fread(&originalImage.size, sizeof(unsigned int), 1, file);
-
-	originalImage.data = new unsigned char[originalImage.size];
-	fread(originalImage.data, sizeof(unsigned char), originalImage.size, file);
-	mipMaps.push_back(originalImage);
-
-	// Read mipmaps
-	fread(&mipMapsCount, sizeof(int), 1, file);
-
-	for (int i = 0; i < mipMapsCount; i++)
+	// Block compressed levels the GPU can't sample are decoded into staging memory instead of copied
+	transcode = IsBlockCompressed(fileFormat) && !device->IsTextureFormatSupported((VkFormat)fileFormat);
+	imageFormat = transcode ? TextureTranscoder::GetDecodedFormat(fileFormat) : fileFormat;
+	if (!device->IsTextureFormatSupported((VkFormat)imageFormat))
 	{
-		MipMap mipMap;
-		fread(&mipMap.width, sizeof(int), 1, file);
-		fread(&mipMap.height, sizeof(int), 1, file);
-		fread(&mipMap.size, sizeof(unsigned int), 1, file);
-
-		mipMap.data = new unsigned char[mipMap.size];
-		fread(mipMap.data, sizeof(unsigned char), mipMap.size, file);
-
-		mipMaps.push_back(mipMap);
+		gLogManager->AddMessage("ERROR: Texture format is not supported by the GPU! (" + filename + ")");
+		return false;
 	}
 
-	fclose(file);
-
-	unsigned int totalTextureSize = 0;
-	for (unsigned int i = 0; i < mipMaps.size(); i++)
-		totalTextureSize += mipMaps[i].size;
-
-	// Create an array of bits which stores all of the texture data
-	std::vector<unsigned char> textureData;
-	for (unsigned int i = 0; i < mipMaps.size(); i++)
-		for (unsigned int j = 0; j < mipMaps[i].size; j++)
-			textureData.push_back(mipMaps[i].data[j]);
-
-	for (int i = 0; i < mipMaps.size(); i++)
-		delete[] mipMaps[i].data;
+	// Textures without levels larger than the tail are loaded whole even when streamed
+	this->filename = filename;
+	tailLevel = (uint32_t)levels.size() - 1;
+	while (tailLevel > 0 && std::max(levels[tailLevel - 1].width, levels[tailLevel - 1].height) <= TEXTURE_STREAMING_TAIL_SIZE)
+		tailLevel--;
+	this->streamed = streamed && tailLevel > 0;
+	residentLevel = (uint32_t)levels.size();
+	requestedLevel = (uint32_t)levels.size() - 1;
 
-	VkMemoryRequirements memReq{};
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingMemory;
-
-	VkBufferCreateInfo bufferCI{};
-	bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferCI.size = totalTextureSize;
-	bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	result = vkCreateBuffer(device->GetDevice(), &bufferCI, VK_NULL_HANDLE, &stagingBuffer);
-	if (result != VK_SUCCESS)
+	if (!CreateImage(device, stagingManager, this->streamed ? tailLevel : 0, file->GetData()))
 		return false;
 
-	vkGetBufferMemoryRequirements(device->GetDevice(), stagingBuffer, &memReq);
+	file->Unload();
 
-	allocInfo.allocationSize = memReq.size;
-	if (!device->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &allocInfo.memoryTypeIndex))
-		return false;
-
-	result = vkAllocateMemory(device->GetDevice(), &allocInfo, VK_NULL_HANDLE, &stagingMemory);
-	if (result != VK_SUCCESS)
-		return false;
+	return true;
+}
 
-	result = vkBindBufferMemory(device->GetDevice(), stagingBuffer, stagingMemory, 0);
-	if (result != VK_SUCCESS)
-		return false;
+bool Texture::CreateImage(VulkanDevice * device, StagingManager * stagingManager, uint32_t firstLevel, const unsigned char * fileData)
+{
+	VkResult result;
 
-	result = vkMapMemory(device->GetDevice(), stagingMemory, 0, memReq.size, 0, &pData);
-	if (result != VK_SUCCESS)
+	// Levels the current image already has are copied over on the GPU, only the missing ones come from the file
+	uint32_t levelCount = (uint32_t)levels.size() - firstLevel;
+	uint32_t copyLevel = std::max(firstLevel, std::min(residentLevel, (uint32_t)levels.size()));
+	if (copyLevel > firstLevel && fileData == NULL)
 		return false;
 
-	memcpy(pData, textureData.data(), textureData.size());
-
-	vkUnmapMemory(device->GetDevice(), stagingMemory);
+	std::vector<VkDeviceSize> levelOffsets;
+	VkDeviceSize totalTextureSize = 0;
+	for (uint32_t level = firstLevel; level < copyLevel; level++)
+	{
+		totalTextureSize = (totalTextureSize + RCT_LEVEL_ALIGNMENT - 1) & ~(VkDeviceSize)(RCT_LEVEL_ALIGNMENT - 1);
+		levelOffsets.push_back(totalTextureSize);
+		totalTextureSize += GetTextureLevelSize(imageFormat, levels[level].width, levels[level].height);
+	}
 
 	std::vector<VkBufferImageCopy> bufferCopyRegions;
-	uint32_t offset = 0;
+	if (totalTextureSize > 0)
+	{
+		// Copy the levels straight from the mapped file into staging memory
+		VkDeviceSize stagingOffset;
+		unsigned char * stagingData = stagingManager->Allocate(device, totalTextureSize, RCT_LEVEL_ALIGNMENT, &stagingOffset);
+		if (stagingData == NULL)
+			return false;
+
+		for (uint32_t level = firstLevel; level < copyLevel; level++)
+		{
+			const RCTextureLevel & textureLevel = levels[level];
+			unsigned char * levelData = stagingData + levelOffsets[level - firstLevel];
+			if (!transcode)
+				memcpy(levelData, fileData + textureLevel.offset, GetTextureLevelSize(imageFormat, textureLevel.width, textureLevel.height));
+			else if (!TextureTranscoder::DecodeLevel(fileFormat, fileData + textureLevel.offset, textureLevel.width, textureLevel.height, levelData))
+			{
+				gLogManager->AddMessage("ERROR: Texture file has blocks that can't be decoded! (" + filename + ")");
+				return false;
+			}
+
+			VkBufferImageCopy bufferCopyRegion{};
+			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferCopyRegion.imageSubresource.mipLevel = level - firstLevel;
+			bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+			bufferCopyRegion.imageSubresource.layerCount = 1;
+			bufferCopyRegion.imageExtent.depth = 1;
+			bufferCopyRegion.bufferOffset = stagingOffset + levelOffsets[level - firstLevel];
+			bufferCopyRegion.imageExtent.width = textureLevel.width;
+			bufferCopyRegion.imageExtent.height = textureLevel.height;
+
+			bufferCopyRegions.push_back(bufferCopyRegion);
+		}
+	}
 
-	for (unsigned int level = 0; level < mipMaps.size(); level++)
+	std::vector<VkImageCopy> imageCopyRegions;
+	for (uint32_t level = copyLevel; level < levels.size(); level++)
 	{
-		VkBufferImageCopy bufferCopyRegion{};
-		bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		bufferCopyRegion.imageSubresource.mipLevel = level;
-		bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-		bufferCopyRegion.imageSubresource.layerCount = 1;
-		bufferCopyRegion.imageExtent.depth = 1;
-		bufferCopyRegion.bufferOffset = offset;
-		bufferCopyRegion.imageExtent.width = mipMaps[level].width;
-		bufferCopyRegion.imageExtent.height = mipMaps[level].height;
-		offset += (uint32_t)mipMaps[level].size;
-
-		bufferCopyRegions.push_back(bufferCopyRegion);
+		VkImageCopy imageCopyRegion{};
+		imageCopyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageCopyRegion.srcSubresource.mipLevel = level - residentLevel;
+		imageCopyRegion.srcSubresource.layerCount = 1;
+		imageCopyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageCopyRegion.dstSubresource.mipLevel = level - firstLevel;
+		imageCopyRegion.dstSubresource.layerCount = 1;
+		imageCopyRegion.extent.width = levels[level].width;
+		imageCopyRegion.extent.height = levels[level].height;
+		imageCopyRegion.extent.depth = 1;
+
+		imageCopyRegions.push_back(imageCopyRegion);
 	}
 
+	RetiredImage newImage = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
+
 	VkImageCreateInfo imageCI{};
 	imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageCI.imageType = VK_IMAGE_TYPE_2D;
-	imageCI.format = VK_FORMAT_R8G8B8A8_UNORM;
-	imageCI.mipLevels = (uint32_t)mipMaps.size();
+	imageCI.format = (VkFormat)imageFormat;
+	imageCI.mipLevels = levelCount;
 	imageCI.arrayLayers = 1;
 	imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 	imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-	imageCI.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageCI.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 	imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageCI.extent.width = mipMaps[0].width;
-	imageCI.extent.height = mipMaps[0].height;
+	imageCI.extent.width = levels[firstLevel].width;
+	imageCI.extent.height = levels[firstLevel].height;
 	imageCI.extent.depth = 1;
 
-	result = vkCreateImage(device->GetDevice(), &imageCI, VK_NULL_HANDLE, &textureImage);
+	result = vkCreateImage(device->GetDevice(), &imageCI, VK_NULL_HANDLE, &newImage.image);
 	if (result != VK_SUCCESS)
 		return false;
 
-	vkGetImageMemoryRequirements(device->GetDevice(), textureImage, &memReq);
+	VkMemoryRequirements memReq;
+	vkGetImageMemoryRequirements(device->GetDevice(), newImage.image, &memReq);
 
 	VkMemoryAllocateInfo memAlloc{};
 	memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	memAlloc.allocationSize = memReq.size;
 
-	if (!device->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex))
-		return false;
-
-	result = vkAllocateMemory(device->GetDevice(), &memAlloc, VK_NULL_HANDLE, &textureMemory);
-	if (result != VK_SUCCESS)
-		return false;
-
-	result = vkBindImageMemory(device->GetDevice(), textureImage, textureMemory, 0);
-	if (result != VK_SUCCESS)
+	if (!device->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memAlloc.memoryTypeIndex) ||
+		vkAllocateMemory(device->GetDevice(), &memAlloc, VK_NULL_HANDLE, &newImage.memory) != VK_SUCCESS ||
+		vkBindImageMemory(device->GetDevice(), newImage.image, newImage.memory, 0) != VK_SUCCESS)
+	{
+		retiredImages.push_back(newImage);
 		return false;
+	}
 
 	VkImageSubresourceRange range{};
 	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	range.baseMipLevel = 0;
-	range.levelCount = (uint32_t)mipMaps.size();
+	range.levelCount = levelCount;
 	range.layerCount = 1;
 
-	cmdBuffer->BeginRecording();
-	VulkanTools::SetImageLayout(textureImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	// Copies are batched with other pending uploads and submitted when the staging manager is flushed
+	VulkanCommandBuffer * cmdBuffer = stagingManager->GetCommandBuffer();
+
+	VulkanTools::SetImageLayout(newImage.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		&range, cmdBuffer, device, false);
 
-	vkCmdCopyBufferToImage(cmdBuffer->GetCommandBuffer(), stagingBuffer, textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		(uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
+	if (!bufferCopyRegions.empty())
+	{
+		vkCmdCopyBufferToImage(cmdBuffer->GetCommandBuffer(), stagingManager->GetBuffer(), newImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			(uint32_t)bufferCopyRegions.size(), bufferCopyRegions.data());
+	}
 
-	VulkanTools::SetImageLayout(textureImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		&range, cmdBuffer, device, false);
+	if (!imageCopyRegions.empty())
+	{
+		VkImageSubresourceRange residentRange{};
+		residentRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		residentRange.baseMipLevel = 0;
+		residentRange.levelCount = (uint32_t)levels.size() - residentLevel;
+		residentRange.layerCount = 1;
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(device, NULL, NULL, NULL, true);
+		VulkanTools::SetImageLayout(textureImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, &residentRange, cmdBuffer, device, false);
 
-	vkFreeMemory(device->GetDevice(), stagingMemory, VK_NULL_HANDLE);
-	vkDestroyBuffer(device->GetDevice(), stagingBuffer, VK_NULL_HANDLE);
+		vkCmdCopyImage(cmdBuffer->GetCommandBuffer(), textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, newImage.image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)imageCopyRegions.size(), imageCopyRegions.data());
+	}
+
+	VulkanTools::SetImageLayout(newImage.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		&range, cmdBuffer, device, false);
 
 	VkImageViewCreateInfo viewCI{};
 	viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	viewCI.image = textureImage;
+	viewCI.image = newImage.image;
 	viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewCI.format = VK_FORMAT_R8G8B8A8_UNORM;
+	viewCI.format = (VkFormat)imageFormat;
+
+	// Grayscale textures are stored in one channel and sampled as (r, r, r, 1)
+	bool grayscale = (flags & RCT_FLAG_GRAYSCALE) != 0;
 	viewCI.components.r = VK_COMPONENT_SWIZZLE_R;
-	viewCI.components.g = VK_COMPONENT_SWIZZLE_G;
-	viewCI.components.b = VK_COMPONENT_SWIZZLE_B;
-	viewCI.components.a = VK_COMPONENT_SWIZZLE_A;
+	viewCI.components.g = grayscale ? VK_COMPONENT_SWIZZLE_R : VK_COMPONENT_SWIZZLE_G;
+	viewCI.components.b = grayscale ? VK_COMPONENT_SWIZZLE_R : VK_COMPONENT_SWIZZLE_B;
+	viewCI.components.a = grayscale ? VK_COMPONENT_SWIZZLE_ONE : VK_COMPONENT_SWIZZLE_A;
 	viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	viewCI.subresourceRange.baseMipLevel = 0;
 	viewCI.subresourceRange.baseArrayLayer = 0;
 	viewCI.subresourceRange.layerCount = 1;
-	viewCI.subresourceRange.levelCount = (uint32_t)mipMaps.size();
-	result = vkCreateImageView(device->GetDevice(), &viewCI, VK_NULL_HANDLE, &textureImageView);
+	viewCI.subresourceRange.levelCount = levelCount;
+	result = vkCreateImageView(device->GetDevice(), &viewCI, VK_NULL_HANDLE, &newImage.imageView);
 	if (result != VK_SUCCESS)
+	{
+		// The commands recorded for it are still pending, so it can't be destroyed right away
+		retiredImages.push_back(newImage);
 		return false;
+	}
+
+	// Descriptor sets notice the new version and pick up the new view with the next draw
+	if (textureImage != VK_NULL_HANDLE)
+	{
+		RetiredImage oldImage = { textureImage, textureImageView, textureMemory };
+		retiredImages.push_back(oldImage);
+	}
+
+	textureImage = newImage.image;
+	textureImageView = newImage.imageView;
+	textureMemory = newImage.memory;
+	memorySize = memReq.size;
+	residentLevel = firstLevel;
+	imageVersion++;
 
 	return true;
 }
 
 void Texture::Unload(VulkanDevice * vulkanDevice)
 {
+	ReleaseRetiredImages(vulkanDevice);
+
 	vkDestroyImageView(vulkanDevice->GetDevice(), textureImageView, VK_NULL_HANDLE);
 	vkFreeMemory(vulkanDevice->GetDevice(), textureMemory, VK_NULL_HANDLE);
 	vkDestroyImage(vulkanDevice->GetDevice(), textureImage, VK_NULL_HANDLE);
 }
 
+bool Texture::SetResidentLevel(VulkanDevice * device, StagingManager * stagingManager, uint32_t firstLevel, MappedFile * textureFile)
+{
+	if (firstLevel >= levels.size() || firstLevel == residentLevel)
+		return false;
+
+	// Files that changed on disk since the texture was loaded can't be mixed with what is already resident
+	const unsigned char * fileData = NULL;
+	if (textureFile != NULL)
+	{
+		uint32_t format, fileFlags;
+		std::vector<RCTextureLevel> fileLevels;
+		if (!ReadTextureLevels(textureFile->GetData(), textureFile->GetSize(), format, fileFlags, fileLevels) || format != fileFormat ||
+			fileLevels.size() != levels.size() || memcmp(fileLevels.data(), levels.data(), sizeof(RCTextureLevel) * levels.size()) != 0)
+		{
+			gLogManager->AddMessage("ERROR: Streamed texture file changed! (" + filename + ")");
+			return false;
+		}
+		fileData = textureFile->GetData();
+	}
+
+	return CreateImage(device, stagingManager, firstLevel, fileData);
+}
+
+void Texture::ReleaseRetiredImages(VulkanDevice * device)
+{
+	for (size_t i = 0; i < retiredImages.size(); i++)
+	{
+		vkDestroyImageView(device->GetDevice(), retiredImages[i].imageView, VK_NULL_HANDLE);
+		vkFreeMemory(device->GetDevice(), retiredImages[i].memory, VK_NULL_HANDLE);
+		vkDestroyImage(device->GetDevice(), retiredImages[i].image, VK_NULL_HANDLE);
+	}
+
+	retiredImages.clear();
+}
+
+void Texture::RequestResolution(float pixelsPerUV)
+{
+	// The smallest level that still has a texel for every pixel
+	uint32_t level = 0;
+	while (level + 1 < levels.size() && (float)std::max(levels[level + 1].width, levels[level + 1].height) >= pixelsPerUV)
+		level++;
+
+	uint32_t currentLevel = requestedLevel;
+	while (level < currentLevel && !requestedLevel.compare_exchange_weak(currentLevel, level));
+	visible = true;
+}
+
+uint32_t Texture::UpdateVisibility(uint32_t frame)
+{
+	// Level count if it wasn't drawn since the last call
+	uint32_t level = visible ? requestedLevel.load() : (uint32_t)levels.size();
+	if (visible)
+		lastVisibleFrame = frame;
+
+	visible = false;
+	requestedLevel = (uint32_t)levels.size() - 1;
+
+	return level;
+}
+
+void Texture::StopStreaming()
+{
+	streamed = false;
+}
+
+void Texture::SetStreamPending(bool pending)
+{
+	streamPending = pending;
+}
+
 VkImageView * Texture::GetImageView()
 {
 	return &textureImageView;
 }
 
+uint32_t Texture::GetImageVersion()
+{
+	return imageVersion;
+}
+
 int Texture::GetMipMapCount()
 {
 	return mipMapsCount;
 }
+
+VkDeviceSize Texture::GetMemorySize()
+{
+	return memorySize;
+}
+
+VkDeviceSize Texture::GetLevelsSize(uint32_t firstLevel, uint32_t endLevel)
+{
+	VkDeviceSize size = 0;
+	for (uint32_t level = firstLevel; level < endLevel && level < levels.size(); level++)
+		size += GetTextureLevelSize(imageFormat, levels[level].width, levels[level].height);
+
+	return size;
+}
+
+std::string Texture::GetFilename()
+{
+	return filename;
+}
+
+bool Texture::IsStreamed()
+{
+	return streamed;
+}
+
+bool Texture::IsStreamPending()
+{
+	return streamPending;
+}
+
+uint32_t Texture::GetLevelCount()
+{
+	return (uint32_t)levels.size();
+}
+
+uint32_t Texture::GetResidentLevel()
+{
+	return residentLevel;
+}
+
+uint32_t Texture::GetTailLevel()
+{
+	return tailLevel;
+}
+
+uint32_t Texture::GetLastVisibleFrame()
+{
+	return lastVisibleFrame;
+}
\ No newline at end of file
@@ -7,22 +7,78 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <atomic>
 
-#include "VulkanCommandBuffer.h"
+#include "StagingManager.h"
+#include "MappedFile.h"
+#include "TextureFormat.h"
+
+// Streamed textures load the levels up to this size right away, the larger ones when they're drawn close enough
+#define TEXTURE_STREAMING_TAIL_SIZE 64
 
 class Texture
 {
 	private:
+		struct RetiredImage
+		{
+			VkImage image;
+			VkImageView imageView;
+			VkDeviceMemory memory;
+		};
+
 		VkImage textureImage;
 		VkImageView textureImageView;
 		VkDeviceMemory textureMemory;
 		int mipMapsCount;
+		VkDeviceSize memorySize;
+		// Changes whenever the image is replaced, descriptor sets holding the old view have to be written again
+		uint32_t imageVersion;
+
+		// Images replaced since the last staging flush, the copies out of them have to finish before they're destroyed
+		std::vector<RetiredImage> retiredImages;
+
+		std::string filename;
+		std::vector<RCTextureLevel> levels;
+		uint32_t fileFormat;
+		uint32_t imageFormat;
+		uint32_t flags;
+		bool transcode;
+
+		// The image only holds the levels from residentLevel on, streamed textures start with the ones from tailLevel
+		bool streamed;
+		uint32_t residentLevel;
+		uint32_t tailLevel;
+		// Requested by every model drawing the texture, models are recorded on several threads
+		std::atomic<uint32_t> requestedLevel;
+		std::atomic<bool> visible;
+		uint32_t lastVisibleFrame;
+		bool streamPending;
+	private:
+		bool CreateImage(VulkanDevice * device, StagingManager * stagingManager, uint32_t firstLevel, const unsigned char * fileData);
 	public:
 		Texture();
 		~Texture();
 
-		bool Init(VulkanDevice * device, VulkanCommandBuffer * cmdBuffer, std::string filename);
+		bool Init(VulkanDevice * device, StagingManager * stagingManager, std::string filename, MappedFile * textureFile = NULL,
+			bool streamed = false);
 		void Unload(VulkanDevice * vulkanDevice);
+		bool SetResidentLevel(VulkanDevice * device, StagingManager * stagingManager, uint32_t firstLevel, MappedFile * textureFile);
+		void ReleaseRetiredImages(VulkanDevice * device);
+		void RequestResolution(float pixelsPerUV);
+		uint32_t UpdateVisibility(uint32_t frame);
+		void StopStreaming();
+		void SetStreamPending(bool pending);
 		VkImageView * GetImageView();
+		uint32_t GetImageVersion();
 		int GetMipMapCount();
+		VkDeviceSize GetMemorySize();
+		VkDeviceSize GetLevelsSize(uint32_t firstLevel, uint32_t endLevel);
+		std::string GetFilename();
+		bool IsStreamed();
+		bool IsStreamPending();
+		uint32_t GetLevelCount();
+		uint32_t GetResidentLevel();
+		uint32_t GetTailLevel();
+		uint32_t GetLastVisibleFrame();
 };
\ No newline at end of file
@@ -0,0 +1,164 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TextureFormat.h                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+// .rct files written by the exporter are RGBA8 mip chains: width, height, size and pixels of the first level, the
+// number of levels after it, then width, height, size and pixels of each of them. Files cooked by RC-Tools start
+// with RCTextureHeader instead, followed by a RCTextureLevel for every level, largest first, and the level data at
+// the offsets in the table. A real texture width never equals RCT_MAGIC, so the loaders can tell them apart.
+
+#define RCT_MAGIC 0x58544352
+#define RCT_VERSION 1
+
+// Formats are stored as their VkFormat values, so the loaders can create images with them directly
+#define RCT_FORMAT_R8_UNORM 9
+#define RCT_FORMAT_R8G8_UNORM 16
+#define RCT_FORMAT_R8G8B8A8_UNORM 37
+#define RCT_FORMAT_BC1_RGBA_UNORM 133
+#define RCT_FORMAT_BC3_UNORM 137
+#define RCT_FORMAT_BC4_UNORM 139
+#define RCT_FORMAT_BC5_UNORM 141
+#define RCT_FORMAT_BC7_UNORM 145
+
+// Single channel texture holding a grayscale image, sampled as (r, r, r, 1)
+#define RCT_FLAG_GRAYSCALE 0x1
+
+#define RCT_MAX_LEVELS 16
+#define RCT_LEVEL_ALIGNMENT 16
+
+struct RCTextureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t flags;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint32_t reserved;
+};
+
+struct RCTextureLevel
+{
+	uint32_t width;
+	uint32_t height;
+	// From the start of the file
+	uint32_t offset;
+	uint32_t size;
+};
+
+inline bool IsBlockCompressed(uint32_t format)
+{
+	return format == RCT_FORMAT_BC1_RGBA_UNORM || format == RCT_FORMAT_BC3_UNORM || format == RCT_FORMAT_BC4_UNORM ||
+		format == RCT_FORMAT_BC5_UNORM || format == RCT_FORMAT_BC7_UNORM;
+}
+
+// Bytes per 4x4 block for block compressed formats, bytes per pixel for the rest. 0 for unknown formats.
+inline uint32_t GetTextureFormatBytes(uint32_t format)
+{
+	switch (format)
+	{
+		case RCT_FORMAT_R8_UNORM: return 1;
+		case RCT_FORMAT_R8G8_UNORM: return 2;
+		case RCT_FORMAT_R8G8B8A8_UNORM: return 4;
+		case RCT_FORMAT_BC1_RGBA_UNORM: return 8;
+		case RCT_FORMAT_BC4_UNORM: return 8;
+		case RCT_FORMAT_BC3_UNORM: return 16;
+		case RCT_FORMAT_BC5_UNORM: return 16;
+		case RCT_FORMAT_BC7_UNORM: return 16;
+	}
+
+	return 0;
+}
+
+inline size_t GetTextureLevelSize(uint32_t format, uint32_t width, uint32_t height)
+{
+	if (IsBlockCompressed(format))
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetTextureFormatBytes(format);
+
+	return (size_t)width * height * GetTextureFormatBytes(format);
+}
+
+// Reads the level table of either kind of .rct file, level offsets point into data. Returns false if the file is
+// corrupted or has an unknown version or format.
+inline bool ReadTextureLevels(const unsigned char * data, size_t size, uint32_t & format, uint32_t & flags,
+	std::vector<RCTextureLevel> & levels)
+{
+	levels.clear();
+	format = RCT_FORMAT_R8G8B8A8_UNORM;
+	flags = 0;
+
+	uint32_t magic;
+	if (size < sizeof(uint32_t))
+		return false;
+	memcpy(&magic, data, sizeof(uint32_t));
+
+	if (magic != RCT_MAGIC)
+	{
+		size_t offset = 0;
+		int32_t extraLevels = 0;
+		for (int32_t level = 0; level <= extraLevels; level++)
+		{
+			RCTextureLevel textureLevel;
+			if (size - offset < sizeof(uint32_t) * 3)
+				return false;
+
+			memcpy(&textureLevel.width, data + offset, sizeof(uint32_t));
+			memcpy(&textureLevel.height, data + offset + sizeof(uint32_t), sizeof(uint32_t));
+			memcpy(&textureLevel.size, data + offset + sizeof(uint32_t) * 2, sizeof(uint32_t));
+			offset += sizeof(uint32_t) * 3;
+
+			if (textureLevel.size > size - offset || textureLevel.size < GetTextureLevelSize(format, textureLevel.width, textureLevel.height))
+				return false;
+
+			textureLevel.offset = (uint32_t)offset;
+			offset += textureLevel.size;
+			levels.push_back(textureLevel);
+
+			if (level == 0)
+			{
+				if (size - offset < sizeof(int32_t))
+					return false;
+
+				memcpy(&extraLevels, data + offset, sizeof(int32_t));
+				offset += sizeof(int32_t);
+				if (extraLevels < 0 || extraLevels >= RCT_MAX_LEVELS)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	RCTextureHeader header;
+	if (size < sizeof(RCTextureHeader))
+		return false;
+	memcpy(&header, data, sizeof(RCTextureHeader));
+
+	if (header.version != RCT_VERSION || GetTextureFormatBytes(header.format) == 0 || header.levelCount == 0 ||
+		header.levelCount > RCT_MAX_LEVELS || size - sizeof(RCTextureHeader) < sizeof(RCTextureLevel) * header.levelCount)
+		return false;
+
+	format = header.format;
+	flags = header.flags;
+	levels.resize(header.levelCount);
+	memcpy(levels.data(), data + sizeof(RCTextureHeader), sizeof(RCTextureLevel) * header.levelCount);
+
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		if (levels[i].offset > size || levels[i].size > size - levels[i].offset ||
+			levels[i].size < GetTextureLevelSize(format, levels[i].width, levels[i].height))
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
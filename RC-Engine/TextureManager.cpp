@@ -5,62 +5,326 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
+#include <algorithm>
+
 #include "TextureManager.h"
 #include "LogManager.h"
 #include "StdInc.h"
+#include "ParallelFor.h"
+#include "XXHash.h"
 
 extern LogManager * gLogManager;
+extern StagingManager * gStagingManager;
+
+static uint64_t GetFilenameKey(const std::string & filename)
+{
+	return XXHash::Hash64(filename.c_str(), filename.size());
+}
+
+TextureManager::TextureManager()
+{
+	streamingFrame = 0;
+	pendingReadCount = 0;
+}
+
+void TextureManager::Init()
+{
+	streamer.Init();
+}
+
+void TextureManager::SetBudget(VkDeviceSize budget)
+{
+	textures.SetBudget(budget);
+}
+
+void TextureManager::Unload(VulkanDevice * device)
+{
+	// Reads still in flight are dropped, their textures may be gone by now
+	streamer.Unload();
+	pendingReadCount = 0;
+
+	ReleasePrefetchedTextures();
+	textures.Clear(device);
+}
+
+void TextureManager::PrefetchTextures(const std::vector<std::string> & filenames)
+{
+	// Collect files that are neither loaded nor prefetched yet, each one only once
+	std::vector<std::string> newFiles;
+	std::vector<PrefetchEntry*> newEntries;
+	for (unsigned int i = 0; i < filenames.size(); i++)
+	{
+		if (HasTexture(filenames[i]))
+			continue;
+
+		PrefetchEntry & entry = texturesPrefetched[filenames[i]];
+		entry.file = NULL;
+		entry.contentHash = 0;
+		newFiles.push_back(filenames[i]);
+		newEntries.push_back(&entry);
+	}
+
+	// Mapping, decompressing and hashing the files happens on worker threads, RequestTexture picks them up later
+	ParallelFor((unsigned int)newFiles.size(), [&](unsigned int i)
+	{
+		PrefetchEntry & entry = *newEntries[i];
+		entry.file = MapTextureFile(newFiles[i], entry.contentHash);
+	});
+}
+
+void TextureManager::AddPrefetchedTexture(std::string filename, MappedFile * file, uint64_t contentHash)
+{
+	if (HasTexture(filename))
+	{
+		SAFE_DELETE(file);
+		return;
+	}
+
+	PrefetchEntry & entry = texturesPrefetched[filename];
+	entry.file = file;
+	entry.contentHash = contentHash;
+}
+
+bool TextureManager::HasTexture(std::string filename)
+{
+	return textures.Contains(GetFilenameKey(filename)) || texturesPrefetched.count(filename) > 0;
+}
+
+MappedFile * TextureManager::MapTextureFile(std::string filename, uint64_t & contentHash)
+{
+	// Safe to call from any thread, a missing file is left for RequestTexture to report
+	contentHash = 0;
+
+	MappedFile * file = new MappedFile();
+	if (!file->Init(filename))
+	{
+		SAFE_DELETE(file);
+		return NULL;
+	}
+	file->Prefetch();
+
+	contentHash = XXHash::Hash64(file->GetData(), file->GetSize());
+
+	return file;
+}
+
+void TextureManager::ReleasePrefetchedTextures()
+{
+	for (auto it = texturesPrefetched.begin(); it != texturesPrefetched.end(); it++)
+		SAFE_DELETE(it->second.file);
+
+	texturesPrefetched.clear();
+}
+
+// Loads the streamed levels of a texture that is now also used without streaming
+static void LoadAllLevels(Texture * texture, VulkanDevice * device)
+{
+	MappedFile textureFile;
+	if (textureFile.Init(texture->GetFilename()) && texture->SetResidentLevel(device, gStagingManager, 0, &textureFile))
+	{
+		gStagingManager->Flush(device);
+		texture->ReleaseRetiredImages(device);
+	}
+
+	texture->StopStreaming();
+}
 
-Texture * TextureManager::RequestTexture(std::string filename, VulkanDevice * device, VulkanCommandBuffer * cmdBuffer)
+ResourceHandle TextureManager::RequestTexture(std::string filename, VulkanDevice * device, bool streamed)
 {
-	// Check if texture is already loaded
-	for (unsigned int i = 0; i < texturesLoaded.size(); i++)
+	// Check if texture is already loaded, or still cached from an earlier use
+	uint64_t filenameKey = GetFilenameKey(filename);
+	ResourceHandle handle = textures.Acquire(filenameKey);
+	if (handle.IsValid())
+	{
+		Texture * texture = textures.Get(handle);
+		if (!streamed && texture->IsStreamed())
+		{
+			LoadAllLevels(texture, device);
+			textures.SetMemorySize(handle, texture->GetMemorySize());
+		}
+		return handle;
+	}
+
+	// Use the prefetched file if there is one
+	MappedFile * textureFile = NULL;
+	uint64_t contentHash = 0;
+
+	auto prefetched = texturesPrefetched.find(filename);
+	if (prefetched != texturesPrefetched.end())
+	{
+		textureFile = prefetched->second.file;
+		contentHash = prefetched->second.contentHash;
+		texturesPrefetched.erase(prefetched);
+	}
+
+	if (textureFile == NULL)
+	{
+		textureFile = new MappedFile();
+		if (!textureFile->Init(filename))
+		{
+			gLogManager->AddMessage("ERROR: Texture file not found! (" + filename + ")");
+			SAFE_DELETE(textureFile);
+			return ResourceHandle();
+		}
+		contentHash = XXHash::Hash64(textureFile->GetData(), textureFile->GetSize());
+	}
+
+	// A file with the same contents under another name shares the already loaded texture
+	handle = textures.Acquire(contentHash);
+	if (handle.IsValid())
 	{
-		if (filename == texturesLoaded[i].filename)
+		SAFE_DELETE(textureFile);
+		textures.AddKey(handle, filenameKey);
+
+		Texture * texture = textures.Get(handle);
+		if (!streamed && texture->IsStreamed())
 		{
-			texturesLoaded[i].useCount++;
-			return texturesLoaded[i].texturePtr;
+			LoadAllLevels(texture, device);
+			textures.SetMemorySize(handle, texture->GetMemorySize());
 		}
+		return handle;
 	}
 
 	// If texture is not loaded, create new entry
 	Texture * texture = new Texture();
-	if (!texture->Init(device, cmdBuffer, filename))
+	bool textureLoaded = texture->Init(device, gStagingManager, filename, textureFile, streamed);
+	SAFE_DELETE(textureFile);
+
+	if (!textureLoaded)
 	{
 		gLogManager->AddMessage("ERROR: Couldn't init a texture!");
-		return nullptr;
+		SAFE_UNLOAD(texture, device);
+		return ResourceHandle();
 	}
 
-	TextureEntry entry;
-	entry.filename = filename;
-	entry.texturePtr = texture;
-	entry.useCount = 1;
-	texturesLoaded.push_back(entry);
+	handle = textures.Add(contentHash, texture, texture->GetMemorySize());
+	textures.AddKey(handle, filenameKey);
 
-	return texture;
+	// Make room for the new texture by dropping unused ones if needed
+	textures.Evict(device);
+
+	return handle;
 }
 
-void TextureManager::ReleaseTexture(Texture * texture, VulkanDevice * device)
+void TextureManager::UpdateStreaming(VulkanDevice * device)
 {
-	for (unsigned int i = 0; i < texturesLoaded.size(); i++)
+	streamingFrame++;
+
+	// Upload the levels the IO thread finished reading, a few megabytes per frame at most
+	std::vector<Texture*> changedTextures;
+	VkDeviceSize uploadSize = 0;
+	TextureStreamer::StreamRead read;
+	while (uploadSize < TEXTURE_STREAMING_UPLOAD_LIMIT && streamer.GetCompletedRead(read))
 	{
-		if (texture == texturesLoaded[i].texturePtr)
+		pendingReadCount--;
+
+		// The texture may have been unloaded, trimmed or fully loaded while the read was in flight
+		Texture * texture = textures.Get(read.handle);
+		if (texture != NULL)
 		{
-			if (texturesLoaded[i].useCount > 1)
-				texturesLoaded[i].useCount--;
-			else
+			texture->SetStreamPending(false);
+			if (read.file != NULL && texture->IsStreamed() && texture->GetResidentLevel() == read.endLevel &&
+				texture->SetResidentLevel(device, gStagingManager, read.firstLevel, read.file))
 			{
-				SAFE_UNLOAD(texturesLoaded[i].texturePtr, device);
-				texturesLoaded.erase(texturesLoaded.begin() + i);
+				textures.SetMemorySize(read.handle, texture->GetMemorySize());
+				changedTextures.push_back(texture);
+				uploadSize += texture->GetLevelsSize(read.firstLevel, read.endLevel);
 			}
+		}
+
+		SAFE_DELETE(read.file);
+	}
+
+	// Collect the level each streamed texture needs this frame
+	struct StreamedTexture
+	{
+		ResourceHandle handle;
+		Texture * texture;
+		uint32_t wantedLevel;
+	};
+	std::vector<StreamedTexture> streamedTextures;
+	textures.ForEach([&](ResourceHandle handle, Texture * texture)
+	{
+		if (!texture->IsStreamed())
+			return;
 
-			texture = NULL;
-			break;
+		StreamedTexture entry = { handle, texture, texture->UpdateVisibility(streamingFrame) };
+		streamedTextures.push_back(entry);
+	});
+
+	// Over budget, drop the high levels of the textures that were drawn longest ago first. Idle textures go back
+	// to their tail, textures drawn this frame only lose the levels they don't need.
+	VkDeviceSize budget = textures.GetBudget();
+	if (textures.GetResidentSize() > budget)
+	{
+		std::sort(streamedTextures.begin(), streamedTextures.end(), [](const StreamedTexture & a, const StreamedTexture & b)
+		{
+			return a.texture->GetLastVisibleFrame() < b.texture->GetLastVisibleFrame();
+		});
+
+		for (size_t i = 0; i < streamedTextures.size() && textures.GetResidentSize() > budget; i++)
+		{
+			Texture * texture = streamedTextures[i].texture;
+			bool idle = streamingFrame - texture->GetLastVisibleFrame() > TEXTURE_STREAMING_IDLE_FRAMES;
+			if (!idle && texture->GetLastVisibleFrame() != streamingFrame)
+				continue;
+
+			uint32_t trimLevel = texture->GetTailLevel();
+			if (!idle)
+				trimLevel = std::min(streamedTextures[i].wantedLevel, trimLevel);
+			if (trimLevel <= texture->GetResidentLevel())
+				continue;
+
+			if (texture->SetResidentLevel(device, gStagingManager, trimLevel, NULL))
+			{
+				textures.SetMemorySize(streamedTextures[i].handle, texture->GetMemorySize());
+				changedTextures.push_back(texture);
+			}
 		}
 	}
+
+	// Start reading the missing levels of visible textures, as long as they would still fit in the budget
+	VkDeviceSize projectedSize = textures.GetResidentSize();
+	for (size_t i = 0; i < streamedTextures.size() && pendingReadCount < TEXTURE_STREAMING_MAX_READS; i++)
+	{
+		Texture * texture = streamedTextures[i].texture;
+		uint32_t wantedLevel = streamedTextures[i].wantedLevel;
+		if (texture->IsStreamPending() || wantedLevel >= texture->GetResidentLevel())
+			continue;
+
+		VkDeviceSize readSize = texture->GetLevelsSize(wantedLevel, texture->GetResidentLevel());
+		if (projectedSize + readSize > budget)
+			continue;
+		projectedSize += readSize;
+
+		texture->SetStreamPending(true);
+		streamer.QueueRead(streamedTextures[i].handle, texture->GetFilename(), wantedLevel, texture->GetResidentLevel());
+		pendingReadCount++;
+	}
+
+	// The old images are still the source of the level copies, so they can only go once those are done
+	if (!changedTextures.empty())
+	{
+		gStagingManager->Flush(device);
+		for (size_t i = 0; i < changedTextures.size(); i++)
+			changedTextures[i]->ReleaseRetiredImages(device);
+	}
+
+	// Streaming in may have pushed unused cached textures over the budget
+	textures.Evict(device);
 }
 
-size_t TextureManager::GetLoadedTexturesCount()
+Texture * TextureManager::GetTexture(ResourceHandle handle)
 {
-	return texturesLoaded.size();
+	return textures.Get(handle);
 }
+
+void TextureManager::ReleaseTexture(ResourceHandle handle, VulkanDevice * device)
+{
+	textures.Release(handle, device);
+}
+
+size_t TextureManager::GetLoadedTexturesCount()
+{
+	return textures.GetResidentCount();
+}
\ No newline at end of file
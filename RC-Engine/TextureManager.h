@@ -8,20 +8,49 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include "Texture.h"
+#include "ResourceRegistry.h"
+#include "TextureStreamer.h"
+
+// Limits on how much streaming work is started each frame
+#define TEXTURE_STREAMING_MAX_READS 8
+#define TEXTURE_STREAMING_UPLOAD_LIMIT (16 * 1024 * 1024)
+// Textures not drawn for this many frames are the first to lose their high levels when over budget
+#define TEXTURE_STREAMING_IDLE_FRAMES 120
 
 class TextureManager
 {
 	private:
-		struct TextureEntry
+		// Textures are reachable both by the hash of their filename and by the hash of their contents
+		ResourceRegistry<Texture> textures;
+
+		struct PrefetchEntry
 		{
-			std::string filename;
-			Texture * texturePtr;
-			unsigned int useCount;
+			MappedFile * file;
+			uint64_t contentHash;
 		};
-		std::vector<TextureEntry> texturesLoaded;
+		std::unordered_map<std::string, PrefetchEntry> texturesPrefetched;
+
+		TextureStreamer streamer;
+		uint32_t streamingFrame;
+		uint32_t pendingReadCount;
 	public:
-		Texture * RequestTexture(std::string filename, VulkanDevice * device, VulkanCommandBuffer * cmdBuffer);
-		void ReleaseTexture(Texture * texture, VulkanDevice * device);
+		TextureManager();
+
+		void Init();
+		void SetBudget(VkDeviceSize budget);
+		void Unload(VulkanDevice * device);
+		void PrefetchTextures(const std::vector<std::string> & filenames);
+		void AddPrefetchedTexture(std::string filename, MappedFile * file, uint64_t contentHash);
+		void ReleasePrefetchedTextures();
+		// Loaded, cached or prefetched textures don't have to be read again
+		bool HasTexture(std::string filename);
+		ResourceHandle RequestTexture(std::string filename, VulkanDevice * device, bool streamed = false);
+		void UpdateStreaming(VulkanDevice * device);
+		Texture * GetTexture(ResourceHandle handle);
+		void ReleaseTexture(ResourceHandle handle, VulkanDevice * device);
 		size_t GetLoadedTexturesCount();
+
+		static MappedFile * MapTextureFile(std::string filename, uint64_t & contentHash);
 };
\ No newline at end of file
@@ -0,0 +1,97 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TextureStreamer.cpp                                  |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include "TextureStreamer.h"
+#include "StdInc.h"
+
+TextureStreamer::TextureStreamer()
+{
+	running = false;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	running = false;
+}
+
+void TextureStreamer::Init()
+{
+	running = true;
+	ioThread = std::thread(&TextureStreamer::IOThread, this);
+}
+
+void TextureStreamer::Unload()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		running = false;
+	}
+	queueCondition.notify_all();
+
+	if (ioThread.joinable())
+		ioThread.join();
+
+	pendingReads.clear();
+	for (size_t i = 0; i < completedReads.size(); i++)
+		SAFE_DELETE(completedReads[i].file);
+	completedReads.clear();
+}
+
+void TextureStreamer::IOThread()
+{
+	for (;;)
+	{
+		StreamRead read;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueCondition.wait(lock, [this]() { return !running || !pendingReads.empty(); });
+			if (!running)
+				return;
+
+			read = pendingReads.front();
+			pendingReads.pop_front();
+		}
+
+		// The whole file is paged in here, the upload only copies from memory
+		read.file = new MappedFile();
+		if (read.file->Init(read.filename))
+			read.file->Prefetch();
+		else
+			SAFE_DELETE(read.file);
+
+		std::lock_guard<std::mutex> lock(queueMutex);
+		completedReads.push_back(read);
+	}
+}
+
+void TextureStreamer::QueueRead(ResourceHandle handle, std::string filename, uint32_t firstLevel, uint32_t endLevel)
+{
+	StreamRead read;
+	read.handle = handle;
+	read.filename = filename;
+	read.firstLevel = firstLevel;
+	read.endLevel = endLevel;
+	read.file = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		pendingReads.push_back(read);
+	}
+	queueCondition.notify_one();
+}
+
+bool TextureStreamer::GetCompletedRead(StreamRead & read)
+{
+	std::lock_guard<std::mutex> lock(queueMutex);
+	if (completedReads.empty())
+		return false;
+
+	read = completedReads.front();
+	completedReads.pop_front();
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TextureStreamer.h                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ResourceRegistry.h"
+#include "MappedFile.h"
+
+// Reads the files of streamed textures on a background thread, so mapping and decompressing them never stalls a
+// frame. The uploads happen on the main thread once a read is done.
+class TextureStreamer
+{
+	public:
+		struct StreamRead
+		{
+			ResourceHandle handle;
+			std::string filename;
+			// Levels firstLevel up to (not including) endLevel are missing from the texture
+			uint32_t firstLevel;
+			uint32_t endLevel;
+			// NULL if the file couldn't be opened
+			MappedFile * file;
+		};
+	private:
+		std::thread ioThread;
+		std::mutex queueMutex;
+		std::condition_variable queueCondition;
+		std::deque<StreamRead> pendingReads;
+		std::deque<StreamRead> completedReads;
+		bool running;
+	private:
+		void IOThread();
+	public:
+		TextureStreamer();
+		~TextureStreamer();
+
+		void Init();
+		void Unload();
+		void QueueRead(ResourceHandle handle, std::string filename, uint32_t firstLevel, uint32_t endLevel);
+		bool GetCompletedRead(StreamRead & read);
+};
\ No newline at end of file
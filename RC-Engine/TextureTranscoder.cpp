@@ -0,0 +1,355 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TextureTranscoder.cpp                                |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <string.h>
+
+#include "TextureTranscoder.h"
+#include "TextureFormat.h"
+
+static const int bc7Weights2[4] = { 0, 21, 43, 64 };
+static const int bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const int bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BC7Mode
+{
+	int subsetCount;
+	int partitionBits;
+	int rotationBits;
+	int indexModeBits;
+	int colorBits;
+	int alphaBits;
+	// One P-bit per endpoint or one per subset
+	int endpointPBits;
+	int sharedPBits;
+	int indexBits;
+	int secondaryIndexBits;
+};
+
+static const BC7Mode bc7Modes[8] = {
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+// Subset of every pixel for each partition, one bit per pixel for two subsets and two bits per pixel for three
+static const uint16_t bc7Partitions2[64] = {
+	0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+	0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+	0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+	0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+static const uint32_t bc7Partitions3[64] = {
+	0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+	0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+	0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+	0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+	0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+	0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+	0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+	0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+};
+
+// Anchor pixels of the second and third subsets, their index has an implicit top bit of 0 like pixel 0
+static const unsigned char bc7Anchors2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+};
+
+static const unsigned char bc7Anchors3Second[64] = {
+	3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3, 3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+	8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15, 3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+};
+
+static const unsigned char bc7Anchors3Third[64] = {
+	15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8, 15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+	15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8, 15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+};
+
+// Reads a 128-bit BC7 block from the lowest bit up
+class BlockBitReader
+{
+	private:
+		const unsigned char * block;
+		uint32_t position;
+	public:
+		BlockBitReader(const unsigned char * block)
+		{
+			this->block = block;
+			position = 0;
+		}
+
+		uint32_t Read(uint32_t bitCount)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bitCount; i++, position++)
+				value |= (uint32_t)((block[position >> 3] >> (position & 7)) & 1) << i;
+
+			return value;
+		}
+};
+
+static void Decode565(uint16_t color, unsigned char * rgb)
+{
+	uint32_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+	rgb[0] = (unsigned char)((r << 3) | (r >> 2));
+	rgb[1] = (unsigned char)((g << 2) | (g >> 4));
+	rgb[2] = (unsigned char)((b << 3) | (b >> 2));
+}
+
+// 4x4 RGBA8 pixels from a BC1 color block. BC3 color blocks always use four colors.
+static void DecodeColorBlock(const unsigned char * block, unsigned char * pixels, bool alwaysFourColors)
+{
+	uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+
+	unsigned char palette[4][4];
+	Decode565(color0, palette[0]);
+	Decode565(color1, palette[1]);
+	palette[0][3] = palette[1][3] = 255;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (color0 > color1 || alwaysFourColors)
+		{
+			palette[2][i] = (unsigned char)((2 * palette[0][i] + palette[1][i] + 1) / 3);
+			palette[3][i] = (unsigned char)((palette[0][i] + 2 * palette[1][i] + 1) / 3);
+		}
+		else
+		{
+			palette[2][i] = (unsigned char)((palette[0][i] + palette[1][i]) / 2);
+			palette[3][i] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = (color0 > color1 || alwaysFourColors) ? 255 : 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+		memcpy(pixels + i * 4, palette[index], 4);
+	}
+}
+
+// 16 single channel values from a BC4 block, written every stride bytes
+static void DecodeChannelBlock(const unsigned char * block, unsigned char * values, int stride)
+{
+	int value0 = block[0], value1 = block[1];
+
+	int palette[8];
+	palette[0] = value0;
+	palette[1] = value1;
+	if (value0 > value1)
+	{
+		for (int i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (uint64_t)block[2 + i] << (i * 8);
+
+	for (int i = 0; i < 16; i++)
+		values[i * stride] = (unsigned char)palette[(indices >> (i * 3)) & 7];
+}
+
+static unsigned char Interpolate(int value0, int value1, int weight)
+{
+	return (unsigned char)(((64 - weight) * value0 + weight * value1 + 32) >> 6);
+}
+
+static int ExpandBits(int value, int bitCount)
+{
+	value <<= 8 - bitCount;
+	return value | (value >> bitCount);
+}
+
+static const int * GetBC7Weights(int indexBits)
+{
+	return indexBits == 2 ? bc7Weights2 : (indexBits == 3 ? bc7Weights3 : bc7Weights4);
+}
+
+static void DecodeBC7Block(const unsigned char * block, unsigned char * pixels)
+{
+	int modeIndex = 0;
+	while (modeIndex < 8 && !((block[0] >> modeIndex) & 1))
+		modeIndex++;
+
+	// Reserved mode, the GPU decodes it as transparent black
+	if (modeIndex == 8)
+	{
+		memset(pixels, 0, 16 * 4);
+		return;
+	}
+
+	const BC7Mode & mode = bc7Modes[modeIndex];
+	BlockBitReader reader(block);
+	reader.Read(modeIndex + 1);
+
+	int partition = (int)reader.Read(mode.partitionBits);
+	int rotation = (int)reader.Read(mode.rotationBits);
+	int indexMode = (int)reader.Read(mode.indexModeBits);
+
+	// Endpoints 2 * subset and 2 * subset + 1, channel by channel. Modes without alpha are opaque.
+	int endpointCount = mode.subsetCount * 2;
+	int endpoints[6][4];
+	for (int channel = 0; channel < 4; channel++)
+	{
+		int bitCount = channel < 3 ? mode.colorBits : mode.alphaBits;
+		for (int endpoint = 0; endpoint < endpointCount; endpoint++)
+			endpoints[endpoint][channel] = bitCount > 0 ? (int)reader.Read(bitCount) : 255;
+	}
+
+	int pBits[6] = { 0 };
+	for (int i = 0; i < endpointCount * mode.endpointPBits; i++)
+		pBits[i] = (int)reader.Read(1);
+	for (int i = 0; i < mode.subsetCount * mode.sharedPBits; i++)
+		pBits[i * 2] = pBits[i * 2 + 1] = (int)reader.Read(1);
+
+	int hasPBits = mode.endpointPBits + mode.sharedPBits;
+	for (int endpoint = 0; endpoint < endpointCount; endpoint++)
+	{
+		for (int channel = 0; channel < 4; channel++)
+		{
+			int bitCount = channel < 3 ? mode.colorBits : mode.alphaBits;
+			if (bitCount == 0)
+				continue;
+
+			int value = endpoints[endpoint][channel];
+			if (hasPBits)
+				value = (value << 1) | pBits[endpoint];
+			endpoints[endpoint][channel] = ExpandBits(value, bitCount + hasPBits);
+		}
+	}
+
+	int subsets[16];
+	for (int i = 0; i < 16; i++)
+	{
+		if (mode.subsetCount == 2)
+			subsets[i] = (bc7Partitions2[partition] >> i) & 1;
+		else if (mode.subsetCount == 3)
+			subsets[i] = (bc7Partitions3[partition] >> (i * 2)) & 3;
+		else
+			subsets[i] = 0;
+	}
+
+	int primaryIndices[16], secondaryIndices[16];
+	for (int i = 0; i < 16; i++)
+	{
+		bool anchor = i == 0 || (mode.subsetCount == 2 && i == bc7Anchors2[partition]) ||
+			(mode.subsetCount == 3 && (i == bc7Anchors3Second[partition] || i == bc7Anchors3Third[partition]));
+		primaryIndices[i] = (int)reader.Read(anchor ? mode.indexBits - 1 : mode.indexBits);
+	}
+	for (int i = 0; i < 16 && mode.secondaryIndexBits > 0; i++)
+		secondaryIndices[i] = (int)reader.Read(i == 0 ? mode.secondaryIndexBits - 1 : mode.secondaryIndexBits);
+
+	// Modes 4 and 5 have separate alpha indices, the index mode of mode 4 picks which set is used for color
+	const int * colorIndices = primaryIndices, * alphaIndices = primaryIndices;
+	int colorIndexBits = mode.indexBits, alphaIndexBits = mode.indexBits;
+	if (mode.secondaryIndexBits > 0)
+	{
+		colorIndices = indexMode == 0 ? primaryIndices : secondaryIndices;
+		alphaIndices = indexMode == 0 ? secondaryIndices : primaryIndices;
+		colorIndexBits = indexMode == 0 ? mode.indexBits : mode.secondaryIndexBits;
+		alphaIndexBits = indexMode == 0 ? mode.secondaryIndexBits : mode.indexBits;
+	}
+	const int * colorWeights = GetBC7Weights(colorIndexBits);
+	const int * alphaWeights = GetBC7Weights(alphaIndexBits);
+
+	for (int i = 0; i < 16; i++)
+	{
+		unsigned char * pixel = pixels + i * 4;
+		const int * endpoint0 = endpoints[subsets[i] * 2];
+		const int * endpoint1 = endpoints[subsets[i] * 2 + 1];
+		for (int channel = 0; channel < 3; channel++)
+			pixel[channel] = Interpolate(endpoint0[channel], endpoint1[channel], colorWeights[colorIndices[i]]);
+		pixel[3] = Interpolate(endpoint0[3], endpoint1[3], alphaWeights[alphaIndices[i]]);
+
+		// Modes 4 and 5 can swap alpha with one of the color channels
+		if (rotation != 0)
+		{
+			unsigned char swap = pixel[3];
+			pixel[3] = pixel[rotation - 1];
+			pixel[rotation - 1] = swap;
+		}
+	}
+}
+
+uint32_t TextureTranscoder::GetDecodedFormat(uint32_t format)
+{
+	switch (format)
+	{
+		case RCT_FORMAT_BC4_UNORM: return RCT_FORMAT_R8_UNORM;
+		case RCT_FORMAT_BC5_UNORM: return RCT_FORMAT_R8G8_UNORM;
+		case RCT_FORMAT_BC1_RGBA_UNORM:
+		case RCT_FORMAT_BC3_UNORM:
+		case RCT_FORMAT_BC7_UNORM:
+			return RCT_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	return format;
+}
+
+bool TextureTranscoder::DecodeLevel(uint32_t format, const unsigned char * src, uint32_t width, uint32_t height, unsigned char * dst)
+{
+	uint32_t blockBytes = GetTextureFormatBytes(format);
+	uint32_t pixelBytes = GetTextureFormatBytes(GetDecodedFormat(format));
+	if (!IsBlockCompressed(format))
+		return false;
+
+	uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+		{
+			const unsigned char * block = src + ((size_t)blockY * blocksX + blockX) * blockBytes;
+
+			// Decoded as 4x4 pixels, then the part inside the level is copied out
+			unsigned char pixels[16 * 4];
+			switch (format)
+			{
+				case RCT_FORMAT_BC1_RGBA_UNORM:
+					DecodeColorBlock(block, pixels, false);
+					break;
+				case RCT_FORMAT_BC3_UNORM:
+					DecodeColorBlock(block + 8, pixels, true);
+					DecodeChannelBlock(block, pixels + 3, 4);
+					break;
+				case RCT_FORMAT_BC4_UNORM:
+					DecodeChannelBlock(block, pixels, 1);
+					break;
+				case RCT_FORMAT_BC5_UNORM:
+					DecodeChannelBlock(block, pixels, 2);
+					DecodeChannelBlock(block + 8, pixels + 1, 2);
+					break;
+				case RCT_FORMAT_BC7_UNORM:
+					DecodeBC7Block(block, pixels);
+					break;
+			}
+
+			for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+			{
+				uint32_t rowPixels = width - blockX * 4 < 4 ? width - blockX * 4 : 4;
+				memcpy(dst + (((size_t)blockY * 4 + y) * width + blockX * 4) * pixelBytes, pixels + y * 4 * pixelBytes, rowPixels * pixelBytes);
+			}
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
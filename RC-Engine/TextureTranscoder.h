@@ -0,0 +1,21 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: TextureTranscoder.h                                  |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CPU decoding of block compressed .rct levels, for devices that can't sample the BC formats
+namespace TextureTranscoder
+{
+	// Format decoded levels are stored in: RGBA8 for BC1, BC3 and BC7, R8 for BC4 and RG8 for BC5
+	uint32_t GetDecodedFormat(uint32_t format);
+
+	// Decodes a whole level into dst, which holds GetTextureLevelSize(GetDecodedFormat(format), width, height) bytes.
+	// BC7 blocks are decoded in all eight modes. Returns false for formats that aren't block compressed.
+	bool DecodeLevel(uint32_t format, const unsigned char * src, uint32_t width, uint32_t height, unsigned char * dst);
+}
\ No newline at end of file
@@ -5,9 +5,10 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
-#include <fstream>
+#include <sstream>
 #include "TimeCycle.h"
 #include "LogManager.h"
+#include "MappedFile.h"
 
 extern LogManager * gLogManager;
 
@@ -17,13 +18,16 @@ bool TimeCycle::Init(Skydome * skydome, Sunlight * light)
 	lightPtr = light;
 	timePassSpeed = 1000;
 
-	std::ifstream file("data/timecycle.dat");
-	if (!file.is_open())
+	MappedFile timecycleFile;
+	if (!timecycleFile.Init("data/timecycle.dat"))
 	{
 		gLogManager->AddMessage("ERROR: Missing timecycle.dat");
 		return false;
 	}
 
+	std::istringstream file(std::string((const char*)timecycleFile.GetData(), timecycleFile.GetSize()));
+	timecycleFile.Unload();
+
 	std::string identifier, weatherName;
 	while (!file.eof())
 	{
@@ -74,8 +78,6 @@ bool TimeCycle::Init(Skydome * skydome, Sunlight * light)
 		weatherList.push_back(weather);
 	}
 
-	file.close();
-
 	timer = new GameplayTimer();
 	return true;
 }
@@ -0,0 +1,310 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: UniformRing.cpp                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <algorithm>
+
+#include "UniformRing.h"
+#include "LogManager.h"
+#include "StdInc.h"
+
+extern LogManager * gLogManager;
+
+UniformRing::UniformRing()
+{
+	vulkanDevice = NULL;
+	buffer = VK_NULL_HANDLE;
+	memory = VK_NULL_HANDLE;
+	mappedData = NULL;
+	frameSize = 0;
+	sliceSize = 0;
+	slotSize = 0;
+	alignment = 1;
+	frameIndex = 0;
+	bufferVersion = 0;
+	frameOffset = 0;
+	overflowReported = false;
+}
+
+UniformRing::~UniformRing()
+{
+	mappedData = NULL;
+	memory = VK_NULL_HANDLE;
+	buffer = VK_NULL_HANDLE;
+	vulkanDevice = NULL;
+}
+
+bool UniformRing::Init(VulkanDevice * vulkanDevice, VkDeviceSize frameSize, uint32_t slotCount)
+{
+	this->vulkanDevice = vulkanDevice;
+
+	// Every slice starts on an offset the device accepts for dynamic uniform and storage buffers, instance data is read
+	// as a storage buffer
+	VkPhysicalDeviceLimits limits = vulkanDevice->GetGPUProperties().limits;
+	alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+	if (alignment == 0)
+		alignment = 1;
+	this->frameSize = (frameSize + alignment - 1) & ~(alignment - 1);
+	slotSize = (UNIFORM_RING_SLOT_SIZE + alignment - 1) & ~(alignment - 1);
+	sliceSize = this->frameSize + slotSize * slotCount;
+	slotRuns.assign(slotCount, 0);
+
+	if (!CreateBuffer(GetBufferSize(sliceSize), &buffer, &memory, &mappedData))
+		return false;
+
+	frameIndex = 0;
+	frameOffset = 0;
+
+	return true;
+}
+
+void UniformRing::Unload(VulkanDevice * vulkanDevice)
+{
+	DestroyBuffer(buffer, memory, mappedData);
+
+	mappedData = NULL;
+	memory = VK_NULL_HANDLE;
+	buffer = VK_NULL_HANDLE;
+	slotRuns.clear();
+}
+
+VkDeviceSize UniformRing::GetBufferSize(VkDeviceSize sliceSize)
+{
+	// The descriptor range starting at the last offset of the last slice has to stay inside the buffer
+	return sliceSize * UNIFORM_RING_FRAME_COUNT + UNIFORM_RING_STORAGE_RANGE;
+}
+
+bool UniformRing::CreateBuffer(VkDeviceSize size, VkBuffer * newBuffer, VkDeviceMemory * newMemory, unsigned char ** newMappedData)
+{
+	VkResult result;
+
+	*newBuffer = VK_NULL_HANDLE;
+	*newMemory = VK_NULL_HANDLE;
+	*newMappedData = NULL;
+
+	VkBufferCreateInfo bufferCI{};
+	bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCI.size = size;
+	bufferCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	result = vkCreateBuffer(vulkanDevice->GetDevice(), &bufferCI, VK_NULL_HANDLE, newBuffer);
+	if (result != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements memReq;
+	vkGetBufferMemoryRequirements(vulkanDevice->GetDevice(), *newBuffer, &memReq);
+
+	// Coherent memory, so the persistent mapping never has to be flushed
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memReq.size;
+	if (!vulkanDevice->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&allocInfo.memoryTypeIndex))
+		return false;
+
+	result = vkAllocateMemory(vulkanDevice->GetDevice(), &allocInfo, VK_NULL_HANDLE, newMemory);
+	if (result != VK_SUCCESS)
+		return false;
+
+	result = vkBindBufferMemory(vulkanDevice->GetDevice(), *newBuffer, *newMemory, 0);
+	if (result != VK_SUCCESS)
+		return false;
+
+	result = vkMapMemory(vulkanDevice->GetDevice(), *newMemory, 0, VK_WHOLE_SIZE, 0, (void**)newMappedData);
+	if (result != VK_SUCCESS)
+		return false;
+
+	return true;
+}
+
+void UniformRing::DestroyBuffer(VkBuffer oldBuffer, VkDeviceMemory oldMemory, unsigned char * oldMappedData)
+{
+	if (oldMappedData != NULL)
+		vkUnmapMemory(vulkanDevice->GetDevice(), oldMemory);
+	vkFreeMemory(vulkanDevice->GetDevice(), oldMemory, VK_NULL_HANDLE);
+	vkDestroyBuffer(vulkanDevice->GetDevice(), oldBuffer, VK_NULL_HANDLE);
+}
+
+bool UniformRing::Resize(VkDeviceSize newFrameSize, uint32_t newSlotCount)
+{
+	VkDeviceSize newSliceSize = newFrameSize + slotSize * newSlotCount;
+
+	VkBuffer newBuffer;
+	VkDeviceMemory newMemory;
+	unsigned char * newMappedData;
+	if (!CreateBuffer(GetBufferSize(newSliceSize), &newBuffer, &newMemory, &newMappedData))
+	{
+		DestroyBuffer(newBuffer, newMemory, newMappedData);
+		gLogManager->AddMessage("ERROR: Failed to grow the uniform ring!");
+		return false;
+	}
+
+	// Nothing may still read the old buffer. Data written so far keeps its place inside its part of the slice, the
+	// dynamic offsets handed out before are invalid now.
+	vkDeviceWaitIdle(vulkanDevice->GetDevice());
+
+	for (uint32_t i = 0; i < UNIFORM_RING_FRAME_COUNT; i++)
+	{
+		memcpy(newMappedData + i * newSliceSize, mappedData + i * sliceSize, (size_t)frameSize);
+		memcpy(newMappedData + i * newSliceSize + newFrameSize, mappedData + i * sliceSize + frameSize, (size_t)(slotSize * slotRuns.size()));
+	}
+
+	DestroyBuffer(buffer, memory, mappedData);
+
+	buffer = newBuffer;
+	memory = newMemory;
+	mappedData = newMappedData;
+	frameSize = newFrameSize;
+	sliceSize = newSliceSize;
+	slotRuns.resize(newSlotCount, 0);
+	bufferVersion++;
+
+	return true;
+}
+
+void UniformRing::BeginFrame()
+{
+	// The slice written two frames ago is free again, the frame that read it waited for the deferred pass fence
+	frameIndex = (frameIndex + 1) % UNIFORM_RING_FRAME_COUNT;
+	frameOffset = 0;
+	overflowReported = false;
+}
+
+bool UniformRing::Reserve(VkDeviceSize size)
+{
+	VkDeviceSize requiredSize = frameOffset + size;
+	if (requiredSize <= frameSize)
+		return true;
+
+	// Doubling keeps the number of resizes low while the scene grows
+	VkDeviceSize newFrameSize = frameSize;
+	while (newFrameSize < requiredSize)
+		newFrameSize *= 2;
+
+	return Resize(newFrameSize, (uint32_t)slotRuns.size());
+}
+
+VkDeviceSize UniformRing::GetAllocationSize(size_t dataSize)
+{
+	return (dataSize + alignment - 1) & ~(alignment - 1);
+}
+
+bool UniformRing::Allocate(const void * data, size_t dataSize, uint32_t * dynamicOffset)
+{
+	// Every allocation is a multiple of the alignment, so the offsets handed out stay aligned
+	VkDeviceSize alignedSize = GetAllocationSize(dataSize);
+	VkDeviceSize allocationOffset = frameOffset.fetch_add(alignedSize);
+	if (allocationOffset + dataSize > frameSize)
+	{
+		if (!overflowReported.exchange(true))
+			gLogManager->AddMessage("ERROR: Uniform ring allocation wasn't reserved!");
+		return false;
+	}
+
+	VkDeviceSize offset = frameIndex * sliceSize + allocationOffset;
+	memcpy(mappedData + offset, data, dataSize);
+
+	*dynamicOffset = (uint32_t)offset;
+
+	return true;
+}
+
+bool UniformRing::AllocateSlot(size_t dataSize, uint32_t * slot)
+{
+	// Objects are created while loading only, a first fit search over the slots is fast enough for that
+	if (dataSize > UNIFORM_RING_STORAGE_RANGE)
+	{
+		gLogManager->AddMessage("ERROR: Uniform ring slot is larger than the descriptor range!");
+		*slot = UNIFORM_RING_NO_SLOT;
+		return false;
+	}
+
+	uint32_t runLength = (uint32_t)((dataSize + slotSize - 1) / slotSize);
+	uint32_t freeCount = 0;
+	for (uint32_t i = 0; i < slotRuns.size(); i++)
+	{
+		if (slotRuns[i] != 0)
+		{
+			i += slotRuns[i] - 1;
+			freeCount = 0;
+			continue;
+		}
+
+		freeCount++;
+		if (freeCount == runLength)
+		{
+			*slot = i + 1 - runLength;
+			slotRuns[*slot] = runLength;
+			return true;
+		}
+	}
+
+	// No free run is long enough, the slots grow and the run continues the free slots at the end
+	uint32_t slotCount = (uint32_t)slotRuns.size();
+	uint32_t newSlotCount = slotCount * 2;
+	if (newSlotCount < slotCount + runLength)
+		newSlotCount = slotCount + runLength;
+
+	if (!Resize(frameSize, newSlotCount))
+	{
+		*slot = UNIFORM_RING_NO_SLOT;
+		return false;
+	}
+
+	*slot = slotCount - freeCount;
+	slotRuns[*slot] = runLength;
+
+	return true;
+}
+
+void UniformRing::FreeSlot(uint32_t slot)
+{
+	if (slot < slotRuns.size())
+		slotRuns[slot] = 0;
+}
+
+bool UniformRing::Write(uint32_t slot, const void * data, size_t dataSize, uint32_t * dynamicOffset)
+{
+	if (slot == UNIFORM_RING_NO_SLOT)
+		return false;
+
+	// Anything past the run of the slot belongs to the next slots or the next slice
+	if (slot >= slotRuns.size() || dataSize > slotRuns[slot] * slotSize)
+	{
+		gLogManager->AddMessage("ERROR: Uniform ring write doesn't fit its slot!");
+		return false;
+	}
+
+	// Every slice has its own copy of the slot, the one the GPU may still be reading is left alone
+	VkDeviceSize offset = frameIndex * sliceSize + frameSize + slot * slotSize;
+	memcpy(mappedData + offset, data, dataSize);
+
+	*dynamicOffset = (uint32_t)offset;
+
+	return true;
+}
+
+uint32_t UniformRing::GetFrameIndex()
+{
+	return frameIndex;
+}
+
+uint32_t UniformRing::GetBufferVersion()
+{
+	return bufferVersion;
+}
+
+VkDescriptorBufferInfo UniformRing::GetBufferInfo(VkDescriptorType descriptorType)
+{
+	// The real position of the data comes with the dynamic offset when the set is bound
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = (descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC ? UNIFORM_RING_STORAGE_RANGE : UNIFORM_RING_UNIFORM_RANGE);
+
+	return bufferInfo;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: UniformRing.h                                        |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <vector>
+#include <atomic>
+
+#include "VulkanDevice.h"
+
+// One slice per frame the GPU can still be reading, the deferred pass waits for its fence every frame
+#define UNIFORM_RING_FRAME_COUNT 2
+// Starting sizes, both parts of the slices grow to what the scene actually uses
+#define UNIFORM_RING_FRAME_SIZE (64 * 1024)
+// Persistent slots after the per frame data of every slice, objects write to the same offsets every frame
+#define UNIFORM_RING_SLOT_SIZE 256
+#define UNIFORM_RING_SLOT_COUNT 1024
+#define UNIFORM_RING_NO_SLOT 0xFFFFFFFF
+// Ranges of the ring descriptors in the frame sets of the pipelines, they don't depend on what is bound at the offset.
+// The uniform range is the smallest maxUniformBufferRange a device may have.
+#define UNIFORM_RING_UNIFORM_RANGE (16 * 1024)
+#define UNIFORM_RING_STORAGE_RANGE (1024 * 1024)
+
+// Growing replaces the buffer, so it only happens on the render thread outside of recording. The frame sets written
+// with an older buffer version have to be written again.
+class UniformRing
+{
+	private:
+		VulkanDevice * vulkanDevice;
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		unsigned char * mappedData;
+		VkDeviceSize frameSize;
+		VkDeviceSize sliceSize;
+		VkDeviceSize slotSize;
+		VkDeviceSize alignment;
+		uint32_t frameIndex;
+		uint32_t bufferVersion;
+		// Draws are recorded on several threads, they allocate from the same slice
+		std::atomic<VkDeviceSize> frameOffset;
+		std::atomic<bool> overflowReported;
+		// Slot count of the run starting at each slot, 0 if the slot is free
+		std::vector<uint32_t> slotRuns;
+	private:
+		VkDeviceSize GetBufferSize(VkDeviceSize sliceSize);
+		bool CreateBuffer(VkDeviceSize size, VkBuffer * newBuffer, VkDeviceMemory * newMemory, unsigned char ** newMappedData);
+		void DestroyBuffer(VkBuffer oldBuffer, VkDeviceMemory oldMemory, unsigned char * oldMappedData);
+		bool Resize(VkDeviceSize newFrameSize, uint32_t newSlotCount);
+	public:
+		UniformRing();
+		~UniformRing();
+
+		bool Init(VulkanDevice * vulkanDevice, VkDeviceSize frameSize, uint32_t slotCount);
+		void Unload(VulkanDevice * vulkanDevice);
+		void BeginFrame();
+		// Makes sure this many bytes can still be allocated this frame, every allocation has to be reserved first
+		bool Reserve(VkDeviceSize size);
+		VkDeviceSize GetAllocationSize(size_t dataSize);
+		bool Allocate(const void * data, size_t dataSize, uint32_t * dynamicOffset);
+		bool AllocateSlot(size_t dataSize, uint32_t * slot);
+		void FreeSlot(uint32_t slot);
+		bool Write(uint32_t slot, const void * data, size_t dataSize, uint32_t * dynamicOffset);
+		uint32_t GetFrameIndex();
+		uint32_t GetBufferVersion();
+		VkDescriptorBufferInfo GetBufferInfo(VkDescriptorType descriptorType);
+};
\ No newline at end of file
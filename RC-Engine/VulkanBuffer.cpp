@@ -14,13 +14,15 @@ VulkanBuffer::VulkanBuffer()
 {
 	buffer = VK_NULL_HANDLE;
 	memory = VK_NULL_HANDLE;
+	memReq.size = 0;
+	mappedData = NULL;
+	stagedBuffer = false;
 }
 
 bool VulkanBuffer::Init(VulkanDevice * vulkanDevice, VkBufferUsageFlags usage, const void * dataPtr,
-	VkDeviceSize dataSize, bool useStaging, VulkanCommandBuffer * cmdBuffer)
+	VkDeviceSize dataSize, bool useStaging, StagingManager * stagingManager)
 {
 	VkResult result;
-	uint8_t *pData;
 	VkMemoryAllocateInfo allocInfo{};
 
 	stagedBuffer = useStaging;
@@ -49,13 +51,11 @@ bool VulkanBuffer::Init(VulkanDevice * vulkanDevice, VkBufferUsageFlags usage, c
 		if (result != VK_SUCCESS)
 			return false;
 
-		result = vkMapMemory(vulkanDevice->GetDevice(), memory, 0, memReq.size, 0, (void**)&pData);
+		result = vkMapMemory(vulkanDevice->GetDevice(), memory, 0, memReq.size, 0, (void**)&mappedData);
 		if (result != VK_SUCCESS)
 			return false;
 
-		memcpy(pData, dataPtr, (size_t)dataSize);
-
-		vkUnmapMemory(vulkanDevice->GetDevice(), memory);
+		memcpy(mappedData, dataPtr, (size_t)dataSize);
 
 		result = vkBindBufferMemory(vulkanDevice->GetDevice(), buffer, memory, 0);
 		if (result != VK_SUCCESS)
@@ -67,50 +67,24 @@ bool VulkanBuffer::Init(VulkanDevice * vulkanDevice, VkBufferUsageFlags usage, c
 	}
 	else
 	{
-		if (cmdBuffer == NULL)
+		if (stagingManager == NULL)
 		{
-			gLogManager->AddMessage("ERROR: Staged buffer creation requires a valid command buffer!");
+			gLogManager->AddMessage("ERROR: Staged buffer creation requires a staging manager!");
 			return false;
 		}
 
 		VkBufferCreateInfo bufferCI{};
 		bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		bufferCI.size = dataSize;
-		result = vkCreateBuffer(vulkanDevice->GetDevice(), &bufferCI, VK_NULL_HANDLE, &stagingBuffer);
-		if (result != VK_SUCCESS)
-			return false;
-
-		vkGetBufferMemoryRequirements(vulkanDevice->GetDevice(), stagingBuffer, &memReq);
-
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memReq.size;
-		if (!vulkanDevice->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &allocInfo.memoryTypeIndex))
-			return false;
-
-		result = vkAllocateMemory(vulkanDevice->GetDevice(), &allocInfo, VK_NULL_HANDLE, &stagingMemory);
-		if (result != VK_SUCCESS)
-			return false;
-
-		result = vkMapMemory(vulkanDevice->GetDevice(), stagingMemory, 0, memReq.size, 0, (void**)&pData);
-		if (result != VK_SUCCESS)
-			return false;
-
-		memcpy(pData, dataPtr, (size_t)dataSize);
-
-		vkUnmapMemory(vulkanDevice->GetDevice(), stagingMemory);
-
-		result = vkBindBufferMemory(vulkanDevice->GetDevice(), stagingBuffer, stagingMemory, 0);
-		if (result != VK_SUCCESS)
-			return false;
-
 		bufferCI.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferCI.size = dataSize;
+		bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		result = vkCreateBuffer(vulkanDevice->GetDevice(), &bufferCI, VK_NULL_HANDLE, &buffer);
 		if (result != VK_SUCCESS)
 			return false;
 
 		vkGetBufferMemoryRequirements(vulkanDevice->GetDevice(), buffer, &memReq);
 
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		allocInfo.allocationSize = memReq.size;
 		if (!vulkanDevice->MemoryTypeFromProperties(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &allocInfo.memoryTypeIndex))
 			return false;
@@ -123,9 +97,22 @@ bool VulkanBuffer::Init(VulkanDevice * vulkanDevice, VkBufferUsageFlags usage, c
 		if (result != VK_SUCCESS)
 			return false;
 
+		// Data goes through the shared staging buffer, the copy is submitted with the next flush
+		VkDeviceSize stagingOffset;
+		unsigned char * stagingData = stagingManager->Allocate(vulkanDevice, dataSize, 16, &stagingOffset);
+		if (stagingData == NULL)
+			return false;
+
+		memcpy(stagingData, dataPtr, (size_t)dataSize);
+
 		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = stagingOffset;
 		copyRegion.size = dataSize;
-		vkCmdCopyBuffer(cmdBuffer->GetCommandBuffer(), stagingBuffer, buffer, 1, &copyRegion);
+		vkCmdCopyBuffer(stagingManager->GetCommandBuffer()->GetCommandBuffer(), stagingManager->GetBuffer(), buffer, 1, &copyRegion);
+
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = dataSize;
 	}
 
 	return true;
@@ -139,22 +126,18 @@ void VulkanBuffer::Update(VulkanDevice * vulkanDevice, const void * dataPtr, siz
 		return;
 	}
 
-	uint8_t * pData;
-
-	vkMapMemory(vulkanDevice->GetDevice(), memory, 0, memReq.size, 0, (void**)&pData);
-
-	memcpy(pData, dataPtr, dataSize);
-
-	vkUnmapMemory(vulkanDevice->GetDevice(), memory);
+	// Coherent memory, the write is visible to the next submit without a flush
+	memcpy(mappedData, dataPtr, dataSize);
 }
 
 void VulkanBuffer::Unload(VulkanDevice * vulkanDevice)
 {
-	if (stagedBuffer)
+	if (mappedData != NULL)
 	{
-		vkFreeMemory(vulkanDevice->GetDevice(), stagingMemory, VK_NULL_HANDLE);
-		vkDestroyBuffer(vulkanDevice->GetDevice(), stagingBuffer, VK_NULL_HANDLE);
+		vkUnmapMemory(vulkanDevice->GetDevice(), memory);
+		mappedData = NULL;
 	}
+
 	vkFreeMemory(vulkanDevice->GetDevice(), memory, VK_NULL_HANDLE);
 	vkDestroyBuffer(vulkanDevice->GetDevice(), buffer, VK_NULL_HANDLE);
 }
@@ -168,3 +151,8 @@ VkDescriptorBufferInfo * VulkanBuffer::GetBufferInfo()
 {
 	return &bufferInfo;
 }
+
+VkDeviceSize VulkanBuffer::GetMemorySize()
+{
+	return memReq.size;
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include "VulkanDevice.h"
 #include "VulkanCommandBuffer.h"
+#include "StagingManager.h"
 
 #pragma once
 
@@ -17,17 +18,17 @@ class VulkanBuffer
 		VkDeviceMemory memory;
 		VkDescriptorBufferInfo bufferInfo;
 		VkMemoryRequirements memReq;
+		// Host visible buffers stay mapped for their whole lifetime
+		uint8_t * mappedData;
 		bool stagedBuffer;
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingMemory;
 	public:
 		VulkanBuffer();
 
 		bool Init(VulkanDevice * vulkanDevice, VkBufferUsageFlags usage, const void * dataPtr,
-			VkDeviceSize dataSize, bool useStaging, VulkanCommandBuffer * cmdBuffer = NULL);
+			VkDeviceSize dataSize, bool useStaging, StagingManager * stagingManager = NULL);
 		void Update(VulkanDevice * vulkanDevice, const void * dataPtr, size_t dataSize);
 		void Unload(VulkanDevice * vulkanDevice);
 		VkBuffer * GetBuffer();
 		VkDescriptorBufferInfo * GetBufferInfo();
+		VkDeviceSize GetMemorySize();
 };
\ No newline at end of file
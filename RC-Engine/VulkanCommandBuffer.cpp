@@ -140,6 +140,14 @@ void VulkanCommandBuffer::ExecuteSecondary(VulkanCommandBuffer * primaryCmdBuffe
 		gLogManager->AddMessage("WARNING: Used ExecuteSecondary on primary command buffer!");
 }
 
+void VulkanCommandBuffer::ExecuteSecondaries(std::vector<VkCommandBuffer> & secondaryCmdBuffers)
+{
+	if (!primary)
+		gLogManager->AddMessage("WARNING: Used ExecuteSecondaries on secondary command buffer!");
+	else if (!secondaryCmdBuffers.empty())
+		vkCmdExecuteCommands(commandBuffer, (uint32_t)secondaryCmdBuffers.size(), secondaryCmdBuffers.data());
+}
+
 VkCommandBuffer VulkanCommandBuffer::GetCommandBuffer()
 {
 	return commandBuffer;
@@ -6,6 +6,8 @@
 ==========================================================================================*/
 #pragma once
 
+#include <vector>
+
 #include "VulkanDevice.h"
 #include "VulkanCommandPool.h"
 
@@ -26,5 +28,6 @@ class VulkanCommandBuffer
 		void EndRecording();
 		void Execute(VulkanDevice * device, VkPipelineStageFlags flags, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, bool waitFence);
 		void ExecuteSecondary(VulkanCommandBuffer * primaryCmdBuffer);
+		void ExecuteSecondaries(std::vector<VkCommandBuffer> & secondaryCmdBuffers);
 		VkCommandBuffer GetCommandBuffer();
 };
\ No newline at end of file
@@ -14,6 +14,7 @@ VulkanDevice::VulkanDevice()
 {
 	device = VK_NULL_HANDLE;
 	surface = VK_NULL_HANDLE;
+	textureCompressionBC = false;
 }
 
 VulkanDevice::~VulkanDevice()
@@ -125,6 +126,12 @@ bool VulkanDevice::Init(VulkanInstance * vulkanInstance, HWND hwnd)
 	deviceFeatures.shaderTessellationAndGeometryPointSize = VK_TRUE;
 	deviceFeatures.fillModeNonSolid = VK_TRUE;
 
+	// Block compressed textures are transcoded on load when the GPU can't sample them
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(gpu, &supportedFeatures);
+	textureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
 	// Device
 	VkDeviceCreateInfo deviceCI{};
 	deviceCI.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -206,4 +213,16 @@ bool VulkanDevice::MemoryTypeFromProperties(uint32_t typeBits, VkFlags reqMask,
 		typeBits >>= 1;
 	}
 	return false;
+}
+
+bool VulkanDevice::IsTextureFormatSupported(VkFormat textureFormat)
+{
+	if (textureFormat >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && textureFormat <= VK_FORMAT_BC7_SRGB_BLOCK && !textureCompressionBC)
+		return false;
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(gpu, textureFormat, &formatProperties);
+
+	VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
 }
\ No newline at end of file
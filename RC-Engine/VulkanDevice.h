@@ -27,6 +27,7 @@ class VulkanDevice
 		VkQueue deviceQueue;
 		VkDevice device;
 		std::vector<const char*> deviceExtensions;
+		bool textureCompressionBC;
 	public:
 		VulkanDevice();
 		~VulkanDevice();
@@ -35,6 +36,7 @@ class VulkanDevice
 		void Unload(VulkanInstance * vulkanInstance);
 		void AddDeviceExtension(const char * deviceExtensionName);
 		bool MemoryTypeFromProperties(uint32_t typeBits, VkFlags reqMask, uint32_t * typeIndex);
+		bool IsTextureFormatSupported(VkFormat textureFormat);
 		VkDevice GetDevice();
 		VkPhysicalDevice GetGPU();
 		VkQueue GetQueue();
@@ -5,7 +5,10 @@
 |                             Author: Ruscris2                                           |
 ==========================================================================================*/
 
+#include <fstream>
+
 #include "VulkanInterface.h"
+#include "MappedFile.h"
 #include "LogManager.h"
 #include "Settings.h"
 #include "StdInc.h"
@@ -29,6 +32,8 @@ VulkanInterface::VulkanInterface()
 	albedoAtt = NULL;
 	materialAtt = NULL;
 	depthAtt = NULL;
+
+	pipelineCache = VK_NULL_HANDLE;
 }
 
 VulkanInterface::~VulkanInterface()
@@ -36,6 +41,7 @@ VulkanInterface::~VulkanInterface()
 #if VULKAN_DEBUG_MODE_ENABLED
 		UnloadVulkanDebugMode();
 #endif
+	SavePipelineCache();
 	vkDestroyPipelineCache(vulkanDevice->GetDevice(), pipelineCache, VK_NULL_HANDLE);
 
 	vkDestroySemaphore(vulkanDevice->GetDevice(), drawCompleteSemaphore, VK_NULL_HANDLE);
@@ -192,12 +198,11 @@ bool VulkanInterface::Init(HWND hwnd)
 	vkCreateSemaphore(vulkanDevice->GetDevice(), &semaphoreCI, VK_NULL_HANDLE, &drawCompleteSemaphore);
 
 	// Pipeline cache
-	VkPipelineCacheCreateInfo pipelineCacheCI{};
-	pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-	pipelineCacheCI.pNext = NULL;
-	VkResult result = vkCreatePipelineCache(vulkanDevice->GetDevice(), &pipelineCacheCI, VK_NULL_HANDLE, &pipelineCache);
-	if (result != VK_SUCCESS)
+	if (!InitPipelineCache())
+	{
+		gLogManager->AddMessage("ERROR: Failed to create pipeline cache!");
 		return false;
+	}
 
 	return true;
 }
@@ -557,6 +562,8 @@ bool VulkanInterface::InitColorSampler()
 
 void VulkanInterface::InitViewportAndScissors(VulkanCommandBuffer * commandBuffer, float vWidth, float vHeight, uint32_t sWidth, uint32_t sHeight)
 {
+	// Draws are recorded on several threads at once, nothing here may be kept in the interface
+	VkViewport viewport;
 	viewport.width = vWidth;
 	viewport.height = vHeight;
 	viewport.minDepth = 0.0f;
@@ -565,6 +572,7 @@ void VulkanInterface::InitViewportAndScissors(VulkanCommandBuffer * commandBuffe
 	viewport.y = 0;
 	vkCmdSetViewport(commandBuffer->GetCommandBuffer(), 0, 1, &viewport);
 
+	VkRect2D scissor;
 	scissor.extent.width = sWidth;
 	scissor.extent.height = sHeight;
 	scissor.offset.x = 0;
@@ -616,3 +624,147 @@ void VulkanInterface::InitViewportAndScissors(VulkanCommandBuffer * commandBuffe
 		debugReport = VK_NULL_HANDLE;
 	}
 #endif
+
+
+bool VulkanInterface::InitPipelineCache()
+{
+	VkPipelineCacheCreateInfo pipelineCacheCI{};
+	pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCI.pNext = NULL;
+
+	// Reuse the cache saved by the previous run if it was made by the same device and driver
+	MappedFile cacheFile;
+	if (cacheFile.Init(PIPELINE_CACHE_FILENAME, false))
+	{
+		if (ValidatePipelineCacheFile(cacheFile.GetData(), cacheFile.GetSize()))
+		{
+			pipelineCacheCI.initialDataSize = cacheFile.GetSize() - sizeof(PipelineCacheFileHeader);
+			pipelineCacheCI.pInitialData = cacheFile.GetData() + sizeof(PipelineCacheFileHeader);
+		}
+		else
+			gLogManager->AddMessage("WARNING: Discarding stale or corrupted pipeline cache!");
+	}
+
+	VkResult result = vkCreatePipelineCache(vulkanDevice->GetDevice(), &pipelineCacheCI, VK_NULL_HANDLE, &pipelineCache);
+	if (result != VK_SUCCESS && pipelineCacheCI.initialDataSize > 0)
+	{
+		// The driver can still reject data it doesn't like, start with an empty cache in that case
+		pipelineCacheCI.initialDataSize = 0;
+		pipelineCacheCI.pInitialData = NULL;
+		result = vkCreatePipelineCache(vulkanDevice->GetDevice(), &pipelineCacheCI, VK_NULL_HANDLE, &pipelineCache);
+	}
+
+	if (result != VK_SUCCESS)
+		return false;
+
+	if (pipelineCacheCI.initialDataSize > 0)
+		gLogManager->AddMessage("SUCCESS: Loaded pipeline cache!");
+
+	return true;
+}
+
+bool VulkanInterface::ValidatePipelineCacheFile(const unsigned char * fileData, size_t fileSize)
+{
+	if (fileSize < sizeof(PipelineCacheFileHeader))
+		return false;
+
+	const PipelineCacheFileHeader * fileHeader = (const PipelineCacheFileHeader*)fileData;
+	VkPhysicalDeviceProperties gpuProperties = vulkanDevice->GetGPUProperties();
+
+	if (fileHeader->magic != PIPELINE_CACHE_MAGIC || fileHeader->version != PIPELINE_CACHE_VERSION)
+		return false;
+
+	if (fileHeader->vendorID != gpuProperties.vendorID || fileHeader->deviceID != gpuProperties.deviceID ||
+		fileHeader->driverVersion != gpuProperties.driverVersion ||
+		memcmp(fileHeader->pipelineCacheUUID, gpuProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return false;
+
+	if (fileHeader->dataSize != fileSize - sizeof(PipelineCacheFileHeader))
+		return false;
+
+	const unsigned char * cacheData = fileData + sizeof(PipelineCacheFileHeader);
+	if (fileHeader->dataChecksum != ChecksumPipelineCacheData(cacheData, fileHeader->dataSize))
+		return false;
+
+	// The data has to start with a valid Vulkan pipeline cache header for the same device
+	struct
+	{
+		uint32_t headerSize;
+		uint32_t headerVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+	} cacheHeader;
+
+	if (fileHeader->dataSize < sizeof(cacheHeader))
+		return false;
+
+	memcpy(&cacheHeader, cacheData, sizeof(cacheHeader));
+	if (cacheHeader.headerSize < sizeof(cacheHeader) || cacheHeader.headerSize > fileHeader->dataSize ||
+		cacheHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		cacheHeader.vendorID != gpuProperties.vendorID || cacheHeader.deviceID != gpuProperties.deviceID ||
+		memcmp(cacheHeader.pipelineCacheUUID, gpuProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		return false;
+
+	return true;
+}
+
+void VulkanInterface::SavePipelineCache()
+{
+	if (pipelineCache == VK_NULL_HANDLE)
+		return;
+
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(vulkanDevice->GetDevice(), pipelineCache, &dataSize, NULL) != VK_SUCCESS || dataSize == 0)
+		return;
+
+	std::vector<unsigned char> data(sizeof(PipelineCacheFileHeader) + dataSize);
+	if (vkGetPipelineCacheData(vulkanDevice->GetDevice(), pipelineCache, &dataSize, data.data() + sizeof(PipelineCacheFileHeader)) != VK_SUCCESS)
+		return;
+
+	VkPhysicalDeviceProperties gpuProperties = vulkanDevice->GetGPUProperties();
+
+	PipelineCacheFileHeader fileHeader;
+	fileHeader.magic = PIPELINE_CACHE_MAGIC;
+	fileHeader.version = PIPELINE_CACHE_VERSION;
+	fileHeader.vendorID = gpuProperties.vendorID;
+	fileHeader.deviceID = gpuProperties.deviceID;
+	fileHeader.driverVersion = gpuProperties.driverVersion;
+	memcpy(fileHeader.pipelineCacheUUID, gpuProperties.pipelineCacheUUID, VK_UUID_SIZE);
+	fileHeader.dataSize = (uint32_t)dataSize;
+	fileHeader.dataChecksum = ChecksumPipelineCacheData(data.data() + sizeof(PipelineCacheFileHeader), dataSize);
+	memcpy(data.data(), &fileHeader, sizeof(PipelineCacheFileHeader));
+
+	// Write to a temporary file first, so a crash while saving can't leave a half written cache behind
+	std::string tempFilename = std::string(PIPELINE_CACHE_FILENAME) + ".tmp";
+
+	std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+	if (file.is_open() == false)
+	{
+		gLogManager->AddMessage("WARNING: Failed to save pipeline cache!");
+		return;
+	}
+
+	file.write((const char*)data.data(), sizeof(PipelineCacheFileHeader) + dataSize);
+	bool writeFailed = file.fail();
+	file.close();
+
+	if (writeFailed || !MoveFileEx(tempFilename.c_str(), PIPELINE_CACHE_FILENAME, MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFile(tempFilename.c_str());
+		gLogManager->AddMessage("WARNING: Failed to save pipeline cache!");
+	}
+}
+
+// 32-bit FNV-1a
+uint32_t VulkanInterface::ChecksumPipelineCacheData(const unsigned char * data, size_t size)
+{
+	uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
\ No newline at end of file
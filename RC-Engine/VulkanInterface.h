@@ -10,6 +10,10 @@
 
 #define VK_USE_PLATFORM_WIN32_KHR
 
+#define PIPELINE_CACHE_FILENAME "pipeline.cache"
+#define PIPELINE_CACHE_MAGIC 0x43505243
+#define PIPELINE_CACHE_VERSION 1
+
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm.hpp>
@@ -42,9 +46,6 @@ class VulkanInterface
 		VulkanRenderpass * forwardRenderPass;
 		VulkanRenderpass * deferredRenderPass;
 
-		VkViewport viewport;
-		VkRect2D scissor;
-
 		VkSampler colorSampler;
 		VkFramebuffer deferredFramebuffer;
 
@@ -58,6 +59,18 @@ class VulkanInterface
 		VkSemaphore imageReadySemaphore;
 		VkSemaphore drawCompleteSemaphore;
 
+		struct PipelineCacheFileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint32_t dataSize;
+			uint32_t dataChecksum;
+		};
+
 		VkPipelineCache pipelineCache;
 #if VULKAN_DEBUG_MODE_ENABLED
 		VkDebugReportCallbackEXT debugReport;
@@ -66,6 +79,10 @@ class VulkanInterface
 		bool InitDepthBuffer();
 		bool InitColorSampler();
 		bool InitDeferredFramebuffer();
+		bool InitPipelineCache();
+		void SavePipelineCache();
+		bool ValidatePipelineCacheFile(const unsigned char * fileData, size_t fileSize);
+		uint32_t ChecksumPipelineCacheData(const unsigned char * data, size_t size);
 	
 #if VULKAN_DEBUG_MODE_ENABLED
 		bool InitVulkanDebugMode();
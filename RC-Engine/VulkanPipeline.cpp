@@ -6,6 +6,9 @@
 ==========================================================================================*/
 
 #include "VulkanPipeline.h"
+#include "UniformRing.h"
+
+extern UniformRing * gUniformRing;
 
 VulkanPipeline::VulkanPipeline()
 {
@@ -13,10 +16,19 @@ VulkanPipeline::VulkanPipeline()
 	pipelineLayout = VK_NULL_HANDLE;
 	pipeline = VK_NULL_HANDLE;
 	descriptorPool = VK_NULL_HANDLE;
+	descriptorSet = VK_NULL_HANDLE;
+	frameDescriptorLayout = VK_NULL_HANDLE;
+	frameDescriptorPool = VK_NULL_HANDLE;
+	frameDescriptorSet = VK_NULL_HANDLE;
+	frameSetRingVersion = 0;
 }
 
 VulkanPipeline::~VulkanPipeline()
 {
+	frameDescriptorSet = VK_NULL_HANDLE;
+	frameDescriptorPool = VK_NULL_HANDLE;
+	frameDescriptorLayout = VK_NULL_HANDLE;
+	descriptorSet = VK_NULL_HANDLE;
 	descriptorPool = VK_NULL_HANDLE;
 	descriptorLayout = VK_NULL_HANDLE;
 	pipelineLayout = VK_NULL_HANDLE;
@@ -44,37 +56,88 @@ bool VulkanPipeline::Init(VulkanInterface * vulkan, VulkanPipelineCI * pipelineC
 	if (result != VK_SUCCESS)
 		return false;
 
+	VkDescriptorSetLayout setLayouts[2] = { descriptorLayout, VK_NULL_HANDLE };
+	if (pipelineCI->numFrameLayoutBindings > 0)
+	{
+		VkDescriptorSetLayoutCreateInfo frameLayoutCI{};
+		frameLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		frameLayoutCI.bindingCount = pipelineCI->numFrameLayoutBindings;
+		frameLayoutCI.pBindings = pipelineCI->frameLayoutBindings;
+
+		result = vkCreateDescriptorSetLayout(vulkan->GetVulkanDevice()->GetDevice(), &frameLayoutCI, VK_NULL_HANDLE, &frameDescriptorLayout);
+		if (result != VK_SUCCESS)
+			return false;
+
+		setLayouts[1] = frameDescriptorLayout;
+	}
+
 	VkPipelineLayoutCreateInfo pipelineLayoutCI{};
 	pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutCI.setLayoutCount = 1;
-	pipelineLayoutCI.pSetLayouts = &descriptorLayout;
+	pipelineLayoutCI.setLayoutCount = (frameDescriptorLayout != VK_NULL_HANDLE ? 2 : 1);
+	pipelineLayoutCI.pSetLayouts = setLayouts;
 
 	result = vkCreatePipelineLayout(vulkan->GetVulkanDevice()->GetDevice(), &pipelineLayoutCI, VK_NULL_HANDLE, &pipelineLayout);
 	if (result != VK_SUCCESS)
 		return false;
 
-	
-	// Descriptor pool
-	VkDescriptorPoolCreateInfo descriptorPoolCI{};
-	descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descriptorPoolCI.maxSets = 1;
-	descriptorPoolCI.poolSizeCount = pipelineCI->numLayoutBindings;
-	descriptorPoolCI.pPoolSizes = pipelineCI->typeCounts;
-
-	result = vkCreateDescriptorPool(vulkan->GetVulkanDevice()->GetDevice(), &descriptorPoolCI, VK_NULL_HANDLE, &descriptorPool);
-	if (result != VK_SUCCESS)
-		return false;
+	// Descriptor pool, set 0 may be empty when everything the shaders read comes from the uniform ring
+	if (pipelineCI->numLayoutBindings > 0)
+	{
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolCI.maxSets = 1;
+		descriptorPoolCI.poolSizeCount = pipelineCI->numLayoutBindings;
+		descriptorPoolCI.pPoolSizes = pipelineCI->typeCounts;
+
+		result = vkCreateDescriptorPool(vulkan->GetVulkanDevice()->GetDevice(), &descriptorPoolCI, VK_NULL_HANDLE, &descriptorPool);
+		if (result != VK_SUCCESS)
+			return false;
+
+		// Descriptor set
+		VkDescriptorSetAllocateInfo descSetAllocInfo[1];
+		descSetAllocInfo[0].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descSetAllocInfo[0].pNext = NULL;
+		descSetAllocInfo[0].descriptorPool = descriptorPool;
+		descSetAllocInfo[0].descriptorSetCount = 1;
+		descSetAllocInfo[0].pSetLayouts = &descriptorLayout;
+		result = vkAllocateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), descSetAllocInfo, &descriptorSet);
+		if (result != VK_SUCCESS)
+			return false;
+	}
 
-	// Descriptor set
-	VkDescriptorSetAllocateInfo descSetAllocInfo[1];
-	descSetAllocInfo[0].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descSetAllocInfo[0].pNext = NULL;
-	descSetAllocInfo[0].descriptorPool = descriptorPool;
-	descSetAllocInfo[0].descriptorSetCount = 1;
-	descSetAllocInfo[0].pSetLayouts = &descriptorLayout;
-	result = vkAllocateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), descSetAllocInfo, &descriptorSet);
-	if (result != VK_SUCCESS)
-		return false;
+	// Frame set
+	if (frameDescriptorLayout != VK_NULL_HANDLE)
+	{
+		VkDescriptorPoolCreateInfo framePoolCI{};
+		framePoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		framePoolCI.maxSets = 1;
+		framePoolCI.poolSizeCount = pipelineCI->numFrameLayoutBindings;
+		framePoolCI.pPoolSizes = pipelineCI->frameTypeCounts;
+
+		result = vkCreateDescriptorPool(vulkan->GetVulkanDevice()->GetDevice(), &framePoolCI, VK_NULL_HANDLE, &frameDescriptorPool);
+		if (result != VK_SUCCESS)
+			return false;
+
+		VkDescriptorSetAllocateInfo frameSetAllocInfo{};
+		frameSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		frameSetAllocInfo.descriptorPool = frameDescriptorPool;
+		frameSetAllocInfo.descriptorSetCount = 1;
+		frameSetAllocInfo.pSetLayouts = &frameDescriptorLayout;
+		result = vkAllocateDescriptorSets(vulkan->GetVulkanDevice()->GetDevice(), &frameSetAllocInfo, &frameDescriptorSet);
+		if (result != VK_SUCCESS)
+			return false;
+
+		frameBindings.assign(pipelineCI->frameLayoutBindings, pipelineCI->frameLayoutBindings + pipelineCI->numFrameLayoutBindings);
+		WriteFrameSet(vulkan->GetVulkanDevice());
+	}
+
+	// Pool sizes for the sets allocated later on
+	for (uint32_t i = 0; i < pipelineCI->numLayoutBindings; i++)
+	{
+		VkDescriptorPoolSize poolSize = pipelineCI->typeCounts[i];
+		poolSize.descriptorCount *= PIPELINE_DESCRIPTOR_POOL_SETS;
+		setPoolSizes.push_back(poolSize);
+	}
 
 	// Pipeline
 	VkDynamicState dynamicStateEnables[VK_DYNAMIC_STATE_RANGE_SIZE];
@@ -235,17 +298,134 @@ bool VulkanPipeline::Init(VulkanInterface * vulkan, VulkanPipelineCI * pipelineC
 
 void VulkanPipeline::Unload(VulkanDevice * vulkanDevice)
 {
-	vkDestroyDescriptorPool(vulkanDevice->GetDevice(), descriptorPool, VK_NULL_HANDLE);
+	for (size_t i = 0; i < setPools.size(); i++)
+		vkDestroyDescriptorPool(vulkanDevice->GetDevice(), setPools[i].pool, VK_NULL_HANDLE);
+	setPools.clear();
+	setPoolIndices.clear();
+
+	if (frameDescriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(vulkanDevice->GetDevice(), frameDescriptorPool, VK_NULL_HANDLE);
+	if (frameDescriptorLayout != VK_NULL_HANDLE)
+		vkDestroyDescriptorSetLayout(vulkanDevice->GetDevice(), frameDescriptorLayout, VK_NULL_HANDLE);
+	if (descriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(vulkanDevice->GetDevice(), descriptorPool, VK_NULL_HANDLE);
 	vkDestroyPipelineLayout(vulkanDevice->GetDevice(), pipelineLayout, VK_NULL_HANDLE);
 	vkDestroyDescriptorSetLayout(vulkanDevice->GetDevice(), descriptorLayout, VK_NULL_HANDLE);
 	vkDestroyPipeline(vulkanDevice->GetDevice(), pipeline, VK_NULL_HANDLE);
 }
 
-void VulkanPipeline::SetActive(VulkanCommandBuffer * commandBuffer)
+void VulkanPipeline::SetActive(VulkanCommandBuffer * commandBuffer, uint32_t dynamicOffsetCount, const uint32_t * dynamicOffsets)
+{
+	vkCmdBindPipeline(commandBuffer->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	BindDescriptorSets(commandBuffer, descriptorSet, dynamicOffsetCount, dynamicOffsets);
+}
+
+void VulkanPipeline::SetActive(VulkanCommandBuffer * commandBuffer, VkDescriptorSet set, uint32_t dynamicOffsetCount, const uint32_t * dynamicOffsets)
 {
 	vkCmdBindPipeline(commandBuffer->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	BindDescriptorSets(commandBuffer, set, dynamicOffsetCount, dynamicOffsets);
+}
+
+void VulkanPipeline::BindDescriptorSets(VulkanCommandBuffer * commandBuffer, VkDescriptorSet set, uint32_t dynamicOffsetCount,
+	const uint32_t * dynamicOffsets)
+{
+	// Set 0 has no dynamic bindings, so all of the offsets belong to the frame set
+	VkDescriptorSet sets[2] = { set, frameDescriptorSet };
+	uint32_t firstSet = (set != VK_NULL_HANDLE ? 0 : 1);
+	uint32_t setCount = (frameDescriptorSet != VK_NULL_HANDLE ? 2 : 1) - firstSet;
+	if (setCount == 0)
+		return;
+
 	vkCmdBindDescriptorSets(commandBuffer->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS,
-		pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+		pipelineLayout, firstSet, setCount, &sets[firstSet], dynamicOffsetCount, dynamicOffsets);
+}
+
+void VulkanPipeline::UpdateFrameSet(VulkanDevice * vulkanDevice)
+{
+	// Draws recorded with the old contents are recorded again, the draw command caches check the ring version as well
+	if (frameDescriptorSet != VK_NULL_HANDLE && frameSetRingVersion != gUniformRing->GetBufferVersion())
+		WriteFrameSet(vulkanDevice);
+}
+
+void VulkanPipeline::WriteFrameSet(VulkanDevice * vulkanDevice)
+{
+	std::vector<VkDescriptorBufferInfo> bufferInfos(frameBindings.size());
+	std::vector<VkWriteDescriptorSet> descriptorWrites(frameBindings.size());
+	for (size_t i = 0; i < frameBindings.size(); i++)
+	{
+		bufferInfos[i] = gUniformRing->GetBufferInfo(frameBindings[i].descriptorType);
+
+		descriptorWrites[i] = {};
+		descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[i].pNext = NULL;
+		descriptorWrites[i].dstSet = frameDescriptorSet;
+		descriptorWrites[i].descriptorCount = 1;
+		descriptorWrites[i].descriptorType = frameBindings[i].descriptorType;
+		descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+		descriptorWrites[i].dstArrayElement = 0;
+		descriptorWrites[i].dstBinding = frameBindings[i].binding;
+	}
+
+	vkUpdateDescriptorSets(vulkanDevice->GetDevice(), (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, NULL);
+	frameSetRingVersion = gUniformRing->GetBufferVersion();
+}
+
+bool VulkanPipeline::AllocateDescriptorSet(VulkanDevice * vulkanDevice, VkDescriptorSet * set)
+{
+	VkResult result;
+
+	std::lock_guard<std::mutex> lock(setPoolMutex);
+
+	// Sets of one layout never fragment a pool, so a pool that isn't full always has room for one more
+	size_t poolIndex = 0;
+	while (poolIndex < setPools.size() && setPools[poolIndex].allocatedCount == PIPELINE_DESCRIPTOR_POOL_SETS)
+		poolIndex++;
+
+	if (poolIndex == setPools.size())
+	{
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolCI.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+		descriptorPoolCI.maxSets = PIPELINE_DESCRIPTOR_POOL_SETS;
+		descriptorPoolCI.poolSizeCount = (uint32_t)setPoolSizes.size();
+		descriptorPoolCI.pPoolSizes = setPoolSizes.data();
+
+		SetPool setPool;
+		setPool.allocatedCount = 0;
+		result = vkCreateDescriptorPool(vulkanDevice->GetDevice(), &descriptorPoolCI, VK_NULL_HANDLE, &setPool.pool);
+		if (result != VK_SUCCESS)
+			return false;
+
+		setPools.push_back(setPool);
+	}
+
+	VkDescriptorSetAllocateInfo descSetAllocInfo{};
+	descSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descSetAllocInfo.descriptorPool = setPools[poolIndex].pool;
+	descSetAllocInfo.descriptorSetCount = 1;
+	descSetAllocInfo.pSetLayouts = &descriptorLayout;
+	result = vkAllocateDescriptorSets(vulkanDevice->GetDevice(), &descSetAllocInfo, set);
+	if (result != VK_SUCCESS)
+		return false;
+
+	setPools[poolIndex].allocatedCount++;
+	setPoolIndices[*set] = poolIndex;
+
+	return true;
+}
+
+void VulkanPipeline::FreeDescriptorSet(VulkanDevice * vulkanDevice, VkDescriptorSet set)
+{
+	std::lock_guard<std::mutex> lock(setPoolMutex);
+
+	auto it = setPoolIndices.find(set);
+	if (it == setPoolIndices.end())
+		return;
+
+	SetPool & setPool = setPools[it->second];
+	vkFreeDescriptorSets(vulkanDevice->GetDevice(), setPool.pool, 1, &set);
+	setPool.allocatedCount--;
+	setPoolIndices.erase(it);
 }
 
 VkDescriptorSet VulkanPipeline::GetDescriptorSet()
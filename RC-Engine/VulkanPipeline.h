@@ -6,9 +6,15 @@
 ==========================================================================================*/
 #pragma once
 
+#include <unordered_map>
+#include <mutex>
+
 #include "VulkanInterface.h"
 #include "Shader.h"
 
+// Descriptor sets handed out by a pipeline come from pools of this many sets
+#define PIPELINE_DESCRIPTOR_POOL_SETS 64
+
 struct VulkanPipelineCI
 {
 	std::string pipelineName;
@@ -20,6 +26,10 @@ struct VulkanPipelineCI
 	uint32_t numLayoutBindings;
 	size_t strideSize;
 	VkDescriptorPoolSize * typeCounts;
+	// Uniform ring buffers bound with dynamic offsets, they go to set 1 which the pipeline writes itself
+	VkDescriptorSetLayoutBinding * frameLayoutBindings;
+	uint32_t numFrameLayoutBindings;
+	VkDescriptorPoolSize * frameTypeCounts;
 	int numColorAttachments;
 	bool wireframeEnabled;
 	VkCullModeFlags cullMode;
@@ -37,14 +47,44 @@ class VulkanPipeline
 		VkDescriptorSet descriptorSet;
 		VkPipeline pipeline;
 
+		// Set 1 holds every uniform ring buffer of the pipeline. Only the dynamic offsets change between draws, the set
+		// itself is written again when the ring gets a new buffer.
+		VkDescriptorSetLayout frameDescriptorLayout;
+		VkDescriptorPool frameDescriptorPool;
+		VkDescriptorSet frameDescriptorSet;
+		std::vector<VkDescriptorSetLayoutBinding> frameBindings;
+		uint32_t frameSetRingVersion;
+
+		// Pools for the sets that objects keep for themselves, another one is added when all of them are full. Objects
+		// drawn on different recording threads allocate from the same pools.
+		struct SetPool
+		{
+			VkDescriptorPool pool;
+			uint32_t allocatedCount;
+		};
+		std::vector<SetPool> setPools;
+		std::vector<VkDescriptorPoolSize> setPoolSizes;
+		std::unordered_map<VkDescriptorSet, size_t> setPoolIndices;
+		std::mutex setPoolMutex;
+
 		std::string pipelineName;
+	private:
+		void WriteFrameSet(VulkanDevice * vulkanDevice);
+		void BindDescriptorSets(VulkanCommandBuffer * commandBuffer, VkDescriptorSet set, uint32_t dynamicOffsetCount, const uint32_t * dynamicOffsets);
 	public:
 		VulkanPipeline();
 		~VulkanPipeline();
 
 		bool Init(VulkanInterface * vulkan, VulkanPipelineCI * pipelineCI);
 		void Unload(VulkanDevice * vulkanDevice);
-		void SetActive(VulkanCommandBuffer * commandBuffer);
+		// Dynamic offsets go in binding order, one for each binding of the frame set. Pipelines without per object
+		// bindings draw with VK_NULL_HANDLE as set.
+		void SetActive(VulkanCommandBuffer * commandBuffer, uint32_t dynamicOffsetCount = 0, const uint32_t * dynamicOffsets = NULL);
+		void SetActive(VulkanCommandBuffer * commandBuffer, VkDescriptorSet set, uint32_t dynamicOffsetCount, const uint32_t * dynamicOffsets);
+		// Only called on the render thread outside of recording, like the ring growing itself
+		void UpdateFrameSet(VulkanDevice * vulkanDevice);
+		bool AllocateDescriptorSet(VulkanDevice * vulkanDevice, VkDescriptorSet * set);
+		void FreeDescriptorSet(VulkanDevice * vulkanDevice, VkDescriptorSet set);
 		VkDescriptorSet GetDescriptorSet();
 		VkDescriptorSetLayout * GetDescriptorLayout();
 		VkPipelineLayout GetPipelineLayout();
@@ -8,8 +8,10 @@
 #include "WireframeModel.h"
 #include "StdInc.h"
 #include "Settings.h"
+#include "StagingManager.h"
 
 extern Settings * gSettings;
+extern StagingManager * gStagingManager;
 
 WireframeModel::WireframeModel()
 {
@@ -31,7 +33,6 @@ WireframeModel::~WireframeModel()
 bool WireframeModel::Init(VulkanInterface * vulkan, GEOMETRY_GENERATE_INFO generateInfo, glm::vec4 color)
 {
 	VulkanDevice * vulkanDevice = vulkan->GetVulkanDevice();
-	VulkanCommandPool * cmdPool = vulkan->GetVulkanCommandPool();
 
 	Vertex * vertexData;
 	uint32_t * indexData;
@@ -320,30 +321,18 @@ bool WireframeModel::Init(VulkanInterface * vulkan, GEOMETRY_GENERATE_INFO gener
 		vertexData[i].a = color.a;
 	}
 
-	// Command buffer used for creating buffers
-	VulkanCommandBuffer * cmdBuffer = new VulkanCommandBuffer();
-	if (!cmdBuffer->Init(vulkanDevice, cmdPool, true))
-		return false;
-
-	cmdBuffer->BeginRecording();
-
 	// Vertex buffer
 	vertexBuffer = new VulkanBuffer();
 	if (!vertexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexData,
-		sizeof(Vertex) * vertexCount, true, cmdBuffer))
+		sizeof(Vertex) * vertexCount, true, gStagingManager))
 		return false;
 
 	// Index buffer
 	indexBuffer = new VulkanBuffer();
 	if (!indexBuffer->Init(vulkanDevice, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexData,
-		sizeof(uint32_t) * indexCount, true, cmdBuffer))
+		sizeof(uint32_t) * indexCount, true, gStagingManager))
 		return false;
 
-	cmdBuffer->EndRecording();
-	cmdBuffer->Execute(vulkanDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, true);
-
-	SAFE_UNLOAD(cmdBuffer, vulkanDevice, cmdPool);
-
 	delete[] vertexData;
 	delete[] indexData;
 
@@ -0,0 +1,115 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: XXHash.cpp                                           |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <string.h>
+
+#include "XXHash.h"
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t RotateLeft(uint64_t value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const unsigned char * ptr)
+{
+	uint64_t value;
+	memcpy(&value, ptr, sizeof(uint64_t));
+	return value;
+}
+
+static inline uint32_t Read32(const unsigned char * ptr)
+{
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(uint32_t));
+	return value;
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input)
+{
+	acc += input * XXH_PRIME64_2;
+	acc = RotateLeft(acc, 31);
+	return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, uint64_t value)
+{
+	acc ^= Round(0, value);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t XXHash::Hash64(const void * data, size_t size, uint64_t seed)
+{
+	const unsigned char * ptr = (const unsigned char*)data;
+	const unsigned char * end = ptr + size;
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		// Four independent lanes over 32 byte stripes
+		uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = seed + XXH_PRIME64_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - XXH_PRIME64_1;
+
+		const unsigned char * limit = end - 32;
+		do
+		{
+			v1 = Round(v1, Read64(ptr));
+			v2 = Round(v2, Read64(ptr + 8));
+			v3 = Round(v3, Read64(ptr + 16));
+			v4 = Round(v4, Read64(ptr + 24));
+			ptr += 32;
+		} while (ptr <= limit);
+
+		hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		hash = MergeRound(hash, v1);
+		hash = MergeRound(hash, v2);
+		hash = MergeRound(hash, v3);
+		hash = MergeRound(hash, v4);
+	}
+	else
+		hash = seed + XXH_PRIME64_5;
+
+	hash += (uint64_t)size;
+
+	// Remaining tail
+	while (ptr + 8 <= end)
+	{
+		hash ^= Round(0, Read64(ptr));
+		hash = RotateLeft(hash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		ptr += 8;
+	}
+
+	if (ptr + 4 <= end)
+	{
+		hash ^= (uint64_t)Read32(ptr) * XXH_PRIME64_1;
+		hash = RotateLeft(hash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		ptr += 4;
+	}
+
+	while (ptr < end)
+	{
+		hash ^= (*ptr) * XXH_PRIME64_5;
+		hash = RotateLeft(hash, 11) * XXH_PRIME64_1;
+		ptr++;
+	}
+
+	// Final avalanche
+	hash ^= hash >> 33;
+	hash *= XXH_PRIME64_2;
+	hash ^= hash >> 29;
+	hash *= XXH_PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
\ No newline at end of file
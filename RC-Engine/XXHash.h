@@ -0,0 +1,16 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Engine                                         |
+|                             File: XXHash.h                                             |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Implementation of the 64-bit xxHash, produces the same values as the reference XXH64
+namespace XXHash
+{
+	uint64_t Hash64(const void * data, size_t size, uint64_t seed = 0);
+}
\ No newline at end of file
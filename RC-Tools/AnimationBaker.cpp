@@ -0,0 +1,261 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: AnimationBaker.cpp                                   |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "AnimationBaker.h"
+#include "FileUtils.h"
+#include "../RC-Engine/MeshFormat.h"
+
+AnimationBaker::AnimationBaker()
+{
+	boneCount = 0;
+	animation = NULL;
+}
+
+AnimationBaker::~AnimationBaker()
+{
+	animation = NULL;
+}
+
+bool AnimationBaker::LoadSkin(std::string skinFile)
+{
+	std::vector<unsigned char> data;
+	if (!FileUtils::ReadFile(skinFile, data))
+	{
+		printf("ERROR: Failed to read %s\n", skinFile.c_str());
+		return false;
+	}
+
+	size_t offset = 0;
+	auto read = [&](void * dst, size_t size)
+	{
+		if (offset + size > data.size())
+			return false;
+		if (dst != NULL)
+			memcpy(dst, &data[offset], size);
+		offset += size;
+		return true;
+	};
+
+	uint32_t flags;
+	size_t headerSize;
+	if (!ReadMeshHeader(data.data(), data.size(), flags, headerSize))
+	{
+		printf("ERROR: %s has an unknown version\n", skinFile.c_str());
+		return false;
+	}
+	size_t vertexSize = GetMeshVertexSize(flags, true);
+	offset = headerSize;
+
+	// Skip mesh data, bone offsets and bone names follow it
+	uint32_t meshCount;
+	if (!read(&meshCount, sizeof(uint32_t)))
+		return false;
+
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		uint32_t vertexCount, indexCount;
+		if (!read(&vertexCount, sizeof(uint32_t)) || !read(&indexCount, sizeof(uint32_t)) ||
+			!read(NULL, (size_t)vertexCount * vertexSize + GetMeshIndexDataSize(flags, vertexCount, indexCount) + 128))
+		{
+			printf("ERROR: %s is corrupted\n", skinFile.c_str());
+			return false;
+		}
+	}
+
+	if (!read(&boneCount, sizeof(uint32_t)) || !read(NULL, sizeof(float) * 16 * boneCount))
+	{
+		printf("ERROR: %s is corrupted\n", skinFile.c_str());
+		return false;
+	}
+
+	boneMapping.clear();
+	for (uint32_t i = 0; i < boneCount; i++)
+	{
+		uint32_t nameSize, boneIndex;
+		if (!read(&nameSize, sizeof(uint32_t)) || offset + nameSize > data.size())
+		{
+			printf("ERROR: %s is corrupted\n", skinFile.c_str());
+			return false;
+		}
+
+		std::string name((const char*)&data[offset], nameSize);
+		offset += nameSize;
+
+		if (!read(&boneIndex, sizeof(uint32_t)) || boneIndex >= boneCount)
+		{
+			printf("ERROR: %s is corrupted\n", skinFile.c_str());
+			return false;
+		}
+
+		boneMapping[name] = (int32_t)boneIndex;
+	}
+
+	return true;
+}
+
+bool AnimationBaker::MarkUsedNodes(const aiNode * node)
+{
+	bool used = boneMapping.find(node->mName.data) != boneMapping.end();
+	for (uint32_t i = 0; i < node->mNumChildren; i++)
+	{
+		if (MarkUsedNodes(node->mChildren[i]))
+			used = true;
+	}
+
+	if (used)
+		usedNodes.insert(node);
+
+	return used;
+}
+
+void AnimationBaker::AddNode(const aiNode * node, int32_t parent)
+{
+	if (usedNodes.find(node) == usedNodes.end())
+		return;
+
+	std::string nodeName = node->mName.data;
+
+	RCAnimNode bakedNode;
+	bakedNode.parent = parent;
+	bakedNode.boneIndex = boneMapping.find(nodeName) != boneMapping.end() ? boneMapping[nodeName] : -1;
+	bakedNode.channelIndex = AddChannel(nodeName);
+	StoreMatrix(node->mTransformation, bakedNode.transform);
+
+	int32_t nodeIndex = (int32_t)nodes.size();
+	nodes.push_back(bakedNode);
+
+	for (uint32_t i = 0; i < node->mNumChildren; i++)
+		AddNode(node->mChildren[i], nodeIndex);
+}
+
+int32_t AnimationBaker::AddChannel(std::string nodeName)
+{
+	const aiNodeAnim * nodeAnim = NULL;
+	for (uint32_t i = 0; i < animation->mNumChannels; i++)
+	{
+		if (std::string(animation->mChannels[i]->mNodeName.data) == nodeName)
+		{
+			nodeAnim = animation->mChannels[i];
+			break;
+		}
+	}
+
+	if (nodeAnim == NULL || nodeAnim->mNumPositionKeys == 0 || nodeAnim->mNumRotationKeys == 0 || nodeAnim->mNumScalingKeys == 0)
+		return -1;
+
+	RCAnimChannel channel;
+	channel.firstPositionKey = (uint32_t)positionKeys.size();
+	channel.positionKeyCount = nodeAnim->mNumPositionKeys;
+	channel.firstRotationKey = (uint32_t)rotationKeys.size();
+	channel.rotationKeyCount = nodeAnim->mNumRotationKeys;
+	channel.firstScaleKey = (uint32_t)scaleKeys.size();
+	channel.scaleKeyCount = nodeAnim->mNumScalingKeys;
+
+	for (uint32_t i = 0; i < nodeAnim->mNumPositionKeys; i++)
+	{
+		const aiVectorKey & key = nodeAnim->mPositionKeys[i];
+		RCAnimVectorKey bakedKey = { (float)key.mTime, key.mValue.x, key.mValue.y, key.mValue.z };
+		positionKeys.push_back(bakedKey);
+	}
+
+	for (uint32_t i = 0; i < nodeAnim->mNumRotationKeys; i++)
+	{
+		const aiQuatKey & key = nodeAnim->mRotationKeys[i];
+		RCAnimQuatKey bakedKey = { (float)key.mTime, key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w };
+		rotationKeys.push_back(bakedKey);
+	}
+
+	for (uint32_t i = 0; i < nodeAnim->mNumScalingKeys; i++)
+	{
+		const aiVectorKey & key = nodeAnim->mScalingKeys[i];
+		RCAnimVectorKey bakedKey = { (float)key.mTime, key.mValue.x, key.mValue.y, key.mValue.z };
+		scaleKeys.push_back(bakedKey);
+	}
+
+	channels.push_back(channel);
+	return (int32_t)channels.size() - 1;
+}
+
+void AnimationBaker::StoreMatrix(const aiMatrix4x4 & matrix, float * dst)
+{
+	// Assimp matrices are row major, the engine expects column major
+	for (int column = 0; column < 4; column++)
+		for (int row = 0; row < 4; row++)
+			dst[column * 4 + row] = matrix[row][column];
+}
+
+bool AnimationBaker::Bake(std::string animFile, std::string outputFile)
+{
+	// Same post processing the engine used when it imported clips at runtime
+	Assimp::Importer importer;
+	const aiScene * scene = importer.ReadFile(animFile, aiProcess_MakeLeftHanded | aiProcess_FlipWindingOrder);
+	if (scene == NULL || scene->mNumAnimations == 0)
+	{
+		printf("ERROR: Failed to read animation %s (%s)\n", animFile.c_str(), importer.GetErrorString());
+		return false;
+	}
+
+	animation = scene->mAnimations[0];
+	usedNodes.clear();
+	nodes.clear();
+	channels.clear();
+	positionKeys.clear();
+	rotationKeys.clear();
+	scaleKeys.clear();
+
+	MarkUsedNodes(scene->mRootNode);
+	AddNode(scene->mRootNode, -1);
+
+	if (nodes.empty())
+	{
+		printf("ERROR: %s doesn't animate any bone of the skin\n", animFile.c_str());
+		return false;
+	}
+
+	RCAnimHeader header;
+	memset(&header, 0, sizeof(RCAnimHeader));
+	header.magic = RCA_MAGIC;
+	header.version = RCA_VERSION;
+	header.duration = (float)animation->mDuration;
+	header.ticksPerSecond = (float)(animation->mTicksPerSecond != 0 ? animation->mTicksPerSecond : 25.0f);
+	header.boneCount = boneCount;
+	header.nodeCount = (uint32_t)nodes.size();
+	header.channelCount = (uint32_t)channels.size();
+	header.positionKeyCount = (uint32_t)positionKeys.size();
+	header.rotationKeyCount = (uint32_t)rotationKeys.size();
+	header.scaleKeyCount = (uint32_t)scaleKeys.size();
+
+	aiMatrix4x4 globalInverseTransform = scene->mRootNode->mTransformation;
+	globalInverseTransform.Inverse();
+	StoreMatrix(globalInverseTransform, header.globalInverseTransform);
+
+	std::vector<unsigned char> data;
+	auto append = [&](const void * src, size_t size)
+	{
+		data.insert(data.end(), (const unsigned char*)src, (const unsigned char*)src + size);
+	};
+
+	append(&header, sizeof(RCAnimHeader));
+	append(nodes.data(), nodes.size() * sizeof(RCAnimNode));
+	append(channels.data(), channels.size() * sizeof(RCAnimChannel));
+	append(positionKeys.data(), positionKeys.size() * sizeof(RCAnimVectorKey));
+	append(rotationKeys.data(), rotationKeys.size() * sizeof(RCAnimQuatKey));
+	append(scaleKeys.data(), scaleKeys.size() * sizeof(RCAnimVectorKey));
+
+	if (!FileUtils::WriteFile(outputFile, data.data(), data.size()))
+	{
+		printf("ERROR: Failed to write %s\n", outputFile.c_str());
+		return false;
+	}
+
+	printf("Baked %s (%u nodes, %u channels) into %s\n", animFile.c_str(), header.nodeCount, header.channelCount, outputFile.c_str());
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: AnimationBaker.h                                     |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "../RC-Engine/AnimationClipFormat.h"
+
+class AnimationBaker
+{
+	private:
+		std::map<std::string, int32_t> boneMapping;
+		uint32_t boneCount;
+
+		const aiAnimation * animation;
+		std::set<const aiNode*> usedNodes;
+		std::vector<RCAnimNode> nodes;
+		std::vector<RCAnimChannel> channels;
+		std::vector<RCAnimVectorKey> positionKeys;
+		std::vector<RCAnimQuatKey> rotationKeys;
+		std::vector<RCAnimVectorKey> scaleKeys;
+	private:
+		bool MarkUsedNodes(const aiNode * node);
+		void AddNode(const aiNode * node, int32_t parent);
+		int32_t AddChannel(std::string nodeName);
+		void StoreMatrix(const aiMatrix4x4 & matrix, float * dst);
+	public:
+		AnimationBaker();
+		~AnimationBaker();
+
+		bool LoadSkin(std::string skinFile);
+		bool Bake(std::string animFile, std::string outputFile);
+};
\ No newline at end of file
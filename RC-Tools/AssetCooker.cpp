@@ -0,0 +1,310 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: AssetCooker.cpp                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <thread>
+#include <fstream>
+#include <sstream>
+
+#include "AssetCooker.h"
+#include "FileUtils.h"
+#include "ModelImporter.h"
+#include "MeshCooker.h"
+#include "CollisionCooker.h"
+#include "TextureCooker.h"
+#include "../RC-Engine/XXHash.h"
+#include "../RC-Engine/MeshFormat.h"
+
+static bool IsModelSource(std::string extension)
+{
+	return extension == ".fbx" || extension == ".obj" || extension == ".gltf" || extension == ".glb" || extension == ".dae";
+}
+
+// Files the model importer reads next to the model, they only count for its hash and aren't copied
+static bool IsCompanionFile(std::string extension)
+{
+	return extension == ".mtl" || extension == ".bin";
+}
+
+AssetCooker::AssetCooker()
+{
+	nextJob = 0;
+}
+
+AssetCooker::~AssetCooker()
+{
+}
+
+void AssetCooker::ReadCache()
+{
+	cache.clear();
+
+	// One line per asset: hash, source path and the files cooked from it, separated by tabs
+	std::ifstream file(cacheFile);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string hash, sourcePath, outputFile;
+		if (!std::getline(fields, hash, '\t') || !std::getline(fields, sourcePath, '\t'))
+			continue;
+
+		CacheEntry & entry = cache[sourcePath];
+		entry.hash = strtoull(hash.c_str(), NULL, 16);
+		while (std::getline(fields, outputFile, '\t'))
+			entry.outputFiles.push_back(outputFile);
+	}
+}
+
+bool AssetCooker::WriteCache()
+{
+	std::string data;
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		if (!jobs[i].succeeded)
+			continue;
+
+		char hash[17];
+		snprintf(hash, sizeof(hash), "%016" PRIx64, jobs[i].hash);
+
+		data += std::string(hash) + "\t" + jobs[i].sourcePath;
+		for (size_t j = 0; j < jobs[i].outputFiles.size(); j++)
+			data += "\t" + jobs[i].outputFiles[j];
+		data += "\n";
+	}
+
+	return FileUtils::WriteFile(cacheFile, data.data(), data.size());
+}
+
+bool AssetCooker::IsUpToDate(const CookJob & job)
+{
+	std::map<std::string, CacheEntry>::const_iterator it = cache.find(job.sourcePath);
+	if (it == cache.end() || it->second.hash != job.hash)
+		return false;
+
+	// Cooked files deleted since the last run have to be cooked again
+	for (size_t i = 0; i < it->second.outputFiles.size(); i++)
+	{
+		if (!FileUtils::FileExists(dataDir + "/" + it->second.outputFiles[i]))
+			return false;
+	}
+
+	return true;
+}
+
+bool AssetCooker::CookAsset(CookJob & job)
+{
+	std::string sourceFile = sourceDir + "/" + job.sourcePath;
+	std::string outputFile = dataDir + "/" + job.sourcePath;
+	std::string extension = FileUtils::GetExtension(job.sourcePath);
+
+	if (!FileUtils::CreateDirectories(FileUtils::GetParentDirectory(outputFile)))
+	{
+		printf("ERROR: Failed to create the directory of %s\n", outputFile.c_str());
+		return false;
+	}
+
+	std::vector<std::string> outputFiles;
+	if (IsModelSource(extension))
+	{
+		ModelImporter importer;
+		std::vector<std::string> importedFiles;
+		if (!importer.Import(sourceFile, FileUtils::ReplaceExtension(outputFile, ""), importedFiles))
+			return false;
+
+		for (size_t i = 0; i < importedFiles.size(); i++)
+		{
+			std::string importedExtension = FileUtils::GetExtension(importedFiles[i]);
+			if (importedExtension == ".rcm" || importedExtension == ".rcs")
+			{
+				MeshCooker meshCooker;
+				if (!meshCooker.Cook(importedFiles[i], importedFiles[i], importedExtension == ".rcs"))
+					return false;
+			}
+			else if (importedExtension == ".col")
+			{
+				// The engine only loads the cooked collision
+				CollisionCooker collisionCooker;
+				std::string collisionFile = FileUtils::ReplaceExtension(importedFiles[i], ".rcc");
+				bool cooked = collisionCooker.Cook(importedFiles[i], collisionFile);
+				remove(importedFiles[i].c_str());
+				if (!cooked)
+					return false;
+
+				importedFiles[i] = collisionFile;
+			}
+
+			outputFiles.push_back(importedFiles[i]);
+		}
+	}
+	else if (extension == ".rcm" || extension == ".rcs")
+	{
+		MeshCooker meshCooker;
+		if (!meshCooker.Cook(sourceFile, outputFile, extension == ".rcs"))
+			return false;
+
+		outputFiles.push_back(outputFile);
+	}
+	else if (extension == ".rct")
+	{
+		TextureCooker textureCooker;
+		if (!textureCooker.Cook(sourceFile, outputFile, true))
+			return false;
+
+		outputFiles.push_back(outputFile);
+	}
+	else if (extension == ".col")
+	{
+		CollisionCooker collisionCooker;
+		std::string collisionFile = FileUtils::ReplaceExtension(outputFile, ".rcc");
+		if (!collisionCooker.Cook(sourceFile, collisionFile))
+			return false;
+
+		outputFiles.push_back(collisionFile);
+	}
+	else
+	{
+		std::vector<unsigned char> data;
+		if (!FileUtils::ReadFile(sourceFile, data) || !FileUtils::WriteFile(outputFile, data.data(), data.size()))
+		{
+			printf("ERROR: Failed to copy %s\n", sourceFile.c_str());
+			return false;
+		}
+
+		outputFiles.push_back(outputFile);
+	}
+
+	// The cache stores paths relative to the data directory
+	job.outputFiles.clear();
+	for (size_t i = 0; i < outputFiles.size(); i++)
+		job.outputFiles.push_back(outputFiles[i].substr(dataDir.size() + 1));
+
+	return true;
+}
+
+void AssetCooker::WorkerThread()
+{
+	for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+	{
+		CookJob & job = jobs[i];
+
+		// Hashed with the cooker version, so a new cooker cooks everything again
+		std::vector<unsigned char> data;
+		if (!FileUtils::ReadFile(sourceDir + "/" + job.sourcePath, data))
+		{
+			printf("ERROR: Failed to read %s\n", job.sourcePath.c_str());
+			continue;
+		}
+		job.hash = XXHash::Hash64(data.data(), data.size(), ((uint64_t)COOK_VERSION << 32) | RCM_COOKED_VERSION);
+
+		for (size_t j = 0; j < job.companionPaths.size(); j++)
+		{
+			if (FileUtils::ReadFile(sourceDir + "/" + job.companionPaths[j], data))
+				job.hash = XXHash::Hash64(data.data(), data.size(), job.hash);
+		}
+
+		if (IsUpToDate(job))
+		{
+			job.outputFiles = cache.find(job.sourcePath)->second.outputFiles;
+			job.upToDate = true;
+			job.succeeded = true;
+			continue;
+		}
+
+		job.succeeded = CookAsset(job);
+	}
+}
+
+bool AssetCooker::Cook(std::string sourceDir, std::string dataDir, unsigned int threadCount)
+{
+	while (sourceDir.size() > 1 && (sourceDir[sourceDir.size() - 1] == '/' || sourceDir[sourceDir.size() - 1] == '\\'))
+		sourceDir.erase(sourceDir.size() - 1);
+	while (dataDir.size() > 1 && (dataDir[dataDir.size() - 1] == '/' || dataDir[dataDir.size() - 1] == '\\'))
+		dataDir.erase(dataDir.size() - 1);
+
+	this->sourceDir = sourceDir;
+	this->dataDir = dataDir;
+
+	// Kept next to the data directory, so it doesn't end up in the asset archive
+	cacheFile = dataDir + ".cookcache";
+
+	std::vector<std::string> files;
+	if (!FileUtils::ListFiles(sourceDir, files))
+	{
+		printf("ERROR: Failed to list directory %s\n", sourceDir.c_str());
+		return false;
+	}
+
+	if (!FileUtils::CreateDirectories(dataDir))
+	{
+		printf("ERROR: Failed to create directory %s\n", dataDir.c_str());
+		return false;
+	}
+
+	ReadCache();
+
+	jobs.clear();
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (IsCompanionFile(FileUtils::GetExtension(files[i])))
+			continue;
+
+		CookJob job;
+		job.sourcePath = files[i];
+		job.hash = 0;
+		job.upToDate = false;
+		job.succeeded = false;
+
+		if (IsModelSource(FileUtils::GetExtension(files[i])))
+		{
+			std::string baseName = FileUtils::ReplaceExtension(files[i], "");
+			for (size_t j = 0; j < files.size(); j++)
+			{
+				if (IsCompanionFile(FileUtils::GetExtension(files[j])) && FileUtils::ReplaceExtension(files[j], "") == baseName)
+					job.companionPaths.push_back(files[j]);
+			}
+		}
+
+		jobs.push_back(job);
+	}
+
+	// Every asset is independent, the jobs are handed out to one thread per core
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+	if (threadCount > jobs.size())
+		threadCount = jobs.size() > 0 ? (unsigned int)jobs.size() : 1;
+
+	nextJob = 0;
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadCount; i++)
+		threads.push_back(std::thread(&AssetCooker::WorkerThread, this));
+	WorkerThread();
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	unsigned int cookedCount = 0, upToDateCount = 0, failedCount = 0;
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		if (!jobs[i].succeeded)
+			failedCount++;
+		else if (jobs[i].upToDate)
+			upToDateCount++;
+		else
+			cookedCount++;
+	}
+
+	if (!WriteCache())
+		printf("WARNING: Failed to write %s\n", cacheFile.c_str());
+
+	printf("Cooked %u assets on %u threads, %u up to date, %u failed\n", cookedCount, threadCount, upToDateCount, failedCount);
+
+	return failedCount == 0;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: AssetCooker.h                                        |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <stdint.h>
+
+// Bump when anything the cookers write changes, so every asset gets cooked again
+#define COOK_VERSION 2
+
+// Cooks a source tree into a data directory with the same layout, on all cores. Model sources are imported and
+// cooked into .rcm/.rcs, .mat and .rcc, .rcm/.rcs and .col files go through the mesh and collision cookers and
+// everything else is copied. Assets whose content hash didn't change since the last run are skipped.
+class AssetCooker
+{
+	private:
+		struct CookJob
+		{
+			std::string sourcePath;
+			std::vector<std::string> companionPaths;
+			uint64_t hash;
+			std::vector<std::string> outputFiles;
+			bool upToDate;
+			bool succeeded;
+		};
+
+		struct CacheEntry
+		{
+			uint64_t hash;
+			std::vector<std::string> outputFiles;
+		};
+
+		std::string sourceDir;
+		std::string dataDir;
+		std::string cacheFile;
+		std::map<std::string, CacheEntry> cache;
+		std::vector<CookJob> jobs;
+		std::atomic<size_t> nextJob;
+	private:
+		void ReadCache();
+		bool WriteCache();
+		bool IsUpToDate(const CookJob & job);
+		bool CookAsset(CookJob & job);
+		void WorkerThread();
+	public:
+		AssetCooker();
+		~AssetCooker();
+
+		bool Cook(std::string sourceDir, std::string dataDir, unsigned int threadCount);
+};
\ No newline at end of file
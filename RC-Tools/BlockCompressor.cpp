@@ -0,0 +1,270 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: BlockCompressor.cpp                                  |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "BlockCompressor.h"
+
+// Endpoint refinement passes, each solves the endpoints for the indices of the previous one
+#define REFINE_ITERATIONS 2
+
+static const float bc1Weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+// Main direction of the pixels in the first channelCount channels, by power iteration on their covariance
+static void PrincipalAxis(const unsigned char * pixels, int channelCount, float * mean, float * axis)
+{
+	for (int c = 0; c < channelCount; c++)
+	{
+		mean[c] = 0.0f;
+		for (int i = 0; i < 16; i++)
+			mean[c] += pixels[i * 4 + c];
+		mean[c] /= 16.0f;
+	}
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		for (int a = 0; a < channelCount; a++)
+			for (int b = 0; b < channelCount; b++)
+				covariance[a][b] += (pixels[i * 4 + a] - mean[a]) * (pixels[i * 4 + b] - mean[b]);
+	}
+
+	for (int c = 0; c < channelCount; c++)
+		axis[c] = 1.0f;
+
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		for (int a = 0; a < channelCount; a++)
+			for (int b = 0; b < channelCount; b++)
+				next[a] += covariance[a][b] * axis[b];
+
+		float length = 0.0f;
+		for (int c = 0; c < channelCount; c++)
+			length = fmaxf(length, fabsf(next[c]));
+		if (length == 0.0f)
+			break;
+
+		for (int c = 0; c < channelCount; c++)
+			axis[c] = next[c] / length;
+	}
+}
+
+// Endpoints at the ends of the pixels projected on the principal axis
+static void AxisEndpoints(const unsigned char * pixels, int channelCount, float * endpoint0, float * endpoint1)
+{
+	float mean[4], axis[4];
+	PrincipalAxis(pixels, channelCount, mean, axis);
+
+	float minimum = FLT_MAX, maximum = -FLT_MAX;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < channelCount; c++)
+			t += (pixels[i * 4 + c] - mean[c]) * axis[c];
+
+		minimum = fminf(minimum, t);
+		maximum = fmaxf(maximum, t);
+	}
+
+	for (int c = 0; c < channelCount; c++)
+	{
+		endpoint0[c] = fminf(fmaxf(mean[c] + axis[c] * maximum, 0.0f), 255.0f);
+		endpoint1[c] = fminf(fmaxf(mean[c] + axis[c] * minimum, 0.0f), 255.0f);
+	}
+}
+
+// Least squares endpoints for the given weights of endpoint0, keeps the old ones if the system is degenerate
+static void SolveEndpoints(const unsigned char * pixels, int channelCount, const float * weights, float * endpoint0, float * endpoint1)
+{
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[4] = {}, bx[4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float a = weights[i], b = 1.0f - weights[i];
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (int c = 0; c < channelCount; c++)
+		{
+			ax[c] += a * pixels[i * 4 + c];
+			bx[c] += b * pixels[i * 4 + c];
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return;
+
+	for (int c = 0; c < channelCount; c++)
+	{
+		endpoint0[c] = fminf(fmaxf((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), 255.0f);
+		endpoint1[c] = fminf(fmaxf((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), 255.0f);
+	}
+}
+
+static uint16_t Quantize565(const float * color)
+{
+	uint32_t r = (uint32_t)(color[0] * 31.0f / 255.0f + 0.5f);
+	uint32_t g = (uint32_t)(color[1] * 63.0f / 255.0f + 0.5f);
+	uint32_t b = (uint32_t)(color[2] * 31.0f / 255.0f + 0.5f);
+
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void Expand565(uint16_t color, int * rgb)
+{
+	int r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Four color palette of two 565 colors, picks the closest entry for every pixel. Returns the squared error.
+static int ColorIndices(const unsigned char * pixels, uint16_t color0, uint16_t color1, int * indices)
+{
+	int palette[4][3];
+	Expand565(color0, palette[0]);
+	Expand565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+	}
+
+	int totalError = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int bestError = INT32_MAX;
+		for (int j = 0; j < 4; j++)
+		{
+			int error = 0;
+			for (int c = 0; c < 3; c++)
+				error += (pixels[i * 4 + c] - palette[j][c]) * (pixels[i * 4 + c] - palette[j][c]);
+
+			if (error < bestError)
+			{
+				bestError = error;
+				indices[i] = j;
+			}
+		}
+		totalError += bestError;
+	}
+
+	return totalError;
+}
+
+static void EncodeColorBlock(const unsigned char * pixels, unsigned char * block)
+{
+	float endpoint0[4], endpoint1[4];
+	AxisEndpoints(pixels, 3, endpoint0, endpoint1);
+
+	uint16_t bestColor0 = 0, bestColor1 = 0;
+	int bestIndices[16] = {}, bestError = INT32_MAX;
+	for (int iteration = 0; iteration <= REFINE_ITERATIONS; iteration++)
+	{
+		uint16_t color0 = Quantize565(endpoint0), color1 = Quantize565(endpoint1);
+
+		int indices[16];
+		int error = ColorIndices(pixels, color0, color1, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestColor0 = color0;
+			bestColor1 = color1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+
+		float weights[16];
+		for (int i = 0; i < 16; i++)
+			weights[i] = bc1Weights[indices[i]];
+		SolveEndpoints(pixels, 3, weights, endpoint0, endpoint1);
+	}
+
+	// Four color mode needs color0 > color1, swapping the endpoints swaps the palette entries
+	if (bestColor0 < bestColor1)
+	{
+		uint16_t swap = bestColor0;
+		bestColor0 = bestColor1;
+		bestColor1 = swap;
+		for (int i = 0; i < 16; i++)
+			bestIndices[i] ^= 1;
+	}
+	else if (bestColor0 == bestColor1)
+		memset(bestIndices, 0, sizeof(bestIndices));
+
+	block[0] = (unsigned char)(bestColor0 & 0xFF);
+	block[1] = (unsigned char)(bestColor0 >> 8);
+	block[2] = (unsigned char)(bestColor1 & 0xFF);
+	block[3] = (unsigned char)(bestColor1 >> 8);
+	for (int i = 0; i < 4; i++)
+	{
+		block[4 + i] = (unsigned char)(bestIndices[i * 4] | (bestIndices[i * 4 + 1] << 2) | (bestIndices[i * 4 + 2] << 4) |
+			(bestIndices[i * 4 + 3] << 6));
+	}
+}
+
+// BC4 block of one channel of the pixels, in the eight value mode
+static void EncodeChannelBlock(const unsigned char * pixels, int channel, unsigned char * block)
+{
+	int minimum = 255, maximum = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		minimum = pixels[i * 4 + channel] < minimum ? pixels[i * 4 + channel] : minimum;
+		maximum = pixels[i * 4 + channel] > maximum ? pixels[i * 4 + channel] : maximum;
+	}
+
+	int palette[8];
+	palette[0] = maximum;
+	palette[1] = minimum;
+	for (int i = 1; i < 7; i++)
+		palette[i + 1] = ((7 - i) * maximum + i * minimum + 3) / 7;
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 16 && maximum > minimum; i++)
+	{
+		int bestIndex = 0, bestError = INT32_MAX;
+		for (int j = 0; j < 8; j++)
+		{
+			int error = (pixels[i * 4 + channel] - palette[j]) * (pixels[i * 4 + channel] - palette[j]);
+			if (error < bestError)
+			{
+				bestError = error;
+				bestIndex = j;
+			}
+		}
+		indices |= (uint64_t)bestIndex << (i * 3);
+	}
+
+	block[0] = (unsigned char)maximum;
+	block[1] = (unsigned char)minimum;
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+void BlockCompressor::EncodeBC1(const unsigned char * pixels, unsigned char * block)
+{
+	EncodeColorBlock(pixels, block);
+}
+
+void BlockCompressor::EncodeBC3(const unsigned char * pixels, unsigned char * block)
+{
+	EncodeChannelBlock(pixels, 3, block);
+	EncodeColorBlock(pixels, block + 8);
+}
+
+void BlockCompressor::EncodeBC4(const unsigned char * pixels, unsigned char * block)
+{
+	EncodeChannelBlock(pixels, 0, block);
+}
+
+void BlockCompressor::EncodeBC5(const unsigned char * pixels, unsigned char * block)
+{
+	EncodeChannelBlock(pixels, 0, block);
+	EncodeChannelBlock(pixels, 1, block + 8);
+}
\ No newline at end of file
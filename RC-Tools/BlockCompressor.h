@@ -0,0 +1,25 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: BlockCompressor.h                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <stdint.h>
+
+// Block encoders for the .rct formats. Every encoder takes 4x4 RGBA8 pixels, row by row.
+namespace BlockCompressor
+{
+	// Opaque colors, 8 bytes
+	void EncodeBC1(const unsigned char * pixels, unsigned char * block);
+
+	// Colors with alpha, 16 bytes
+	void EncodeBC3(const unsigned char * pixels, unsigned char * block);
+
+	// Red channel, 8 bytes
+	void EncodeBC4(const unsigned char * pixels, unsigned char * block);
+
+	// Red and green channels, 16 bytes
+	void EncodeBC5(const unsigned char * pixels, unsigned char * block);
+}
\ No newline at end of file
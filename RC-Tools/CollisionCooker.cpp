@@ -0,0 +1,164 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: CollisionCooker.cpp                                  |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <btBulletCollisionCommon.h>
+
+#include "CollisionCooker.h"
+#include "FileUtils.h"
+
+CollisionCooker::CollisionCooker()
+{
+}
+
+CollisionCooker::~CollisionCooker()
+{
+}
+
+bool CollisionCooker::ReadTriangleSoup(std::string colFile)
+{
+	std::vector<unsigned char> data;
+	if (!FileUtils::ReadFile(colFile, data))
+	{
+		printf("ERROR: Failed to read %s\n", colFile.c_str());
+		return false;
+	}
+
+	// Legacy .col files are a vertex count followed by three vertices per triangle
+	uint32_t vertexCount;
+	if (data.size() < sizeof(uint32_t))
+	{
+		printf("ERROR: %s is corrupted\n", colFile.c_str());
+		return false;
+	}
+	memcpy(&vertexCount, data.data(), sizeof(uint32_t));
+
+	size_t triangleCount = vertexCount / 3;
+	if (sizeof(uint32_t) + triangleCount * 9 * sizeof(float) > data.size())
+	{
+		printf("ERROR: %s is corrupted\n", colFile.c_str());
+		return false;
+	}
+
+	const float * positions = (const float*)(data.data() + sizeof(uint32_t));
+
+	vertices.clear();
+	indices.clear();
+	vertexMapping.clear();
+
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		int i0 = WeldVertex(positions + i * 9);
+		int i1 = WeldVertex(positions + i * 9 + 3);
+		int i2 = WeldVertex(positions + i * 9 + 6);
+
+		// Triangles that collapse after welding can't be hit by anything
+		if (i0 == i1 || i1 == i2 || i0 == i2)
+			continue;
+
+		indices.push_back(i0);
+		indices.push_back(i1);
+		indices.push_back(i2);
+	}
+
+	return true;
+}
+
+int CollisionCooker::WeldVertex(const float * position)
+{
+	std::vector<float> key(position, position + 3);
+
+	std::map<std::vector<float>, int>::iterator it = vertexMapping.find(key);
+	if (it != vertexMapping.end())
+		return it->second;
+
+	int index = (int)(vertices.size() / 3);
+	vertices.insert(vertices.end(), position, position + 3);
+	vertexMapping[key] = index;
+
+	return index;
+}
+
+bool CollisionCooker::Cook(std::string colFile, std::string outputFile)
+{
+	if (!ReadTriangleSoup(colFile))
+		return false;
+
+	if (indices.empty())
+	{
+		printf("ERROR: %s has no triangles\n", colFile.c_str());
+		return false;
+	}
+
+	btIndexedMesh indexedMesh;
+	indexedMesh.m_numTriangles = (int)(indices.size() / 3);
+	indexedMesh.m_triangleIndexBase = (const unsigned char*)indices.data();
+	indexedMesh.m_triangleIndexStride = sizeof(int) * 3;
+	indexedMesh.m_numVertices = (int)(vertices.size() / 3);
+	indexedMesh.m_vertexBase = (const unsigned char*)vertices.data();
+	indexedMesh.m_vertexStride = sizeof(float) * 3;
+	indexedMesh.m_indexType = PHY_INTEGER;
+	indexedMesh.m_vertexType = PHY_FLOAT;
+
+	btTriangleIndexVertexArray mesh;
+	mesh.addIndexedMesh(indexedMesh, PHY_INTEGER);
+
+	// Same settings the engine uses for static meshes, so the BVH can be used as is
+	btBvhTriangleMeshShape shape(&mesh, true, true);
+	btOptimizedBvh * bvh = shape.getOptimizedBvh();
+
+	unsigned int bvhSize = bvh->calculateSerializeBufferSize();
+	void * bvhData = btAlignedAlloc(bvhSize, RCC_BVH_ALIGNMENT);
+	if (!bvh->serializeInPlace(bvhData, bvhSize, false))
+	{
+		printf("ERROR: Failed to serialize the BVH of %s\n", colFile.c_str());
+		btAlignedFree(bvhData);
+		return false;
+	}
+
+	RCCollisionHeader header;
+	memset(&header, 0, sizeof(RCCollisionHeader));
+	header.magic = RCC_MAGIC;
+	header.version = RCC_VERSION;
+	header.vertexCount = (uint32_t)(vertices.size() / 3);
+	header.triangleCount = (uint32_t)(indices.size() / 3);
+	for (int i = 0; i < 3; i++)
+	{
+		header.aabbMin[i] = shape.getLocalAabbMin()[i];
+		header.aabbMax[i] = shape.getLocalAabbMax()[i];
+	}
+	header.bvhPointerSize = sizeof(void*);
+	header.bvhSize = bvhSize;
+
+	std::vector<unsigned char> data;
+	auto append = [&](const void * src, size_t size)
+	{
+		data.insert(data.end(), (const unsigned char*)src, (const unsigned char*)src + size);
+	};
+
+	append(&header, sizeof(RCCollisionHeader));
+	append(vertices.data(), vertices.size() * sizeof(float));
+	append(indices.data(), indices.size() * sizeof(int));
+
+	data.resize((data.size() + RCC_BVH_ALIGNMENT - 1) & ~(size_t)(RCC_BVH_ALIGNMENT - 1), 0);
+	header.bvhOffset = data.size();
+	memcpy(data.data(), &header, sizeof(RCCollisionHeader));
+
+	append(bvhData, bvhSize);
+	btAlignedFree(bvhData);
+
+	if (!FileUtils::WriteFile(outputFile, data.data(), data.size()))
+	{
+		printf("ERROR: Failed to write %s\n", outputFile.c_str());
+		return false;
+	}
+
+	printf("Cooked %s (%u vertices, %u triangles) into %s\n", colFile.c_str(), header.vertexCount, header.triangleCount, outputFile.c_str());
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: CollisionCooker.h                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../RC-Engine/CollisionFormat.h"
+
+class CollisionCooker
+{
+	private:
+		std::vector<float> vertices;
+		std::vector<int> indices;
+		std::map<std::vector<float>, int> vertexMapping;
+	private:
+		bool ReadTriangleSoup(std::string colFile);
+		int WeldVertex(const float * position);
+	public:
+		CollisionCooker();
+		~CollisionCooker();
+
+		bool Cook(std::string colFile, std::string outputFile);
+};
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: FileUtils.cpp                                        |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "FileUtils.h"
+
+static bool ListFilesRecursive(std::string directory, std::string relativeDir, std::vector<std::string> & files)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATA findData;
+	HANDLE findHandle = FindFirstFile((directory + "/" + relativeDir + "*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	do
+	{
+		std::string name = findData.cFileName;
+		if (name == "." || name == "..")
+			continue;
+
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			ListFilesRecursive(directory, relativeDir + name + "/", files);
+		else
+			files.push_back(relativeDir + name);
+	} while (FindNextFile(findHandle, &findData));
+
+	FindClose(findHandle);
+#else
+	DIR * dir = opendir((directory + "/" + relativeDir).c_str());
+	if (dir == NULL)
+		return false;
+
+	struct dirent * dirEntry;
+	while ((dirEntry = readdir(dir)) != NULL)
+	{
+		std::string name = dirEntry->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+		struct stat fileStat;
+		if (stat((directory + "/" + relativeDir + name).c_str(), &fileStat) != 0)
+			continue;
+
+		if (S_ISDIR(fileStat.st_mode))
+			ListFilesRecursive(directory, relativeDir + name + "/", files);
+		else
+			files.push_back(relativeDir + name);
+	}
+
+	closedir(dir);
+#endif
+
+	return true;
+}
+
+bool FileUtils::ListFiles(std::string directory, std::vector<std::string> & files)
+{
+	return ListFilesRecursive(directory, "", files);
+}
+
+bool FileUtils::ReadFile(std::string filename, std::vector<unsigned char> & data)
+{
+	FILE * file = fopen(filename.c_str(), "rb");
+	if (file == NULL)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	rewind(file);
+
+	data.resize(size);
+	size_t readSize = size > 0 ? fread(data.data(), 1, size, file) : 0;
+
+	fclose(file);
+
+	return readSize == (size_t)size;
+}
+
+bool FileUtils::WriteFile(std::string filename, const void * data, size_t size)
+{
+	FILE * file = fopen(filename.c_str(), "wb");
+	if (file == NULL)
+		return false;
+
+	size_t writtenSize = size > 0 ? fwrite(data, 1, size, file) : 0;
+
+	fclose(file);
+
+	return writtenSize == size;
+}
+
+bool FileUtils::FileExists(std::string filename)
+{
+	struct stat fileStat;
+	return stat(filename.c_str(), &fileStat) == 0;
+}
+
+bool FileUtils::CreateDirectories(std::string directory)
+{
+	if (directory.empty() || directory == "." || FileExists(directory))
+		return true;
+
+	std::string parent = GetParentDirectory(directory);
+	if (parent != directory && !CreateDirectories(parent))
+		return false;
+
+#ifdef _WIN32
+	return CreateDirectory(directory.c_str(), NULL) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	return mkdir(directory.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+std::string FileUtils::GetFileName(std::string path)
+{
+	size_t pos = path.find_last_of("/\\");
+	if (pos == std::string::npos)
+		return path;
+
+	return path.substr(pos + 1);
+}
+
+std::string FileUtils::GetParentDirectory(std::string path)
+{
+	while (!path.empty() && (path[path.size() - 1] == '/' || path[path.size() - 1] == '\\'))
+		path.erase(path.size() - 1);
+
+	size_t pos = path.find_last_of("/\\");
+	if (pos == std::string::npos)
+		return ".";
+
+	return path.substr(0, pos);
+}
+
+std::string FileUtils::GetExtension(std::string path)
+{
+	std::string name = GetFileName(path);
+	size_t pos = name.rfind('.');
+	if (pos == std::string::npos)
+		return "";
+
+	std::string extension = name.substr(pos);
+	for (size_t i = 0; i < extension.size(); i++)
+		extension[i] = (char)tolower(extension[i]);
+
+	return extension;
+}
+
+std::string FileUtils::ReplaceExtension(std::string path, std::string extension)
+{
+	size_t pos = path.rfind('.');
+	if (pos != std::string::npos && pos > path.find_last_of("/\\") + 1)
+		path.erase(pos);
+
+	return path + extension;
+}
\ No newline at end of file
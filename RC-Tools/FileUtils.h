@@ -0,0 +1,23 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: FileUtils.h                                          |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace FileUtils
+{
+	bool ListFiles(std::string directory, std::vector<std::string> & files);
+	bool ReadFile(std::string filename, std::vector<unsigned char> & data);
+	bool WriteFile(std::string filename, const void * data, size_t size);
+	bool FileExists(std::string filename);
+	bool CreateDirectories(std::string directory);
+	std::string GetFileName(std::string path);
+	std::string GetParentDirectory(std::string path);
+	std::string GetExtension(std::string path);
+	std::string ReplaceExtension(std::string path, std::string extension);
+}
\ No newline at end of file
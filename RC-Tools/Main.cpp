@@ -0,0 +1,281 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: Main.cpp                                             |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "PakBuilder.h"
+#include "AnimationBaker.h"
+#include "CollisionCooker.h"
+#include "MapConverter.h"
+#include "MeshCooker.h"
+#include "TextureCooker.h"
+#include "AssetCooker.h"
+#include "FileUtils.h"
+
+static void PrintUsage()
+{
+	printf("Usage:\n");
+	printf("  RC-Tools pack <dataDir> <output.rcpak> [-lz4]\n");
+	printf("  RC-Tools bakeanim <input.fbx|animDir> <skin.rcs> [output.rca]\n");
+	printf("  RC-Tools cookcol <input.col|modelDir> [output.rcc]\n");
+	printf("  RC-Tools convertmap <input.map> <dataRoot> [output.rcmap]\n");
+	printf("  RC-Tools cookmesh <input.rcm|input.rcs|modelDir> [output]\n");
+	printf("  RC-Tools cooktex <input.rct|textureDir> [output] [-uncompressed]\n");
+	printf("  RC-Tools cook <sourceDir> <dataDir> [-j threads]\n");
+}
+
+static int Pack(int argc, char ** argv)
+{
+	if (argc < 4)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	PakBuilder builder;
+	for (int i = 4; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "-lz4")
+			builder.SetCompression(true);
+	}
+
+	if (!builder.AddDirectory(argv[2]))
+		return 1;
+
+	if (!builder.Write(argv[3]))
+		return 1;
+
+	return 0;
+}
+
+static int BakeAnim(int argc, char ** argv)
+{
+	if (argc < 4)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	AnimationBaker baker;
+	if (!baker.LoadSkin(argv[3]))
+		return 1;
+
+	std::string input = argv[2];
+	std::vector<std::string> animFiles;
+
+	// A directory bakes every .fbx clip inside it next to the source file
+	if (FileUtils::ListFiles(input, animFiles))
+	{
+		for (size_t i = 0; i < animFiles.size(); i++)
+		{
+			if (FileUtils::GetExtension(animFiles[i]) != ".fbx")
+				continue;
+
+			std::string animFile = input + "/" + animFiles[i];
+			if (!baker.Bake(animFile, FileUtils::ReplaceExtension(animFile, ".rca")))
+				return 1;
+		}
+
+		return 0;
+	}
+
+	std::string output = argc > 4 ? argv[4] : FileUtils::ReplaceExtension(input, ".rca");
+	if (!baker.Bake(input, output))
+		return 1;
+
+	return 0;
+}
+
+static int CookCol(int argc, char ** argv)
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	CollisionCooker cooker;
+
+	std::string input = argv[2];
+	std::vector<std::string> colFiles;
+
+	// A directory cooks every .col file inside it next to the source file
+	if (FileUtils::ListFiles(input, colFiles))
+	{
+		for (size_t i = 0; i < colFiles.size(); i++)
+		{
+			if (FileUtils::GetExtension(colFiles[i]) != ".col")
+				continue;
+
+			std::string colFile = input + "/" + colFiles[i];
+			if (!cooker.Cook(colFile, FileUtils::ReplaceExtension(colFile, ".rcc")))
+				return 1;
+		}
+
+		return 0;
+	}
+
+	std::string output = argc > 3 ? argv[3] : FileUtils::ReplaceExtension(input, ".rcc");
+	if (!cooker.Cook(input, output))
+		return 1;
+
+	return 0;
+}
+
+static int ConvertMap(int argc, char ** argv)
+{
+	if (argc < 4)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// Asset paths in the map are relative to dataRoot, the same way the engine sees them
+	MapConverter converter;
+	std::string output = argc > 4 ? argv[4] : FileUtils::ReplaceExtension(argv[2], ".rcmap");
+	if (!converter.Convert(argv[2], argv[3], output))
+		return 1;
+
+	return 0;
+}
+
+static int CookMesh(int argc, char ** argv)
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	MeshCooker cooker;
+
+	std::string input = argv[2];
+	std::vector<std::string> meshFiles;
+
+	// A directory cooks every .rcm and .rcs file inside it in place
+	if (FileUtils::ListFiles(input, meshFiles))
+	{
+		for (size_t i = 0; i < meshFiles.size(); i++)
+		{
+			std::string extension = FileUtils::GetExtension(meshFiles[i]);
+			if (extension != ".rcm" && extension != ".rcs")
+				continue;
+
+			std::string meshFile = input + "/" + meshFiles[i];
+			if (!cooker.Cook(meshFile, meshFile, extension == ".rcs"))
+				return 1;
+		}
+
+		return 0;
+	}
+
+	std::string output = argc > 3 ? argv[3] : input;
+	if (!cooker.Cook(input, output, FileUtils::GetExtension(input) == ".rcs"))
+		return 1;
+
+	return 0;
+}
+
+static int CookTex(int argc, char ** argv)
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	bool compress = true;
+	std::string output;
+	for (int i = 3; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "-uncompressed")
+			compress = false;
+		else
+			output = argv[i];
+	}
+
+	TextureCooker cooker;
+
+	std::string input = argv[2];
+	std::vector<std::string> textureFiles;
+
+	// A directory cooks every .rct file inside it in place
+	if (FileUtils::ListFiles(input, textureFiles))
+	{
+		for (size_t i = 0; i < textureFiles.size(); i++)
+		{
+			if (FileUtils::GetExtension(textureFiles[i]) != ".rct")
+				continue;
+
+			std::string textureFile = input + "/" + textureFiles[i];
+			if (!cooker.Cook(textureFile, textureFile, compress))
+				return 1;
+		}
+
+		return 0;
+	}
+
+	if (!cooker.Cook(input, output.empty() ? input : output, compress))
+		return 1;
+
+	return 0;
+}
+
+static int Cook(int argc, char ** argv)
+{
+	if (argc < 4)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// Defaults to one thread per core
+	unsigned int threadCount = 0;
+	for (int i = 4; i < argc - 1; i++)
+	{
+		if (std::string(argv[i]) == "-j")
+			threadCount = (unsigned int)atoi(argv[i + 1]);
+	}
+
+	AssetCooker cooker;
+	if (!cooker.Cook(argv[2], argv[3], threadCount))
+		return 1;
+
+	return 0;
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::string command = argv[1];
+	if (command == "pack")
+		return Pack(argc, argv);
+	if (command == "bakeanim")
+		return BakeAnim(argc, argv);
+	if (command == "cookcol")
+		return CookCol(argc, argv);
+	if (command == "convertmap")
+		return ConvertMap(argc, argv);
+	if (command == "cookmesh")
+		return CookMesh(argc, argv);
+	if (command == "cooktex")
+		return CookTex(argc, argv);
+	if (command == "cook")
+		return Cook(argc, argv);
+
+	printf("ERROR: Unknown command %s\n", command.c_str());
+	PrintUsage();
+	return 1;
+}
\ No newline at end of file
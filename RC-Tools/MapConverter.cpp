@@ -0,0 +1,305 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: MapConverter.cpp                                     |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <sstream>
+#include <algorithm>
+#include <LinearMath/btMatrix3x3.h>
+
+#include "MapConverter.h"
+#include "FileUtils.h"
+#include "../RC-Engine/MeshFormat.h"
+
+MapConverter::MapConverter()
+{
+}
+
+MapConverter::~MapConverter()
+{
+}
+
+bool MapConverter::ReadModelBounds(std::string modelFile, ModelBounds & bounds)
+{
+	std::vector<unsigned char> data;
+	if (!FileUtils::ReadFile(modelFile, data))
+	{
+		printf("ERROR: Failed to read %s\n", modelFile.c_str());
+		return false;
+	}
+
+	size_t offset = 0;
+	auto read = [&](void * dst, size_t size)
+	{
+		if (size > data.size() - offset)
+			return false;
+
+		memcpy(dst, data.data() + offset, size);
+		offset += size;
+		return true;
+	};
+
+	// Both vertex formats start with a float position
+	uint32_t flags;
+	size_t headerSize;
+	if (!ReadMeshHeader(data.data(), data.size(), flags, headerSize))
+	{
+		printf("ERROR: %s has an unknown version\n", modelFile.c_str());
+		return false;
+	}
+	size_t vertexSize = GetMeshVertexSize(flags, false);
+	offset = headerSize;
+
+	uint32_t meshCount;
+	float frustumCullRadius;
+	if (!read(&meshCount, sizeof(uint32_t)) || !read(&frustumCullRadius, sizeof(float)))
+	{
+		printf("ERROR: %s is corrupted\n", modelFile.c_str());
+		return false;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		bounds.boundsMin[i] = FLT_MAX;
+		bounds.boundsMax[i] = -FLT_MAX;
+	}
+
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		// The LOD table isn't needed, every LOD uses the same vertices
+		uint32_t vertexCount, indexCount, lodCount = 0;
+		if (!read(&vertexCount, sizeof(uint32_t)) || !read(&indexCount, sizeof(uint32_t)) ||
+			((flags & RCM_FLAG_LODS) && !read(&lodCount, sizeof(uint32_t))) ||
+			(size_t)lodCount * sizeof(RCMeshLod) > data.size() - offset ||
+			(size_t)vertexCount * vertexSize > data.size() - offset - (size_t)lodCount * sizeof(RCMeshLod))
+		{
+			printf("ERROR: %s is corrupted\n", modelFile.c_str());
+			return false;
+		}
+
+		offset += (size_t)lodCount * sizeof(RCMeshLod);
+		for (uint32_t j = 0; j < vertexCount; j++)
+		{
+			float position[3];
+			memcpy(position, data.data() + offset + (size_t)j * vertexSize, sizeof(position));
+
+			for (int k = 0; k < 3; k++)
+			{
+				bounds.boundsMin[k] = std::min(bounds.boundsMin[k], position[k]);
+				bounds.boundsMax[k] = std::max(bounds.boundsMax[k], position[k]);
+			}
+		}
+
+		// Skip vertices, indices and the two texture names
+		offset += (size_t)vertexCount * vertexSize;
+		size_t indexDataSize = GetMeshIndexDataSize(flags, vertexCount, indexCount);
+		if (indexDataSize + 128 > data.size() - offset)
+		{
+			printf("ERROR: %s is corrupted\n", modelFile.c_str());
+			return false;
+		}
+		offset += indexDataSize + 128;
+	}
+
+	// Models without geometry still get a point, so they can be found by position
+	if (bounds.boundsMin[0] > bounds.boundsMax[0])
+	{
+		for (int i = 0; i < 3; i++)
+			bounds.boundsMin[i] = bounds.boundsMax[i] = 0.0f;
+	}
+
+	return true;
+}
+
+bool MapConverter::AddAsset(std::string assetPath, uint32_t & assetIndex)
+{
+	std::map<std::string, uint32_t>::iterator it = assetMapping.find(assetPath);
+	if (it != assetMapping.end())
+	{
+		assetIndex = it->second;
+		return true;
+	}
+
+	ModelBounds bounds;
+	if (!ReadModelBounds(dataRoot + "/" + assetPath, bounds))
+		return false;
+
+	RCMapAsset asset;
+	asset.pathOffset = (uint32_t)strings.size();
+	asset.pathLength = (uint32_t)assetPath.size();
+	strings.insert(strings.end(), assetPath.begin(), assetPath.end());
+	strings.push_back(0);
+
+	assetIndex = (uint32_t)assets.size();
+	assets.push_back(asset);
+	assetBounds.push_back(bounds);
+	assetMapping[assetPath] = assetIndex;
+
+	return true;
+}
+
+void MapConverter::ComputeInstanceBounds(RCMapInstance & instance)
+{
+	const ModelBounds & bounds = assetBounds[instance.assetIndex];
+
+	// Same rotation the engine applies to the rigid body in Model::SetRotation
+	btMatrix3x3 basis;
+	basis.setEulerZYX(btRadians(instance.rotation[0]), btRadians(instance.rotation[1]), btRadians(instance.rotation[2]));
+
+	for (int i = 0; i < 3; i++)
+	{
+		instance.boundsMin[i] = FLT_MAX;
+		instance.boundsMax[i] = -FLT_MAX;
+	}
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		btVector3 point((corner & 1) ? bounds.boundsMax[0] : bounds.boundsMin[0],
+			(corner & 2) ? bounds.boundsMax[1] : bounds.boundsMin[1],
+			(corner & 4) ? bounds.boundsMax[2] : bounds.boundsMin[2]);
+
+		btVector3 worldPoint = basis * point;
+		for (int i = 0; i < 3; i++)
+		{
+			float value = (float)worldPoint[i] + instance.position[i];
+			instance.boundsMin[i] = std::min(instance.boundsMin[i], value);
+			instance.boundsMax[i] = std::max(instance.boundsMax[i], value);
+		}
+	}
+}
+
+void MapConverter::BuildNode(uint32_t first, uint32_t count)
+{
+	uint32_t nodeIndex = (uint32_t)nodes.size();
+	nodes.push_back(RCMapNode());
+
+	RCMapNode node;
+	for (int i = 0; i < 3; i++)
+	{
+		node.boundsMin[i] = FLT_MAX;
+		node.boundsMax[i] = -FLT_MAX;
+	}
+
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const RCMapInstance & instance = instances[instanceIndices[i]];
+		for (int j = 0; j < 3; j++)
+		{
+			node.boundsMin[j] = std::min(node.boundsMin[j], instance.boundsMin[j]);
+			node.boundsMax[j] = std::max(node.boundsMax[j], instance.boundsMax[j]);
+		}
+	}
+
+	if (count <= RCMAP_MAX_LEAF_INSTANCES)
+	{
+		node.childOrFirstIndex = first;
+		node.instanceCount = count;
+		nodes[nodeIndex] = node;
+		return;
+	}
+
+	// Split at the median of the instance centers along the longest axis
+	int axis = 0;
+	for (int i = 1; i < 3; i++)
+	{
+		if (node.boundsMax[i] - node.boundsMin[i] > node.boundsMax[axis] - node.boundsMin[axis])
+			axis = i;
+	}
+
+	uint32_t half = count / 2;
+	std::nth_element(instanceIndices.begin() + first, instanceIndices.begin() + first + half, instanceIndices.begin() + first + count,
+		[&](uint32_t a, uint32_t b)
+	{
+		return instances[a].boundsMin[axis] + instances[a].boundsMax[axis] < instances[b].boundsMin[axis] + instances[b].boundsMax[axis];
+	});
+
+	BuildNode(first, half);
+
+	node.childOrFirstIndex = (uint32_t)nodes.size();
+	node.instanceCount = 0;
+	nodes[nodeIndex] = node;
+
+	BuildNode(first + half, count - half);
+}
+
+bool MapConverter::Convert(std::string mapFile, std::string dataRoot, std::string outputFile)
+{
+	this->dataRoot = dataRoot;
+
+	std::vector<unsigned char> mapData;
+	if (!FileUtils::ReadFile(mapFile, mapData))
+	{
+		printf("ERROR: Failed to read %s\n", mapFile.c_str());
+		return false;
+	}
+
+	// Text maps are one instance per line: model posX posY posZ rotX rotY rotZ mass
+	std::istringstream file(std::string(mapData.begin(), mapData.end()));
+
+	std::string modelName;
+	RCMapInstance instance;
+	while (file >> modelName >> instance.position[0] >> instance.position[1] >> instance.position[2] >>
+		instance.rotation[0] >> instance.rotation[1] >> instance.rotation[2] >> instance.mass)
+	{
+		if (!AddAsset("data/models/" + modelName + ".rcm", instance.assetIndex))
+			return false;
+
+		ComputeInstanceBounds(instance);
+		instances.push_back(instance);
+	}
+
+	if (!file.eof())
+	{
+		printf("ERROR: %s has a malformed line after %u instances\n", mapFile.c_str(), (unsigned int)instances.size());
+		return false;
+	}
+
+	for (uint32_t i = 0; i < instances.size(); i++)
+		instanceIndices.push_back(i);
+
+	if (!instances.empty())
+		BuildNode(0, (uint32_t)instances.size());
+
+	RCMapHeader header;
+	memset(&header, 0, sizeof(RCMapHeader));
+	header.magic = RCMAP_MAGIC;
+	header.version = RCMAP_VERSION;
+	header.assetCount = (uint32_t)assets.size();
+	header.instanceCount = (uint32_t)instances.size();
+	header.nodeCount = (uint32_t)nodes.size();
+	header.stringTableSize = (uint32_t)strings.size();
+	if (!nodes.empty())
+	{
+		memcpy(header.boundsMin, nodes[0].boundsMin, sizeof(header.boundsMin));
+		memcpy(header.boundsMax, nodes[0].boundsMax, sizeof(header.boundsMax));
+	}
+
+	std::vector<unsigned char> data;
+	auto append = [&](const void * src, size_t size)
+	{
+		data.insert(data.end(), (const unsigned char*)src, (const unsigned char*)src + size);
+	};
+
+	append(&header, sizeof(RCMapHeader));
+	append(assets.data(), assets.size() * sizeof(RCMapAsset));
+	append(instances.data(), instances.size() * sizeof(RCMapInstance));
+	append(nodes.data(), nodes.size() * sizeof(RCMapNode));
+	append(instanceIndices.data(), instanceIndices.size() * sizeof(uint32_t));
+	append(strings.data(), strings.size());
+
+	if (!FileUtils::WriteFile(outputFile, data.data(), data.size()))
+	{
+		printf("ERROR: Failed to write %s\n", outputFile.c_str());
+		return false;
+	}
+
+	printf("Converted %s (%u instances, %u assets, %u BVH nodes) into %s\n", mapFile.c_str(), header.instanceCount, header.assetCount,
+		header.nodeCount, outputFile.c_str());
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: MapConverter.h                                       |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../RC-Engine/MapFormat.h"
+
+class MapConverter
+{
+	private:
+		struct ModelBounds
+		{
+			float boundsMin[3];
+			float boundsMax[3];
+		};
+
+		std::string dataRoot;
+		std::map<std::string, uint32_t> assetMapping;
+		std::vector<ModelBounds> assetBounds;
+		std::vector<RCMapAsset> assets;
+		std::vector<char> strings;
+		std::vector<RCMapInstance> instances;
+		std::vector<RCMapNode> nodes;
+		std::vector<uint32_t> instanceIndices;
+	private:
+		bool ReadModelBounds(std::string modelFile, ModelBounds & bounds);
+		bool AddAsset(std::string assetPath, uint32_t & assetIndex);
+		void ComputeInstanceBounds(RCMapInstance & instance);
+		void BuildNode(uint32_t first, uint32_t count);
+	public:
+		MapConverter();
+		~MapConverter();
+
+		bool Convert(std::string mapFile, std::string dataRoot, std::string outputFile);
+};
\ No newline at end of file
@@ -0,0 +1,600 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: MeshCooker.cpp                                       |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "MeshCooker.h"
+#include "FileUtils.h"
+#include "../RC-Engine/MeshOptimizer.h"
+
+// Largest UV error accepted from the half float conversion, half a texel of a 2048 texture.
+// Meshes with tiled UVs far outside 0..1 lose too much precision and keep float vertices.
+#define PACKED_UV_MAX_ERROR (1.0f / 4096.0f)
+
+// Bone IDs are stored as signed bytes, the shaders read them as ivec4
+#define PACKED_MAX_BONE_ID 127
+
+// Every LOD aims for half the triangles of the one before it. The chain ends when a LOD can't get at least a
+// quarter below the previous one without going over LOD_MAX_ERROR (a fraction of the mesh size), or gets too small.
+#define LOD_MAX_ERROR 0.05f
+#define LOD_MIN_REDUCTION 0.75f
+#define LOD_MIN_TRIANGLES 32
+
+static uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(float));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (exponent >= 31)
+		return (uint16_t)(sign | 0x7C00);
+
+	// Denormals and values too small for a half
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return (uint16_t)sign;
+
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			half++;
+
+		return (uint16_t)(sign | half);
+	}
+
+	// Rounding can carry into the exponent, which is still the correct result
+	uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+		half++;
+
+	return (uint16_t)half;
+}
+
+static float HalfToFloat(uint16_t value)
+{
+	int exponent = (value >> 10) & 0x1F;
+	int mantissa = value & 0x3FF;
+
+	float result;
+	if (exponent == 0)
+		result = ldexpf((float)mantissa, -24);
+	else if (exponent == 31)
+		result = HUGE_VALF;
+	else
+		result = ldexpf((float)(mantissa | 0x400), exponent - 25);
+
+	return (value & 0x8000) ? -result : result;
+}
+
+static void DecodeOctahedral(float x, float y, float * direction)
+{
+	direction[0] = x;
+	direction[1] = y;
+	direction[2] = 1.0f - fabsf(x) - fabsf(y);
+
+	float t = fmaxf(-direction[2], 0.0f);
+	direction[0] += direction[0] >= 0.0f ? -t : t;
+	direction[1] += direction[1] >= 0.0f ? -t : t;
+
+	float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	for (int i = 0; i < 3; i++)
+		direction[i] /= length;
+}
+
+// Octahedral encoding quantized to signed values in -maxValue..maxValue. Of the four roundings around the exact
+// position the one that decodes closest to the direction is kept, which matters most for the 8-bit tangents.
+static void EncodeOctahedral(const float * direction, int maxValue, int * dst)
+{
+	float length = fabsf(direction[0]) + fabsf(direction[1]) + fabsf(direction[2]);
+	if (length == 0.0f)
+	{
+		dst[0] = 0;
+		dst[1] = 0;
+		return;
+	}
+
+	float x = direction[0] / length;
+	float y = direction[1] / length;
+	if (direction[2] < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	float bestDot = -2.0f;
+	float baseX = floorf(x * maxValue), baseY = floorf(y * maxValue);
+	for (int i = 0; i < 4; i++)
+	{
+		int qx = (int)baseX + (i & 1), qy = (int)baseY + (i >> 1);
+		qx = qx < -maxValue ? -maxValue : (qx > maxValue ? maxValue : qx);
+		qy = qy < -maxValue ? -maxValue : (qy > maxValue ? maxValue : qy);
+
+		float decoded[3];
+		DecodeOctahedral((float)qx / maxValue, (float)qy / maxValue, decoded);
+		float dot = (decoded[0] * direction[0] + decoded[1] * direction[1] + decoded[2] * direction[2]) /
+			sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		if (dot > bestDot)
+		{
+			bestDot = dot;
+			dst[0] = qx;
+			dst[1] = qy;
+		}
+	}
+}
+
+// Octahedral normal and tangent, the bitangent is rebuilt from them and only its direction is kept
+static void PackTangentFrame(const float * normal, const float * tangent, const float * bitangent, int16_t * packedNormal,
+	int8_t * packedTangent)
+{
+	int encoded[2];
+	EncodeOctahedral(normal, 32767, encoded);
+	packedNormal[0] = (int16_t)encoded[0];
+	packedNormal[1] = (int16_t)encoded[1];
+
+	EncodeOctahedral(tangent, 127, encoded);
+	packedTangent[0] = (int8_t)encoded[0];
+	packedTangent[1] = (int8_t)encoded[1];
+
+	float cross[3] = { normal[1] * tangent[2] - normal[2] * tangent[1], normal[2] * tangent[0] - normal[0] * tangent[2],
+		normal[0] * tangent[1] - normal[1] * tangent[0] };
+	float sign = cross[0] * bitangent[0] + cross[1] * bitangent[1] + cross[2] * bitangent[2];
+	packedTangent[2] = (int8_t)(sign < 0.0f ? -127 : 127);
+	packedTangent[3] = 0;
+}
+
+static void UnpackLegacyDirection(const int8_t * packed, float * direction)
+{
+	for (int i = 0; i < 3; i++)
+		direction[i] = packed[i] / 127.0f;
+}
+
+static void PackWeights(const float * weights, uint8_t * dst)
+{
+	int total = 0;
+	int largest = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		float weight = weights[i] < 0.0f ? 0.0f : (weights[i] > 1.0f ? 1.0f : weights[i]);
+		dst[i] = (uint8_t)(weight * 255.0f + 0.5f);
+		total += dst[i];
+		if (dst[i] > dst[largest])
+			largest = i;
+	}
+
+	// Rounding can leave the sum a couple of steps off, the largest weight takes the difference
+	if (total != 255 && total >= 253 && total <= 257)
+		dst[largest] = (uint8_t)(dst[largest] + 255 - total);
+}
+
+MeshCooker::MeshCooker()
+{
+	offset = 0;
+	skinned = false;
+}
+
+MeshCooker::~MeshCooker()
+{
+}
+
+bool MeshCooker::Read(void * dst, size_t size)
+{
+	if (offset + size > data.size())
+		return false;
+	if (dst != NULL)
+		memcpy(dst, &data[offset], size);
+	offset += size;
+
+	return true;
+}
+
+void MeshCooker::Append(const void * src, size_t size)
+{
+	output.insert(output.end(), (const unsigned char*)src, (const unsigned char*)src + size);
+}
+
+bool MeshCooker::ReadMeshes(uint32_t flags, uint32_t meshCount)
+{
+	size_t vertexSize = GetMeshVertexSize(flags, skinned);
+
+	meshes.clear();
+	meshes.resize(meshCount);
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		MeshData & mesh = meshes[i];
+
+		uint32_t vertexCount, indexCount;
+		if (!Read(&vertexCount, sizeof(uint32_t)) || !Read(&indexCount, sizeof(uint32_t)))
+			return false;
+
+		// Only the full mesh is kept from an existing LOD chain, the LODs are built again from it
+		uint32_t fullIndexCount = indexCount;
+		if (flags & RCM_FLAG_LODS)
+		{
+			uint32_t lodCount;
+			RCMeshLod lod;
+			if (!Read(&lodCount, sizeof(uint32_t)) || lodCount == 0 || !Read(&lod, sizeof(RCMeshLod)) ||
+				!Read(NULL, sizeof(RCMeshLod) * (lodCount - 1)) || lod.firstIndex != 0 || lod.indexCount > indexCount)
+				return false;
+
+			fullIndexCount = lod.indexCount;
+		}
+
+		size_t vertexOffset = offset;
+		size_t indexOffset = offset + (size_t)vertexCount * vertexSize;
+		if (!Read(NULL, (size_t)vertexCount * vertexSize + GetMeshIndexDataSize(flags, vertexCount, indexCount)))
+			return false;
+
+		mesh.textureNames = &data[offset];
+		if (!Read(NULL, 128))
+			return false;
+
+		mesh.vertices.assign(data.begin() + vertexOffset, data.begin() + indexOffset);
+
+		mesh.indices.resize(fullIndexCount);
+		if (HasShortIndices(flags, vertexCount))
+		{
+			for (uint32_t j = 0; j < fullIndexCount; j++)
+			{
+				uint16_t index;
+				memcpy(&index, &data[indexOffset + j * sizeof(uint16_t)], sizeof(uint16_t));
+				mesh.indices[j] = index;
+			}
+		}
+		else if (fullIndexCount > 0)
+			memcpy(mesh.indices.data(), &data[indexOffset], (size_t)fullIndexCount * sizeof(uint32_t));
+	}
+
+	return true;
+}
+
+bool MeshCooker::CanPackVertices(const MeshData & mesh)
+{
+	size_t vertexSize = skinned ? RCS_VERTEX_SIZE : RCM_VERTEX_SIZE;
+	size_t vertexCount = mesh.vertices.size() / vertexSize;
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		float vertex[RCS_VERTEX_SIZE / sizeof(float)];
+		memcpy(vertex, &mesh.vertices[i * vertexSize], vertexSize);
+
+		for (int j = 3; j < 5; j++)
+		{
+			if (fabsf(HalfToFloat(FloatToHalf(vertex[j])) - vertex[j]) > PACKED_UV_MAX_ERROR)
+			{
+				reason = "UVs need more precision than half floats";
+				return false;
+			}
+		}
+
+		if (skinned)
+		{
+			uint32_t boneIDs[4];
+			memcpy(boneIDs, vertex + 12, sizeof(boneIDs));
+			for (int j = 0; j < 4; j++)
+			{
+				if (boneIDs[j] > PACKED_MAX_BONE_ID)
+				{
+					reason = "bone IDs don't fit a byte";
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void MeshCooker::ConvertLegacyVertices(const MeshData & mesh)
+{
+	size_t vertexSize = skinned ? sizeof(RCLegacyPackedSkinnedVertex) : sizeof(RCLegacyPackedVertex);
+	size_t vertexCount = mesh.vertices.size() / vertexSize;
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		float normal[3], tangent[3], bitangent[3];
+
+		if (skinned)
+		{
+			RCLegacyPackedSkinnedVertex legacy;
+			memcpy(&legacy, &mesh.vertices[i * vertexSize], vertexSize);
+			UnpackLegacyDirection(legacy.normal, normal);
+			UnpackLegacyDirection(legacy.tangent, tangent);
+			UnpackLegacyDirection(legacy.bitangent, bitangent);
+
+			RCPackedSkinnedVertex packed;
+			memcpy(packed.position, legacy.position, sizeof(packed.position));
+			memcpy(packed.uv, legacy.uv, sizeof(packed.uv));
+			memcpy(packed.boneWeights, legacy.boneWeights, sizeof(packed.boneWeights));
+			memcpy(packed.boneIDs, legacy.boneIDs, sizeof(packed.boneIDs));
+			PackTangentFrame(normal, tangent, bitangent, packed.normal, packed.tangent);
+
+			Append(&packed, sizeof(RCPackedSkinnedVertex));
+		}
+		else
+		{
+			RCLegacyPackedVertex legacy;
+			memcpy(&legacy, &mesh.vertices[i * vertexSize], vertexSize);
+			UnpackLegacyDirection(legacy.normal, normal);
+			UnpackLegacyDirection(legacy.tangent, tangent);
+			UnpackLegacyDirection(legacy.bitangent, bitangent);
+
+			RCPackedVertex packed;
+			memcpy(packed.position, legacy.position, sizeof(packed.position));
+			memcpy(packed.uv, legacy.uv, sizeof(packed.uv));
+			PackTangentFrame(normal, tangent, bitangent, packed.normal, packed.tangent);
+
+			Append(&packed, sizeof(RCPackedVertex));
+		}
+	}
+}
+
+void MeshCooker::PackVertices(const MeshData & mesh)
+{
+	size_t vertexSize = skinned ? RCS_VERTEX_SIZE : RCM_VERTEX_SIZE;
+	size_t vertexCount = mesh.vertices.size() / vertexSize;
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		float vertex[RCS_VERTEX_SIZE / sizeof(float)];
+		memcpy(vertex, &mesh.vertices[i * vertexSize], vertexSize);
+
+		if (skinned)
+		{
+			// x y z, u v, normal, 4 weights, 4 bone IDs, tangent, bitangent
+			uint32_t boneIDs[4];
+			memcpy(boneIDs, vertex + 12, sizeof(boneIDs));
+
+			RCPackedSkinnedVertex packed;
+			memcpy(packed.position, vertex, sizeof(float) * 3);
+			packed.uv[0] = FloatToHalf(vertex[3]);
+			packed.uv[1] = FloatToHalf(vertex[4]);
+			PackWeights(vertex + 8, packed.boneWeights);
+			for (int j = 0; j < 4; j++)
+				packed.boneIDs[j] = (int8_t)boneIDs[j];
+			PackTangentFrame(vertex + 5, vertex + 16, vertex + 19, packed.normal, packed.tangent);
+
+			Append(&packed, sizeof(RCPackedSkinnedVertex));
+		}
+		else
+		{
+			// x y z, u v, normal, tangent, bitangent
+			RCPackedVertex packed;
+			memcpy(packed.position, vertex, sizeof(float) * 3);
+			packed.uv[0] = FloatToHalf(vertex[3]);
+			packed.uv[1] = FloatToHalf(vertex[4]);
+			PackTangentFrame(vertex + 5, vertex + 8, vertex + 11, packed.normal, packed.tangent);
+
+			Append(&packed, sizeof(RCPackedVertex));
+		}
+	}
+}
+
+void MeshCooker::GenerateLods(MeshData & mesh, size_t vertexSize)
+{
+	size_t vertexCount = mesh.vertices.size() / vertexSize;
+
+	RCMeshLod fullMesh = { 0, (uint32_t)mesh.indices.size(), 0.0f };
+	mesh.lods.assign(1, fullMesh);
+
+	// Errors are limited relative to the size of the mesh
+	float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		float position[3];
+		memcpy(position, &mesh.vertices[i * vertexSize], sizeof(position));
+		for (int j = 0; j < 3; j++)
+		{
+			minimum[j] = fminf(minimum[j], position[j]);
+			maximum[j] = fmaxf(maximum[j], position[j]);
+		}
+	}
+
+	float size = 0.0f;
+	for (int j = 0; j < 3 && vertexCount > 0; j++)
+		size = fmaxf(size, maximum[j] - minimum[j]);
+
+	std::vector<uint32_t> lodIndices;
+	size_t fullIndexCount = mesh.indices.size();
+	while (mesh.lods.size() < RCM_MAX_LODS)
+	{
+		size_t previousIndexCount = mesh.lods.back().indexCount;
+		if (previousIndexCount / 3 < LOD_MIN_TRIANGLES * 2)
+			break;
+
+		// Simplified from the full mesh every time, so the error is measured against it
+		size_t targetIndexCount = previousIndexCount / 6 * 3;
+		float error = MeshOptimizer::Simplify(mesh.vertices.data(), vertexCount, vertexSize, mesh.indices.data(), fullIndexCount,
+			targetIndexCount, size * LOD_MAX_ERROR, lodIndices);
+		if (lodIndices.size() > previousIndexCount * LOD_MIN_REDUCTION)
+			break;
+
+		MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndices.size(), vertexCount);
+
+		RCMeshLod lod = { (uint32_t)mesh.indices.size(), (uint32_t)lodIndices.size(), error };
+		mesh.lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+}
+
+bool MeshCooker::Cook(std::string meshFile, std::string outputFile, bool skinnedMesh)
+{
+	if (!FileUtils::ReadFile(meshFile, data))
+	{
+		printf("ERROR: Failed to read %s\n", meshFile.c_str());
+		return false;
+	}
+
+	skinned = skinnedMesh;
+	reason.clear();
+
+	uint32_t inputFlags;
+	size_t headerSize;
+	if (!ReadMeshHeader(data.data(), data.size(), inputFlags, headerSize))
+	{
+		printf("ERROR: %s has an unknown version\n", meshFile.c_str());
+		return false;
+	}
+
+	// Cooking again wouldn't change anything, static meshes cooked before they had LODs get them now and packed
+	// vertices from before version 4 are converted
+	if ((inputFlags & (skinned ? RCM_FLAG_OPTIMIZED : RCM_FLAG_LODS)) && !(inputFlags & RCM_FLAG_LEGACY_PACKED_VERTICES))
+	{
+		printf("Skipped %s (already cooked)\n", meshFile.c_str());
+
+		if (outputFile != meshFile && !FileUtils::WriteFile(outputFile, data.data(), data.size()))
+		{
+			printf("ERROR: Failed to write %s\n", outputFile.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	// Static meshes store the frustum cull radius after the mesh count
+	offset = headerSize;
+	uint32_t meshCount;
+	float frustumCullRadius = 0.0f;
+	if (!Read(&meshCount, sizeof(uint32_t)) || (!skinned && !Read(&frustumCullRadius, sizeof(float))) ||
+		!ReadMeshes(inputFlags, meshCount))
+	{
+		printf("ERROR: %s is corrupted\n", meshFile.c_str());
+		return false;
+	}
+
+	// Reorder every mesh, the ACMR is summed over all triangles to show the difference
+	size_t inputVertexSize = GetMeshVertexSize(inputFlags, skinned);
+	float missesBefore = 0.0f, missesAfter = 0.0f;
+	size_t triangleCount = 0;
+	size_t lodTriangleCounts[RCM_MAX_LODS] = { 0 };
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		MeshData & mesh = meshes[i];
+		size_t vertexCount = mesh.vertices.size() / inputVertexSize;
+		size_t meshTriangleCount = mesh.indices.size() / 3;
+
+		for (size_t j = 0; j < mesh.indices.size(); j++)
+		{
+			if (mesh.indices[j] >= vertexCount)
+			{
+				printf("ERROR: %s has indices out of range\n", meshFile.c_str());
+				return false;
+			}
+		}
+
+		missesBefore += MeshOptimizer::CalculateACMR(mesh.indices.data(), mesh.indices.size(), vertexCount, 32) * meshTriangleCount;
+		MeshOptimizer::Optimize(mesh.vertices, inputVertexSize, mesh.indices);
+		missesAfter += MeshOptimizer::CalculateACMR(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size() / inputVertexSize, 32) *
+			meshTriangleCount;
+		triangleCount += meshTriangleCount;
+
+		if (!skinned)
+		{
+			GenerateLods(mesh, inputVertexSize);
+
+			for (size_t j = 1; j < mesh.lods.size(); j++)
+				lodTriangleCounts[j] += mesh.lods[j].indexCount / 3;
+			lodTriangleCounts[0] += meshTriangleCount;
+		}
+	}
+
+	// Packing is decided for the whole asset, the engine loads float and packed vertices alike
+	bool packVertices = false;
+	if (inputFlags & RCM_FLAG_PACKED_VERTICES)
+		packVertices = true;
+	else
+	{
+		packVertices = true;
+		for (size_t i = 0; i < meshes.size() && packVertices; i++)
+			packVertices = CanPackVertices(meshes[i]);
+	}
+
+	RCMeshHeader header;
+	header.magic = RCM_COOKED_MAGIC;
+	header.version = RCM_COOKED_VERSION;
+	header.flags = RCM_FLAG_OPTIMIZED | (packVertices ? RCM_FLAG_PACKED_VERTICES : 0) | (skinned ? 0 : RCM_FLAG_LODS);
+
+	output.clear();
+	Append(&header, sizeof(RCMeshHeader));
+	Append(&meshCount, sizeof(uint32_t));
+	if (!skinned)
+		Append(&frustumCullRadius, sizeof(float));
+
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		const MeshData & mesh = meshes[i];
+		uint32_t vertexCount = (uint32_t)(mesh.vertices.size() / inputVertexSize);
+		uint32_t indexCount = (uint32_t)mesh.indices.size();
+
+		Append(&vertexCount, sizeof(uint32_t));
+		Append(&indexCount, sizeof(uint32_t));
+
+		if (header.flags & RCM_FLAG_LODS)
+		{
+			uint32_t lodCount = (uint32_t)mesh.lods.size();
+			Append(&lodCount, sizeof(uint32_t));
+			Append(mesh.lods.data(), sizeof(RCMeshLod) * lodCount);
+		}
+
+		if (inputFlags & RCM_FLAG_LEGACY_PACKED_VERTICES)
+			ConvertLegacyVertices(mesh);
+		else if (packVertices && !(inputFlags & RCM_FLAG_PACKED_VERTICES))
+			PackVertices(mesh);
+		else
+			Append(mesh.vertices.data(), mesh.vertices.size());
+
+		if (HasShortIndices(header.flags, vertexCount))
+		{
+			for (uint32_t j = 0; j < indexCount; j++)
+			{
+				uint16_t index = (uint16_t)mesh.indices[j];
+				Append(&index, sizeof(uint16_t));
+			}
+
+			if (indexCount % 2 != 0)
+			{
+				uint16_t padding = 0;
+				Append(&padding, sizeof(uint16_t));
+			}
+		}
+		else
+			Append(mesh.indices.data(), (size_t)indexCount * sizeof(uint32_t));
+
+		Append(mesh.textureNames, 128);
+	}
+
+	// Skinned meshes are followed by the bone data
+	if (offset < data.size())
+		Append(&data[offset], data.size() - offset);
+
+	if (!FileUtils::WriteFile(outputFile, output.data(), output.size()))
+	{
+		printf("ERROR: Failed to write %s\n", outputFile.c_str());
+		return false;
+	}
+
+	// Triangles summed over all meshes for each LOD, meshes that stop early don't count for the later ones
+	std::string lodInfo;
+	for (int i = 0; i < RCM_MAX_LODS && !skinned && lodTriangleCounts[i] > 0; i++)
+		lodInfo += (i == 0 ? ", LOD triangles " : "/") + std::to_string(lodTriangleCounts[i]);
+
+	printf("Cooked %s into %s (%u bytes -> %u bytes, ACMR %.2f -> %.2f, %s vertices%s%s%s)\n", meshFile.c_str(), outputFile.c_str(),
+		(unsigned int)data.size(), (unsigned int)output.size(), triangleCount > 0 ? missesBefore / triangleCount : 0.0f,
+		triangleCount > 0 ? missesAfter / triangleCount : 0.0f, packVertices ? "packed" : "float", lodInfo.c_str(),
+		reason.empty() ? "" : ", ", reason.c_str());
+
+	return true;
+}
\ No newline at end of file
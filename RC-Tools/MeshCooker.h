@@ -0,0 +1,44 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: MeshCooker.h                                         |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../RC-Engine/MeshFormat.h"
+
+class MeshCooker
+{
+	private:
+		struct MeshData
+		{
+			std::vector<unsigned char> vertices;
+			std::vector<uint32_t> indices;
+			const unsigned char * textureNames;
+			std::vector<RCMeshLod> lods;
+		};
+
+		std::vector<unsigned char> data;
+		size_t offset;
+		std::vector<unsigned char> output;
+		std::vector<MeshData> meshes;
+		bool skinned;
+		std::string reason;
+	private:
+		bool Read(void * dst, size_t size);
+		void Append(const void * src, size_t size);
+		bool ReadMeshes(uint32_t flags, uint32_t meshCount);
+		bool CanPackVertices(const MeshData & mesh);
+		void PackVertices(const MeshData & mesh);
+		void ConvertLegacyVertices(const MeshData & mesh);
+		void GenerateLods(MeshData & mesh, size_t vertexSize);
+	public:
+		MeshCooker();
+		~MeshCooker();
+
+		bool Cook(std::string meshFile, std::string outputFile, bool skinnedMesh);
+};
\ No newline at end of file
@@ -0,0 +1,309 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: ModelImporter.cpp                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ModelImporter.h"
+#include "FileUtils.h"
+
+// Same limit as MAX_BONES in the engine, the bone uniform buffer has room for that many
+#define MAX_SKIN_BONES 64
+
+// Texture names are stored in fixed size fields, null terminated
+#define TEXTURE_NAME_SIZE 64
+
+ModelImporter::ModelImporter()
+{
+	skinned = false;
+	frustumCullRadius = 0.0f;
+}
+
+ModelImporter::~ModelImporter()
+{
+}
+
+void ModelImporter::Append(const void * src, size_t size)
+{
+	output.insert(output.end(), (const unsigned char*)src, (const unsigned char*)src + size);
+}
+
+std::string ModelImporter::GetTextureName(const aiMaterial * material, aiTextureType type)
+{
+	aiString path;
+	if (material == NULL || material->GetTexture(type, 0, &path) != AI_SUCCESS)
+		return "NONE";
+
+	// Embedded textures have no file to convert
+	std::string name = FileUtils::GetFileName(path.data);
+	if (name.empty() || name[0] == '*')
+		return "NONE";
+
+	// Textures are converted to .rct separately, under the same name
+	size_t pos = name.rfind('.');
+	if (pos != std::string::npos)
+		name.erase(pos);
+	name += ".rct";
+
+	if (name.size() >= TEXTURE_NAME_SIZE)
+	{
+		printf("WARNING: Texture name %s is too long, it's left out\n", name.c_str());
+		return "NONE";
+	}
+
+	return name;
+}
+
+void ModelImporter::AppendTextureName(const aiMaterial * material, aiTextureType type)
+{
+	std::string name = GetTextureName(material, type);
+
+	// OBJ files list normal maps as bump maps
+	if (name == "NONE" && type == aiTextureType_NORMALS)
+		name = GetTextureName(material, aiTextureType_HEIGHT);
+
+	char field[TEXTURE_NAME_SIZE];
+	memset(field, 0, sizeof(field));
+	memcpy(field, name.c_str(), name.size());
+	Append(field, sizeof(field));
+}
+
+bool ModelImporter::AddBones(const aiMesh * mesh, std::vector<float> & boneWeights, std::vector<uint32_t> & boneIDs)
+{
+	for (uint32_t i = 0; i < mesh->mNumBones; i++)
+	{
+		const aiBone * bone = mesh->mBones[i];
+
+		// Bones are shared by every mesh of the model
+		uint32_t boneIndex;
+		std::map<std::string, uint32_t>::iterator it = boneMapping.find(bone->mName.data);
+		if (it != boneMapping.end())
+			boneIndex = it->second;
+		else
+		{
+			if (boneOffsets.size() >= MAX_SKIN_BONES)
+			{
+				printf("ERROR: Model has more than %d bones\n", MAX_SKIN_BONES);
+				return false;
+			}
+
+			boneIndex = (uint32_t)boneOffsets.size();
+			boneMapping[bone->mName.data] = boneIndex;
+			boneOffsets.push_back(bone->mOffsetMatrix);
+		}
+
+		// Limiting bone weights left at most 4 per vertex, each goes to the first free slot
+		for (uint32_t j = 0; j < bone->mNumWeights; j++)
+		{
+			const aiVertexWeight & weight = bone->mWeights[j];
+			if (weight.mVertexId >= mesh->mNumVertices)
+				continue;
+
+			for (int k = 0; k < 4; k++)
+			{
+				if (boneWeights[weight.mVertexId * 4 + k] == 0.0f)
+				{
+					boneWeights[weight.mVertexId * 4 + k] = weight.mWeight;
+					boneIDs[weight.mVertexId * 4 + k] = boneIndex;
+					break;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool ModelImporter::AddMesh(const aiMesh * mesh, const aiScene * scene)
+{
+	std::vector<float> boneWeights((size_t)mesh->mNumVertices * 4, 0.0f);
+	std::vector<uint32_t> boneIDs((size_t)mesh->mNumVertices * 4, 0);
+	if (skinned && !AddBones(mesh, boneWeights, boneIDs))
+		return false;
+
+	// Points and lines were sorted out already, anything left that isn't a triangle is skipped
+	std::vector<uint32_t> indices;
+	for (uint32_t i = 0; i < mesh->mNumFaces; i++)
+	{
+		const aiFace & face = mesh->mFaces[i];
+		if (face.mNumIndices == 3)
+			indices.insert(indices.end(), face.mIndices, face.mIndices + 3);
+	}
+
+	uint32_t vertexCount = mesh->mNumVertices;
+	uint32_t indexCount = (uint32_t)indices.size();
+	Append(&vertexCount, sizeof(uint32_t));
+	Append(&indexCount, sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < vertexCount; i++)
+	{
+		aiVector3D position = mesh->mVertices[i];
+		aiVector3D uv = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][i] : aiVector3D();
+		aiVector3D normal = mesh->HasNormals() ? mesh->mNormals[i] : aiVector3D();
+		aiVector3D tangent = mesh->HasTangentsAndBitangents() ? mesh->mTangents[i] : aiVector3D();
+		aiVector3D bitangent = mesh->HasTangentsAndBitangents() ? mesh->mBitangents[i] : aiVector3D();
+
+		// Same layout as Mesh::Vertex and SkinnedMesh::Vertex
+		float vertex[22];
+		size_t count = 0;
+		vertex[count++] = position.x; vertex[count++] = position.y; vertex[count++] = position.z;
+		vertex[count++] = uv.x; vertex[count++] = uv.y;
+		vertex[count++] = normal.x; vertex[count++] = normal.y; vertex[count++] = normal.z;
+		if (skinned)
+		{
+			memcpy(vertex + count, &boneWeights[i * 4], sizeof(float) * 4);
+			memcpy(vertex + count + 4, &boneIDs[i * 4], sizeof(uint32_t) * 4);
+			count += 8;
+		}
+		vertex[count++] = tangent.x; vertex[count++] = tangent.y; vertex[count++] = tangent.z;
+		vertex[count++] = bitangent.x; vertex[count++] = bitangent.y; vertex[count++] = bitangent.z;
+
+		Append(vertex, sizeof(float) * count);
+
+		if (!skinned && position.Length() > frustumCullRadius)
+			frustumCullRadius = position.Length();
+	}
+
+	Append(indices.data(), indices.size() * sizeof(uint32_t));
+
+	const aiMaterial * material = mesh->mMaterialIndex < scene->mNumMaterials ? scene->mMaterials[mesh->mMaterialIndex] : NULL;
+	AppendTextureName(material, aiTextureType_DIFFUSE);
+	AppendTextureName(material, aiTextureType_NORMALS);
+
+	// glTF metallic-roughness maps are the closest thing to the engine's material textures
+	materials += GetTextureName(material, aiTextureType_DIFFUSE) + " " + GetTextureName(material, aiTextureType_UNKNOWN) + " 0.0 0.0\n";
+
+	if (!skinned)
+	{
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			const aiVector3D & position = mesh->mVertices[indices[i]];
+			collisionVertices.push_back(position.x);
+			collisionVertices.push_back(position.y);
+			collisionVertices.push_back(position.z);
+		}
+	}
+
+	return true;
+}
+
+bool ModelImporter::Import(std::string sourceFile, std::string outputBase, std::vector<std::string> & outputFiles)
+{
+	// Left handed with clockwise winding and top-left UV origin like the rest of the engine's assets,
+	// at most 4 bone weights per vertex
+	Assimp::Importer importer;
+	importer.SetPropertyInteger(AI_CONFIG_PP_LBW_MAX_WEIGHTS, 4);
+	importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+
+	const aiScene * scene = importer.ReadFile(sourceFile, aiProcess_Triangulate | aiProcess_SortByPType |
+		aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace |
+		aiProcess_LimitBoneWeights | aiProcess_ConvertToLeftHanded);
+	if (scene == NULL || scene->mNumMeshes == 0)
+	{
+		printf("ERROR: Failed to import %s (%s)\n", sourceFile.c_str(), importer.GetErrorString());
+		return false;
+	}
+
+	skinned = false;
+	for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+	{
+		if (scene->mMeshes[i]->HasBones())
+			skinned = true;
+	}
+
+	// Static models are flattened into model space, skinned meshes stay in their bind pose
+	if (!skinned)
+	{
+		scene = importer.ApplyPostProcessing(aiProcess_PreTransformVertices);
+		if (scene == NULL)
+		{
+			printf("ERROR: Failed to import %s (%s)\n", sourceFile.c_str(), importer.GetErrorString());
+			return false;
+		}
+	}
+
+	output.clear();
+	boneMapping.clear();
+	boneOffsets.clear();
+	materials.clear();
+	collisionVertices.clear();
+	frustumCullRadius = 0.0f;
+
+	// Static models store the frustum cull radius after the mesh count, it's filled in once all vertices are seen
+	uint32_t meshCount = scene->mNumMeshes;
+	Append(&meshCount, sizeof(uint32_t));
+	size_t radiusOffset = output.size();
+	if (!skinned)
+		Append(&frustumCullRadius, sizeof(float));
+
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		if (!AddMesh(scene->mMeshes[i], scene))
+		{
+			printf("ERROR: Failed to import %s\n", sourceFile.c_str());
+			return false;
+		}
+	}
+
+	if (!skinned)
+		memcpy(&output[radiusOffset], &frustumCullRadius, sizeof(float));
+	else
+	{
+		// Bone offsets row major, then the bone names the animation baker maps channels with
+		uint32_t boneCount = (uint32_t)boneOffsets.size();
+		Append(&boneCount, sizeof(uint32_t));
+		for (uint32_t i = 0; i < boneCount; i++)
+		{
+			float offset[16];
+			for (int row = 0; row < 4; row++)
+				for (int column = 0; column < 4; column++)
+					offset[row * 4 + column] = (float)boneOffsets[i][row][column];
+			Append(offset, sizeof(offset));
+		}
+
+		for (std::map<std::string, uint32_t>::iterator it = boneMapping.begin(); it != boneMapping.end(); it++)
+		{
+			uint32_t nameSize = (uint32_t)it->first.size();
+			Append(&nameSize, sizeof(uint32_t));
+			Append(it->first.data(), nameSize);
+			Append(&it->second, sizeof(uint32_t));
+		}
+	}
+
+	std::string modelFile = outputBase + (skinned ? ".rcs" : ".rcm");
+	std::string materialFile = outputBase + ".mat";
+	if (!FileUtils::WriteFile(modelFile, output.data(), output.size()) ||
+		!FileUtils::WriteFile(materialFile, materials.data(), materials.size()))
+	{
+		printf("ERROR: Failed to write %s\n", modelFile.c_str());
+		return false;
+	}
+	outputFiles.push_back(modelFile);
+	outputFiles.push_back(materialFile);
+
+	// Legacy triangle soup, three vertices per triangle
+	if (!skinned)
+	{
+		std::string collisionFile = outputBase + ".col";
+		std::vector<unsigned char> collisionData(sizeof(uint32_t) + collisionVertices.size() * sizeof(float));
+		uint32_t collisionVertexCount = (uint32_t)(collisionVertices.size() / 3);
+		memcpy(collisionData.data(), &collisionVertexCount, sizeof(uint32_t));
+		if (!collisionVertices.empty())
+			memcpy(collisionData.data() + sizeof(uint32_t), collisionVertices.data(), collisionVertices.size() * sizeof(float));
+
+		if (!FileUtils::WriteFile(collisionFile, collisionData.data(), collisionData.size()))
+		{
+			printf("ERROR: Failed to write %s\n", collisionFile.c_str());
+			return false;
+		}
+		outputFiles.push_back(collisionFile);
+	}
+
+	printf("Imported %s into %s (%u meshes%s)\n", sourceFile.c_str(), modelFile.c_str(), meshCount, skinned ? ", skinned" : "");
+
+	return true;
+}
\ No newline at end of file
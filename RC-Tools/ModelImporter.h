@@ -0,0 +1,41 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: ModelImporter.h                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <string>
+#include <vector>
+#include <map>
+
+// Turns FBX, OBJ, glTF and everything else Assimp reads into the files the exporter used to write:
+// .rcm (or .rcs when the model has bones) with float vertices, .mat and a .col triangle soup for static models.
+// The mesh and collision cookers take it from there.
+class ModelImporter
+{
+	private:
+		std::vector<unsigned char> output;
+		std::map<std::string, uint32_t> boneMapping;
+		std::vector<aiMatrix4x4> boneOffsets;
+		std::string materials;
+		std::vector<float> collisionVertices;
+		bool skinned;
+		float frustumCullRadius;
+	private:
+		void Append(const void * src, size_t size);
+		void AppendTextureName(const aiMaterial * material, aiTextureType type);
+		std::string GetTextureName(const aiMaterial * material, aiTextureType type);
+		bool AddMesh(const aiMesh * mesh, const aiScene * scene);
+		bool AddBones(const aiMesh * mesh, std::vector<float> & boneWeights, std::vector<uint32_t> & boneIDs);
+	public:
+		ModelImporter();
+		~ModelImporter();
+
+		// Writes outputBase + .rcm/.rcs, .mat and .col, the files written are added to outputFiles
+		bool Import(std::string sourceFile, std::string outputBase, std::vector<std::string> & outputFiles);
+};
\ No newline at end of file
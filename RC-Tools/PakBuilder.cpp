@@ -0,0 +1,243 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: PakBuilder.cpp                                       |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "PakBuilder.h"
+#include "FileUtils.h"
+#include "../RC-Engine/AssetArchiveFormat.h"
+#include "../RC-Engine/LZ4.h"
+
+PakBuilder::PakBuilder()
+{
+	compress = false;
+}
+
+PakBuilder::~PakBuilder()
+{
+}
+
+void PakBuilder::SetCompression(bool compress)
+{
+	this->compress = compress;
+}
+
+bool PakBuilder::ShouldPack(std::string name)
+{
+	name = RCPakNormalizePath(name);
+
+	// Build scripts, source assets and user editable files stay out of the archive. Source .col files are kept,
+	// models build their collision from them when the cooked .rcc is missing or stale.
+	if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".bat") == 0)
+		return false;
+	if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".fbx") == 0)
+		return false;
+	if (name.size() >= 4 && name.compare(name.size() - 4, 4, ".map") == 0)
+		return false;
+	if (name.find("_uncompiled.") != std::string::npos)
+		return false;
+	if (FileUtils::GetFileName(name) == "settings.cfg")
+		return false;
+
+	return true;
+}
+
+bool PakBuilder::AddDirectory(std::string directory)
+{
+	std::vector<std::string> directoryFiles;
+	if (!FileUtils::ListFiles(directory, directoryFiles))
+	{
+		printf("ERROR: Failed to list directory %s\n", directory.c_str());
+		return false;
+	}
+
+	// Entry names are relative to the parent directory, so bin/data/models/a.rcm becomes data/models/a.rcm
+	std::string prefix = FileUtils::GetFileName(directory);
+	while (!directory.empty() && prefix.empty())
+	{
+		directory.erase(directory.size() - 1);
+		prefix = FileUtils::GetFileName(directory);
+	}
+
+	for (size_t i = 0; i < directoryFiles.size(); i++)
+	{
+		std::string name = prefix + "/" + directoryFiles[i];
+		if (ShouldPack(name))
+			AddFile(directory + "/" + directoryFiles[i], name);
+	}
+
+	return true;
+}
+
+void PakBuilder::AddFile(std::string sourcePath, std::string name)
+{
+	PakFile file;
+	file.sourcePath = sourcePath;
+	file.name = RCPakNormalizePath(name);
+	files.push_back(file);
+}
+
+bool PakBuilder::CompressEntry(const std::vector<unsigned char> & data, std::vector<unsigned char> & compressedData, unsigned int & blockCount)
+{
+	blockCount = (unsigned int)((data.size() + RCPAK_BLOCK_SIZE - 1) / RCPAK_BLOCK_SIZE);
+
+	std::vector<uint32_t> blockSizes(blockCount);
+	std::vector<unsigned char> blocks;
+	std::vector<unsigned char> blockBuffer(LZ4::CompressBound(RCPAK_BLOCK_SIZE));
+
+	for (unsigned int i = 0; i < blockCount; i++)
+	{
+		size_t blockStart = (size_t)i * RCPAK_BLOCK_SIZE;
+		int blockSize = (int)std::min(data.size() - blockStart, (size_t)RCPAK_BLOCK_SIZE);
+
+		int compressedSize = LZ4::CompressBlock(&data[blockStart], blockSize, blockBuffer.data(), (int)blockBuffer.size());
+
+		// Blocks that do not shrink are stored raw
+		if (compressedSize <= 0 || compressedSize >= blockSize)
+		{
+			blockSizes[i] = blockSize;
+			blocks.insert(blocks.end(), data.begin() + blockStart, data.begin() + blockStart + blockSize);
+		}
+		else
+		{
+			blockSizes[i] = compressedSize;
+			blocks.insert(blocks.end(), blockBuffer.begin(), blockBuffer.begin() + compressedSize);
+		}
+	}
+
+	compressedData.resize(blockCount * sizeof(uint32_t));
+	memcpy(compressedData.data(), blockSizes.data(), blockCount * sizeof(uint32_t));
+	compressedData.insert(compressedData.end(), blocks.begin(), blocks.end());
+
+	return compressedData.size() < data.size();
+}
+
+bool PakBuilder::Write(std::string filename)
+{
+	// Sorted names keep the output deterministic between builds
+	std::sort(files.begin(), files.end(), [](const PakFile & a, const PakFile & b) { return a.name < b.name; });
+
+	for (size_t i = 1; i < files.size(); i++)
+	{
+		if (files[i].name == files[i - 1].name)
+		{
+			printf("ERROR: Duplicate archive entry %s\n", files[i].name.c_str());
+			return false;
+		}
+	}
+
+	FILE * output = fopen(filename.c_str(), "wb");
+	if (output == NULL)
+	{
+		printf("ERROR: Failed to create %s\n", filename.c_str());
+		return false;
+	}
+
+	RCPakHeader header;
+	memset(&header, 0, sizeof(RCPakHeader));
+	fwrite(&header, sizeof(RCPakHeader), 1, output);
+
+	std::vector<RCPakEntry> entries;
+	std::string nameTable;
+	uint64_t offset = sizeof(RCPakHeader);
+	uint64_t totalOriginalSize = 0;
+	const unsigned char padding[RCPAK_PAGE_SIZE] = { 0 };
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		std::vector<unsigned char> data;
+		if (!FileUtils::ReadFile(files[i].sourcePath, data))
+		{
+			printf("ERROR: Failed to read %s\n", files[i].sourcePath.c_str());
+			fclose(output);
+			return false;
+		}
+
+		// Every entry starts on a page boundary so the engine can use it directly from the mapped archive
+		uint64_t alignedOffset = (offset + RCPAK_PAGE_SIZE - 1) & ~(uint64_t)(RCPAK_PAGE_SIZE - 1);
+		fwrite(padding, 1, (size_t)(alignedOffset - offset), output);
+		offset = alignedOffset;
+
+		RCPakEntry entry;
+		memset(&entry, 0, sizeof(RCPakEntry));
+		entry.pathHash = RCPakHashPath(files[i].name);
+		entry.dataOffset = offset;
+		entry.originalSize = data.size();
+		entry.nameOffset = (uint32_t)nameTable.size();
+		entry.nameLength = (uint32_t)files[i].name.size();
+		entry.compression = RCPAK_COMPRESSION_NONE;
+
+		std::vector<unsigned char> compressedData;
+		unsigned int blockCount = 0;
+		if (compress && !data.empty() && CompressEntry(data, compressedData, blockCount))
+		{
+			entry.compression = RCPAK_COMPRESSION_LZ4;
+			entry.blockCount = blockCount;
+			data.swap(compressedData);
+		}
+
+		entry.storedSize = data.size();
+		if (!data.empty())
+			fwrite(data.data(), 1, data.size(), output);
+
+		offset += data.size();
+		totalOriginalSize += entry.originalSize;
+		nameTable += files[i].name;
+		entries.push_back(entry);
+	}
+
+	// Hash slots are kept at most half full so probe sequences stay short
+	uint32_t hashSlotCount = 1;
+	while (hashSlotCount < entries.size() * 2)
+		hashSlotCount *= 2;
+
+	std::vector<uint32_t> hashSlots(hashSlotCount, 0);
+	for (uint32_t i = 0; i < entries.size(); i++)
+	{
+		uint32_t slot = (uint32_t)(entries[i].pathHash & (hashSlotCount - 1));
+		while (hashSlots[slot] != 0)
+			slot = (slot + 1) & (hashSlotCount - 1);
+
+		hashSlots[slot] = i + 1;
+	}
+
+	uint64_t alignedOffset = (offset + 7) & ~(uint64_t)7;
+	fwrite(padding, 1, (size_t)(alignedOffset - offset), output);
+	offset = alignedOffset;
+
+	header.magic = RCPAK_MAGIC;
+	header.version = RCPAK_VERSION;
+	header.entryCount = (uint32_t)entries.size();
+	header.hashSlotCount = hashSlotCount;
+	header.entryTableOffset = offset;
+	header.hashTableOffset = header.entryTableOffset + entries.size() * sizeof(RCPakEntry);
+	header.nameTableOffset = header.hashTableOffset + hashSlots.size() * sizeof(uint32_t);
+
+	if (!entries.empty())
+		fwrite(entries.data(), sizeof(RCPakEntry), entries.size(), output);
+	fwrite(hashSlots.data(), sizeof(uint32_t), hashSlots.size(), output);
+	fwrite(nameTable.data(), 1, nameTable.size(), output);
+
+	fseek(output, 0, SEEK_SET);
+	fwrite(&header, sizeof(RCPakHeader), 1, output);
+
+	bool success = ferror(output) == 0;
+	fclose(output);
+
+	if (!success)
+	{
+		printf("ERROR: Failed to write %s\n", filename.c_str());
+		return false;
+	}
+
+	printf("Packed %u files (%llu bytes) into %s (%llu bytes)\n", header.entryCount, (unsigned long long)totalOriginalSize,
+		filename.c_str(), (unsigned long long)(header.nameTableOffset + nameTable.size()));
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: PakBuilder.h                                         |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+class PakBuilder
+{
+	private:
+		struct PakFile
+		{
+			std::string sourcePath;
+			std::string name;
+		};
+
+		std::vector<PakFile> files;
+		bool compress;
+	private:
+		bool ShouldPack(std::string name);
+		bool CompressEntry(const std::vector<unsigned char> & data, std::vector<unsigned char> & compressedData, unsigned int & blockCount);
+	public:
+		PakBuilder();
+		~PakBuilder();
+
+		void SetCompression(bool compress);
+		bool AddDirectory(std::string directory);
+		void AddFile(std::string sourcePath, std::string name);
+		bool Write(std::string filename);
+};
\ No newline at end of file
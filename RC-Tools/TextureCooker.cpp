@@ -0,0 +1,335 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: TextureCooker.cpp                                    |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+
+#include "TextureCooker.h"
+#include "BlockCompressor.h"
+#include "FileUtils.h"
+#include "../RC-Engine/TextureTranscoder.h"
+
+static std::string ToLower(std::string text)
+{
+	for (size_t i = 0; i < text.size(); i++)
+		text[i] = (char)tolower((unsigned char)text[i]);
+
+	return text;
+}
+
+static bool EndsWith(std::string text, std::string suffix)
+{
+	return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool IsInDirectory(std::string path, std::string directory)
+{
+	path = "/" + ToLower(path);
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		if (path[i] == '\\')
+			path[i] = '/';
+	}
+
+	return path.find("/" + directory + "/") != std::string::npos;
+}
+
+static bool IsNormalMap(std::string textureFile)
+{
+	std::string name = ToLower(FileUtils::ReplaceExtension(FileUtils::GetFileName(textureFile), ""));
+	return EndsWith(name, "_norm") || EndsWith(name, "_normal");
+}
+
+static const char * GetFormatName(uint32_t format)
+{
+	switch (format)
+	{
+		case RCT_FORMAT_R8_UNORM: return "R8";
+		case RCT_FORMAT_R8G8_UNORM: return "RG8";
+		case RCT_FORMAT_R8G8B8A8_UNORM: return "RGBA8";
+		case RCT_FORMAT_BC1_RGBA_UNORM: return "BC1";
+		case RCT_FORMAT_BC3_UNORM: return "BC3";
+		case RCT_FORMAT_BC4_UNORM: return "BC4";
+		case RCT_FORMAT_BC5_UNORM: return "BC5";
+		case RCT_FORMAT_BC7_UNORM: return "BC7";
+	}
+
+	return "unknown";
+}
+
+TextureCooker::TextureCooker()
+{
+}
+
+TextureCooker::~TextureCooker()
+{
+}
+
+bool TextureCooker::ReadLevels(uint32_t format, uint32_t flags, const std::vector<RCTextureLevel> & fileLevels)
+{
+	// Every level is expanded to RGBA8, single channel textures that aren't grayscale only have red. BC7 is only read
+	// to convert old normal maps.
+	levels.resize(fileLevels.size());
+	for (size_t i = 0; i < fileLevels.size(); i++)
+	{
+		LevelData & level = levels[i];
+		level.width = fileLevels[i].width;
+		level.height = fileLevels[i].height;
+		level.pixels.resize((size_t)level.width * level.height * 4);
+
+		if (level.width == 0 || level.height == 0)
+			return false;
+
+		const unsigned char * src = data.data() + fileLevels[i].offset;
+		if (format == RCT_FORMAT_BC7_UNORM)
+		{
+			if (!TextureTranscoder::DecodeLevel(format, src, level.width, level.height, level.pixels.data()))
+				return false;
+			continue;
+		}
+
+		for (size_t j = 0; j < (size_t)level.width * level.height; j++)
+		{
+			unsigned char * pixel = &level.pixels[j * 4];
+			switch (format)
+			{
+				case RCT_FORMAT_R8_UNORM:
+					pixel[0] = src[j];
+					pixel[1] = pixel[2] = (flags & RCT_FLAG_GRAYSCALE) ? src[j] : 0;
+					pixel[3] = 255;
+					break;
+				case RCT_FORMAT_R8G8_UNORM:
+					pixel[0] = src[j * 2];
+					pixel[1] = src[j * 2 + 1];
+					pixel[2] = 0;
+					pixel[3] = 255;
+					break;
+				case RCT_FORMAT_R8G8B8A8_UNORM:
+					memcpy(pixel, src + j * 4, 4);
+					break;
+				default:
+					return false;
+			}
+		}
+	}
+
+	return !levels.empty();
+}
+
+uint32_t TextureCooker::ChooseFormat(std::string textureFile, bool compress, uint32_t & flags)
+{
+	std::string name = ToLower(FileUtils::ReplaceExtension(FileUtils::GetFileName(textureFile), ""));
+
+	bool opaque = true, grayscale = true, equalRedGreen = true;
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const std::vector<unsigned char> & pixels = levels[i].pixels;
+		for (size_t j = 0; j < pixels.size(); j += 4)
+		{
+			opaque = opaque && pixels[j + 3] == 255;
+			equalRedGreen = equalRedGreen && pixels[j] == pixels[j + 1];
+			grayscale = grayscale && pixels[j] == pixels[j + 1] && pixels[j] == pixels[j + 2];
+		}
+	}
+
+	// The GUI blends with the texture alpha and is drawn pixel for pixel, it stays uncompressed
+	if (IsInDirectory(textureFile, "gui"))
+		compress = false;
+
+	flags = 0;
+
+	// Only x and y of normal maps are kept, the shaders rebuild z from them
+	if (IsNormalMap(textureFile))
+	{
+		usage = "normal map";
+		return compress ? RCT_FORMAT_BC5_UNORM : RCT_FORMAT_R8G8_UNORM;
+	}
+
+	// Metallic in red and roughness in green, materials with both equal are sampled from one channel
+	if (EndsWith(name, "_mat") || EndsWith(name, "_material"))
+	{
+		usage = "material";
+		if (equalRedGreen)
+		{
+			flags |= RCT_FLAG_GRAYSCALE;
+			return compress ? RCT_FORMAT_BC4_UNORM : RCT_FORMAT_R8_UNORM;
+		}
+
+		return compress ? RCT_FORMAT_BC5_UNORM : RCT_FORMAT_R8G8_UNORM;
+	}
+
+	// All faces of a cubemap have to share a format, so they are never stored as grayscale
+	if (grayscale && opaque && !IsInDirectory(textureFile, "cubemaps"))
+	{
+		usage = "grayscale";
+		flags |= RCT_FLAG_GRAYSCALE;
+		return compress ? RCT_FORMAT_BC4_UNORM : RCT_FORMAT_R8_UNORM;
+	}
+
+	usage = opaque ? "opaque color" : "color with alpha";
+	if (!compress)
+		return RCT_FORMAT_R8G8B8A8_UNORM;
+
+	return opaque ? RCT_FORMAT_BC1_RGBA_UNORM : RCT_FORMAT_BC3_UNORM;
+}
+
+void TextureCooker::EncodeLevel(uint32_t format, const LevelData & level, std::vector<unsigned char> & encoded)
+{
+	encoded.resize(GetTextureLevelSize(format, level.width, level.height));
+
+	if (!IsBlockCompressed(format))
+	{
+		uint32_t channelCount = GetTextureFormatBytes(format);
+		for (size_t i = 0; i < (size_t)level.width * level.height; i++)
+			memcpy(&encoded[i * channelCount], &level.pixels[i * 4], channelCount);
+
+		return;
+	}
+
+	uint32_t blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+	uint32_t blockSize = GetTextureFormatBytes(format);
+	for (uint32_t by = 0; by < blocksY; by++)
+	{
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			// Levels smaller than a block repeat their last row and column
+			unsigned char pixels[64];
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				for (uint32_t x = 0; x < 4; x++)
+				{
+					uint32_t px = bx * 4 + x < level.width ? bx * 4 + x : level.width - 1;
+					uint32_t py = by * 4 + y < level.height ? by * 4 + y : level.height - 1;
+					memcpy(pixels + (y * 4 + x) * 4, &level.pixels[((size_t)py * level.width + px) * 4], 4);
+				}
+			}
+
+			unsigned char * block = &encoded[((size_t)by * blocksX + bx) * blockSize];
+			switch (format)
+			{
+				case RCT_FORMAT_BC1_RGBA_UNORM: BlockCompressor::EncodeBC1(pixels, block); break;
+				case RCT_FORMAT_BC3_UNORM: BlockCompressor::EncodeBC3(pixels, block); break;
+				case RCT_FORMAT_BC4_UNORM: BlockCompressor::EncodeBC4(pixels, block); break;
+				case RCT_FORMAT_BC5_UNORM: BlockCompressor::EncodeBC5(pixels, block); break;
+			}
+		}
+	}
+}
+
+float TextureCooker::CalculatePSNR(uint32_t format, const std::vector<unsigned char> & encoded)
+{
+	// Measured on the first level, in the channels the format keeps
+	const LevelData & level = levels[0];
+	uint32_t decodedFormat = format;
+	std::vector<unsigned char> decoded = encoded;
+	if (IsBlockCompressed(format))
+	{
+		decodedFormat = TextureTranscoder::GetDecodedFormat(format);
+		decoded.resize(GetTextureLevelSize(decodedFormat, level.width, level.height));
+		if (!TextureTranscoder::DecodeLevel(format, encoded.data(), level.width, level.height, decoded.data()))
+			return 0.0f;
+	}
+
+	uint32_t channelCount = GetTextureFormatBytes(decodedFormat);
+	double squaredError = 0.0;
+	for (size_t i = 0; i < (size_t)level.width * level.height; i++)
+	{
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			double difference = (double)decoded[i * channelCount + c] - level.pixels[i * 4 + c];
+			squaredError += difference * difference;
+		}
+	}
+
+	if (squaredError == 0.0)
+		return INFINITY;
+
+	double meanSquaredError = squaredError / ((double)level.width * level.height * channelCount);
+	return (float)(10.0 * log10(255.0 * 255.0 / meanSquaredError));
+}
+
+bool TextureCooker::Cook(std::string textureFile, std::string outputFile, bool compress)
+{
+	if (!FileUtils::ReadFile(textureFile, data))
+	{
+		printf("ERROR: Failed to read %s\n", textureFile.c_str());
+		return false;
+	}
+
+	uint32_t inputFormat, inputFlags;
+	std::vector<RCTextureLevel> fileLevels;
+	if (!ReadTextureLevels(data.data(), data.size(), inputFormat, inputFlags, fileLevels))
+	{
+		printf("ERROR: %s is corrupted or has an unknown version\n", textureFile.c_str());
+		return false;
+	}
+
+	// Compressing again would only lose quality, normal maps cooked as BC7 before are still moved to BC5
+	if (IsBlockCompressed(inputFormat) && !(inputFormat == RCT_FORMAT_BC7_UNORM && IsNormalMap(textureFile)))
+	{
+		printf("Skipped %s (already compressed)\n", textureFile.c_str());
+
+		if (outputFile != textureFile && !FileUtils::WriteFile(outputFile, data.data(), data.size()))
+		{
+			printf("ERROR: Failed to write %s\n", outputFile.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	if (!ReadLevels(inputFormat, inputFlags, fileLevels))
+	{
+		printf("ERROR: %s is corrupted\n", textureFile.c_str());
+		return false;
+	}
+
+	RCTextureHeader header;
+	header.magic = RCT_MAGIC;
+	header.version = RCT_VERSION;
+	header.format = ChooseFormat(textureFile, compress, header.flags);
+	header.width = levels[0].width;
+	header.height = levels[0].height;
+	header.levelCount = (uint32_t)levels.size();
+	header.reserved = 0;
+
+	// Level data starts aligned, so the loaders can copy it straight into staging memory
+	std::vector<RCTextureLevel> outputLevels(levels.size());
+	std::vector<std::vector<unsigned char>> encodedLevels(levels.size());
+	size_t offset = sizeof(RCTextureHeader) + sizeof(RCTextureLevel) * levels.size();
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		EncodeLevel(header.format, levels[i], encodedLevels[i]);
+
+		offset = (offset + RCT_LEVEL_ALIGNMENT - 1) & ~(size_t)(RCT_LEVEL_ALIGNMENT - 1);
+		outputLevels[i].width = levels[i].width;
+		outputLevels[i].height = levels[i].height;
+		outputLevels[i].offset = (uint32_t)offset;
+		outputLevels[i].size = (uint32_t)encodedLevels[i].size();
+		offset += encodedLevels[i].size();
+	}
+
+	std::vector<unsigned char> output(offset, 0);
+	memcpy(output.data(), &header, sizeof(RCTextureHeader));
+	memcpy(output.data() + sizeof(RCTextureHeader), outputLevels.data(), sizeof(RCTextureLevel) * outputLevels.size());
+	for (size_t i = 0; i < levels.size(); i++)
+		memcpy(output.data() + outputLevels[i].offset, encodedLevels[i].data(), encodedLevels[i].size());
+
+	if (!FileUtils::WriteFile(outputFile, output.data(), output.size()))
+	{
+		printf("ERROR: Failed to write %s\n", outputFile.c_str());
+		return false;
+	}
+
+	printf("Cooked %s into %s (%u bytes -> %u bytes, %s as %s%s, PSNR %.1f dB)\n", textureFile.c_str(), outputFile.c_str(),
+		(unsigned int)data.size(), (unsigned int)output.size(), usage.c_str(), GetFormatName(header.format),
+		(header.flags & RCT_FLAG_GRAYSCALE) ? " grayscale" : "", CalculatePSNR(header.format, encodedLevels[0]));
+
+	return true;
+}
\ No newline at end of file
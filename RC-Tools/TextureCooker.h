@@ -0,0 +1,38 @@
+/*========================================================================================
+|                                   RC-Engine (c) 2016                                   |
+|                             Project: RC-Tools                                          |
+|                             File: TextureCooker.h                                      |
+|                             Author: Ruscris2                                           |
+==========================================================================================*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../RC-Engine/TextureFormat.h"
+
+class TextureCooker
+{
+	private:
+		struct LevelData
+		{
+			uint32_t width;
+			uint32_t height;
+			std::vector<unsigned char> pixels;
+		};
+
+		std::vector<unsigned char> data;
+		std::vector<LevelData> levels;
+		std::string usage;
+	private:
+		bool ReadLevels(uint32_t format, uint32_t flags, const std::vector<RCTextureLevel> & fileLevels);
+		uint32_t ChooseFormat(std::string textureFile, bool compress, uint32_t & flags);
+		void EncodeLevel(uint32_t format, const LevelData & level, std::vector<unsigned char> & encoded);
+		float CalculatePSNR(uint32_t format, const std::vector<unsigned char> & encoded);
+	public:
+		TextureCooker();
+		~TextureCooker();
+
+		// Uncompressed textures still get the smallest format that holds their channels
+		bool Cook(std::string textureFile, std::string outputFile, bool compress);
+};
\ No newline at end of file
@@ -1,2 +1,4 @@
-glslangValidator -V canvas_uncompiled.vert -o canvasVS.spv
-glslangValidator -V canvas_uncompiled.frag -o canvasFS.spv
\ No newline at end of file
+glslangValidator -V canvas_uncompiled.vert -o canvasVS.spv || exit /b 1
+spirv-val canvasVS.spv || exit /b 1
+glslangValidator -V canvas_uncompiled.frag -o canvasFS.spv || exit /b 1
+spirv-val canvasFS.spv || exit /b 1
\ No newline at end of file
@@ -1,2 +1,4 @@
-glslangValidator -V default_uncompiled.vert -o defaultVS.spv
-glslangValidator -V default_uncompiled.frag -o defaultFS.spv
\ No newline at end of file
+glslangValidator -V default_uncompiled.vert -o defaultVS.spv || exit /b 1
+spirv-val defaultVS.spv || exit /b 1
+glslangValidator -V default_uncompiled.frag -o defaultFS.spv || exit /b 1
+spirv-val defaultFS.spv || exit /b 1
\ No newline at end of file
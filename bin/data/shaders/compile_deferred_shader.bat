@@ -1,2 +1,4 @@
-glslangValidator -V deferred_uncompiled.vert -o deferredVS.spv
-glslangValidator -V deferred_uncompiled.frag -o deferredFS.spv
\ No newline at end of file
+glslangValidator -V deferred_uncompiled.vert -o deferredVS.spv || exit /b 1
+spirv-val deferredVS.spv || exit /b 1
+glslangValidator -V deferred_uncompiled.frag -o deferredFS.spv || exit /b 1
+spirv-val deferredFS.spv || exit /b 1
\ No newline at end of file
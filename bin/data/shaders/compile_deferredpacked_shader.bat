@@ -0,0 +1,4 @@
+glslangValidator -V deferredpacked_uncompiled.vert -o deferredpackedVS.spv || exit /b 1
+spirv-val deferredpackedVS.spv || exit /b 1
+glslangValidator -V deferred_uncompiled.frag -o deferredpackedFS.spv || exit /b 1
+spirv-val deferredpackedFS.spv || exit /b 1
\ No newline at end of file
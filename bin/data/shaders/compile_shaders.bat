@@ -0,0 +1,4 @@
+@echo off
+rem Compiles every shader and validates the SPIR-V, the build runs this before compiling the engine
+cd /d "%~dp0"
+for %%f in (compile_*_shader.bat) do call %%f || exit /b 1
\ No newline at end of file
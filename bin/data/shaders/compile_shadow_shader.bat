@@ -1,3 +1,6 @@
-glslangValidator -V shadow_uncompiled.vert -o shadowVS.spv
-glslangValidator -V shadow_uncompiled.frag -o shadowFS.spv
-glslangValidator -V shadow_uncompiled.geom -o shadowGS.spv
\ No newline at end of file
+glslangValidator -V shadow_uncompiled.vert -o shadowVS.spv || exit /b 1
+spirv-val shadowVS.spv || exit /b 1
+glslangValidator -V shadow_uncompiled.frag -o shadowFS.spv || exit /b 1
+spirv-val shadowFS.spv || exit /b 1
+glslangValidator -V shadow_uncompiled.geom -o shadowGS.spv || exit /b 1
+spirv-val shadowGS.spv || exit /b 1
\ No newline at end of file
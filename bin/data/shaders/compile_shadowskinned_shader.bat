@@ -1,3 +1,6 @@
-glslangValidator -V shadowskinned_uncompiled.vert -o shadowskinnedVS.spv
-glslangValidator -V shadowskinned_uncompiled.frag -o shadowskinnedFS.spv
-glslangValidator -V shadowskinned_uncompiled.geom -o shadowskinnedGS.spv
\ No newline at end of file
+glslangValidator -V shadowskinned_uncompiled.vert -o shadowskinnedVS.spv || exit /b 1
+spirv-val shadowskinnedVS.spv || exit /b 1
+glslangValidator -V shadowskinned_uncompiled.frag -o shadowskinnedFS.spv || exit /b 1
+spirv-val shadowskinnedFS.spv || exit /b 1
+glslangValidator -V shadowskinned_uncompiled.geom -o shadowskinnedGS.spv || exit /b 1
+spirv-val shadowskinnedGS.spv || exit /b 1
\ No newline at end of file
@@ -1,2 +1,4 @@
-glslangValidator -V skinned_uncompiled.vert -o skinnedVS.spv
-glslangValidator -V skinned_uncompiled.frag -o skinnedFS.spv
\ No newline at end of file
+glslangValidator -V skinned_uncompiled.vert -o skinnedVS.spv || exit /b 1
+spirv-val skinnedVS.spv || exit /b 1
+glslangValidator -V skinned_uncompiled.frag -o skinnedFS.spv || exit /b 1
+spirv-val skinnedFS.spv || exit /b 1
\ No newline at end of file
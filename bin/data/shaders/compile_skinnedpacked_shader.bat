@@ -0,0 +1,4 @@
+glslangValidator -V skinnedpacked_uncompiled.vert -o skinnedpackedVS.spv || exit /b 1
+spirv-val skinnedpackedVS.spv || exit /b 1
+glslangValidator -V skinned_uncompiled.frag -o skinnedpackedFS.spv || exit /b 1
+spirv-val skinnedpackedFS.spv || exit /b 1
\ No newline at end of file
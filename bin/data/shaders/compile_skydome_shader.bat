@@ -1,2 +1,4 @@
-glslangValidator -V skydome_uncompiled.vert -o skydomeVS.spv
-glslangValidator -V skydome_uncompiled.frag -o skydomeFS.spv
\ No newline at end of file
+glslangValidator -V skydome_uncompiled.vert -o skydomeVS.spv || exit /b 1
+spirv-val skydomeVS.spv || exit /b 1
+glslangValidator -V skydome_uncompiled.frag -o skydomeFS.spv || exit /b 1
+spirv-val skydomeFS.spv || exit /b 1
\ No newline at end of file
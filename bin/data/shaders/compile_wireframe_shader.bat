@@ -1,2 +1,4 @@
-glslangValidator -V wireframe_uncompiled.vert -o wireframeVS.spv
-glslangValidator -V wireframe_uncompiled.frag -o wireframeFS.spv
\ No newline at end of file
+glslangValidator -V wireframe_uncompiled.vert -o wireframeVS.spv || exit /b 1
+spirv-val wireframeVS.spv || exit /b 1
+glslangValidator -V wireframe_uncompiled.frag -o wireframeFS.spv || exit /b 1
+spirv-val wireframeFS.spv || exit /b 1
\ No newline at end of file
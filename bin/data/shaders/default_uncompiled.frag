@@ -14,13 +14,15 @@ layout (binding = 3) uniform sampler2D samplerAlbedo;
 layout (binding = 4) uniform sampler2D samplerMaterial;
 layout (binding = 5) uniform sampler2D samplerDepth;
 
-layout (binding = 6) uniform UBO
+layout (set = 1, binding = 6) uniform UBO
 {
 	mat4 lightViewMatrix[CASCADE_COUNT];
 	vec3 lightDirection;
 	int imageIndex;
 	vec3 cameraPosition;
 	float lightStrength;
+	vec4 irradiance[9];
+	float environmentRoughestLevel;
 } ubo;
 
 layout (binding = 7) uniform sampler2DArray samplerShadowMap;
@@ -69,6 +71,16 @@ float CalculateNormalDistributionTrowReitz(float roughness, vec3 surfaceNormal,
 	return pow(roughnessActual, 2.0f) / (PI * pow(pow(dot(surfaceNormal, microfacetNormal), 2.0f) * (pow(roughnessActual, 2.0f) - 1.0f) + 1.0f, 2.0f));
 }
 
+// Diffuse light from the environment, the coefficients already hold the cosine lobe and 1 / pi
+vec3 CalculateIrradiance(vec3 n)
+{
+	return ubo.irradiance[0].rgb * 0.282095f +
+		ubo.irradiance[1].rgb * 0.488603f * n.y + ubo.irradiance[2].rgb * 0.488603f * n.z + ubo.irradiance[3].rgb * 0.488603f * n.x +
+		ubo.irradiance[4].rgb * 1.092548f * n.x * n.y + ubo.irradiance[5].rgb * 1.092548f * n.y * n.z +
+		ubo.irradiance[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f) + ubo.irradiance[7].rgb * 1.092548f * n.x * n.z +
+		ubo.irradiance[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+}
+
 //========================================== MAIN ===================================================
 void main()
 {
@@ -143,15 +155,16 @@ void main()
 					shadow * nDotL * ubo.lightStrength;
 		
 		// Calculate ambient component
-		ambientComponent = albedo.rgb * max(ubo.lightStrength * 0.35f, 0.05f);
+		ambientComponent = albedo.rgb * (1.0f - metallic) * max(CalculateIrradiance(normal), 0.0f) * max(ubo.lightStrength, 0.2f);
 		
 		// Calculate diffuse component
 		diffuseComponent = (albedo.rgb * nDotL * shadow * (1.0f - metallic) * max(ubo.lightStrength, 0.2f));
 		
 		// Calculate the environment component
 		vec3 R = reflect(-viewDir, normal);
-		float mipMapLevel = (pow(roughness - 1.0f, 3.0f) + 1.0f) *  4.0f; // TODO: Dynamic number of lods
-		vec4 environmentColor = texture(samplerCubeMap, R, mipMapLevel);
+		// Each level is prefiltered for roughness level / roughest level
+		float mipMapLevel = roughness * ubo.environmentRoughestLevel;
+		vec4 environmentColor = textureLod(samplerCubeMap, R, mipMapLevel);
 		
 		vec3 envFactorRoughness = environmentColor.rgb * pow(1.0f - clamp(dot(normal, viewDir), 0.0f, 1.0f), 5.0f) * (1.0f - roughness);
 		vec3 envFactorMetallic = environmentColor.rgb * nDotL * metallic * (1.0f - roughness);
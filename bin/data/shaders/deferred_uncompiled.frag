@@ -7,18 +7,12 @@ layout (binding = 1) uniform sampler2D diffuseSampler;
 layout (binding = 2) uniform sampler2D materialSampler;
 layout (binding = 3) uniform sampler2D normalSampler;
 
-layout (binding = 4) uniform UBO
-{
-	float hasNormalMap;
-	float metallicOffset;
-	float roughnessOffset;
-	float padding;
-} ubo;
-
 layout (location = 0) in vec3 worldPos;
 layout (location = 1) in vec2 texCoord;
 layout (location = 2) in vec3 normals;
 layout (location = 3) in mat3 tangentSpace;
+// hasNormalMap, metallicOffset, roughnessOffset
+layout (location = 6) flat in vec4 materialParams;
 
 layout (location = 0) out vec4 outPosition;
 layout (location = 1) out vec4 outNormal;
@@ -32,14 +26,17 @@ void main()
 	outAlbedo = texture(diffuseSampler, texCoord);
 	
 	outMaterial = texture(materialSampler, texCoord);
-	outMaterial.r = clamp(outMaterial.r + ubo.metallicOffset, 0.0f, 1.0f);
-	outMaterial.g = clamp(outMaterial.g + ubo.roughnessOffset, 0.0f, 1.0f);
+	outMaterial.r = clamp(outMaterial.r + materialParams.y, 0.0f, 1.0f);
+	outMaterial.g = clamp(outMaterial.g + materialParams.z, 0.0f, 1.0f);
 	
 	// If there is a normal map available overwrite normals
-	if(ubo.hasNormalMap == 1.0f)
+	if(materialParams.x == 1.0f)
 	{
-		vec3 tempNormal = texture(normalSampler, texCoord).rgb;
-		tempNormal = normalize(tempNormal * 2.0f - 1.0f);
+		// Normal maps only store x and y (BC5), z is rebuilt
+		vec3 tempNormal;
+		tempNormal.xy = texture(normalSampler, texCoord).rg * 2.0f - 1.0f;
+		tempNormal.z = sqrt(max(1.0f - dot(tempNormal.xy, tempNormal.xy), 0.0f));
+		tempNormal = normalize(tempNormal);
 		tempNormal = normalize(tangentSpace * tempNormal);
 		outNormal = vec4(tempNormal, 1.0f);
 	}
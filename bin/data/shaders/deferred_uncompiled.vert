@@ -3,11 +3,18 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
-layout (binding = 0) uniform UBO
+// One element per instance and mesh, the draw picks its instances with firstInstance
+struct InstanceData
 {
 	mat4 mvp;
 	mat4 worldMatrix;
-} ubo;
+	vec4 materialParams;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer InstanceBuffer
+{
+	InstanceData instances[];
+};
 
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 inTexCoord;
@@ -19,24 +26,28 @@ layout (location = 0) out vec3 outWorldPos;
 layout (location = 1) out vec2 outTexCoord;
 layout (location = 2) out vec3 outNormals;
 layout (location = 3) out mat3 outTangentSpace;
+layout (location = 6) flat out vec4 outMaterialParams;
 
 void main()
 {
-	gl_Position = ubo.mvp * vec4(pos, 1.0f);
+	gl_Position = instances[gl_InstanceIndex].mvp * vec4(pos, 1.0f);
 	
 	// outWorldPos
 	vec4 tempPos = vec4(pos, 1.0f);
-	outWorldPos = vec3(ubo.worldMatrix * tempPos);
+	outWorldPos = vec3(instances[gl_InstanceIndex].worldMatrix * tempPos);
 	
 	// outTexCoord
 	outTexCoord = inTexCoord;
 	
 	// outNormals
-	outNormals = mat3(transpose(inverse(ubo.worldMatrix))) * inNormals;
+	outNormals = mat3(transpose(inverse(instances[gl_InstanceIndex].worldMatrix))) * inNormals;
 	
 	// outTangentSpace
-	vec3 tan = normalize(vec3(ubo.worldMatrix * vec4(inTangents, 0.0f)));
-	vec3 bitan = normalize(vec3(ubo.worldMatrix * vec4(inBitangents, 0.0f)));
-	vec3 norm = normalize(vec3(ubo.worldMatrix * vec4(inNormals, 0.0f)));
+	vec3 tan = normalize(vec3(instances[gl_InstanceIndex].worldMatrix * vec4(inTangents, 0.0f)));
+	vec3 bitan = normalize(vec3(instances[gl_InstanceIndex].worldMatrix * vec4(inBitangents, 0.0f)));
+	vec3 norm = normalize(vec3(instances[gl_InstanceIndex].worldMatrix * vec4(inNormals, 0.0f)));
 	outTangentSpace = mat3(tan, bitan, norm);
+	
+	// outMaterialParams
+	outMaterialParams = instances[gl_InstanceIndex].materialParams;
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// One element per instance and mesh, the draw picks its instances with firstInstance
+struct InstanceData
+{
+	mat4 mvp;
+	mat4 worldMatrix;
+	vec4 materialParams;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer InstanceBuffer
+{
+	InstanceData instances[];
+};
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 inTexCoord;
+// Packed vertices (MeshFormat.h): octahedral normal, octahedral tangent with the bitangent sign in z
+layout (location = 2) in vec2 inNormal;
+layout (location = 3) in vec4 inTangent;
+
+layout (location = 0) out vec3 outWorldPos;
+layout (location = 1) out vec2 outTexCoord;
+layout (location = 2) out vec3 outNormals;
+layout (location = 3) out mat3 outTangentSpace;
+layout (location = 6) flat out vec4 outMaterialParams;
+
+// Octahedral direction, the vertex fetch already maps it to -1..1
+vec3 DecodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0f);
+	n.x += (n.x >= 0.0f ? -t : t);
+	n.y += (n.y >= 0.0f ? -t : t);
+	return normalize(n);
+}
+
+void main()
+{
+	vec3 inNormals = DecodeOctahedral(inNormal);
+	vec3 inTangents = DecodeOctahedral(inTangent.xy);
+	vec3 inBitangents = cross(inNormals, inTangents) * (inTangent.z < 0.0f ? -1.0f : 1.0f);
+	
+	gl_Position = instances[gl_InstanceIndex].mvp * vec4(pos, 1.0f);
+	
+	// outWorldPos
+	vec4 tempPos = vec4(pos, 1.0f);
+	outWorldPos = vec3(instances[gl_InstanceIndex].worldMatrix * tempPos);
+	
+	// outTexCoord
+	outTexCoord = inTexCoord;
+	
+	// outNormals
+	outNormals = mat3(transpose(inverse(instances[gl_InstanceIndex].worldMatrix))) * inNormals;
+	
+	// outTangentSpace
+	vec3 tan = normalize(vec3(instances[gl_InstanceIndex].worldMatrix * vec4(inTangents, 0.0f)));
+	vec3 bitan = normalize(vec3(instances[gl_InstanceIndex].worldMatrix * vec4(inBitangents, 0.0f)));
+	vec3 norm = normalize(vec3(instances[gl_InstanceIndex].worldMatrix * vec4(inNormals, 0.0f)));
+	outTangentSpace = mat3(tan, bitan, norm);
+	
+	// outMaterialParams
+	outMaterialParams = instances[gl_InstanceIndex].materialParams;
+}
\ No newline at end of file
@@ -3,15 +3,19 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
-layout (binding = 0) uniform UBO
+struct InstanceData
 {
-	mat4 mvp;
 	mat4 worldMatrix;
-} ubo;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer InstanceBuffer
+{
+	InstanceData instances[];
+};
 
 layout (location = 0) in vec3 pos;
 
 void main()
 {
-	gl_Position = ubo.worldMatrix * vec4(pos, 1.0f);
+	gl_Position = instances[gl_InstanceIndex].worldMatrix * vec4(pos, 1.0f);
 }
\ No newline at end of file
@@ -38,8 +38,11 @@ void main()
 	// If there is a normal map available overwrite normals
 	if(ubo.hasNormalMap == 1.0f)
 	{
-		vec3 tempNormal = texture(normalSampler, texCoord).rgb;
-		tempNormal = normalize(tempNormal * 2.0f - 1.0f);
+		// Normal maps only store x and y (BC5), z is rebuilt
+		vec3 tempNormal;
+		tempNormal.xy = texture(normalSampler, texCoord).rg * 2.0f - 1.0f;
+		tempNormal.z = sqrt(max(1.0f - dot(tempNormal.xy, tempNormal.xy), 0.0f));
+		tempNormal = normalize(tempNormal);
 		tempNormal = normalize(tangentSpace * tempNormal);
 		outNormal = vec4(tempNormal, 1.0f);
 	}
@@ -5,14 +5,14 @@
 
 #define MAX_BONES 64
 
-layout (binding = 0) uniform UBO
+layout (set = 1, binding = 0) uniform UBO
 {
 	mat4 mvp;
 	mat4 worldMatrix;
 	
 } ubo;
 
-layout (binding = 1) uniform BoneUniform
+layout (set = 1, binding = 1) uniform BoneUniform
 {
 	mat4 bones[MAX_BONES];
 } boneUniform;